@@ -7,74 +7,87 @@
 #include <syslog.h>
 
 // Standard includes
+#include <atomic>
 #include <functional>
 #include <iostream>
 #include <memory>
 #include <mutex>
+#include <sstream>
 #include <string>
 #include <vector>
 
+// Most verbose level that is compiled in, statements above it are discarded
+// without evaluating their arguments. Builds configured with
+// DATAFED_STRIP_DEBUG_LOGS keep INFO and above only.
+#ifndef DL_COMPILED_LEVEL
+#ifdef DATAFED_STRIP_DEBUG_LOGS
+#define DL_COMPILED_LEVEL ::SDMS::LogLevel::INFO
+#else
+#define DL_COMPILED_LEVEL ::SDMS::LogLevel::TRACE
+#endif
+#endif
+
 // Have to use macros for the line and func macros to work
+//
+// The message is only formatted when the level is enabled, so a disabled
+// statement costs a relaxed atomic load and a branch.
 #define DL_LOG(level, context, message)                                        \
   {                                                                            \
-    std::stringstream temp_buffer;                                             \
-    temp_buffer << message;                                                    \
-    ::SDMS::global_logger.log(level, __FILE__, __func__, __LINE__, context,    \
-                              temp_buffer.str());                              \
+    if (::SDMS::global_logger.isEnabled(level)) {                              \
+      std::ostringstream temp_buffer;                                          \
+      temp_buffer << message;                                                  \
+      ::SDMS::global_logger.log(level, __FILE__, __func__, __LINE__, context,  \
+                                temp_buffer.str());                            \
+    }                                                                          \
   }
 
-#define DL_CRITICAL(context, message)                                          \
+#define DL_LOG_AT(level, method, context, message)                             \
   {                                                                            \
-    std::stringstream temp_buffer;                                             \
-    temp_buffer << message;                                                    \
-    ::SDMS::global_logger.critical(__FILE__, __func__, __LINE__, context,      \
-                                   temp_buffer.str());                         \
+    if constexpr (::SDMS::LogLevel::level <= DL_COMPILED_LEVEL) {              \
+      if (::SDMS::global_logger.isEnabled(::SDMS::LogLevel::level)) {          \
+        std::ostringstream temp_buffer;                                        \
+        temp_buffer << message;                                                \
+        ::SDMS::global_logger.method(__FILE__, __func__, __LINE__, context,    \
+                                     temp_buffer.str());                       \
+      }                                                                        \
+    }                                                                          \
   }
 
-#define DL_ERROR(context, message)                                             \
-  {                                                                            \
-    std::stringstream temp_buffer;                                             \
-    temp_buffer << message;                                                    \
-    ::SDMS::global_logger.error(__FILE__, __func__, __LINE__, context,         \
-                                temp_buffer.str());                            \
-  }
+#define DL_CRITICAL(context, message)                                          \
+  DL_LOG_AT(CRITICAL, critical, context, message)
+
+#define DL_ERROR(context, message) DL_LOG_AT(ERROR, error, context, message)
 
 #define DL_WARNING(context, message)                                           \
-  {                                                                            \
-    std::stringstream temp_buffer;                                             \
-    temp_buffer << message;                                                    \
-    ::SDMS::global_logger.warning(__FILE__, __func__, __LINE__, context,       \
-                                  temp_buffer.str());                          \
-  }
+  DL_LOG_AT(WARNING, warning, context, message)
 
-#define DL_INFO(context, message)                                              \
-  {                                                                            \
-    std::stringstream temp_buffer;                                             \
-    temp_buffer << message;                                                    \
-    ::SDMS::global_logger.info(__FILE__, __func__, __LINE__, context,          \
-                               temp_buffer.str());                             \
-  }
+#define DL_INFO(context, message) DL_LOG_AT(INFO, info, context, message)
 
-#define DL_DEBUG(context, message)                                             \
-  {                                                                            \
-    std::stringstream temp_buffer;                                             \
-    temp_buffer << message;                                                    \
-    ::SDMS::global_logger.debug(__FILE__, __func__, __LINE__, context,         \
-                                temp_buffer.str());                            \
-  }
+#define DL_DEBUG(context, message) DL_LOG_AT(DEBUG, debug, context, message)
 
-#define DL_TRACE(context, message)                                             \
-  {                                                                            \
-    std::stringstream temp_buffer;                                             \
-    temp_buffer << message;                                                    \
-    ::SDMS::global_logger.trace(__FILE__, __func__, __LINE__, context,         \
-                                temp_buffer.str());                            \
-  }
+#define DL_TRACE(context, message) DL_LOG_AT(TRACE, trace, context, message)
 
 namespace SDMS {
 
 enum class LogLevel { CRITICAL, ERROR, WARNING, INFO, DEBUG, TRACE };
 
+/**
+ * Layout of each line written to the streams, TEXT is a timestamp, level and
+ * source location followed by the LogLine object, JSON writes every field as
+ * a single JSON object per line.
+ **/
+enum class LogFormat { TEXT, JSON };
+
+/**
+ * What a logging thread does when the asynchronous queue is full
+ *
+ * BLOCK         - wait for the writer thread to make room
+ * DROP          - discard the message
+ * COUNT_DROPPED - discard the message, the writer reports how many messages
+ *                 were discarded the next time it writes
+ **/
+enum class LogOverflowPolicy { BLOCK, DROP, COUNT_DROPPED };
+
 std::string toString(const LogLevel level);
 int toSysLog(const LogLevel level);
 
@@ -93,23 +106,60 @@ public:
 };
 std::ostream &operator<<(std::ostream &out, const LogLine &log_line);
 
+class AsyncLogSink;
+struct LogRecord;
+
 class Logger {
 private:
   // Parameters
   std::vector<std::reference_wrapper<std::ostream>> m_streams;
-  LogLevel m_log_level = LogLevel::INFO;
+  std::atomic<LogLevel> m_log_level{LogLevel::INFO};
   bool m_output_to_syslog = false;
+  LogFormat m_format = LogFormat::TEXT;
   mutable std::vector<std::unique_ptr<std::mutex>> m_mutexes;
+  std::unique_ptr<AsyncLogSink> m_async;
+  std::atomic<size_t> m_dropped{0};
 
   // Internal Methods
   void output(const LogLevel, std::string, std::string, int,
               const LogContext &context, const std::string &message);
 
+  friend class AsyncLogSink;
+  void format(const LogRecord &record, std::string &out) const;
+  void write(const std::string &lines, bool flush);
+  void writeSysLog(const LogRecord &record) const;
+
 public:
+  Logger();
+  ~Logger();
+
   // Methods
   void setLevel(LogLevel) noexcept;
+  bool isEnabled(LogLevel level) const noexcept {
+    return m_log_level.load(std::memory_order_relaxed) >= level;
+  }
   void addStream(std::ostream &stream);
   void setSysLog(bool on_or_off) noexcept { m_output_to_syslog = on_or_off; }
+  void setFormat(LogFormat format) noexcept { m_format = format; }
+
+  /**
+   * Hands messages to a background writer thread instead of writing them on
+   * the calling thread. Messages are queued in a lock free ring buffer of at
+   * least the given capacity, the writer formats them in batches and flushes
+   * the streams once per batch.
+   *
+   * The streams, format and syslog settings must be configured before this
+   * is called. Neither startAsync nor stopAsync may run while other threads
+   * are logging.
+   **/
+  void startAsync(size_t capacity = 8192,
+                  LogOverflowPolicy policy = LogOverflowPolicy::COUNT_DROPPED);
+  /// Writes any queued messages and stops the writer thread
+  void stopAsync();
+  /// Blocks until every message logged before the call has been written
+  void flush();
+  /// Number of messages discarded because the asynchronous queue was full
+  size_t droppedCount() const noexcept;
 
   void log(const LogLevel, std::string file_name, std::string func_name, int,
            const LogContext &context, const std::string &message);
@@ -4,6 +4,7 @@
 #pragma once
 
 // Standard imports
+#include <cstdint>
 #include <string>
 
 namespace SDMS {
@@ -52,9 +53,33 @@ public:
   virtual std::string getUID(const std::string &pub_key) const = 0;
 
   /**
-   * Purge keys if needed
+   * Combines hasKey, incrementKeyAccessCounter and getUID in a single lookup.
+   *Returns false, leaving uid untouched, if the public key is not known.
+   **/
+  virtual bool findUID(const std::string &pub_key, std::string &uid) = 0;
+
+  /**
+   * Purge keys if needed, this is called from a background thread and not
+   *while handling messages.
    **/
   virtual void purge() = 0;
+
+  /**
+   * Called by the ZAP handler once per connection with the public key the
+   *client presented during the CURVE handshake. Sets the uid the key maps to,
+   *"anon" if it is unknown.
+   *
+   * Returns a non zero token if messages arriving on the connection can be
+   *attributed to the uid without looking the key up again, 0 otherwise.
+   **/
+  virtual uint32_t authenticateConnection(const std::string &pub_key,
+                                          std::string &uid) = 0;
+
+  /**
+   * Will return true if the token returned by authenticateConnection has not
+   *been revoked since.
+   **/
+  virtual bool isConnectionValid(uint32_t token) const noexcept = 0;
 };
 
 } // namespace SDMS
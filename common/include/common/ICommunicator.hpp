@@ -45,6 +45,19 @@ public:
    **/
   virtual Response receive(const MessageType) = 0;
 
+  /**
+   * Receive a message only if one is already waiting, returns a time out
+   * response immediately otherwise.
+   **/
+  virtual Response tryReceive(const MessageType) = 0;
+
+  /**
+   * A file descriptor that becomes readable when a message arrives, so the
+   * communicator can be waited on along with other sources, or -1 if there is
+   * none. Only messages arriving after tryReceive has timed out are signaled.
+   **/
+  virtual int fileDescriptor() const noexcept { return -1; }
+
   virtual const std::string id() const noexcept = 0;
   virtual const std::string address() const noexcept = 0;
 
@@ -46,6 +46,11 @@ const std::string PROTO_ID = "proto_id";
 const std::string MSG_ID = "msg_id";
 const std::string MSG_TYPE = "msg_type";
 const std::string CONTEXT = "context";
+/// Highest wire envelope version the peer that sent the message understands
+const std::string WIRE_VERSION = "wire_version";
+/// Token the ZAP handler stamped on the connection the message arrived on, 0
+/// if the connection was not given one
+const std::string CONNECTION_TOKEN = "connection_token";
 } // namespace google
 } // namespace message
 } // namespace constants
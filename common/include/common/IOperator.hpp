@@ -13,6 +13,8 @@ class IOperator {
 public:
   virtual OperatorType type() const noexcept = 0;
   virtual void execute(IMessage &message) = 0;
+
+  virtual ~IOperator(){};
 };
 
 } // namespace SDMS
@@ -0,0 +1,117 @@
+#ifndef JSON_PROTO_MAPPER_HPP
+#define JSON_PROTO_MAPPER_HPP
+#pragma once
+
+// Local public includes
+#include "libjson.hpp"
+
+// Third party includes
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/message.h>
+
+// Standard includes
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace SDMS {
+
+/**
+ * Fills protobuf messages from JSON objects through a field table built once
+ * per message type from its descriptor.
+ *
+ * Every field is read from the JSON key of the same name unless mapped to
+ * another key. The table is kept sorted by key, as are the members of a
+ * libjson object, so a message is filled in a single merge of the two with
+ * no lookups by key. Keys without a field are ignored and null values leave
+ * their field unset. A required field that is still unset once the object is
+ * read is reported as a missing key.
+ *
+ * Numeric and enum fields take JSON numbers, or booleans as 0 and 1, boolean
+ * fields take booleans or numbers and string fields take strings, or JSON
+ * text when given an object or array. Message fields take objects, repeated
+ * fields arrays of the above.
+ *
+ * Mappers are configured when built and immutable afterwards, so one mapper
+ * may fill messages from any number of threads. They fill generated messages,
+ * whose reflection is looked up once with the table. Setting fields through
+ * reflection costs more than the generated setters hand-written translators
+ * call, see benchmark_JsonProtoMapper.
+ **/
+class JsonProtoMapper {
+public:
+  /// Fills a key the table cannot express, given the message, the value of
+  /// the key and the object holding it
+  typedef std::function<void(google::protobuf::Message &,
+                             const libjson::Value &,
+                             const libjson::Value::Object &)>
+      Handler;
+
+  explicit JsonProtoMapper(const google::protobuf::Descriptor *a_descriptor);
+
+  /// Shared mapper that reads every field from the key of its name
+  static const JsonProtoMapper &
+  forType(const google::protobuf::Descriptor *a_descriptor);
+
+  /// Reads a_field from a_key rather than from the key of its name
+  JsonProtoMapper &key(const std::string &a_key, const std::string &a_field);
+
+  /// Fills message field a_field with a_mapper, which must outlive this one
+  JsonProtoMapper &nested(const std::string &a_field,
+                          const JsonProtoMapper &a_mapper);
+
+  /// Hands a_key to a_handler, in place of any field read from it
+  JsonProtoMapper &handle(const std::string &a_key, Handler a_handler);
+
+  const google::protobuf::Descriptor *descriptor() const {
+    return m_descriptor;
+  }
+
+  /// Fills a_message, which must be of this mapper's type, from a_object
+  void fill(google::protobuf::Message &a_message,
+            const libjson::Value::Object &a_object) const;
+
+private:
+  struct Entry {
+    std::string key;
+    const google::protobuf::FieldDescriptor *field;
+    const JsonProtoMapper *nested;
+    Handler handler;
+    uint64_t required; ///< Bit of a required field, 0 for optional ones
+  };
+
+  struct Required {
+    const google::protobuf::FieldDescriptor *field;
+    std::string key;
+  };
+
+  /// Table without nested mappers, linked by forType
+  JsonProtoMapper(const google::protobuf::Descriptor *a_descriptor,
+                  bool a_link);
+
+  std::vector<Entry>::iterator find(const std::string &a_key);
+  Entry &insert(const std::string &a_key);
+  void erase(const google::protobuf::FieldDescriptor *a_field);
+
+  void setField(google::protobuf::Message &a_message,
+                const google::protobuf::Reflection &a_reflection,
+                const Entry &a_entry, const libjson::Value &a_value) const;
+  void setScalar(google::protobuf::Message &a_message,
+                 const google::protobuf::Reflection &a_reflection,
+                 const Entry &a_entry, const libjson::Value &a_value) const;
+  void addScalar(google::protobuf::Message &a_message,
+                 const google::protobuf::Reflection &a_reflection,
+                 const Entry &a_entry, const libjson::Value &a_value) const;
+
+  const google::protobuf::Descriptor *m_descriptor;
+  const google::protobuf::Reflection *m_reflection;
+  std::vector<Entry> m_entries; ///< Sorted by key
+  std::vector<Required> m_required;
+  /// Bits of the required fields, all set when a field has no bit
+  uint64_t m_required_mask;
+};
+
+} // namespace SDMS
+
+#endif // JSON_PROTO_MAPPER_HPP
@@ -0,0 +1,40 @@
+#ifndef JSON_SCANNER_HPP
+#define JSON_SCANNER_HPP
+#pragma once
+
+// Standard includes
+#include <string>
+#include <vector>
+
+namespace libjson {
+namespace scan {
+
+/**
+ * Structural scanning used by the libjson parser to skip over runs of
+ * whitespace and string content.
+ *
+ * The kernel is picked once from the CPU: AVX2 or SSE2 on x86-64, NEON on
+ * ARM64 and a portable byte loop everywhere else. Kernels read NUL terminated
+ * input in aligned blocks, so they may look at bytes past the terminator but
+ * never past the block, and so the page, that holds it.
+ **/
+
+/// First '"', '\\' or control character, NUL included, at or after a_c
+const char *stringEnd(const char *a_c);
+
+/// First character at or after a_c that is not JSON whitespace
+const char *skipWhitespace(const char *a_c);
+
+/// Name of the kernel in use
+const char *kernel();
+
+/// Kernels this CPU can run, best first
+std::vector<std::string> kernels();
+
+/// Switches to a kernel by name, false if this CPU cannot run it
+bool useKernel(const std::string &a_name);
+
+} // namespace scan
+} // namespace libjson
+
+#endif // JSON_SCANNER_HPP
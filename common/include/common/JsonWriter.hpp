@@ -0,0 +1,85 @@
+#ifndef JSON_WRITER_HPP
+#define JSON_WRITER_HPP
+#pragma once
+
+// Standard includes
+#include <charconv>
+#include <cstddef>
+#include <string>
+#include <type_traits>
+
+namespace libjson {
+
+/// Appends a_value to a_buffer with '"', '\\' and control characters escaped,
+/// the latter as \u00XX. Other bytes, UTF-8 included, are copied unchanged.
+void escape(std::string &a_buffer, const std::string &a_value);
+
+/// As above for a_size bytes at a_value, which must be NUL terminated
+void escape(std::string &a_buffer, const char *a_value, size_t a_size);
+
+/**
+ * Writes a JSON document straight into one growable buffer.
+ *
+ * Strings are escaped into the buffer as they are written and separators are
+ * placed by the writer, so a document is built without temporary strings.
+ * The buffer is borrowed from the calling thread when the writer is made and
+ * handed back when it is destroyed, keeping its capacity for the next
+ * document written on the thread. Writers may nest, a writer made while
+ * another is live on the same thread starts with a buffer of its own.
+ *
+ * Structure is not checked, callers pair keys with values and close what
+ * they open.
+ **/
+class Writer {
+public:
+  Writer();
+  ~Writer();
+
+  Writer(const Writer &) = delete;
+  Writer &operator=(const Writer &) = delete;
+
+  Writer &beginObject();
+  Writer &endObject();
+  Writer &beginArray();
+  Writer &endArray();
+
+  Writer &key(const char *a_key);
+  Writer &key(const std::string &a_key);
+
+  Writer &string(const std::string &a_value);
+  Writer &string(const char *a_value);
+  Writer &number(double a_value);
+  Writer &boolean(bool a_value);
+  Writer &null();
+
+  template <typename T>
+  typename std::enable_if<std::is_integral<T>::value, Writer &>::type
+  number(T a_value) {
+    char digits[24];
+    separate();
+    char *end = std::to_chars(digits, digits + sizeof(digits), a_value).ptr;
+    m_buffer.append(digits, end);
+    return *this;
+  }
+
+  /// Writes a_json, which must already be valid JSON, as the next value
+  Writer &raw(const std::string &a_json);
+
+  /// The document written so far
+  const std::string &str() const { return m_buffer; }
+
+private:
+  /// Writes the comma owed before a value or key
+  void separate() {
+    if (m_comma)
+      m_buffer.push_back(',');
+    m_comma = true;
+  }
+
+  std::string m_buffer;
+  bool m_comma;
+};
+
+} // namespace libjson
+
+#endif // JSON_WRITER_HPP
@@ -14,6 +14,12 @@ class MessageFactory {
 public:
   std::unique_ptr<IMessage> create(const MessageType) const;
 
+  /**
+   * Creates a message to receive into. It has no correlation id until the
+   * one sent with it is read.
+   **/
+  std::unique_ptr<IMessage> createReceived(const MessageType) const;
+
   /**
    * Will create a Mesage envelope without the payload but containing the
    * routes so we know who to send the message too. This is meant to
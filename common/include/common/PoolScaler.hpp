@@ -0,0 +1,59 @@
+#ifndef POOL_SCALER_HPP
+#define POOL_SCALER_HPP
+#pragma once
+
+// Standard includes
+#include <chrono>
+#include <cstddef>
+
+namespace SDMS {
+
+/**
+ * Decides how many workers a pool should have from samples of its load.
+ *
+ * Each sample reports the fraction of the pool's capacity in use and how
+ * long the oldest queued item has been waiting. The pool grows by one worker
+ * once grow_after consecutive samples found it busy with work waiting, and
+ * shrinks by one once shrink_after consecutive samples found it mostly idle
+ * and the remaining workers would not be busy enough to grow again. The gap
+ * between the thresholds and the sample counts keep the pool from flapping,
+ * every resize starts both counts over.
+ *
+ * Not thread safe, sampled by the thread that owns the pool.
+ **/
+class PoolScaler {
+public:
+  struct Options {
+    size_t min_workers = 1;
+    size_t max_workers = 1;
+    /// Busy ratio at or above which waiting work makes the pool grow
+    double grow_busy_ratio = 0.85;
+    /// Queue wait at or above which a busy pool grows
+    std::chrono::milliseconds grow_queue_wait = std::chrono::milliseconds(100);
+    /// Busy ratio at or below which an idle pool shrinks
+    double shrink_busy_ratio = 0.4;
+    size_t grow_after = 3;
+    size_t shrink_after = 60;
+  };
+
+  explicit PoolScaler(const Options &options);
+
+  /**
+   * Records a sample of a pool of the given size and returns the size it
+   * should have, which is within the bounds and at most one worker away from
+   * the current size unless that was out of bounds.
+   **/
+  size_t sample(size_t workers, double busy_ratio,
+                std::chrono::steady_clock::duration queue_wait);
+
+  const Options &options() const { return m_options; }
+
+private:
+  Options m_options;
+  size_t m_hot_samples = 0;
+  size_t m_cold_samples = 0;
+};
+
+} // namespace SDMS
+
+#endif // POOL_SCALER_HPP
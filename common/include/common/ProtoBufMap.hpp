@@ -10,34 +10,40 @@
 #include <google/protobuf/message.h>
 
 // Standard includes
-#include <map>
-#include <unordered_map>
+#include <cstdint>
+#include <string>
 
 namespace SDMS {
 
+/**
+ * Maps protobuf message descriptors to the 16 bit message types sent on the
+ * wire, the protocol ID is the upper 8 bits and the index of the message in
+ * its proto file the lower 8 bits.
+ *
+ * The mapping itself is built once, the first time a ProtoBufMap is
+ * constructed, and is never modified afterwards. Every instance refers to
+ * that same registry, so constructing one is cheap and lookups from any
+ * thread need no locking.
+ **/
 class ProtoBufMap : public IMessageMapper {
 public:
-  typedef std::map<uint8_t, const ::google::protobuf::FileDescriptor *>
-      FileDescriptorMap;
-  typedef std::map<uint16_t, const ::google::protobuf::Descriptor *>
-      DescriptorMap;
-  typedef std::map<const ::google::protobuf::Descriptor *, uint16_t> MsgTypeMap;
+  struct Registry;
 
 private:
-  FileDescriptorMap m_file_descriptor_map;
-  DescriptorMap m_descriptor_map;
-  MsgTypeMap m_msg_type_map;
-  std::unordered_map<MessageProtocol, uint16_t> m_protocol_ids;
+  const Registry &m_registry;
+
+  static const Registry &registry();
 
 public:
   ProtoBufMap();
 
   const ::google::protobuf::Descriptor *
   getDescriptorType(uint16_t message_type) const;
-  bool exists(uint16_t message_type) const {
-    return m_descriptor_map.count(message_type) > 0;
-  }
-  uint16_t getMessageType(::google::protobuf::Message &);
+  /// Default instance of the message type, use New() to create messages
+  const ::google::protobuf::Message *
+  getPrototype(uint16_t message_type) const;
+  bool exists(uint16_t message_type) const noexcept;
+  uint16_t getMessageType(const ::google::protobuf::Message &) const;
   std::string toString(uint16_t MessageType) const;
   virtual uint16_t getMessageType(uint8_t a_proto_id,
                                   const std::string &a_message_name) final;
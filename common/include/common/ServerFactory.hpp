@@ -4,9 +4,14 @@
 
 // Local public includes
 #include "DynaLog.hpp"
+#include "PoolScaler.hpp"
 #include "SocketOptions.hpp"
 
 // Standard includes
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <unordered_map>
 #include <vector>
@@ -24,7 +29,48 @@ enum class SocketRole { CLIENT, SERVER, MONITOR, CONTROL };
  * any hanldes hence there is no need to specify the PROTOCOL. The others
  * use convenience objects provided by zmq and are thus technology specific.
  **/
-enum class ServerType { PROXY_CUSTOM, PROXY_BASIC_ZMQ, ROUTER_ZMQ };
+enum class ServerType {
+  PROXY_CUSTOM,
+  PROXY_BASIC_ZMQ,
+  ROUTER_ZMQ,
+  PROXY_LANES
+};
+
+/// Scheduling class of a request, lanes are served in this order
+enum class RequestLane : uint8_t { CHEAP = 0, NORMAL = 1, BULK = 2 };
+
+/**
+ * Options of the PROXY_LANES server.
+ *
+ * The CLIENT socket options are a template, the proxy creates one channel per
+ * worker whose host is the template host followed by "_1" to "_N". Requests
+ * are queued by lane and handed to whichever worker has room for them, so no
+ * request waits behind a slow one while another worker has nothing to do.
+ *
+ * When start_worker and stop_worker are both set the pool is resized between
+ * scaling.min_workers and scaling.max_workers by a PoolScaler sampling it
+ * every scale_period, starting from number_of_workers, which the caller has
+ * already started. Channels are created for the largest pool, the callbacks
+ * run on the proxy thread and BULK requests keep the same share of the pool.
+ **/
+struct LaneOptions {
+  size_t number_of_workers = 1;
+  /// Most workers' worth of BULK requests that may run at the same time
+  size_t max_bulk_workers = 1;
+  /// Requests a worker is given before it has replied to any of them
+  size_t requests_per_worker = 1;
+  /// Lane of each message type, types that are not listed are NORMAL
+  std::unordered_map<uint16_t, RequestLane> lanes;
+  /// A worker with a request running for this long is given no more work
+  /// until it replies to that request
+  std::chrono::seconds stale_after = std::chrono::seconds(300);
+  PoolScaler::Options scaling;
+  std::chrono::milliseconds scale_period = std::chrono::milliseconds(1000);
+  /// Starts the worker of a channel, numbered from 0
+  std::function<void(size_t worker)> start_worker;
+  /// Stops a deactivated worker once it has replied to all its requests
+  std::function<void(size_t worker)> stop_worker;
+};
 
 class ServerFactory {
   LogContext m_log_context;
@@ -42,6 +88,12 @@ public:
       const std::unordered_map<SocketRole, SocketOptions> &socket_options,
       const std::unordered_map<SocketRole, ICredentials *> &socket_credentials,
       std::vector<std::unique_ptr<IOperator>> incoming_operators);
+
+  std::unique_ptr<IServer> create(
+      ServerType server_type,
+      const std::unordered_map<SocketRole, SocketOptions> &socket_options,
+      const std::unordered_map<SocketRole, ICredentials *> &socket_credentials,
+      const LaneOptions &lane_options);
 };
 
 } // namespace SDMS
@@ -59,6 +59,9 @@ public:
  * host and port represent the host and port the socket is connecting to
  * local_id is an optional identity which defines the machine/process/thread the
  * connections are being made from.
+ * heartbeat_interval is an optional interval in milliseconds at which
+ * heartbeats are exchanged with the peer so that dead connections are detected
+ * and re-established on long-lived sockets.
  **/
 struct SocketOptions {
   URIScheme scheme = URIScheme::INPROC;
@@ -74,6 +77,7 @@ struct SocketOptions {
   std::string host = "";
   std::optional<uint16_t> port;
   std::optional<std::string> local_id;
+  std::optional<uint32_t> heartbeat_interval;
 };
 
 } // namespace SDMS
@@ -0,0 +1,66 @@
+#ifndef ZAP_HANDLER_HPP
+#define ZAP_HANDLER_HPP
+#pragma once
+
+// Local public includes
+#include "DynaLog.hpp"
+#include "IAuthenticationManager.hpp"
+
+// Standard includes
+#include <string>
+#include <vector>
+
+namespace SDMS {
+
+namespace constants {
+namespace zap {
+/// Endpoint libzmq sends authentication requests to, fixed by RFC 27
+const std::string ENDPOINT = "inproc://zeromq.zap.01";
+/// Connection metadata property holding the authenticateConnection token
+const std::string TOKEN_PROPERTY = "DataFed-Token";
+} // namespace zap
+} // namespace constants
+
+/**
+ * ZeroMQ Authentication Protocol (ZAP) handler
+ *
+ * libzmq asks the handler to approve every CURVE handshake made with a server
+ * socket of the shared context. The client public key is resolved once, by
+ * the authentication manager, and the result is stamped on the connection as
+ * the "User-Id" and "DataFed-Token" metadata properties. Both are available
+ * on every message received over the connection with zmq_msg_gets, so
+ * authenticating a message does not require looking its key up again.
+ *
+ * Every connection is accepted, connections with unknown keys are anonymous
+ * and can still authenticate with a password or token.
+ **/
+class ZapHandler {
+public:
+  /**
+   * Binds the handler endpoint, this must happen before any CURVE server
+   * socket is bound otherwise libzmq will not consult the handler.
+   **/
+  ZapHandler(IAuthenticationManager &auth_manager, LogContext log_context);
+  ~ZapHandler();
+
+  ZapHandler(const ZapHandler &) = delete;
+  ZapHandler &operator=(const ZapHandler &) = delete;
+
+  /// Answers authentication requests until the context is terminated
+  void run();
+
+private:
+  bool receive(std::vector<std::string> &request);
+  void reply(const std::string &request_id, const std::string &status_code,
+             const std::string &status_text, const std::string &user_id,
+             const std::string &metadata);
+  void handle(const std::vector<std::string> &request);
+
+  IAuthenticationManager &m_auth_manager;
+  LogContext m_log_context;
+  void *m_zmq_socket = nullptr;
+};
+
+} // namespace SDMS
+
+#endif // ZAP_HANDLER_HPP
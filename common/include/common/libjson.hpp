@@ -1,18 +1,24 @@
 #ifndef LIBJSON_HPP
 #define LIBJSON_HPP
 
+#include "JsonScanner.hpp"
 #include "TraceException.hpp"
 #include "fpconv.h"
+#include <algorithm>
+#include <cstddef>
 #include <cstdlib>
-#include <map>
 #include <math.h>
+#include <new>
 #include <stdint.h>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 namespace libjson {
 
 class Value;
+class Reader;
 
 class ParseError //: public std::exception
 {
@@ -32,6 +38,7 @@ private:
   size_t m_pos;
 
   friend class Value;
+  friend class Reader;
 };
 
 #define ERR_INVALID_CHAR(p) throw ParseError("Invalid character", (size_t)p)
@@ -49,10 +56,81 @@ private:
 #define ERR_INVALID_UNICODE(p)                                                 \
   throw ParseError("Invalid unicode escape sequence", (size_t)p)
 
+/**
+ * @class Arena
+ * @brief Bump allocator for the values of a single parsed document
+ *
+ * Used by Value::fromString in arena mode and owned by the root value of the
+ * document, whose object or array is the first allocation of the arena. Only
+ * the Object, Array and String of each value are placed in the arena, their
+ * own buffers stay on the heap, so short strings cost no allocation at all.
+ */
+class alignas(std::max_align_t) Arena {
+public:
+  static Arena *create(size_t a_block_size = 4096) {
+    return new (::operator new(a_block_size)) Arena(a_block_size);
+  }
+
+  static void destroy(Arena *a_arena) {
+    a_arena->~Arena();
+    ::operator delete(a_arena);
+  }
+
+  /// Arena whose first allocation is at a_first
+  static Arena *ownerOf(void *a_first) {
+    return reinterpret_cast<Arena *>(static_cast<char *>(a_first) -
+                                     sizeof(Arena));
+  }
+
+  void *allocate(size_t a_size) {
+    a_size = (a_size + ALIGN - 1) & ~(ALIGN - 1);
+    if (a_size > (size_t)(m_end - m_next))
+      grow(a_size);
+
+    void *memory = m_next;
+    m_next += a_size;
+    return memory;
+  }
+
+private:
+  static constexpr size_t ALIGN = alignof(std::max_align_t);
+  static constexpr size_t MAX_BLOCK_SIZE = 65536;
+
+  explicit Arena(size_t a_block_size)
+      : m_next(reinterpret_cast<char *>(this + 1)),
+        m_end(reinterpret_cast<char *>(this) + a_block_size), m_blocks(0),
+        m_block_size(a_block_size) {}
+
+  ~Arena() {
+    while (m_blocks) {
+      char *next = *reinterpret_cast<char **>(m_blocks);
+      ::operator delete(m_blocks);
+      m_blocks = next;
+    }
+  }
+
+  /// Chains a new block, each twice the size of the last up to a limit
+  void grow(size_t a_size) {
+    m_block_size = std::min(m_block_size * 2, MAX_BLOCK_SIZE);
+    size_t size = std::max(m_block_size, a_size + ALIGN);
+    char *block = static_cast<char *>(::operator new(size));
+    *reinterpret_cast<char **>(block) = m_blocks;
+    m_blocks = block;
+    m_next = block + ALIGN;
+    m_end = block + size;
+  }
+
+  char *m_next;
+  char *m_end;
+  char *m_blocks; ///< Blocks after the first, each linked to the previous one
+  size_t m_block_size;
+};
+
 class Value {
 public:
-  typedef std::map<std::string, Value>::iterator ObjectIter;
-  typedef std::map<std::string, Value>::const_iterator ObjectConstIter;
+  typedef std::pair<std::string, Value> Member;
+  typedef std::vector<Member>::iterator ObjectIter;
+  typedef std::vector<Member>::const_iterator ObjectConstIter;
   typedef std::vector<Value> Array;
   typedef std::string String;
   typedef std::vector<Value>::iterator ArrayIter;
@@ -70,6 +148,11 @@ public:
   /**
    * @class Object
    * @brief Provides a wrapper around underlying map to provide helper methods
+   *
+   * Members are kept in a vector sorted by key, so an object takes a single
+   * allocation and keys are found by binary search. Adding or erasing a
+   * member invalidates iterators, references to members and the member
+   * selected by has().
    */
   class Object {
   public:
@@ -77,7 +160,7 @@ public:
 
     ~Object() {}
 
-    inline size_t size() { return m_map.size(); }
+    inline size_t size() const { return m_map.size(); }
 
     inline void clear() {
       m_map.clear();
@@ -88,7 +171,7 @@ public:
     // specific type
 
     Value &getValue(const std::string &a_key) {
-      ObjectIter iter = m_map.find(a_key);
+      ObjectIter iter = find(a_key);
 
       if (iter == m_map.end())
         EXCEPT_PARAM(1, "Key not found: " << a_key);
@@ -97,7 +180,7 @@ public:
     }
 
     const Value &getValue(const std::string &a_key) const {
-      ObjectConstIter iter = m_map.find(a_key);
+      ObjectConstIter iter = find(a_key);
 
       if (iter == m_map.end())
         EXCEPT_PARAM(1, "Key not found: " << a_key);
@@ -106,7 +189,7 @@ public:
     }
 
     Object &getObject(const std::string &a_key) {
-      ObjectIter iter = m_map.find(a_key);
+      ObjectIter iter = find(a_key);
 
       if (iter == m_map.end())
         EXCEPT_PARAM(1, "Key not found: " << a_key);
@@ -120,7 +203,7 @@ public:
     }
 
     const Object &getObject(const std::string &a_key) const {
-      ObjectConstIter iter = m_map.find(a_key);
+      ObjectConstIter iter = find(a_key);
 
       if (iter == m_map.end())
         EXCEPT_PARAM(1, "Key not found: " << a_key);
@@ -134,7 +217,7 @@ public:
     }
 
     Array &getArray(const std::string &a_key) {
-      ObjectIter iter = m_map.find(a_key);
+      ObjectIter iter = find(a_key);
 
       if (iter == m_map.end())
         EXCEPT_PARAM(1, "Key not found: " << a_key);
@@ -148,7 +231,7 @@ public:
     }
 
     const Array &getArray(const std::string &a_key) const {
-      ObjectConstIter iter = m_map.find(a_key);
+      ObjectConstIter iter = find(a_key);
 
       if (iter == m_map.end())
         EXCEPT_PARAM(1, "Key not found: " << a_key);
@@ -162,7 +245,7 @@ public:
     }
 
     bool getBool(const std::string &a_key) const {
-      ObjectConstIter iter = m_map.find(a_key);
+      ObjectConstIter iter = find(a_key);
 
       if (iter == m_map.end())
         EXCEPT_PARAM(1, "Key not found: " << a_key);
@@ -178,7 +261,7 @@ public:
     }
 
     double getNumber(const std::string &a_key) const {
-      ObjectConstIter iter = m_map.find(a_key);
+      ObjectConstIter iter = find(a_key);
 
       if (iter == m_map.end())
         EXCEPT_PARAM(1, "Key not found: " << a_key);
@@ -194,7 +277,7 @@ public:
     }
 
     const std::string &getString(const std::string &a_key) const {
-      ObjectConstIter iter = m_map.find(a_key);
+      ObjectConstIter iter = find(a_key);
 
       if (iter == m_map.end())
         EXCEPT_PARAM(1, "Key not found: " << a_key);
@@ -208,7 +291,7 @@ public:
     }
 
     std::string &getString(const std::string &a_key) {
-      ObjectIter iter = m_map.find(a_key);
+      ObjectIter iter = find(a_key);
 
       if (iter == m_map.end())
         EXCEPT_PARAM(1, "Key not found: " << a_key);
@@ -224,7 +307,7 @@ public:
     // Checks if key is present, sets internal iterator to entry
 
     inline bool has(const std::string &a_key) const {
-      return (m_iter = m_map.find(a_key)) != m_map.end();
+      return (m_iter = find(a_key)) != m_map.end();
     }
 
     // The following methods can be called after has() (sets internal iterator
@@ -347,11 +430,20 @@ public:
     // The following methods provide a lower-level map-like interface
 
     inline ObjectIter find(const std::string &a_key) {
-      return m_map.find(a_key);
+      ObjectIter iter = lowerBound(a_key);
+      if (iter != m_map.end() && iter->first == a_key)
+        return iter;
+
+      return m_map.end();
     }
 
     inline ObjectConstIter find(const std::string &a_key) const {
-      return m_map.find(a_key);
+      ObjectConstIter iter =
+          std::lower_bound(m_map.begin(), m_map.end(), a_key, keyLess);
+      if (iter != m_map.end() && iter->first == a_key)
+        return iter;
+
+      return m_map.end();
     }
 
     inline ObjectIter begin() { return m_map.begin(); }
@@ -362,10 +454,18 @@ public:
 
     inline ObjectConstIter end() const { return m_map.end(); }
 
-    Value &operator[](const std::string &a_key) { return m_map[a_key]; }
+    Value &operator[](const std::string &a_key) {
+      ObjectIter iter = lowerBound(a_key);
+      if (iter == m_map.end() || iter->first != a_key) {
+        iter = m_map.emplace(iter, a_key, Value());
+        m_iter = m_map.end();
+      }
+
+      return iter->second;
+    }
 
     Value &at(const std::string &a_key) {
-      ObjectIter iter = m_map.find(a_key);
+      ObjectIter iter = find(a_key);
       if (iter != m_map.end())
         return iter->second;
 
@@ -373,44 +473,96 @@ public:
     }
 
     const Value &at(const std::string &a_key) const {
-      ObjectConstIter iter = m_map.find(a_key);
+      ObjectConstIter iter = find(a_key);
       if (iter != m_map.end())
         return iter->second;
 
       EXCEPT_PARAM(1, "Key " << a_key << " not present");
     }
 
-    void erase(const std::string &a_key) { m_map.erase(a_key); }
+    void erase(const std::string &a_key) {
+      ObjectIter iter = find(a_key);
+      if (iter != m_map.end())
+        m_map.erase(iter);
+
+      m_iter = m_map.end();
+    }
 
   private:
-    std::map<std::string, Value> m_map;
+    static bool keyLess(const Member &a_member, const std::string &a_key) {
+      return a_member.first < a_key;
+    }
+
+    inline ObjectIter lowerBound(const std::string &a_key) {
+      return std::lower_bound(m_map.begin(), m_map.end(), a_key, keyLess);
+    }
+
+    /**
+     * Sorts the members appended by the parser. Their order is sorted first,
+     * members are costly to move, with ties broken by position so a repeated
+     * key keeps the value parsed last, as assigning each member in turn would.
+     */
+    void sortParsed() {
+      std::vector<uint32_t> order(m_map.size());
+      for (uint32_t i = 0; i < order.size(); i++)
+        order[i] = i;
+
+      std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+        int cmp = m_map[a].first.compare(m_map[b].first);
+        return cmp < 0 || (cmp == 0 && a < b);
+      });
+
+      std::vector<Member> sorted;
+      sorted.reserve(order.size());
+      for (size_t i = 0; i < order.size(); i++) {
+        if (i + 1 < order.size() &&
+            m_map[order[i + 1]].first == m_map[order[i]].first)
+          continue;
+        sorted.push_back(std::move(m_map[order[i]]));
+      }
+      m_map.swap(sorted);
+      m_iter = m_map.end();
+    }
+
+    std::vector<Member> m_map;
     mutable ObjectConstIter m_iter;
+
+    friend class Value;
   };
 
-  Value() : m_type(VT_NULL), m_value({0}) {}
+  Value() : m_type(VT_NULL), m_alloc(AL_HEAP), m_value({0}) {}
 
-  Value(bool a_value) : m_type(VT_BOOL) { m_value.b = a_value; }
+  Value(bool a_value) : m_type(VT_BOOL), m_alloc(AL_HEAP) {
+    m_value.b = a_value;
+  }
 
-  Value(double a_value) : m_type(VT_NUMBER) { m_value.n = a_value; }
+  Value(double a_value) : m_type(VT_NUMBER), m_alloc(AL_HEAP) {
+    m_value.n = a_value;
+  }
 
-  Value(int a_value) : m_type(VT_NUMBER) { m_value.n = a_value; }
+  Value(int a_value) : m_type(VT_NUMBER), m_alloc(AL_HEAP) {
+    m_value.n = a_value;
+  }
 
-  Value(const std::string &a_value) : m_type(VT_STRING) {
+  Value(const std::string &a_value) : m_type(VT_STRING), m_alloc(AL_HEAP) {
     m_value.s = new String(a_value);
   }
 
-  Value(const char *a_value) : m_type(VT_STRING) {
+  Value(const char *a_value) : m_type(VT_STRING), m_alloc(AL_HEAP) {
     m_value.s = new String(a_value);
   }
 
   Value(const Value &a_source) = delete;
 
-  Value(Value &&a_source) : m_type(a_source.m_type), m_value(a_source.m_value) {
+  Value(Value &&a_source)
+      : m_type(a_source.m_type), m_alloc(a_source.m_alloc),
+        m_value(a_source.m_value) {
     a_source.m_type = VT_NULL;
+    a_source.m_alloc = AL_HEAP;
     a_source.m_value.o = 0;
   }
 
-  Value(ValueType a_type) : m_type(a_type) {
+  Value(ValueType a_type) : m_type(a_type), m_alloc(AL_HEAP) {
     if (m_type == VT_OBJECT) {
       m_value.o = new Object();
     } else if (m_type == VT_ARRAY) {
@@ -422,52 +574,34 @@ public:
     }
   }
 
-  ~Value() {
-    if (m_type == VT_STRING)
-      delete m_value.s;
-    else if (m_type == VT_OBJECT)
-      delete m_value.o;
-    else if (m_type == VT_ARRAY)
-      delete m_value.a;
-  }
+  ~Value() { release(); }
 
   Value &operator=(Value &&a_source) {
     if (this != &a_source) {
       ValueType type = a_source.m_type;
+      Allocation alloc = a_source.m_alloc;
       ValueUnion value = a_source.m_value;
 
       a_source.m_type = VT_NULL;
+      a_source.m_alloc = AL_HEAP;
       a_source.m_value.o = 0;
 
-      this->~Value();
+      release();
 
       m_type = type;
+      m_alloc = alloc;
       m_value = value;
     }
 
     return *this;
   }
 
-  Value &operator=(Value &a_source) {
-    if (this != &a_source) {
-      ValueType type = a_source.m_type;
-      ValueUnion value = a_source.m_value;
-
-      a_source.m_type = VT_NULL;
-      a_source.m_value.o = 0;
-
-      this->~Value();
-
-      m_type = type;
-      m_value = value;
-    }
-
-    return *this;
-  }
+  /// Values are moved, never copied, so the source of a move is explicit
+  Value &operator=(const Value &a_source) = delete;
 
   Value &operator=(bool a_value) {
     if (m_type != VT_BOOL) {
-      this->~Value();
+      release();
       m_type = VT_BOOL;
       m_value.o = 0;
     }
@@ -479,7 +613,7 @@ public:
 
   Value &operator=(double a_value) {
     if (m_type != VT_NUMBER) {
-      this->~Value();
+      release();
       m_type = VT_NUMBER;
       m_value.o = 0;
     }
@@ -491,7 +625,7 @@ public:
 
   Value &operator=(int a_value) {
     if (m_type != VT_NUMBER) {
-      this->~Value();
+      release();
       m_type = VT_NUMBER;
       m_value.o = 0;
     }
@@ -503,7 +637,7 @@ public:
 
   Value &operator=(size_t a_value) {
     if (m_type != VT_NUMBER) {
-      this->~Value();
+      release();
       m_type = VT_NUMBER;
       m_value.o = 0;
     }
@@ -515,7 +649,7 @@ public:
 
   Value &operator=(const std::string &a_value) {
     if (m_type != VT_STRING) {
-      this->~Value();
+      release();
       m_type = VT_STRING;
       m_value.s = new String(a_value);
     }
@@ -527,7 +661,7 @@ public:
 
   Value &operator=(const char *a_value) {
     if (m_type != VT_STRING) {
-      this->~Value();
+      release();
       m_type = VT_STRING;
       m_value.s = new String(a_value);
     }
@@ -580,7 +714,7 @@ public:
                                              << " value to boolean");
   }
 
-  static bool asBool(const std::map<std::string, Value>::const_iterator &iter) {
+  static bool asBool(const ObjectConstIter &iter) {
     const Value &val = iter->second;
 
     if (val.m_type == VT_BOOL)
@@ -620,7 +754,7 @@ public:
   }
 
   static std::string &
-  asString(const std::map<std::string, Value>::const_iterator &iter) {
+  asString(const ObjectConstIter &iter) {
     const Value &val = iter->second;
 
     if (val.m_type == VT_STRING)
@@ -632,7 +766,7 @@ public:
   }
 
   static const std::string &
-  asStringConst(const std::map<std::string, Value>::const_iterator &iter) {
+  asStringConst(const ObjectConstIter &iter) {
     const Value &val = iter->second;
 
     if (val.m_type == VT_STRING)
@@ -666,7 +800,7 @@ public:
   // ----- Object-only Methods -----
 
   Object &initObject() {
-    this->~Value();
+    release();
     m_type = VT_OBJECT;
     m_value.o = new Object();
 
@@ -690,7 +824,7 @@ public:
   // ----- Array-only Methods -----
 
   Array &initArray() {
-    this->~Value();
+    release();
     m_type = VT_ARRAY;
     m_value.a = new Array();
 
@@ -723,29 +857,39 @@ public:
     return buffer;
   }
 
-  inline void fromString(const std::string &a_raw_json) {
-    fromString(a_raw_json.c_str());
+  inline void fromString(const std::string &a_raw_json,
+                         bool a_use_arena = false) {
+    fromString(a_raw_json.c_str(), a_use_arena);
   }
 
-  void fromString(const char *a_raw_json) {
+  /**
+   * @brief Parse a JSON document into this value
+   *
+   * With a_use_arena the document is parsed into an Arena owned by this value,
+   * which saves most of the allocations of parsing and freeing it. Values
+   * moved out of such a document with std::move must not outlive it, moving
+   * this value moves the document and its arena.
+   */
+  void fromString(const char *a_raw_json, bool a_use_arena = false) {
     if (m_type != VT_NULL) {
-      this->~Value();
+      release();
       m_type = VT_NULL;
       m_value.o = 0;
     }
 
     const char *c = a_raw_json;
     uint8_t state = PS_SEEK_BEG;
+    Arena *arena = a_use_arena ? Arena::create() : 0;
 
     try {
-      while (*c) {
+      while (*(c = skipWS(c))) {
         switch (state) {
         case PS_SEEK_BEG:
           if (*c == '{') {
-            c = parseObject(*this, c + 1);
+            c = parseObject(*this, c + 1, arena);
             state = PS_SEEK_OBJ_END;
           } else if (*c == '[') {
-            c = parseArray(*this, c + 1);
+            c = parseArray(*this, c + 1, arena);
             state = PS_SEEK_ARR_END;
           } else if (notWS(*c))
             ERR_INVALID_CHAR(c);
@@ -772,18 +916,85 @@ public:
       }
     } catch (ParseError &e) {
       e.setOffset((size_t)a_raw_json);
+      adoptArena(arena);
+      throw;
+    } catch (...) {
+      adoptArena(arena);
       throw;
     }
+
+    adoptArena(arena);
   }
 
 private:
-  inline bool notWS(char c) const {
+  /// Where the object, array or string of a value was allocated
+  enum Allocation : uint8_t { AL_HEAP, AL_ARENA, AL_ARENA_ROOT };
+
+  /// Frees the object, array or string of the value before it is reassigned
+  void release() {
+    if (m_alloc == AL_HEAP) {
+      if (m_type == VT_STRING)
+        delete m_value.s;
+      else if (m_type == VT_OBJECT)
+        delete m_value.o;
+      else if (m_type == VT_ARRAY)
+        delete m_value.a;
+      return;
+    }
+
+    void *payload = 0;
+    if (m_type == VT_STRING) {
+      payload = m_value.s;
+      m_value.s->~String();
+    } else if (m_type == VT_OBJECT) {
+      payload = m_value.o;
+      m_value.o->~Object();
+    } else if (m_type == VT_ARRAY) {
+      payload = m_value.a;
+      m_value.a->~Array();
+    }
+
+    if (m_alloc == AL_ARENA_ROOT && payload)
+      Arena::destroy(Arena::ownerOf(payload));
+
+    m_alloc = AL_HEAP;
+  }
+
+  /// Allocates the object, array or string of a value being parsed
+  template <typename T> static T *allocate(Value &a_value, Arena *a_arena) {
+    if (a_arena == 0)
+      return new T();
+
+    a_value.m_alloc = AL_ARENA;
+    return new (a_arena->allocate(sizeof(T))) T();
+  }
+
+  /// Gives the root of a document the arena it was parsed into
+  void adoptArena(Arena *a_arena) {
+    if (a_arena == 0)
+      return;
+
+    // The arena is empty unless the root was its first allocation
+    if (m_alloc == AL_ARENA)
+      m_alloc = AL_ARENA_ROOT;
+    else
+      Arena::destroy(a_arena);
+  }
+
+  static inline bool notWS(char c) {
     return !(c == ' ' || c == '\n' || c == '\t' || c == '\r');
   }
 
-  inline bool isDigit(char c) const { return (c >= '0' && c <= '9'); }
+  /// Skips whitespace, runs longer than a separator a block at a time
+  static inline const char *skipWS(const char *c) {
+    if (notWS(*c) || notWS(*++c))
+      return c;
+    return scan::skipWhitespace(c);
+  }
+
+  static inline bool isDigit(char c) { return (c >= '0' && c <= '9'); }
 
-  uint8_t toHex(const char *C) {
+  static uint8_t toHex(const char *C) {
     char c = *C;
 
     if (c >= '0' && c <= '9')
@@ -814,6 +1025,7 @@ private:
   };
 
   ValueType m_type;
+  Allocation m_alloc;
 
   union ValueUnion {
     Object *o;
@@ -917,27 +1129,38 @@ private:
     a_buffer.resize(sz1 + sz2);
   }
 
-  const char *parseObject(Value &a_parent, const char *start) {
+  static const char *parseObject(Value &a_parent, const char *start,
+                                 Arena *a_arena) {
     // On function entry, c is next char after '{'
 
     uint8_t state = PS_SEEK_KEY;
     const char *c = start;
-    std::string key;
 
     a_parent.m_type = VT_OBJECT;
-    a_parent.m_value.o = new Object();
+    a_parent.m_value.o = allocate<Object>(a_parent, a_arena);
+    std::vector<Member> &members = a_parent.m_value.o->m_map;
+    members.reserve(8);
+    // Members are appended as parsed and sorted once the object is complete
+    bool sorted = true;
 
-    while (*c) {
+    while (*(c = skipWS(c))) {
       switch (state) {
       case PS_SEEK_KEY:
-        if (*c == '}')
+        if (*c == '}') {
+          a_parent.m_value.o->m_iter = members.end();
           return c;
-        else if (*c == '"') {
+        } else if (*c == '"') {
+          members.emplace_back();
+          std::string &key = members.back().first;
           c = parseString(key, c + 1);
 
           if (!key.size())
             ERR_INVALID_KEY(c);
 
+          if (sorted && members.size() > 1 &&
+              !(members[members.size() - 2].first < key))
+            sorted = false;
+
           state = PS_SEEK_SEP;
         } else if (notWS(*c))
           ERR_INVALID_CHAR(c);
@@ -950,7 +1173,7 @@ private:
         break;
       case PS_SEEK_VAL:
         if (notWS(*c)) {
-          c = parseValue((*a_parent.m_value.o)[key], c);
+          c = parseValue(members.back().second, c, a_arena);
           state = PS_SEEK_OBJ_END;
         }
         break;
@@ -958,9 +1181,13 @@ private:
       case PS_SEEK_OBJ_END:
         if (*c == ',')
           state = PS_SEEK_KEY;
-        else if (*c == '}')
+        else if (*c == '}') {
+          if (sorted)
+            a_parent.m_value.o->m_iter = members.end();
+          else
+            a_parent.m_value.o->sortParsed();
           return c;
-        else if (notWS(*c))
+        } else if (notWS(*c))
           ERR_INVALID_CHAR(c);
         break;
       }
@@ -971,23 +1198,24 @@ private:
     ERR_UNTERMINATED_OBJECT(start);
   }
 
-  const char *parseArray(Value &a_parent, const char *start) {
+  static const char *parseArray(Value &a_parent, const char *start,
+                                Arena *a_arena) {
     // On function entry, c is next char after '['
     const char *c = start;
     uint8_t state = PS_SEEK_VAL;
     Value value;
 
     a_parent.m_type = VT_ARRAY;
-    a_parent.m_value.a = new Array();
+    a_parent.m_value.a = allocate<Array>(a_parent, a_arena);
     a_parent.m_value.a->reserve(20);
 
-    while (*c) {
+    while (*(c = skipWS(c))) {
       switch (state) {
       case PS_SEEK_VAL:
         if (*c == ']')
           return c;
         else if (notWS(*c)) {
-          c = parseValue(value, c);
+          c = parseValue(value, c, a_arena);
           a_parent.m_value.a->push_back(std::move(value));
           state = PS_SEEK_SEP;
         }
@@ -1008,20 +1236,21 @@ private:
     ERR_UNTERMINATED_ARRAY(start);
   }
 
-  inline const char *parseValue(Value &a_value, const char *start) {
+  static inline const char *parseValue(Value &a_value, const char *start,
+                                       Arena *a_arena) {
     const char *c = start;
 
-    while (*c) {
+    while (*(c = skipWS(c))) {
       switch (*c) {
       case '{':
-        c = parseObject(a_value, c + 1);
+        c = parseObject(a_value, c + 1, a_arena);
         return c;
       case '[':
-        c = parseArray(a_value, c + 1);
+        c = parseArray(a_value, c + 1, a_arena);
         return c;
       case '"':
         a_value.m_type = VT_STRING;
-        a_value.m_value.s = new String();
+        a_value.m_value.s = allocate<String>(a_value, a_arena);
         c = parseString(*a_value.m_value.s, c + 1);
         return c;
       case 't':
@@ -1067,7 +1296,8 @@ private:
     ERR_UNTERMINATED_VALUE(start);
   }
 
-  inline const char *parseString(std::string &a_value, const char *start) {
+  static inline const char *parseString(std::string &a_value,
+                                        const char *start) {
     // On entry, c is next char after "
     const char *c = start;
     const char *a = start;
@@ -1075,7 +1305,8 @@ private:
 
     a_value.clear();
 
-    while (*c) {
+    // Skip to the next quote, escape or control character a block at a time
+    while (*(c = scan::stringEnd(c))) {
       if (*c == '\\') {
         if (c != a)
           a_value.append(a, (unsigned int)(c - a));
@@ -1132,28 +1363,407 @@ private:
           ERR_INVALID_CHAR(c);
         }
 
-        c++;
-        a = c + 1;
+        c += 2;
+        a = c;
       } else if (*c == '"') {
         if (c != a)
           a_value.append(a, (unsigned int)(c - a));
         return c;
-      } else if (*c >= 0 && *c < 0x20) {
+      } else {
         ERR_INVALID_CHAR(c);
       }
+    }
+
+    ERR_UNTERMINATED_VALUE(start);
+  }
+
+  static inline const char *parseNumber(double &a_value, const char *start) {
+    // Up to 19 digits scaled by a power of ten a double holds exactly give
+    // the same, correctly rounded, result as strtod
+    static const double POW10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                                   1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                   1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                                   1e18, 1e19, 1e20, 1e21, 1e22};
+    const char *c = start;
+    bool negative = (*c == '-');
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
 
+    if (negative)
       c++;
+
+    for (; isDigit(*c); c++, digits++)
+      mantissa = mantissa * 10 + (uint64_t)(*c - '0');
+
+    if (*c == '.') {
+      const char *fraction = ++c;
+      for (; isDigit(*c); c++, digits++)
+        mantissa = mantissa * 10 + (uint64_t)(*c - '0');
+      if (c == fraction)
+        return parseNumberSlow(a_value, start);
+      exponent = -(int)(c - fraction);
     }
 
-    ERR_UNTERMINATED_VALUE(start);
+    if (digits == 0 || digits > 19)
+      return parseNumberSlow(a_value, start);
+
+    if (*c == 'e' || *c == 'E') {
+      bool exp_negative = false;
+      int exp_value = 0;
+
+      c++;
+      if (*c == '-' || *c == '+')
+        exp_negative = (*c++ == '-');
+
+      const char *exp_digits = c;
+      for (; isDigit(*c) && c - exp_digits < 4; c++)
+        exp_value = exp_value * 10 + (*c - '0');
+      if (c == exp_digits || isDigit(*c))
+        return parseNumberSlow(a_value, start);
+
+      exponent += exp_negative ? -exp_value : exp_value;
+    } else if (*c == 'x' || *c == 'X') {
+      // strtod also reads hexadecimal
+      return parseNumberSlow(a_value, start);
+    }
+
+    if (mantissa > (1ull << 53) || exponent < -22 || exponent > 22)
+      return parseNumberSlow(a_value, start);
+
+    double value = (double)mantissa;
+    if (exponent < 0)
+      value /= POW10[-exponent];
+    else
+      value *= POW10[exponent];
+
+    a_value = negative ? -value : value;
+    return c - 1;
   }
 
-  inline const char *parseNumber(double &a_value, const char *start) {
+  static inline const char *parseNumberSlow(double &a_value,
+                                            const char *start) {
     char *end;
     a_value = strtod(start, &end);
 
     return end - 1;
   }
+
+  friend class Reader;
+};
+
+/**
+ * @class Reader
+ * @brief Pull parser reading a document as a sequence of events
+ *
+ * Each call to next() reads one token of a NUL terminated document, which
+ * must outlive the reader. Keys and strings are views into the document, or
+ * into a buffer of the reader when they hold escapes, and stay valid until
+ * the next read. Nothing is allocated for the structure of the document, so
+ * large replies can be translated in one pass without building a Value.
+ */
+class Reader {
+public:
+  enum Event : uint8_t {
+    EV_OBJECT_BEGIN,
+    EV_OBJECT_END,
+    EV_ARRAY_BEGIN,
+    EV_ARRAY_END,
+    EV_KEY,
+    EV_STRING,
+    EV_NUMBER,
+    EV_BOOL,
+    EV_NULL,
+    EV_END
+  };
+
+  explicit Reader(const char *a_json)
+      : m_begin(a_json), m_c(a_json), m_expect(EX_VALUE), m_event(EV_END),
+        m_number(0), m_bool(false) {
+    m_stack.reserve(16);
+  }
+
+  explicit Reader(const std::string &a_json) : Reader(a_json.c_str()) {}
+
+  /// Reads the next token, EV_END once the document is complete
+  Event next() {
+    try {
+      m_event = readEvent();
+    } catch (ParseError &e) {
+      e.setOffset((size_t)m_begin);
+      throw;
+    }
+    return m_event;
+  }
+
+  inline Event event() const { return m_event; }
+  /// Key or string read by the last event
+  inline std::string_view text() const { return m_text; }
+  inline double number() const { return m_number; }
+  inline bool boolean() const { return m_bool; }
+  /// Objects and arrays open at the current position
+  inline size_t depth() const { return m_stack.size(); }
+
+  /// Reads the next value, which must be a string
+  std::string_view readString() {
+    if (next() != EV_STRING)
+      EXCEPT_PARAM(1, "Invalid conversion of " << eventName() << " to string");
+    return m_text;
+  }
+
+  /// Reads the next value, which must be a number
+  double readNumber() {
+    if (next() != EV_NUMBER)
+      EXCEPT_PARAM(1, "Invalid conversion of " << eventName() << " to number");
+    return m_number;
+  }
+
+  /// Reads the next value, which must be a boolean
+  bool readBool() {
+    if (next() != EV_BOOL)
+      EXCEPT_PARAM(1, "Invalid conversion of " << eventName() << " to bool");
+    return m_bool;
+  }
+
+  /// Reads the next value if it is null, true if it was
+  bool readNull() {
+    const char *c = Value::skipWS(m_c);
+
+    if (m_expect == EX_SEP && !m_stack.empty() &&
+        m_stack.back() == IN_ARRAY && *c == ',')
+      c = Value::skipWS(c + 1);
+    else if (m_expect != EX_VALUE && m_expect != EX_VALUE_OR_END)
+      return false;
+
+    if (*c != 'n')
+      return false;
+    next();
+    return true;
+  }
+
+  /// Reads the next value, objects and arrays included, into a_value
+  void readValue(Value &a_value) {
+    Event event = next();
+
+    a_value = Value();
+    switch (event) {
+    case EV_OBJECT_BEGIN:
+    case EV_ARRAY_BEGIN:
+      // The container is parsed whole from its opening bracket
+      m_stack.pop_back();
+      m_expect = EX_SEP;
+      try {
+        m_c = Value::parseValue(a_value, m_c - 1, 0) + 1;
+      } catch (ParseError &e) {
+        e.setOffset((size_t)m_begin);
+        throw;
+      }
+      break;
+    case EV_STRING:
+      a_value = std::string(m_text);
+      break;
+    case EV_NUMBER:
+      a_value = m_number;
+      break;
+    case EV_BOOL:
+      a_value = m_bool;
+      break;
+    case EV_NULL:
+      break;
+    default:
+      EXCEPT_PARAM(1, "Expected a value, not " << eventName());
+    }
+  }
+
+  /// Skips the next value, objects and arrays included
+  void skip() {
+    Event event = next();
+    if (event == EV_OBJECT_BEGIN || event == EV_ARRAY_BEGIN) {
+      size_t depth = m_stack.size();
+      while (m_stack.size() >= depth)
+        next();
+    }
+  }
+
+  /// Name of the last event for error messages
+  const char *eventName() const {
+    switch (m_event) {
+    case EV_OBJECT_BEGIN:
+      return "object";
+    case EV_OBJECT_END:
+      return "end of object";
+    case EV_ARRAY_BEGIN:
+      return "array";
+    case EV_ARRAY_END:
+      return "end of array";
+    case EV_KEY:
+      return "key";
+    case EV_STRING:
+      return "string";
+    case EV_NUMBER:
+      return "number";
+    case EV_BOOL:
+      return "boolean";
+    case EV_NULL:
+      return "null";
+    case EV_END:
+      return "end of document";
+    }
+    return "unknown";
+  }
+
+private:
+  /// What may come next at the current position
+  enum Expect : uint8_t {
+    EX_VALUE,
+    EX_KEY,
+    EX_KEY_OR_END,
+    EX_VALUE_OR_END,
+    EX_SEP
+  };
+
+  enum Container : uint8_t { IN_OBJECT, IN_ARRAY };
+
+  Event readEvent() {
+    const char *c = Value::skipWS(m_c);
+
+    switch (m_expect) {
+    case EX_SEP:
+      if (m_stack.empty()) {
+        if (*c)
+          ERR_INVALID_CHAR(c);
+        m_c = c;
+        return EV_END;
+      }
+
+      if (*c == ',') {
+        c = Value::skipWS(c + 1);
+        m_expect = m_stack.back() == IN_OBJECT ? EX_KEY : EX_VALUE;
+      } else if (*c == (m_stack.back() == IN_OBJECT ? '}' : ']')) {
+        return close(c);
+      } else if (*c) {
+        ERR_INVALID_CHAR(c);
+      } else if (m_stack.back() == IN_OBJECT) {
+        ERR_UNTERMINATED_OBJECT(c);
+      } else {
+        ERR_UNTERMINATED_ARRAY(c);
+      }
+      break;
+    case EX_KEY_OR_END:
+      if (*c == '}')
+        return close(c);
+      m_expect = EX_KEY;
+      break;
+    case EX_VALUE_OR_END:
+      if (*c == ']')
+        return close(c);
+      m_expect = EX_VALUE;
+      break;
+    default:
+      break;
+    }
+
+    if (m_expect == EX_KEY) {
+      if (*c != '"') {
+        if (*c)
+          ERR_INVALID_CHAR(c);
+        ERR_UNTERMINATED_OBJECT(c);
+      }
+
+      c = readText(c + 1);
+      if (m_text.empty())
+        ERR_INVALID_KEY(c);
+
+      c = Value::skipWS(c + 1);
+      if (*c != ':') {
+        if (*c)
+          ERR_INVALID_CHAR(c);
+        ERR_UNTERMINATED_OBJECT(c);
+      }
+
+      m_c = c + 1;
+      m_expect = EX_VALUE;
+      return EV_KEY;
+    }
+
+    m_expect = EX_SEP;
+
+    switch (*c) {
+    case '{':
+      m_stack.push_back(IN_OBJECT);
+      m_expect = EX_KEY_OR_END;
+      m_c = c + 1;
+      return EV_OBJECT_BEGIN;
+    case '[':
+      m_stack.push_back(IN_ARRAY);
+      m_expect = EX_VALUE_OR_END;
+      m_c = c + 1;
+      return EV_ARRAY_BEGIN;
+    case '"':
+      m_c = readText(c + 1) + 1;
+      return EV_STRING;
+    case 't':
+      if (*(c + 1) == 'r' && *(c + 2) == 'u' && *(c + 3) == 'e') {
+        m_bool = true;
+        m_c = c + 4;
+        return EV_BOOL;
+      }
+      ERR_INVALID_VALUE(c);
+    case 'f':
+      if (*(c + 1) == 'a' && *(c + 2) == 'l' && *(c + 3) == 's' &&
+          *(c + 4) == 'e') {
+        m_bool = false;
+        m_c = c + 5;
+        return EV_BOOL;
+      }
+      ERR_INVALID_VALUE(c);
+    case 'n':
+      if (*(c + 1) == 'u' && *(c + 2) == 'l' && *(c + 3) == 'l') {
+        m_c = c + 4;
+        return EV_NULL;
+      }
+      ERR_INVALID_VALUE(c);
+    case 0:
+      ERR_UNTERMINATED_VALUE(c);
+    default:
+      if (*c == '-' || Value::isDigit(*c) || *c == '.') {
+        m_c = Value::parseNumber(m_number, c) + 1;
+        return EV_NUMBER;
+      }
+      ERR_INVALID_CHAR(c);
+    }
+  }
+
+  /// Reads a key or string, a view into the document unless it has escapes
+  const char *readText(const char *a_c) {
+    const char *end = scan::stringEnd(a_c);
+    if (*end == '"') {
+      m_text = std::string_view(a_c, (size_t)(end - a_c));
+      return end;
+    }
+
+    end = Value::parseString(m_buffer, a_c);
+    m_text = m_buffer;
+    return end;
+  }
+
+  Event close(const char *c) {
+    Container container = m_stack.back();
+    m_stack.pop_back();
+    m_c = c + 1;
+    m_expect = EX_SEP;
+    return container == IN_OBJECT ? EV_OBJECT_END : EV_ARRAY_END;
+  }
+
+  const char *m_begin;
+  const char *m_c;
+  Expect m_expect;
+  Event m_event;
+  std::vector<Container> m_stack;
+  std::string_view m_text;
+  std::string m_buffer;
+  double m_number;
+  bool m_bool;
 };
 } // namespace libjson
 
@@ -3,13 +3,250 @@
 #include "common/DynaLog.hpp"
 
 // Standard includes
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
 #include <optional>
 #include <string>
+#include <thread>
 
 namespace SDMS {
 
 Logger global_logger;
 
+struct LogRecord {
+  boost::posix_time::ptime time;
+  LogLevel level = LogLevel::INFO;
+  std::string file;
+  std::string func;
+  int line_num = 0;
+  LogContext context;
+  std::string message;
+};
+
+/**
+ * Bounded multi producer, single consumer queue drained by a writer thread
+ *
+ * Each cell carries a sequence number so producers only contend on the
+ * enqueue position and never on a lock, the writer thread is the only reader.
+ * The writer wakes up every WRITE_PERIOD, or sooner when flushed or when a
+ * blocked producer needs room, and writes whatever has been queued as one
+ * batch followed by a single flush of each stream.
+ **/
+class AsyncLogSink {
+public:
+  AsyncLogSink(Logger &logger, size_t capacity, LogOverflowPolicy policy)
+      : m_logger(logger), m_policy(policy) {
+    size_t size = 2;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    m_mask = size - 1;
+    m_cells = std::make_unique<Cell[]>(size);
+    for (size_t i = 0; i < size; ++i) {
+      m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    m_thread = std::thread(&AsyncLogSink::run, this);
+  }
+
+  ~AsyncLogSink() {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+    m_wake_cv.notify_one();
+    m_thread.join();
+  }
+
+  void push(LogRecord &&record) {
+    while (!tryPush(record)) {
+      if (m_policy != LogOverflowPolicy::BLOCK) {
+        m_logger.m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+      wake();
+      std::this_thread::yield();
+    }
+    m_queued.fetch_add(1, std::memory_order_release);
+  }
+
+  void flush() {
+    const uint64_t target = m_queued.load(std::memory_order_acquire);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_wake = true;
+    m_wake_cv.notify_one();
+    m_written_cv.wait(lock, [&]() { return m_written >= target; });
+  }
+
+private:
+  struct Cell {
+    std::atomic<size_t> sequence{0};
+    LogRecord record;
+  };
+
+  static const size_t MAX_BATCH = 256;
+  static constexpr std::chrono::milliseconds WRITE_PERIOD{10};
+
+  bool tryPush(LogRecord &record) {
+    size_t pos = m_enqueue_pos.load(std::memory_order_relaxed);
+    Cell *cell;
+    for (;;) {
+      cell = &m_cells[pos & m_mask];
+      const size_t seq = cell->sequence.load(std::memory_order_acquire);
+      const intptr_t diff =
+          static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1,
+                                                std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false; // Full
+      } else {
+        pos = m_enqueue_pos.load(std::memory_order_relaxed);
+      }
+    }
+    cell->record = std::move(record);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool tryPop(LogRecord &record) {
+    Cell &cell = m_cells[m_dequeue_pos & m_mask];
+    if (cell.sequence.load(std::memory_order_acquire) != m_dequeue_pos + 1) {
+      return false; // Empty
+    }
+    record = std::move(cell.record);
+    cell.sequence.store(m_dequeue_pos + m_mask + 1, std::memory_order_release);
+    ++m_dequeue_pos;
+    return true;
+  }
+
+  void wake() {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_wake = true;
+    }
+    m_wake_cv.notify_one();
+  }
+
+  void reportDropped(std::string &lines) {
+    if (m_policy != LogOverflowPolicy::COUNT_DROPPED) {
+      return;
+    }
+    const size_t dropped = m_logger.m_dropped.load(std::memory_order_relaxed);
+    if (dropped == m_reported_dropped) {
+      return;
+    }
+    LogRecord record;
+    record.time = boost::posix_time::microsec_clock::universal_time();
+    record.level = LogLevel::WARNING;
+    record.file = __FILE__;
+    record.func = __func__;
+    record.line_num = __LINE__;
+    record.context.thread_name = "logger";
+    record.message = "Dropped " + std::to_string(dropped - m_reported_dropped) +
+                     " log messages, the log queue was full";
+    m_reported_dropped = dropped;
+    m_logger.format(record, lines);
+  }
+
+  void run() {
+    std::string lines;
+    LogRecord record;
+    bool stopping = false;
+    for (;;) {
+      size_t count = 0;
+      while (count < MAX_BATCH && tryPop(record)) {
+        m_logger.format(record, lines);
+        if (m_logger.m_output_to_syslog) {
+          m_logger.writeSysLog(record);
+        }
+        ++count;
+      }
+      reportDropped(lines);
+      if (!lines.empty()) {
+        m_logger.write(lines, true);
+        lines.clear();
+      }
+
+      std::unique_lock<std::mutex> lock(m_mutex);
+      if (count) {
+        m_written += count;
+        m_written_cv.notify_all();
+      }
+      if (count == MAX_BATCH) {
+        continue;
+      }
+      // One more pass once stopping so nothing queued before stopAsync is lost
+      if (stopping) {
+        break;
+      }
+      if (m_stop) {
+        stopping = true;
+        continue;
+      }
+      m_wake_cv.wait_for(lock, WRITE_PERIOD, [&]() { return m_wake || m_stop; });
+      m_wake = false;
+    }
+  }
+
+  Logger &m_logger;
+  LogOverflowPolicy m_policy;
+  size_t m_mask = 0;
+  std::unique_ptr<Cell[]> m_cells;
+  alignas(64) std::atomic<size_t> m_enqueue_pos{0};
+  alignas(64) size_t m_dequeue_pos = 0;
+  std::atomic<uint64_t> m_queued{0};
+  size_t m_reported_dropped = 0;
+
+  // Guarded by m_mutex
+  std::mutex m_mutex;
+  std::condition_variable m_wake_cv;
+  std::condition_variable m_written_cv;
+  uint64_t m_written = 0;
+  bool m_wake = false;
+  bool m_stop = false;
+
+  std::thread m_thread;
+};
+
+namespace {
+
+void appendJSON(std::string &out, const std::string &value) {
+  out += '"';
+  for (const char c : value) {
+    switch (c) {
+    case '"':
+      out += "\\\"";
+      break;
+    case '\\':
+      out += "\\\\";
+      break;
+    case '\n':
+      out += "\\n";
+      break;
+    case '\r':
+      out += "\\r";
+      break;
+    case '\t':
+      out += "\\t";
+      break;
+    default:
+      if (static_cast<unsigned char>(c) < 0x20) {
+        char escaped[8];
+        snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+        out += escaped;
+      } else {
+        out += c;
+      }
+    }
+  }
+  out += '"';
+}
+
+} // namespace
+
 std::string toString(const LogLevel level) {
   if (level == LogLevel::TRACE) {
     return "TRACE";
@@ -75,37 +312,113 @@ std::ostream &operator<<(std::ostream &out, const LogLine &log_line) {
   return out;
 }
 
-void Logger::output(const LogLevel level, std::string file, std::string func,
-                    int line_num, const LogContext &context,
-                    const std::string &message) {
+Logger::Logger() = default;
+
+Logger::~Logger() { stopAsync(); }
+
+void Logger::format(const LogRecord &record, std::string &out) const {
+  const std::string time =
+      boost::posix_time::to_iso_extended_string(record.time) + "Z";
+  if (m_format == LogFormat::JSON) {
+    out += "{\"time\": \"" + time + "\", \"level\": \"" +
+           toString(record.level) + "\", \"file\": ";
+    appendJSON(out, record.file);
+    out += ", \"func\": ";
+    appendJSON(out, record.func);
+    out += ", \"line\": " + std::to_string(record.line_num);
+    if (not record.context.thread_name.empty()) {
+      out += ", \"thread_name\": ";
+      appendJSON(out, record.context.thread_name);
+    }
+    if (record.context.thread_id) {
+      out += ", \"thread_id\": " + std::to_string(record.context.thread_id);
+    }
+    if (not record.context.correlation_id.empty()) {
+      out += ", \"correlation_id\": ";
+      appendJSON(out, record.context.correlation_id);
+    }
+    out += ", \"message\": ";
+    appendJSON(out, record.message);
+    out += "}\n";
+    return;
+  }
 
+  std::ostringstream line;
+  line << time << " " << toString(record.level) << " " << record.file << ":"
+       << record.func << ":" << record.line_num << " "
+       << LogLine(record.context, record.message) << "\n";
+  out += line.str();
+}
+
+void Logger::write(const std::string &lines, bool flush) {
   size_t index = 0;
   for (auto &output_stream : m_streams) {
     std::lock_guard<std::mutex> lock(*m_mutexes.at(index));
     index++;
-    boost::posix_time::ptime time =
-        boost::posix_time::microsec_clock::universal_time();
-    output_stream.get() << boost::posix_time::to_iso_extended_string(time)
-                        << "Z ";
-    output_stream.get() << toString(level) << " ";
-    output_stream.get() << file << ":" << func << ":" << line_num << " ";
-    LogLine log_line(context, message);
-    output_stream.get() << log_line;
-    output_stream.get() << std::endl;
+    output_stream.get().write(lines.data(), lines.size());
+    if (flush) {
+      output_stream.get().flush();
+    }
+  }
+}
+
+void Logger::writeSysLog(const LogRecord &record) const {
+  std::stringstream buffer;
+  buffer << record.message;
+  buffer << record.file << ":" << record.func << ":" << record.line_num << " ";
+  buffer << LogLine(record.context, record.message);
+  buffer << std::endl;
+  syslog(toSysLog(record.level), "%s", buffer.str().c_str());
+}
+
+void Logger::output(const LogLevel level, std::string file, std::string func,
+                    int line_num, const LogContext &context,
+                    const std::string &message) {
+
+  LogRecord record{boost::posix_time::microsec_clock::universal_time(),
+                   level,
+                   std::move(file),
+                   std::move(func),
+                   line_num,
+                   context,
+                   message};
+
+  if (m_async) {
+    m_async->push(std::move(record));
+    return;
   }
 
+  std::string line;
+  format(record, line);
+  write(line, true);
+
   if (m_output_to_syslog) {
-    std::stringstream buffer;
-    buffer << message;
-    buffer << file << ":" << func << ":" << line_num << " ";
-    LogLine log_line(context, message);
-    buffer << log_line;
-    buffer << std::endl;
-    syslog(toSysLog(level), "%s", buffer.str().c_str());
+    writeSysLog(record);
   }
 }
 
-void Logger::setLevel(LogLevel level) noexcept { m_log_level = level; }
+void Logger::startAsync(size_t capacity, LogOverflowPolicy policy) {
+  stopAsync();
+  m_async = std::make_unique<AsyncLogSink>(*this, capacity, policy);
+}
+
+void Logger::stopAsync() { m_async.reset(); }
+
+void Logger::flush() {
+  if (m_async) {
+    m_async->flush();
+    return;
+  }
+  write(std::string(), true);
+}
+
+size_t Logger::droppedCount() const noexcept {
+  return m_dropped.load(std::memory_order_relaxed);
+}
+
+void Logger::setLevel(LogLevel level) noexcept {
+  m_log_level.store(level, std::memory_order_relaxed);
+}
 
 void Logger::addStream(std::ostream &stream) {
   m_streams.push_back(std::ref(stream));
@@ -114,37 +427,37 @@ void Logger::addStream(std::ostream &stream) {
 
 void Logger::trace(std::string file, std::string func, int line_num,
                    const LogContext &context, const std::string &message) {
-  if (m_log_level >= LogLevel::TRACE) {
+  if (isEnabled(LogLevel::TRACE)) {
     output(LogLevel::TRACE, file, func, line_num, context, message);
   }
 }
 void Logger::debug(std::string file, std::string func, int line_num,
                    const LogContext &context, const std::string &message) {
-  if (m_log_level >= LogLevel::DEBUG) {
+  if (isEnabled(LogLevel::DEBUG)) {
     output(LogLevel::DEBUG, file, func, line_num, context, message);
   }
 }
 void Logger::info(std::string file, std::string func, int line_num,
                   const LogContext &context, const std::string &message) {
-  if (m_log_level >= LogLevel::INFO) {
+  if (isEnabled(LogLevel::INFO)) {
     output(LogLevel::INFO, file, func, line_num, context, message);
   }
 }
 void Logger::warning(std::string file, std::string func, int line_num,
                      const LogContext &context, const std::string &message) {
-  if (m_log_level >= LogLevel::WARNING) {
+  if (isEnabled(LogLevel::WARNING)) {
     output(LogLevel::WARNING, file, func, line_num, context, message);
   }
 }
 void Logger::error(std::string file, std::string func, int line_num,
                    const LogContext &context, const std::string &message) {
-  if (m_log_level >= LogLevel::ERROR) {
+  if (isEnabled(LogLevel::ERROR)) {
     output(LogLevel::ERROR, file, func, line_num, context, message);
   }
 }
 void Logger::critical(std::string file, std::string func, int line_num,
                       const LogContext &context, const std::string &message) {
-  if (m_log_level >= LogLevel::CRITICAL) {
+  if (isEnabled(LogLevel::CRITICAL)) {
     output(LogLevel::CRITICAL, file, func, line_num, context, message);
   }
 }
@@ -0,0 +1,208 @@
+// Local private includes
+#include "Envelope.hpp"
+#include "Frame.hpp"
+
+// Local public includes
+#include "common/IMessage.hpp"
+#include "common/TraceException.hpp"
+
+// Standard includes
+#include <arpa/inet.h>
+#include <cstring>
+#include <variant>
+
+namespace SDMS {
+
+namespace {
+
+const unsigned char MAGIC_0 = 'D';
+const unsigned char MAGIC_1 = 'F';
+/// Magic, version, flags and route count
+const size_t PREAMBLE_SIZE = 5;
+const size_t FRAME_SIZE = 8;
+
+std::string keyOf(const IMessage &msg) {
+  if (msg.exists(MessageAttribute::KEY)) {
+    return std::get<std::string>(msg.get(MessageAttribute::KEY));
+  }
+  return "no key";
+}
+
+std::string idOf(const IMessage &msg) {
+  if (msg.exists(MessageAttribute::ID)) {
+    return std::get<std::string>(msg.get(MessageAttribute::ID));
+  }
+  return "no id";
+}
+
+/**
+ * Bounds checked reader over the header bytes
+ **/
+class Reader {
+public:
+  Reader(const void *data, size_t size)
+      : m_data(static_cast<const unsigned char *>(data)), m_size(size) {}
+
+  const unsigned char *take(size_t count) {
+    if (count > m_size - m_offset) {
+      EXCEPT(1, "Compact envelope header is truncated.");
+    }
+    const unsigned char *ptr = m_data + m_offset;
+    m_offset += count;
+    return ptr;
+  }
+
+  uint8_t u8() { return *take(1); }
+
+  uint16_t u16() {
+    uint16_t value;
+    memcpy(&value, take(sizeof(uint16_t)), sizeof(uint16_t));
+    return ntohs(value);
+  }
+
+  std::string str(size_t len) {
+    return std::string(reinterpret_cast<const char *>(take(len)), len);
+  }
+
+  size_t remaining() const { return m_size - m_offset; }
+
+private:
+  const unsigned char *m_data;
+  size_t m_size;
+  size_t m_offset = 0;
+};
+
+} // namespace
+
+bool EnvelopeConverter::isHeader(const void *data, size_t size) noexcept {
+  const unsigned char *bytes = static_cast<const unsigned char *>(data);
+  return size >= PREAMBLE_SIZE && bytes[0] == MAGIC_0 && bytes[1] == MAGIC_1 &&
+         bytes[2] == constants::message::envelope::COMPACT;
+}
+
+size_t EnvelopeConverter::size(const IMessage &msg,
+                               const std::list<std::string> &routes) const {
+  size_t total = PREAMBLE_SIZE + FRAME_SIZE;
+  for (const auto &route : routes) {
+    total += 1 + route.size();
+  }
+  total += 1 + std::get<std::string>(msg.get(MessageAttribute::CORRELATION_ID))
+                   .size();
+  total += sizeof(uint16_t) + keyOf(msg).size();
+  total += sizeof(uint16_t) + idOf(msg).size();
+  return total;
+}
+
+void EnvelopeConverter::encode(const IMessage &msg,
+                               const std::list<std::string> &routes,
+                               void *data, size_t size) const {
+
+  if (routes.size() > 255) {
+    EXCEPT(1, "Compact envelope cannot carry more than 255 routes.");
+  }
+  if (size != this->size(msg, routes)) {
+    EXCEPT_PARAM(1, "Compact envelope buffer size is inconsistent, expected: "
+                        << this->size(msg, routes) << " got: " << size);
+  }
+
+  unsigned char *out = static_cast<unsigned char *>(data);
+  *out++ = MAGIC_0;
+  *out++ = MAGIC_1;
+  *out++ = constants::message::envelope::COMPACT;
+  *out++ = 0; // flags
+  *out++ = static_cast<uint8_t>(routes.size());
+
+  for (const auto &route : routes) {
+    if (route.size() == 0 || route.size() > 255) {
+      EXCEPT_PARAM(1, "Invalid message route segment length: " << route.size());
+    }
+    *out++ = static_cast<uint8_t>(route.size());
+    memcpy(out, route.data(), route.size());
+    out += route.size();
+  }
+
+  const std::string correlation_id =
+      std::get<std::string>(msg.get(MessageAttribute::CORRELATION_ID));
+  if (correlation_id.size() > 255) {
+    EXCEPT(1, "Correlation id exceeds max allowed length.");
+  }
+  *out++ = static_cast<uint8_t>(correlation_id.size());
+  memcpy(out, correlation_id.data(), correlation_id.size());
+  out += correlation_id.size();
+
+  for (const std::string &field : {keyOf(msg), idOf(msg)}) {
+    if (field.size() > UINT16_MAX) {
+      EXCEPT(1, "Message key or id exceeds max allowed length.");
+    }
+    uint16_t len = htons(static_cast<uint16_t>(field.size()));
+    memcpy(out, &len, sizeof(uint16_t));
+    out += sizeof(uint16_t);
+    memcpy(out, field.data(), field.size());
+    out += field.size();
+  }
+
+  FrameFactory frame_factory;
+  Frame frame = frame_factory.create(msg);
+  uint32_t frame_size = htonl(frame.size);
+  uint16_t context = htons(frame.context);
+  memcpy(out, &frame_size, sizeof(uint32_t));
+  out[4] = frame.proto_id;
+  out[5] = frame.msg_id;
+  memcpy(out + 6, &context, sizeof(uint16_t));
+}
+
+void EnvelopeConverter::decode(const void *data, size_t size,
+                               IMessage &msg) const {
+  if (!isHeader(data, size)) {
+    EXCEPT(1, "Not a compact envelope header.");
+  }
+
+  Reader reader(data, size);
+  reader.take(4); // magic, version and flags
+
+  uint8_t number_of_routes = reader.u8();
+  for (uint8_t route_i = 0; route_i < number_of_routes; ++route_i) {
+    uint8_t len = reader.u8();
+    if (len == 0) {
+      EXCEPT(1, "Message route should not be an empty message.");
+    }
+    std::string route = reader.str(len);
+    // Only add the next route if it has a different name
+    if (msg.getRoutes().empty() || msg.getRoutes().back() != route) {
+      msg.addRoute(route);
+    }
+  }
+
+  std::string correlation_id = reader.str(reader.u8());
+  if (correlation_id.size()) {
+    msg.set(MessageAttribute::CORRELATION_ID, correlation_id);
+  }
+  std::string key = reader.str(reader.u16());
+  if (key.size()) {
+    msg.set(MessageAttribute::KEY, key);
+  }
+  std::string id = reader.str(reader.u16());
+  if (id.size()) {
+    msg.set(MessageAttribute::ID, id);
+  }
+
+  const unsigned char *frame_data = reader.take(FRAME_SIZE);
+  if (reader.remaining()) {
+    EXCEPT(1, "Unexpected trailing bytes in compact envelope header.");
+  }
+
+  Frame frame;
+  uint32_t frame_size;
+  uint16_t context;
+  memcpy(&frame_size, frame_data, sizeof(uint32_t));
+  memcpy(&context, frame_data + 6, sizeof(uint16_t));
+  frame.size = ntohl(frame_size);
+  frame.proto_id = frame_data[4];
+  frame.msg_id = frame_data[5];
+  frame.context = ntohs(context);
+
+  FrameConverter converter;
+  converter.copy(FrameConverter::CopyDirection::FROM_FRAME, msg, frame);
+}
+
+} // namespace SDMS
@@ -0,0 +1,72 @@
+#ifndef ENVELOPE_HPP
+#define ENVELOPE_HPP
+#pragma once
+
+// Local public includes
+#include "common/IMessage.hpp"
+
+// Standard includes
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+
+namespace SDMS {
+
+namespace constants {
+namespace message {
+namespace envelope {
+/// Original layout, every field is sent as a separate zmq part
+const uint8_t LEGACY = 1;
+/// Compact layout, one header part followed by one body part
+const uint8_t COMPACT = 2;
+/// Leading null delimiters a legacy request carries to tell the receiver that
+/// the sender also understands the compact layout. A REQ socket adds one more
+/// delimiter on its own, so fewer than this are never treated as a hint.
+const size_t COMPACT_HINT_DELIMITERS = 3;
+} // namespace envelope
+} // namespace message
+} // namespace constants
+
+/**
+ * Compact (version 2) wire envelope
+ *
+ * Packs everything the legacy layout sends as separate parts into a single
+ * header part. All integers are in network byte order.
+ *
+ * 'D' 'F'           - magic
+ * uint8_t           - version (2)
+ * uint8_t           - flags (reserved, 0)
+ * uint8_t           - number of routes
+ *   uint8_t + bytes - route, repeated for each route
+ * uint8_t + bytes   - correlation id
+ * uint16_t + bytes  - key
+ * uint16_t + bytes  - id
+ * 8 bytes           - Frame, same encoding as the legacy frame part
+ *
+ * The header is always followed by exactly one body part, which is empty if
+ * the message has no payload. Identity parts required by ROUTER sockets are
+ * still sent as separate parts ahead of the header.
+ **/
+class EnvelopeConverter {
+public:
+  /// Returns true if the buffer starts with a compact envelope header
+  static bool isHeader(const void *data, size_t size) noexcept;
+
+  /// Number of bytes encode() will write for the message and routes
+  size_t size(const IMessage &msg, const std::list<std::string> &routes) const;
+
+  void encode(const IMessage &msg, const std::list<std::string> &routes,
+              void *data, size_t size) const;
+
+  /**
+   * Sets the routes, correlation id, key, id and frame attributes of the
+   * message from the header. As with the legacy layout, a route is not added
+   * if it matches the last route already attached to the message.
+   **/
+  void decode(const void *data, size_t size, IMessage &msg) const;
+};
+
+} // namespace SDMS
+
+#endif // ENVELOPE_HPP
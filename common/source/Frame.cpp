@@ -69,7 +69,7 @@ void FrameConverter::copy(CopyDirection direction, IMessage &msg,
 }
 
 Frame FrameFactory::create(::google::protobuf::Message &a_msg,
-                           ProtoBufMap &proto_map) {
+                           const ProtoBufMap &proto_map) {
   Frame frame;
   auto msg_type = proto_map.getMessageType(a_msg);
   frame.proto_id = msg_type >> 8;
@@ -0,0 +1,350 @@
+// Local public includes
+#include "common/JsonProtoMapper.hpp"
+#include "common/TraceException.hpp"
+
+// Standard includes
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace proto = ::google::protobuf;
+
+using libjson::Value;
+
+namespace SDMS {
+
+namespace {
+
+double toNumber(const Value &a_value, const std::string &a_key) {
+  if (a_value.isNumber() || a_value.isBool())
+    return a_value.asNumber();
+
+  EXCEPT_PARAM(1, "Invalid conversion of " << a_value.getTypeString()
+                                           << " value to number for key "
+                                           << a_key);
+}
+
+bool toBool(const Value &a_value, const std::string &a_key) {
+  if (a_value.isBool() || a_value.isNumber())
+    return a_value.asBool();
+
+  EXCEPT_PARAM(1, "Invalid conversion of " << a_value.getTypeString()
+                                           << " value to boolean for key "
+                                           << a_key);
+}
+
+std::string toText(const Value &a_value, const std::string &a_key) {
+  if (a_value.isString())
+    return a_value.asString();
+  if (a_value.isObject() || a_value.isArray())
+    return a_value.toString();
+
+  EXCEPT_PARAM(1, "Invalid conversion of " << a_value.getTypeString()
+                                           << " value to string for key "
+                                           << a_key);
+}
+
+} // namespace
+
+JsonProtoMapper::JsonProtoMapper(const proto::Descriptor *a_descriptor)
+    : JsonProtoMapper(a_descriptor, true) {}
+
+JsonProtoMapper::JsonProtoMapper(const proto::Descriptor *a_descriptor,
+                                 bool a_link)
+    : m_descriptor(a_descriptor),
+      m_reflection(proto::MessageFactory::generated_factory()
+                       ->GetPrototype(a_descriptor)
+                       ->GetReflection()),
+      m_required_mask(0) {
+  m_entries.reserve(a_descriptor->field_count());
+
+  for (int i = 0; i < a_descriptor->field_count(); i++) {
+    const proto::FieldDescriptor *field = a_descriptor->field(i);
+    Entry &entry = insert(field->name());
+
+    entry.field = field;
+    if (a_link && field->cpp_type() == proto::FieldDescriptor::CPPTYPE_MESSAGE)
+      entry.nested = &forType(field->message_type());
+
+    if (field->is_required()) {
+      if (m_required.size() < 64)
+        entry.required = uint64_t(1) << m_required.size();
+
+      m_required_mask |= entry.required ? entry.required : ~uint64_t(0);
+      m_required.push_back({field, field->name()});
+    }
+  }
+}
+
+const JsonProtoMapper &
+JsonProtoMapper::forType(const proto::Descriptor *a_descriptor) {
+  static std::mutex mutex;
+  static std::unordered_map<const proto::Descriptor *,
+                            std::unique_ptr<JsonProtoMapper>>
+      mappers;
+
+  std::lock_guard<std::mutex> lock(mutex);
+
+  auto found = mappers.find(a_descriptor);
+  if (found != mappers.end())
+    return *found->second;
+
+  // Build tables for the type and every message type it holds, then link
+  // them, messages may hold themselves
+  std::vector<JsonProtoMapper *> created;
+  std::vector<const proto::Descriptor *> pending = {a_descriptor};
+
+  while (!pending.empty()) {
+    const proto::Descriptor *descriptor = pending.back();
+    pending.pop_back();
+
+    if (mappers.count(descriptor))
+      continue;
+
+    JsonProtoMapper *mapper = new JsonProtoMapper(descriptor, false);
+    mappers.emplace(descriptor, std::unique_ptr<JsonProtoMapper>(mapper));
+    created.push_back(mapper);
+
+    for (const Entry &entry : mapper->m_entries) {
+      if (entry.field->cpp_type() == proto::FieldDescriptor::CPPTYPE_MESSAGE)
+        pending.push_back(entry.field->message_type());
+    }
+  }
+
+  for (JsonProtoMapper *mapper : created) {
+    for (Entry &entry : mapper->m_entries) {
+      if (entry.field->cpp_type() == proto::FieldDescriptor::CPPTYPE_MESSAGE)
+        entry.nested = mappers[entry.field->message_type()].get();
+    }
+  }
+
+  return *mappers[a_descriptor];
+}
+
+JsonProtoMapper &JsonProtoMapper::key(const std::string &a_key,
+                                      const std::string &a_field) {
+  const proto::FieldDescriptor *field = m_descriptor->FindFieldByName(a_field);
+  if (!field)
+    EXCEPT_PARAM(1, "No field " << a_field << " in "
+                                << m_descriptor->full_name());
+
+  const JsonProtoMapper *nested = nullptr;
+  uint64_t required = 0;
+  for (const Entry &entry : m_entries) {
+    if (entry.field == field && !entry.handler) {
+      nested = entry.nested;
+      required = entry.required;
+    }
+  }
+
+  erase(field);
+  Entry &entry = insert(a_key);
+  entry.field = field;
+  entry.nested = nested;
+  entry.required = required;
+
+  for (Required &required : m_required) {
+    if (required.field == field)
+      required.key = a_key;
+  }
+
+  return *this;
+}
+
+JsonProtoMapper &JsonProtoMapper::nested(const std::string &a_field,
+                                         const JsonProtoMapper &a_mapper) {
+  const proto::FieldDescriptor *field = m_descriptor->FindFieldByName(a_field);
+  if (!field || field->message_type() != a_mapper.descriptor())
+    EXCEPT_PARAM(1, "No field " << a_field << " of type "
+                                << a_mapper.descriptor()->full_name() << " in "
+                                << m_descriptor->full_name());
+
+  for (Entry &entry : m_entries) {
+    if (entry.field == field && !entry.handler)
+      entry.nested = &a_mapper;
+  }
+
+  return *this;
+}
+
+JsonProtoMapper &JsonProtoMapper::handle(const std::string &a_key,
+                                         Handler a_handler) {
+  Entry &entry = insert(a_key);
+  entry.handler = std::move(a_handler);
+  return *this;
+}
+
+void JsonProtoMapper::fill(proto::Message &a_message,
+                           const Value::Object &a_object) const {
+  const proto::Reflection &reflection = *m_reflection;
+  std::vector<Entry>::const_iterator entry = m_entries.begin();
+  uint64_t required = 0;
+
+  // Both the table and the members are sorted by key, keys are unique
+  for (Value::ObjectConstIter member = a_object.begin();
+       member != a_object.end() && entry != m_entries.end(); ++member) {
+    int order = entry->key.compare(member->first);
+
+    while (order < 0 && ++entry != m_entries.end())
+      order = entry->key.compare(member->first);
+
+    if (order != 0)
+      continue;
+
+    if (entry->handler)
+      entry->handler(a_message, member->second, a_object);
+    else if (!member->second.isNull()) {
+      setField(a_message, reflection, *entry, member->second);
+      required |= entry->required;
+    }
+
+    ++entry;
+  }
+
+  // Required fields filled by handlers or before the call have no bit set
+  if (required != m_required_mask) {
+    for (const Required &field : m_required) {
+      if (!reflection.HasField(a_message, field.field))
+        EXCEPT_PARAM(1, "Key not found: " << field.key);
+    }
+  }
+}
+
+std::vector<JsonProtoMapper::Entry>::iterator
+JsonProtoMapper::find(const std::string &a_key) {
+  return std::lower_bound(
+      m_entries.begin(), m_entries.end(), a_key,
+      [](const Entry &a_entry, const std::string &a_key_) {
+        return a_entry.key < a_key_;
+      });
+}
+
+JsonProtoMapper::Entry &JsonProtoMapper::insert(const std::string &a_key) {
+  std::vector<Entry>::iterator entry = find(a_key);
+  Entry empty{a_key, nullptr, nullptr, Handler(), 0};
+
+  if (entry != m_entries.end() && entry->key == a_key)
+    *entry = std::move(empty);
+  else
+    entry = m_entries.insert(entry, std::move(empty));
+
+  return *entry;
+}
+
+void JsonProtoMapper::erase(const proto::FieldDescriptor *a_field) {
+  m_entries.erase(std::remove_if(m_entries.begin(), m_entries.end(),
+                                 [a_field](const Entry &a_entry) {
+                                   return a_entry.field == a_field &&
+                                          !a_entry.handler;
+                                 }),
+                  m_entries.end());
+}
+
+void JsonProtoMapper::setField(proto::Message &a_message,
+                               const proto::Reflection &a_reflection,
+                               const Entry &a_entry,
+                               const Value &a_value) const {
+  const proto::FieldDescriptor *field = a_entry.field;
+  const bool message =
+      field->cpp_type() == proto::FieldDescriptor::CPPTYPE_MESSAGE;
+
+  if (field->is_repeated()) {
+    const Value::Array &items = a_value.asArray();
+
+    for (const Value &item : items) {
+      if (message)
+        a_entry.nested->fill(*a_reflection.AddMessage(&a_message, field),
+                             item.asObject());
+      else
+        addScalar(a_message, a_reflection, a_entry, item);
+    }
+  } else if (message) {
+    a_entry.nested->fill(*a_reflection.MutableMessage(&a_message, field),
+                         a_value.asObject());
+  } else {
+    setScalar(a_message, a_reflection, a_entry, a_value);
+  }
+}
+
+void JsonProtoMapper::setScalar(proto::Message &a_message,
+                                const proto::Reflection &a_reflection,
+                                const Entry &a_entry,
+                                const Value &a_value) const {
+  const proto::FieldDescriptor *field = a_entry.field;
+  const std::string &key = a_entry.key;
+
+  switch (field->cpp_type()) {
+  case proto::FieldDescriptor::CPPTYPE_INT32:
+    a_reflection.SetInt32(&a_message, field, toNumber(a_value, key));
+    break;
+  case proto::FieldDescriptor::CPPTYPE_INT64:
+    a_reflection.SetInt64(&a_message, field, toNumber(a_value, key));
+    break;
+  case proto::FieldDescriptor::CPPTYPE_UINT32:
+    a_reflection.SetUInt32(&a_message, field, toNumber(a_value, key));
+    break;
+  case proto::FieldDescriptor::CPPTYPE_UINT64:
+    a_reflection.SetUInt64(&a_message, field, toNumber(a_value, key));
+    break;
+  case proto::FieldDescriptor::CPPTYPE_DOUBLE:
+    a_reflection.SetDouble(&a_message, field, toNumber(a_value, key));
+    break;
+  case proto::FieldDescriptor::CPPTYPE_FLOAT:
+    a_reflection.SetFloat(&a_message, field, toNumber(a_value, key));
+    break;
+  case proto::FieldDescriptor::CPPTYPE_BOOL:
+    a_reflection.SetBool(&a_message, field, toBool(a_value, key));
+    break;
+  case proto::FieldDescriptor::CPPTYPE_ENUM:
+    a_reflection.SetEnumValue(&a_message, field, toNumber(a_value, key));
+    break;
+  case proto::FieldDescriptor::CPPTYPE_STRING:
+    a_reflection.SetString(&a_message, field, toText(a_value, key));
+    break;
+  default:
+    break;
+  }
+}
+
+void JsonProtoMapper::addScalar(proto::Message &a_message,
+                                const proto::Reflection &a_reflection,
+                                const Entry &a_entry,
+                                const Value &a_value) const {
+  const proto::FieldDescriptor *field = a_entry.field;
+  const std::string &key = a_entry.key;
+
+  switch (field->cpp_type()) {
+  case proto::FieldDescriptor::CPPTYPE_INT32:
+    a_reflection.AddInt32(&a_message, field, toNumber(a_value, key));
+    break;
+  case proto::FieldDescriptor::CPPTYPE_INT64:
+    a_reflection.AddInt64(&a_message, field, toNumber(a_value, key));
+    break;
+  case proto::FieldDescriptor::CPPTYPE_UINT32:
+    a_reflection.AddUInt32(&a_message, field, toNumber(a_value, key));
+    break;
+  case proto::FieldDescriptor::CPPTYPE_UINT64:
+    a_reflection.AddUInt64(&a_message, field, toNumber(a_value, key));
+    break;
+  case proto::FieldDescriptor::CPPTYPE_DOUBLE:
+    a_reflection.AddDouble(&a_message, field, toNumber(a_value, key));
+    break;
+  case proto::FieldDescriptor::CPPTYPE_FLOAT:
+    a_reflection.AddFloat(&a_message, field, toNumber(a_value, key));
+    break;
+  case proto::FieldDescriptor::CPPTYPE_BOOL:
+    a_reflection.AddBool(&a_message, field, toBool(a_value, key));
+    break;
+  case proto::FieldDescriptor::CPPTYPE_ENUM:
+    a_reflection.AddEnumValue(&a_message, field, toNumber(a_value, key));
+    break;
+  case proto::FieldDescriptor::CPPTYPE_STRING:
+    a_reflection.AddString(&a_message, field, toText(a_value, key));
+    break;
+  default:
+    break;
+  }
+}
+
+} // namespace SDMS
@@ -0,0 +1,265 @@
+// Local public includes
+#include "common/JsonScanner.hpp"
+
+// Standard includes
+#include <atomic>
+#include <cstdint>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define JSON_SCAN_X86
+#include <immintrin.h>
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+#define JSON_SCAN_NEON
+#include <arm_neon.h>
+#endif
+
+// Reading to the end of an aligned block is safe, but not within the bounds
+// the address sanitizer checks
+#if defined(__GNUC__) || defined(__clang__)
+#define JSON_SCAN_KERNEL __attribute__((no_sanitize_address))
+#else
+#define JSON_SCAN_KERNEL
+#endif
+
+namespace libjson {
+namespace scan {
+
+namespace {
+
+struct Kernel {
+  const char *name;
+  const char *(*string_end)(const char *);
+  const char *(*skip_whitespace)(const char *);
+  bool (*supported)();
+};
+
+bool always() { return true; }
+
+const char *stringEndScalar(const char *a_c) {
+  while (*a_c != '"' && *a_c != '\\' &&
+         static_cast<unsigned char>(*a_c) >= 0x20) {
+    ++a_c;
+  }
+  return a_c;
+}
+
+const char *skipWhitespaceScalar(const char *a_c) {
+  while (*a_c == ' ' || *a_c == '\n' || *a_c == '\t' || *a_c == '\r') {
+    ++a_c;
+  }
+  return a_c;
+}
+
+#ifdef JSON_SCAN_X86
+
+bool hasAVX2() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+}
+
+JSON_SCAN_KERNEL inline uint32_t stringEndMaskSSE2(const char *a_block) {
+  const __m128i v = _mm_load_si128(reinterpret_cast<const __m128i *>(a_block));
+  const __m128i limit = _mm_set1_epi8(0x1F);
+  // Unsigned v <= 0x1F, bytes from 0x80 are not control characters
+  const __m128i control = _mm_cmpeq_epi8(_mm_max_epu8(v, limit), limit);
+  const __m128i quote = _mm_cmpeq_epi8(v, _mm_set1_epi8('"'));
+  const __m128i backslash = _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'));
+  return static_cast<uint32_t>(_mm_movemask_epi8(
+      _mm_or_si128(control, _mm_or_si128(quote, backslash))));
+}
+
+JSON_SCAN_KERNEL inline uint32_t whitespaceMaskSSE2(const char *a_block) {
+  const __m128i v = _mm_load_si128(reinterpret_cast<const __m128i *>(a_block));
+  const __m128i ws = _mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                   _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))),
+      _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\t')),
+                   _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+  return static_cast<uint32_t>(_mm_movemask_epi8(ws));
+}
+
+JSON_SCAN_KERNEL const char *stringEndSSE2(const char *a_c) {
+  const size_t offset = reinterpret_cast<uintptr_t>(a_c) & 15;
+  const char *block = a_c - offset;
+  uint32_t mask = stringEndMaskSSE2(block) & (0xFFFFu << offset);
+  while (mask == 0) {
+    block += 16;
+    mask = stringEndMaskSSE2(block);
+  }
+  return block + __builtin_ctz(mask);
+}
+
+JSON_SCAN_KERNEL const char *skipWhitespaceSSE2(const char *a_c) {
+  const size_t offset = reinterpret_cast<uintptr_t>(a_c) & 15;
+  const char *block = a_c - offset;
+  uint32_t mask = ~whitespaceMaskSSE2(block) & (0xFFFFu << offset) & 0xFFFFu;
+  while (mask == 0) {
+    block += 16;
+    mask = ~whitespaceMaskSSE2(block) & 0xFFFFu;
+  }
+  return block + __builtin_ctz(mask);
+}
+
+__attribute__((target("avx2"))) JSON_SCAN_KERNEL inline uint32_t
+stringEndMaskAVX2(const char *a_block) {
+  const __m256i v =
+      _mm256_load_si256(reinterpret_cast<const __m256i *>(a_block));
+  const __m256i limit = _mm256_set1_epi8(0x1F);
+  const __m256i control =
+      _mm256_cmpeq_epi8(_mm256_max_epu8(v, limit), limit);
+  const __m256i quote = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('"'));
+  const __m256i backslash = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'));
+  return static_cast<uint32_t>(_mm256_movemask_epi8(
+      _mm256_or_si256(control, _mm256_or_si256(quote, backslash))));
+}
+
+__attribute__((target("avx2"))) JSON_SCAN_KERNEL inline uint32_t
+whitespaceMaskAVX2(const char *a_block) {
+  const __m256i v =
+      _mm256_load_si256(reinterpret_cast<const __m256i *>(a_block));
+  const __m256i ws = _mm256_or_si256(
+      _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+                      _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))),
+      _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')),
+                      _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'))));
+  return static_cast<uint32_t>(_mm256_movemask_epi8(ws));
+}
+
+__attribute__((target("avx2"))) JSON_SCAN_KERNEL const char *
+stringEndAVX2(const char *a_c) {
+  const size_t offset = reinterpret_cast<uintptr_t>(a_c) & 31;
+  const char *block = a_c - offset;
+  uint32_t mask = stringEndMaskAVX2(block) & (0xFFFFFFFFu << offset);
+  while (mask == 0) {
+    block += 32;
+    mask = stringEndMaskAVX2(block);
+  }
+  return block + __builtin_ctz(mask);
+}
+
+__attribute__((target("avx2"))) JSON_SCAN_KERNEL const char *
+skipWhitespaceAVX2(const char *a_c) {
+  const size_t offset = reinterpret_cast<uintptr_t>(a_c) & 31;
+  const char *block = a_c - offset;
+  uint32_t mask = ~whitespaceMaskAVX2(block) & (0xFFFFFFFFu << offset);
+  while (mask == 0) {
+    block += 32;
+    mask = ~whitespaceMaskAVX2(block);
+  }
+  return block + __builtin_ctz(mask);
+}
+
+#endif // JSON_SCAN_X86
+
+#ifdef JSON_SCAN_NEON
+
+/// Narrows a byte comparison to a mask with four bits per byte
+JSON_SCAN_KERNEL inline uint64_t nibbleMask(uint8x16_t a_matches) {
+  return vget_lane_u64(
+      vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(a_matches), 4)), 0);
+}
+
+JSON_SCAN_KERNEL inline uint64_t stringEndMaskNEON(const char *a_block) {
+  const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t *>(a_block));
+  const uint8x16_t special =
+      vorrq_u8(vorrq_u8(vceqq_u8(v, vdupq_n_u8('"')),
+                        vceqq_u8(v, vdupq_n_u8('\\'))),
+               vcleq_u8(v, vdupq_n_u8(0x1F)));
+  return nibbleMask(special);
+}
+
+JSON_SCAN_KERNEL inline uint64_t whitespaceMaskNEON(const char *a_block) {
+  const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t *>(a_block));
+  const uint8x16_t ws =
+      vorrq_u8(vorrq_u8(vceqq_u8(v, vdupq_n_u8(' ')),
+                        vceqq_u8(v, vdupq_n_u8('\n'))),
+               vorrq_u8(vceqq_u8(v, vdupq_n_u8('\t')),
+                        vceqq_u8(v, vdupq_n_u8('\r'))));
+  return nibbleMask(ws);
+}
+
+JSON_SCAN_KERNEL const char *stringEndNEON(const char *a_c) {
+  const size_t offset = reinterpret_cast<uintptr_t>(a_c) & 15;
+  const char *block = a_c - offset;
+  uint64_t mask = stringEndMaskNEON(block) & (~0ull << (offset * 4));
+  while (mask == 0) {
+    block += 16;
+    mask = stringEndMaskNEON(block);
+  }
+  return block + (__builtin_ctzll(mask) >> 2);
+}
+
+JSON_SCAN_KERNEL const char *skipWhitespaceNEON(const char *a_c) {
+  const size_t offset = reinterpret_cast<uintptr_t>(a_c) & 15;
+  const char *block = a_c - offset;
+  uint64_t mask = ~whitespaceMaskNEON(block) & (~0ull << (offset * 4));
+  while (mask == 0) {
+    block += 16;
+    mask = ~whitespaceMaskNEON(block);
+  }
+  return block + (__builtin_ctzll(mask) >> 2);
+}
+
+#endif // JSON_SCAN_NEON
+
+/// Best first, the scalar kernel last as it runs anywhere
+const Kernel KERNELS[] = {
+#ifdef JSON_SCAN_X86
+    {"avx2", stringEndAVX2, skipWhitespaceAVX2, hasAVX2},
+    {"sse2", stringEndSSE2, skipWhitespaceSSE2, always},
+#endif
+#ifdef JSON_SCAN_NEON
+    {"neon", stringEndNEON, skipWhitespaceNEON, always},
+#endif
+    {"scalar", stringEndScalar, skipWhitespaceScalar, always}};
+
+const Kernel *detect() {
+  for (const Kernel &kernel : KERNELS) {
+    if (kernel.supported()) {
+      return &kernel;
+    }
+  }
+  return nullptr;
+}
+
+std::atomic<const Kernel *> &current() {
+  static std::atomic<const Kernel *> kernel(detect());
+  return kernel;
+}
+
+} // namespace
+
+const char *stringEnd(const char *a_c) {
+  return current().load(std::memory_order_relaxed)->string_end(a_c);
+}
+
+const char *skipWhitespace(const char *a_c) {
+  return current().load(std::memory_order_relaxed)->skip_whitespace(a_c);
+}
+
+const char *kernel() {
+  return current().load(std::memory_order_relaxed)->name;
+}
+
+std::vector<std::string> kernels() {
+  std::vector<std::string> names;
+  for (const Kernel &kernel : KERNELS) {
+    if (kernel.supported()) {
+      names.push_back(kernel.name);
+    }
+  }
+  return names;
+}
+
+bool useKernel(const std::string &a_name) {
+  for (const Kernel &kernel : KERNELS) {
+    if (a_name == kernel.name && kernel.supported()) {
+      current().store(&kernel, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace scan
+} // namespace libjson
@@ -0,0 +1,153 @@
+// Local public includes
+#include "common/JsonWriter.hpp"
+#include "common/JsonScanner.hpp"
+#include "common/fpconv.h"
+
+namespace libjson {
+
+namespace {
+
+/// Largest buffer a thread keeps between documents, bigger ones are freed
+const size_t MAX_KEPT_CAPACITY = 4 * 1024 * 1024;
+
+std::string &threadBuffer() {
+  thread_local std::string buffer;
+  return buffer;
+}
+
+} // namespace
+
+void escape(std::string &a_buffer, const std::string &a_value) {
+  escape(a_buffer, a_value.c_str(), a_value.size());
+}
+
+void escape(std::string &a_buffer, const char *a_value, size_t a_size) {
+  static const char hex[] = "0123456789ABCDEF";
+  const char *c = a_value;
+  const char *end = a_value + a_size;
+
+  // Runs without anything to escape are found by the scanner kernel and
+  // copied whole
+  while (true) {
+    const char *stop = scan::stringEnd(c);
+    a_buffer.append(c, stop);
+
+    if (stop == end)
+      break;
+
+    const unsigned char s = *stop;
+    if (s == '"') {
+      a_buffer.append("\\\"", 2);
+    } else if (s == '\\') {
+      a_buffer.append("\\\\", 2);
+    } else {
+      const char unicode[] = {'\\', 'u', '0', '0', hex[s >> 4], hex[s & 0xF]};
+      a_buffer.append(unicode, sizeof(unicode));
+    }
+    c = stop + 1;
+  }
+}
+
+Writer::Writer() : m_comma(false) {
+  m_buffer.swap(threadBuffer());
+  m_buffer.clear();
+}
+
+Writer::~Writer() {
+  std::string &kept = threadBuffer();
+
+  // A nested writer may hold a larger buffer than the outer one returns
+  if (m_buffer.capacity() > kept.capacity() &&
+      m_buffer.capacity() <= MAX_KEPT_CAPACITY)
+    kept.swap(m_buffer);
+}
+
+Writer &Writer::beginObject() {
+  separate();
+  m_buffer.push_back('{');
+  m_comma = false;
+  return *this;
+}
+
+Writer &Writer::endObject() {
+  m_buffer.push_back('}');
+  m_comma = true;
+  return *this;
+}
+
+Writer &Writer::beginArray() {
+  separate();
+  m_buffer.push_back('[');
+  m_comma = false;
+  return *this;
+}
+
+Writer &Writer::endArray() {
+  m_buffer.push_back(']');
+  m_comma = true;
+  return *this;
+}
+
+Writer &Writer::key(const char *a_key) {
+  separate();
+  m_buffer.push_back('"');
+  escape(m_buffer, a_key, std::char_traits<char>::length(a_key));
+  m_buffer.append("\":", 2);
+  m_comma = false;
+  return *this;
+}
+
+Writer &Writer::key(const std::string &a_key) {
+  separate();
+  m_buffer.push_back('"');
+  escape(m_buffer, a_key);
+  m_buffer.append("\":", 2);
+  m_comma = false;
+  return *this;
+}
+
+Writer &Writer::string(const std::string &a_value) {
+  separate();
+  m_buffer.push_back('"');
+  escape(m_buffer, a_value);
+  m_buffer.push_back('"');
+  return *this;
+}
+
+Writer &Writer::string(const char *a_value) {
+  separate();
+  m_buffer.push_back('"');
+  escape(m_buffer, a_value, std::char_traits<char>::length(a_value));
+  m_buffer.push_back('"');
+  return *this;
+}
+
+Writer &Writer::number(double a_value) {
+  char digits[24];
+  separate();
+  m_buffer.append(digits, fpconv_dtoa(a_value, digits));
+  return *this;
+}
+
+Writer &Writer::boolean(bool a_value) {
+  separate();
+  if (a_value)
+    m_buffer.append("true", 4);
+  else
+    m_buffer.append("false", 5);
+  return *this;
+}
+
+Writer &Writer::null() {
+  separate();
+  m_buffer.append("null", 4);
+  return *this;
+}
+
+Writer &Writer::raw(const std::string &a_json) {
+  separate();
+  m_buffer.append(a_json);
+  return *this;
+}
+
+} // namespace libjson
@@ -21,11 +21,21 @@ MessageFactory::create(const MessageType msg_type) const {
   EXCEPT(1, "Unsupported MessageType specified in MessageFactory.");
 }
 
+std::unique_ptr<IMessage>
+MessageFactory::createReceived(const MessageType msg_type) const {
+
+  if (msg_type == MessageType::GOOGLE_PROTOCOL_BUFFER) {
+    return std::unique_ptr<IMessage>(new GoogleProtoMessage(false));
+  }
+  EXCEPT(1, "Unsupported MessageType specified in MessageFactory.");
+}
+
 std::unique_ptr<IMessage>
 MessageFactory::createResponseEnvelope(const IMessage &msg) const {
 
   if (msg.type() == MessageType::GOOGLE_PROTOCOL_BUFFER) {
-    auto new_msg = std::unique_ptr<IMessage>(new GoogleProtoMessage());
+    // The id of the request is copied, so none is generated
+    auto new_msg = std::unique_ptr<IMessage>(new GoogleProtoMessage(false));
     new_msg->setRoutes(msg.getRoutes());
     new_msg->set(MessageAttribute::STATE, MessageState::RESPONSE);
     new_msg->set(
@@ -45,6 +55,11 @@ MessageFactory::createResponseEnvelope(const IMessage &msg) const {
       EXCEPT_PARAM(1, error_msg);
     }
     new_msg->set(constants::message::google::CONTEXT, context);
+    // Reply using the same envelope layout the requester can read
+    if (msg.exists(constants::message::google::WIRE_VERSION)) {
+      new_msg->set(constants::message::google::WIRE_VERSION,
+                   msg.get(constants::message::google::WIRE_VERSION));
+    }
     return new_msg;
   }
   EXCEPT(1, "Unsupported MessageType specified in MessageFactory.");
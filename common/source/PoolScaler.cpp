@@ -0,0 +1,58 @@
+// Local public includes
+#include "common/PoolScaler.hpp"
+#include "common/TraceException.hpp"
+
+namespace SDMS {
+
+PoolScaler::PoolScaler(const Options &options) : m_options(options) {
+  if (m_options.min_workers == 0) {
+    EXCEPT(1, "A worker pool must keep at least one worker");
+  }
+  if (m_options.max_workers < m_options.min_workers) {
+    EXCEPT_PARAM(1, "Worker pool maximum " << m_options.max_workers
+                                           << " is below its minimum "
+                                           << m_options.min_workers);
+  }
+  if (m_options.shrink_busy_ratio >= m_options.grow_busy_ratio) {
+    EXCEPT(1, "Worker pool shrink ratio must be below its grow ratio");
+  }
+}
+
+size_t PoolScaler::sample(size_t workers, double busy_ratio,
+                          std::chrono::steady_clock::duration queue_wait) {
+  if (workers < m_options.min_workers || workers > m_options.max_workers) {
+    m_hot_samples = 0;
+    m_cold_samples = 0;
+    return workers < m_options.min_workers ? m_options.min_workers
+                                           : m_options.max_workers;
+  }
+
+  const bool waiting = queue_wait >= m_options.grow_queue_wait;
+  if (waiting && busy_ratio >= m_options.grow_busy_ratio) {
+    m_cold_samples = 0;
+    if (++m_hot_samples >= m_options.grow_after &&
+        workers < m_options.max_workers) {
+      m_hot_samples = 0;
+      return workers + 1;
+    }
+    return workers;
+  }
+  m_hot_samples = 0;
+
+  // The work of the pool spread over one worker less must not look busy
+  const bool idle =
+      !waiting && busy_ratio <= m_options.shrink_busy_ratio && workers > 1 &&
+      busy_ratio * workers / (workers - 1) < m_options.grow_busy_ratio;
+  if (!idle) {
+    m_cold_samples = 0;
+    return workers;
+  }
+  if (++m_cold_samples >= m_options.shrink_after &&
+      workers > m_options.min_workers) {
+    m_cold_samples = 0;
+    return workers - 1;
+  }
+  return workers;
+}
+
+} // namespace SDMS
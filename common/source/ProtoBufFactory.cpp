@@ -18,15 +18,23 @@ ProtoBufFactory::ProtoBufFactory() {
 }
 
 std::unique_ptr<::google::protobuf::Message>
-ProtoBufFactory::create(uint16_t desc_type) {
-  const ::google::protobuf::Descriptor *msg_descriptor =
-      m_proto_map.getDescriptorType(desc_type);
-  return create(msg_descriptor);
+ProtoBufFactory::create(uint16_t desc_type) const {
+  // Prototypes of registered types are cached by the shared ProtoBufMap which
+  // avoids a locked lookup in the protobuf generated factory
+  ::google::protobuf::Message *mutable_msg =
+      m_proto_map.getPrototype(desc_type)->New();
+
+  if (mutable_msg == nullptr) {
+    EXCEPT(1, "Failed in prototype_msg->New(); to create mutable message");
+  }
+
+  return std::unique_ptr<::google::protobuf::Message>(mutable_msg);
 }
 
 // https://stackoverflow.com/questions/29960871/protobuf-message-object-creation-by-name
 std::unique_ptr<::google::protobuf::Message>
-ProtoBufFactory::create(const ::google::protobuf::Descriptor *msg_descriptor) {
+ProtoBufFactory::create(
+    const ::google::protobuf::Descriptor *msg_descriptor) const {
   const ::google::protobuf::Message *prototype_msg =
       m_factory->GetPrototype(msg_descriptor);
 
@@ -21,9 +21,10 @@ class ProtoBufFactory {
 
 public:
   ProtoBufFactory();
-  std::unique_ptr<::google::protobuf::Message> create(uint16_t desc_type);
   std::unique_ptr<::google::protobuf::Message>
-  create(const ::google::protobuf::Descriptor *msg_descriptor);
+  create(uint16_t desc_type) const;
+  std::unique_ptr<::google::protobuf::Message>
+  create(const ::google::protobuf::Descriptor *msg_descriptor) const;
 };
 
 } // namespace SDMS
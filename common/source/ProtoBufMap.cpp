@@ -9,15 +9,45 @@
 #include <google/protobuf/descriptor.h>
 #include <google/protobuf/message.h>
 
+// Standard includes
+#include <array>
+#include <vector>
+
 namespace proto = ::google::protobuf;
 
 namespace SDMS {
 
-ProtoBufMap::ProtoBufMap() {
-  // These two code blocks should be templatized to make them DRY
+namespace {
+const size_t NUMBER_OF_PROTOCOLS = 2;
+
+size_t protocolIndex(MessageProtocol msg_protocol) {
+  return msg_protocol == MessageProtocol::GOOGLE_ANONONYMOUS ? 0 : 1;
+}
+} // namespace
+
+/**
+ * Immutable lookup tables shared by every ProtoBufMap
+ *
+ * Descriptors and their default instances are stored densely by protocol ID
+ * and message index, so both directions of the mapping are a couple of array
+ * reads. A descriptor already knows its file and its index in that file, which
+ * is all that is needed to recover its message type without hashing.
+ **/
+struct ProtoBufMap::Registry {
+  std::array<const proto::FileDescriptor *, 256> files{};
+  std::array<std::vector<const proto::Descriptor *>, 256> descriptors;
+  std::array<std::vector<const proto::Message *>, 256> prototypes;
+  std::array<uint8_t, NUMBER_OF_PROTOCOLS> protocol_ids{};
+
+  Registry() {
+    registerProtocol(Anon::Protocol_descriptor(),
+                     MessageProtocol::GOOGLE_ANONONYMOUS);
+    registerProtocol(Auth::Protocol_descriptor(),
+                     MessageProtocol::GOOGLE_AUTHORIZED);
+  }
 
-  {
-    auto a_enum_desc = Anon::Protocol_descriptor();
+  void registerProtocol(const proto::EnumDescriptor *a_enum_desc,
+                        MessageProtocol msg_protocol) {
     if (a_enum_desc->name() != "Protocol")
       EXCEPT(EC_PROTO_INIT, "Must register with Protocol EnumDescriptor.");
 
@@ -31,67 +61,88 @@ ProtoBufMap::ProtoBufMap() {
     if (!val_desc)
       EXCEPT(EC_PROTO_INIT, "Protocol enum missing required ID field.");
 
-    uint16_t id = val_desc->number();
-    // std::cout << __FILE__ << ":" << __LINE__ << " PROTOCOL id is " << id <<
-    // std::endl;
-    m_file_descriptor_map[id] = file;
+    if (val_desc->number() < 0 || val_desc->number() > 255)
+      EXCEPT_PARAM(EC_PROTO_INIT,
+                   "Protocol ID out of range: " << val_desc->number());
 
+    uint8_t id = static_cast<uint8_t>(val_desc->number());
     int count = file->message_type_count();
-    uint16_t msg_type = id << 8;
+    if (count > 256)
+      EXCEPT_PARAM(EC_PROTO_INIT, "Too many messages in protocol "
+                                      << (unsigned int)id << ": " << count);
 
-    for (int i = 0; i < count; i++, msg_type++) {
+    proto::MessageFactory *factory =
+        proto::MessageFactory::generated_factory();
+
+    files[id] = file;
+    descriptors[id].reserve(count);
+    prototypes[id].reserve(count);
+    for (int i = 0; i < count; i++) {
       const proto::Descriptor *desc = file->message_type(i);
-      m_descriptor_map[msg_type] = desc;
-      // Register Message types from  Anon
-      m_msg_type_map[desc] = msg_type;
+      const proto::Message *prototype = factory->GetPrototype(desc);
+      if (!prototype)
+        EXCEPT_PARAM(EC_PROTO_INIT,
+                     "Cannot create prototype message for " << desc->name());
+      descriptors[id].push_back(desc);
+      prototypes[id].push_back(prototype);
     }
-    m_protocol_ids[MessageProtocol::GOOGLE_ANONONYMOUS] = id;
+    protocol_ids[protocolIndex(msg_protocol)] = id;
   }
-  {
-    auto a_enum_desc = Auth::Protocol_descriptor();
-    if (a_enum_desc->name() != "Protocol")
-      EXCEPT(EC_PROTO_INIT, "Must register with Protocol EnumDescriptor.");
-
-    const proto::FileDescriptor *file = a_enum_desc->file();
-    if (!file)
-      EXCEPT(EC_PROTO_INIT,
-             "Failed to acquire protocol buffer file descriptor.");
 
-    const proto::EnumValueDescriptor *val_desc =
-        a_enum_desc->FindValueByName("ID");
-    if (!val_desc)
-      EXCEPT(EC_PROTO_INIT, "Protocol enum missing required ID field.");
-
-    uint16_t id = val_desc->number();
-    // std::cout << "PROTOCOL id is " << id << std::endl;
-    // std::cout << __FILE__ << ":" << __LINE__ << " PROTOCOL id is " << id <<
-    // std::endl;
-    m_file_descriptor_map[id] = file;
+  const proto::Descriptor *find(uint16_t message_type) const noexcept {
+    const auto &protocol = descriptors[message_type >> 8];
+    const size_t index = message_type & 0xFF;
+    return index < protocol.size() ? protocol[index] : nullptr;
+  }
 
-    int count = file->message_type_count();
-    uint16_t msg_type = id << 8;
+  const proto::Message *prototype(uint16_t message_type) const noexcept {
+    const auto &protocol = prototypes[message_type >> 8];
+    const size_t index = message_type & 0xFF;
+    return index < protocol.size() ? protocol[index] : nullptr;
+  }
 
-    for (int i = 0; i < count; i++, msg_type++) {
-      const proto::Descriptor *desc = file->message_type(i);
-      m_descriptor_map[msg_type] = desc;
-      m_msg_type_map[desc] = msg_type;
+  bool find(const proto::Descriptor *desc, uint16_t &message_type) const
+      noexcept {
+    // Only top level messages are registered
+    if (desc->containing_type()) {
+      return false;
+    }
+    for (uint8_t id : protocol_ids) {
+      if (files[id] == desc->file()) {
+        message_type = (static_cast<uint16_t>(id) << 8) | desc->index();
+        return find(message_type) == desc;
+      }
     }
-    m_protocol_ids[MessageProtocol::GOOGLE_AUTHORIZED] = id;
+    return false;
   }
+};
+
+const ProtoBufMap::Registry &ProtoBufMap::registry() {
+  // Built on first use, initialization of a function local static is thread
+  // safe and the registry is never modified afterwards
+  static const Registry instance;
+  return instance;
 }
 
-uint16_t ProtoBufMap::getMessageType(proto::Message &a_msg) {
+ProtoBufMap::ProtoBufMap() : m_registry(registry()) {}
+
+bool ProtoBufMap::exists(uint16_t message_type) const noexcept {
+  return m_registry.find(message_type) != nullptr;
+}
+
+uint16_t ProtoBufMap::getMessageType(const proto::Message &a_msg) const {
   const proto::Descriptor *desc = a_msg.GetDescriptor();
-  if (m_msg_type_map.count(desc) == 0) {
+  uint16_t msg_type = 0;
+  if (!m_registry.find(desc, msg_type)) {
     EXCEPT_PARAM(EC_INVALID_PARAM,
                  "Unknown descriptor encountered: " << desc->name());
   }
-  return m_msg_type_map.at(desc);
+  return msg_type;
 }
 
 std::string ProtoBufMap::toString(uint16_t msg_type) const {
-  if (m_descriptor_map.count(msg_type)) {
-    return m_descriptor_map.at(msg_type)->name();
+  if (const proto::Descriptor *desc = m_registry.find(msg_type)) {
+    return desc->name();
   }
   EXCEPT_PARAM(1, "Provided message type is unknown cannot retrieve name.");
 }
@@ -99,49 +150,50 @@ std::string ProtoBufMap::toString(uint16_t msg_type) const {
 uint16_t ProtoBufMap::getMessageType(uint8_t a_proto_id,
                                      const std::string &a_message_name) {
 
-  // std::cout << "PROTOCOL id is " << a_proto_id << std::endl;
-  // std::cout << __FILE__ << ":" << __LINE__ << " PROTOCOL id is " <<
-  // static_cast<uint16_t>(a_proto_id) << std::endl;
-  if (m_file_descriptor_map.count(a_proto_id) == 0) {
-    EXCEPT_PARAM(EC_INVALID_PARAM,
-                 "Protocol ID " << a_proto_id << " has not been registered.");
+  const proto::FileDescriptor *file = m_registry.files[a_proto_id];
+  if (!file) {
+    EXCEPT_PARAM(EC_INVALID_PARAM, "Protocol ID "
+                                       << (unsigned int)a_proto_id
+                                       << " has not been registered.");
   }
 
-  const proto::Descriptor *desc = m_file_descriptor_map.at(a_proto_id)
-                                      ->FindMessageTypeByName(a_message_name);
+  const proto::Descriptor *desc = file->FindMessageTypeByName(a_message_name);
   if (!desc)
     EXCEPT_PARAM(EC_PROTO_INIT, "Could not find specified message: "
                                     << a_message_name << " for protocol: "
                                     << (unsigned int)a_proto_id);
 
-  if (m_msg_type_map.count(desc) == 0) {
+  uint16_t msg_type = 0;
+  if (!m_registry.find(desc, msg_type)) {
     EXCEPT_PARAM(EC_INVALID_PARAM, "Message name \""
                                        << a_message_name
                                        << "\" is not registered with protocol "
-                                       << a_proto_id);
+                                       << (unsigned int)a_proto_id);
   }
 
-  return m_msg_type_map.at(desc);
+  return msg_type;
 }
 
 const proto::Descriptor *
 ProtoBufMap::getDescriptorType(uint16_t message_type) const {
-  if (m_descriptor_map.count(message_type)) {
-    return m_descriptor_map.at(message_type);
-  } else {
-    EXCEPT_PARAM(EC_PROTO_INIT,
-                 "Descriptor type mapping failed, unregistered message type "
-                     << message_type);
+  if (const proto::Descriptor *desc = m_registry.find(message_type)) {
+    return desc;
   }
+  EXCEPT_PARAM(EC_PROTO_INIT,
+               "Descriptor type mapping failed, unregistered message type "
+                   << message_type);
 }
 
-uint8_t ProtoBufMap::getProtocolID(MessageProtocol msg_protocol) const {
-  if (m_protocol_ids.count(msg_protocol)) {
-    return static_cast<uint8_t>(m_protocol_ids.at(msg_protocol));
-  } else {
-    EXCEPT(
-        1,
-        "Unsupported MessageProtocol specified, cannot map to a protocol id");
+const proto::Message *ProtoBufMap::getPrototype(uint16_t message_type) const {
+  if (const proto::Message *prototype = m_registry.prototype(message_type)) {
+    return prototype;
   }
+  EXCEPT_PARAM(EC_PROTO_INIT,
+               "Prototype lookup failed, unregistered message type "
+                   << message_type);
+}
+
+uint8_t ProtoBufMap::getProtocolID(MessageProtocol msg_protocol) const {
+  return m_registry.protocol_ids[protocolIndex(msg_protocol)];
 }
 } // namespace SDMS
@@ -1,6 +1,7 @@
 
 // Local private includes
 #include "servers/Proxy.hpp"
+#include "servers/ProxyLanes.hpp"
 
 // Local public includes
 #include "common/IServer.hpp"
@@ -45,4 +46,18 @@ std::unique_ptr<IServer> ServerFactory::create(
   EXCEPT_PARAM(1, "Error Server type unsupported");
 }
 
+std::unique_ptr<IServer> ServerFactory::create(
+    ServerType server_type,
+    const std::unordered_map<SocketRole, SocketOptions> &socket_options,
+    const std::unordered_map<SocketRole, ICredentials *> &socket_credentials,
+    const LaneOptions &lane_options) {
+
+  if (server_type == ServerType::PROXY_LANES) {
+    return std::unique_ptr<IServer>(new ProxyLanes(
+        socket_options, socket_credentials, lane_options, m_log_context));
+  }
+
+  EXCEPT_PARAM(1, "Error only PROXY_LANES servers are built from lane options");
+}
+
 } // namespace SDMS
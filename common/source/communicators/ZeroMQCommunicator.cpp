@@ -1,7 +1,9 @@
 // Local private includes
 #include "ZeroMQCommunicator.hpp"
+#include "../Envelope.hpp"
 #include "../Frame.hpp"
 #include "../ProtoBufFactory.hpp"
+#include "../messages/GoogleProtoMessage.hpp"
 #include "../support/zeromq/Context.hpp"
 #include "../support/zeromq/SocketTranslator.hpp"
 
@@ -12,6 +14,7 @@
 #include "common/ProtoBufMap.hpp"
 #include "common/SocketFactory.hpp"
 #include "common/SocketOptions.hpp"
+#include "common/ZapHandler.hpp"
 
 // Third party includes
 #include <boost/range/adaptor/reversed.hpp>
@@ -19,6 +22,9 @@
 
 // Standard includes
 #include <arpa/inet.h>
+#include <cstdlib>
+#include <cstring>
+#include <list>
 #include <string>
 #include <unordered_map>
 
@@ -28,6 +34,7 @@ namespace proto = ::google::protobuf;
 namespace SDMS {
 
 using namespace constants::message::google;
+namespace envelope = constants::message::envelope;
 
 /******************************************************************************
  * Local File Scoped Functions
@@ -58,6 +65,43 @@ void sendFinalDelimiter(void *outgoing_zmq_socket) {
   zmq_msg_close(&zmq_msg);
 }
 
+/**
+ * Sends the identity parts a ROUTER socket needs to pick the peer. These are
+ * sent ahead of the envelope in both layouts. Returns the routes that still
+ * need to be carried inside the envelope.
+ **/
+std::list<std::string> sendEnvelopeRoutes(IMessage &msg,
+                                          void *outgoing_zmq_socket,
+                                          const int zmq_socket_type) {
+
+  // If this is a response then we need to attach the identity of the server
+  // that the response needs to be sent to
+  auto routes = msg.getRoutes();
+
+  // The ZMQ ROUTER always needs to know who to send too.
+  if (std::get<MessageState>(msg.get(MessageAttribute::STATE)) ==
+          MessageState::RESPONSE or
+      zmq_socket_type == ZMQ_ROUTER) {
+    while (routes.size() != 0) {
+
+      auto route = routes.front();
+      zmq_msg_t zmq_msg;
+      zmq_msg_init_size(&zmq_msg, route.size());
+
+      memcpy(zmq_msg_data(&zmq_msg), route.data(), route.size());
+      int number_of_bytes = 0;
+      if ((number_of_bytes =
+               zmq_msg_send(&zmq_msg, outgoing_zmq_socket, ZMQ_SNDMORE)) < 0) {
+        EXCEPT(1, "sendRoute zmq_msg_send (route) failed.");
+      }
+
+      zmq_msg_close(&zmq_msg);
+      routes.pop_front();
+    }
+  }
+  return routes;
+}
+
 /**
  * The only time we can expect an additional prefixed message is if the
  * server is of the ROUTER type.
@@ -106,39 +150,11 @@ void sendFinalDelimiter(void *outgoing_zmq_socket) {
 // 0 - number of routes
 // null
 // Frame - function will not read
+//
+// Everything up to and including "BEGIN_DATAFED" has already been read by
+// receiveEnvelope, previous_route is the last route found ahead of it.
 void receiveRoute(IMessage &msg, void *incoming_zmq_socket,
-                  LogContext log_context) {
-  // If the first frame is not empty assume it is a route that was provided by
-  // the internals of zmq
-  std::string previous_route = "";
-  std::string received_part = "";
-  while (received_part.compare("BEGIN_DATAFED") != 0) {
-    zmq_msg_t zmq_msg;
-    zmq_msg_init(&zmq_msg);
-    int number_of_bytes = 0;
-    if ((number_of_bytes =
-             zmq_msg_recv(&zmq_msg, incoming_zmq_socket, ZMQ_DONTWAIT)) < 0) {
-      EXCEPT(1, "receiveRoute zmq_msg_recv (route) failed.");
-    }
-    size_t len = zmq_msg_size(&zmq_msg);
-    if (len) {
-      if (len > 255) {
-        EXCEPT(1, "Message route segment exceeds max allowed length.");
-      }
-      received_part =
-          std::string((char *)zmq_msg_data(&zmq_msg), zmq_msg_size(&zmq_msg));
-      if (received_part.compare("BEGIN_DATAFED") == 0) {
-        zmq_msg_close(&zmq_msg);
-        break;
-      } else {
-        previous_route = received_part;
-        msg.addRoute(received_part);
-      }
-    } else {
-    }
-    zmq_msg_close(&zmq_msg);
-  }
-
+                  std::string previous_route, LogContext log_context) {
   uint32_t number_of_routes = 0;
   {
     zmq_msg_t zmq_msg;
@@ -209,35 +225,21 @@ void receiveRoute(IMessage &msg, void *incoming_zmq_socket,
   }
 }
 
+/**
+ * Sends the legacy route section. A request sent with hint set carries extra
+ * leading null delimiters which legacy receivers skip, and which tell an
+ * up-to-date receiver that the compact envelope may be used in reply.
+ **/
 void sendRoute(IMessage &msg, void *outgoing_zmq_socket,
-               const int zmq_socket_type) {
-
-  // If this is a response then we need to attach the identity of the server
-  // that the response needs to be sent to
-  auto routes = msg.getRoutes();
-
-  // The ZMQ ROUTER always needs to know who to send too.
-  if (std::get<MessageState>(msg.get(MessageAttribute::STATE)) ==
-          MessageState::RESPONSE or
-      zmq_socket_type == ZMQ_ROUTER) {
-    while (routes.size() != 0) {
-
-      auto route = routes.front();
-      zmq_msg_t zmq_msg;
-      zmq_msg_init_size(&zmq_msg, route.size());
+               const int zmq_socket_type, const bool hint) {
 
-      memcpy(zmq_msg_data(&zmq_msg), route.data(), route.size());
-      int number_of_bytes = 0;
-      if ((number_of_bytes =
-               zmq_msg_send(&zmq_msg, outgoing_zmq_socket, ZMQ_SNDMORE)) < 0) {
-        EXCEPT(1, "sendRoute zmq_msg_send (route) failed.");
-      }
+  auto routes = sendEnvelopeRoutes(msg, outgoing_zmq_socket, zmq_socket_type);
 
-      zmq_msg_close(&zmq_msg);
-      routes.pop_front();
+  if (hint) {
+    for (size_t i = 1; i < envelope::COMPACT_HINT_DELIMITERS; ++i) {
+      sendDelimiter(outgoing_zmq_socket);
     }
   }
-
   sendDelimiter(outgoing_zmq_socket);
   { // Send header
     zmq_msg_t zmq_msg;
@@ -347,8 +349,12 @@ void sendFrame(IMessage &msg, void *outgoing_zmq_socket) {
 /**
  * Will load the body of the message if there is one. Or else it will do
  * nothing.
+ *
+ * The payload is parsed directly from the zmq message storage, no intermediate
+ * copy is made and there is no limit on the body size beyond the 32 bit frame
+ * size.
  **/
-void receiveBody(IMessage &msg, Buffer &buffer, ProtoBufFactory &factory,
+void receiveBody(IMessage &msg, ProtoBufFactory &factory,
                  void *incoming_zmq_socket, LogContext log_context) {
 
   if (msg.exists(FRAME_SIZE)) {
@@ -373,13 +379,16 @@ void receiveBody(IMessage &msg, Buffer &buffer, ProtoBufFactory &factory,
                             << ", got: " << zmq_msg_size(&zmq_msg));
       }
 
-      copyToBuffer(buffer, zmq_msg_data(&zmq_msg), frame_size);
       uint16_t desc_type = std::get<uint16_t>(msg.get(MSG_TYPE));
       std::unique_ptr<proto::Message> payload = factory.create(desc_type);
       if (payload == nullptr) {
         EXCEPT(1, "No payload was assigned something is wrong");
       }
-      copyFromBuffer(payload.get(), buffer);
+      if (!payload->ParseFromArray(zmq_msg_data(&zmq_msg), frame_size)) {
+        zmq_msg_close(&zmq_msg);
+        EXCEPT_PARAM(1, "RCV Unable to parse message body of type: "
+                            << desc_type << " size: " << frame_size);
+      }
       msg.setPayload(std::move(payload));
     } else {
 
@@ -408,16 +417,16 @@ void receiveBody(IMessage &msg, Buffer &buffer, ProtoBufFactory &factory,
   }
 }
 
-void sendBody(IMessage &msg, Buffer &buffer, void *outgoing_zmq_socket) {
+/**
+ * Serializes the payload directly into the zmq message storage, which is then
+ * handed to zmq without further copies.
+ **/
+void sendBody(IMessage &msg, void *outgoing_zmq_socket) {
 
   if (msg.exists(FRAME_SIZE)) {
 
     uint32_t frame_size = std::get<uint32_t>(msg.get(FRAME_SIZE));
     if (frame_size > 0) {
-      zmq_msg_t zmq_msg;
-
-      zmq_msg_init_size(&zmq_msg, frame_size);
-
       proto::Message *payload;
       try {
         payload = std::get<proto::Message *>(msg.getPayload());
@@ -432,18 +441,29 @@ void sendBody(IMessage &msg, Buffer &buffer, void *outgoing_zmq_socket) {
                               << size << " frame size: " << frame_size);
         }
 
-        copyToBuffer<proto::Message *>(buffer, payload, size);
-        copyFromBuffer<void *>(zmq_msg_data(&zmq_msg), buffer);
+        if (!payload->IsInitialized()) {
+          EXCEPT(1, "Cannot send message it is missing required fields");
+        }
+
+        zmq_msg_t zmq_msg;
+        zmq_msg_init_size(&zmq_msg, frame_size);
+
+        if (!payload->SerializeToArray(zmq_msg_data(&zmq_msg), frame_size)) {
+          zmq_msg_close(&zmq_msg);
+          EXCEPT(1, "SerializeToArray for message body failed.");
+        }
+
         int number_of_bytes = 0;
         if ((number_of_bytes = zmq_msg_send(&zmq_msg, outgoing_zmq_socket, 0)) <
             0) {
+          zmq_msg_close(&zmq_msg);
           EXCEPT(1, "zmq_msg_send (body) failed.");
         }
+        // zmq_msg_send takes ownership of the storage on success
+        zmq_msg_close(&zmq_msg);
       } else {
         EXCEPT(1, "Payload not defined... something went wrong");
       }
-
-      zmq_msg_close(&zmq_msg);
     } else {
 
       sendFinalDelimiter(outgoing_zmq_socket);
@@ -599,12 +619,204 @@ void sendID(IMessage &msg, void *outgoing_zmq_socket) {
   zmq_msg_close(&zmq_msg);
 }
 
+/**
+ * Sends the compact envelope header, preceded by any identity parts the
+ * socket needs. The body part is sent separately by sendBody.
+ **/
+void sendEnvelope(IMessage &msg, void *outgoing_zmq_socket,
+                  const int zmq_socket_type) {
+  auto routes = sendEnvelopeRoutes(msg, outgoing_zmq_socket, zmq_socket_type);
+
+  EnvelopeConverter converter;
+  const size_t header_size = converter.size(msg, routes);
+
+  zmq_msg_t zmq_msg;
+  zmq_msg_init_size(&zmq_msg, header_size);
+  try {
+    converter.encode(msg, routes, zmq_msg_data(&zmq_msg), header_size);
+  } catch (...) {
+    zmq_msg_close(&zmq_msg);
+    throw;
+  }
+
+  int number_of_bytes = 0;
+  if ((number_of_bytes =
+           zmq_msg_send(&zmq_msg, outgoing_zmq_socket, ZMQ_SNDMORE)) < 0) {
+    zmq_msg_close(&zmq_msg);
+    EXCEPT(1, "zmq_msg_send (envelope) failed.");
+  }
+  zmq_msg_close(&zmq_msg);
+}
+
+/**
+ * Connection metadata stamped by the ZAP handler, it is read from the part
+ * that starts the envelope and applied once the envelope has been decoded.
+ **/
+struct ConnectionMetadata {
+  std::string user_id;
+  uint32_t token = 0;
+
+  void read(zmq_msg_t *zmq_msg) {
+    const char *token_property =
+        zmq_msg_gets(zmq_msg, constants::zap::TOKEN_PROPERTY.c_str());
+    const char *user_id_property = zmq_msg_gets(zmq_msg, "User-Id");
+    if (token_property && user_id_property && user_id_property[0]) {
+      token = static_cast<uint32_t>(std::strtoul(token_property, nullptr, 10));
+      user_id = user_id_property;
+    }
+  }
+
+  /// Replaces whatever ID the sender put in the envelope
+  void apply(IMessage &msg) const {
+    if (token) {
+      msg.set(MessageAttribute::ID, user_id);
+      msg.set(CONNECTION_TOKEN, token);
+    }
+  }
+};
+
+/**
+ * Reads everything ahead of the message body, in either envelope layout.
+ *
+ * Non-empty parts ahead of the envelope are identities added by ROUTER
+ * sockets and are treated as routes. A compact header ends the envelope,
+ * while "BEGIN_DATAFED" starts the legacy layout, whose remaining parts are
+ * then read one at a time. The wire version attribute of the message is set
+ * to the highest version the sender is known to understand. If the ZAP handler
+ * gave the connection a token, the ID is the UID it resolved.
+ **/
+void receiveEnvelope(IMessage &msg, void *incoming_zmq_socket,
+                     LogContext log_context) {
+  size_t number_of_delimiters = 0;
+  std::string previous_route = "";
+  ConnectionMetadata connection;
+  while (true) {
+    zmq_msg_t zmq_msg;
+    zmq_msg_init(&zmq_msg);
+    int number_of_bytes = 0;
+    if ((number_of_bytes =
+             zmq_msg_recv(&zmq_msg, incoming_zmq_socket, ZMQ_DONTWAIT)) < 0) {
+      EXCEPT(1, "receiveEnvelope zmq_msg_recv (route) failed.");
+    }
+    const size_t len = zmq_msg_size(&zmq_msg);
+    const char *data = (const char *)zmq_msg_data(&zmq_msg);
+
+    if (len == 0) {
+      ++number_of_delimiters;
+    } else if (EnvelopeConverter::isHeader(data, len)) {
+      connection.read(&zmq_msg);
+      EnvelopeConverter converter;
+      try {
+        converter.decode(data, len, msg);
+      } catch (...) {
+        zmq_msg_close(&zmq_msg);
+        throw;
+      }
+      if (!zmq_msg_more(&zmq_msg)) {
+        zmq_msg_close(&zmq_msg);
+        EXCEPT(1, "Compact envelope must be followed by a message body.");
+      }
+      zmq_msg_close(&zmq_msg);
+      connection.apply(msg);
+      msg.set(WIRE_VERSION, envelope::COMPACT);
+      DL_TRACE(log_context, "Received compact envelope.");
+      return;
+    } else if (std::string(data, len).compare("BEGIN_DATAFED") == 0) {
+      connection.read(&zmq_msg);
+      zmq_msg_close(&zmq_msg);
+      break;
+    } else {
+      if (len > 255) {
+        zmq_msg_close(&zmq_msg);
+        EXCEPT(1, "Message route segment exceeds max allowed length.");
+      }
+      previous_route = std::string(data, len);
+      msg.addRoute(previous_route);
+    }
+    zmq_msg_close(&zmq_msg);
+  }
+
+  receiveRoute(msg, incoming_zmq_socket, previous_route, log_context);
+  receiveCorrelationID(msg, incoming_zmq_socket, log_context);
+  receiveKey(msg, incoming_zmq_socket, log_context);
+  receiveID(msg, incoming_zmq_socket, log_context);
+  receiveFrame(msg, incoming_zmq_socket, log_context);
+  connection.apply(msg);
+
+  if (number_of_delimiters >= envelope::COMPACT_HINT_DELIMITERS) {
+    msg.set(WIRE_VERSION, envelope::COMPACT);
+  } else {
+    msg.set(WIRE_VERSION, envelope::LEGACY);
+  }
+}
+
 } // namespace
 
 /******************************************************************************
  * Private Class Methods
  ******************************************************************************/
 
+/**
+ * Enables ZMTP heartbeats if requested, a peer that misses heartbeats for
+ * three intervals is considered dead and the connection is re-established.
+ **/
+void ZeroMQCommunicator::zmqHeartbeatSetup(
+    const SocketOptions &socket_options) {
+  if (not socket_options.heartbeat_interval) {
+    return;
+  }
+  const int heartbeat_ivl = *socket_options.heartbeat_interval;
+  const int heartbeat_timeout = 3 * heartbeat_ivl;
+
+  zmq_setsockopt(m_zmq_socket, ZMQ_HEARTBEAT_IVL, &heartbeat_ivl,
+                 sizeof(const int));
+  zmq_setsockopt(m_zmq_socket, ZMQ_HEARTBEAT_TIMEOUT, &heartbeat_timeout,
+                 sizeof(const int));
+  zmq_setsockopt(m_zmq_socket, ZMQ_HEARTBEAT_TTL, &heartbeat_timeout,
+                 sizeof(const int));
+}
+
+/**
+ * Decides which envelope layout to send a message with. A ROUTER socket knows
+ * each of its peers by identity, the first route of the message. A response
+ * from any other socket mirrors the request, and any other request uses the
+ * layout last seen from the peer.
+ **/
+bool ZeroMQCommunicator::sendCompact(const IMessage &msg) const {
+  if (m_zmq_socket_type == ZMQ_ROUTER) {
+    const auto &routes = msg.getRoutes();
+    return routes.size() && m_compact_peers.count(routes.front());
+  }
+  if (std::get<MessageState>(msg.get(MessageAttribute::STATE)) ==
+      MessageState::RESPONSE) {
+    return msg.exists(WIRE_VERSION) &&
+           std::get<uint8_t>(msg.get(WIRE_VERSION)) == envelope::COMPACT;
+  }
+  return m_peer_compact;
+}
+
+void ZeroMQCommunicator::rememberWireVersion(const IMessage &msg) {
+  const bool compact =
+      std::get<uint8_t>(msg.get(WIRE_VERSION)) == envelope::COMPACT;
+  if (m_zmq_socket_type == ZMQ_ROUTER) {
+    const auto &routes = msg.getRoutes();
+    if (routes.empty()) {
+      return;
+    }
+    if (not compact) {
+      m_compact_peers.erase(routes.front());
+    } else {
+      // Identities of short lived clients are never erased
+      if (m_compact_peers.size() >= MAX_COMPACT_PEERS) {
+        m_compact_peers.clear();
+      }
+      m_compact_peers.insert(routes.front());
+    }
+  } else {
+    m_peer_compact = compact;
+  }
+}
+
 ICommunicator::Response
 ZeroMQCommunicator::m_poll(uint32_t timeout_milliseconds) {
   zmq_pollitem_t items[] = {{m_zmq_socket, 0, ZMQ_POLLIN, 0}};
@@ -630,6 +842,53 @@ ZeroMQCommunicator::m_poll(uint32_t timeout_milliseconds) {
   return response;
 }
 
+ICommunicator::Response
+ZeroMQCommunicator::m_receive(const MessageType message_type,
+                              long timeout_milliseconds) {
+  Response response = m_poll(timeout_milliseconds);
+  LogContext log_context = m_log_context;
+  if (response.error == false and response.time_out == false) {
+    response.message = m_msg_factory.createReceived(message_type);
+    receiveEnvelope(*response.message, m_zmq_socket, log_context);
+    receiveBody(*response.message, m_protocol_factory, m_zmq_socket,
+                log_context);
+    // Senders always send one, a sender that does not is given one here
+    if (!response.message->exists(MessageAttribute::CORRELATION_ID)) {
+      response.message->set(MessageAttribute::CORRELATION_ID,
+                            newCorrelationID());
+    }
+    rememberWireVersion(*response.message);
+
+    uint16_t msg_type = std::get<uint16_t>(
+        response.message->get(constants::message::google::MSG_TYPE));
+    ProtoBufMap proto_map;
+
+    log_context.correlation_id = std::get<std::string>(
+        response.message->get(MessageAttribute::CORRELATION_ID));
+    std::string log_message = "Received message on communicator id: " + id();
+    log_message += ", msg type: " + proto_map.toString(msg_type);
+    log_message += ", receiving from address: " + address();
+    DL_DEBUG(log_context, log_message);
+  } else {
+    if (response.error) {
+      std::string err_message =
+          "Error encountered for communicator id: " + id();
+      err_message += ", error is: " + response.error_msg;
+      err_message += ", receiving from address: " + address();
+      DL_ERROR(log_context, err_message);
+    } else if (response.time_out) {
+      std::string err_message =
+          "Timeout encountered for communicator id: " + id();
+      err_message += ", timeout occurred after: " +
+                     std::to_string(timeout_milliseconds) + " ms";
+      err_message += ", receiving from address: " + address();
+      DL_TRACE(log_context, err_message);
+    }
+  }
+
+  return response;
+}
+
 /******************************************************************************
  * Public Class Methods
  ******************************************************************************/
@@ -673,6 +932,7 @@ ZeroMQCommunicator::ZeroMQCommunicator(const SocketOptions &socket_options,
                  sizeof(const int));
   zmq_setsockopt(m_zmq_socket, ZMQ_LINGER, &linger_milliseconds,
                  sizeof(const int));
+  zmqHeartbeatSetup(socket_options);
 
   std::string id = m_socket->getID();
 
@@ -733,51 +993,6 @@ ZeroMQCommunicator::~ZeroMQCommunicator() {
   }
 }
 
-ICommunicator::Response
-ZeroMQCommunicator::poll(const MessageType message_type) {
-  Response response = m_poll(m_timeout_on_poll_milliseconds);
-  LogContext log_context = m_log_context;
-  if (response.error == false and response.time_out == false) {
-    response.message = m_msg_factory.create(message_type);
-    receiveRoute(*response.message, m_zmq_socket, log_context);
-    receiveCorrelationID(*response.message, m_zmq_socket, log_context);
-    receiveKey(*response.message, m_zmq_socket, log_context);
-    receiveID(*response.message, m_zmq_socket, log_context);
-    receiveFrame(*response.message, m_zmq_socket, log_context);
-
-    receiveBody(*response.message, m_buffer, m_protocol_factory, m_zmq_socket,
-                log_context);
-
-    uint16_t msg_type = std::get<uint16_t>(
-        response.message->get(constants::message::google::MSG_TYPE));
-    ProtoBufMap proto_map;
-
-    log_context.correlation_id = std::get<std::string>(
-        response.message->get(MessageAttribute::CORRELATION_ID));
-    std::string err_message = "Received message on communicator id: " + id();
-    err_message += ", msg type: " + proto_map.toString(msg_type);
-    err_message += ", receiving from address: " + address();
-    DL_DEBUG(log_context, err_message);
-  } else {
-    if (response.error) {
-      std::string err_message =
-          "Error encountered for communicator id: " + id();
-      err_message += ", error is: " + response.error_msg;
-      err_message += ", receiving from address: " + address();
-      DL_ERROR(log_context, err_message);
-    } else if (response.time_out) {
-      std::string err_message =
-          "Timeout encountered for communicator id: " + id();
-      err_message +=
-          ", timeout occurred after: " + m_timeout_on_poll_milliseconds;
-      err_message += ", receiving from address: " + address();
-      DL_TRACE(log_context, err_message);
-    }
-  }
-
-  return response;
-}
-
 void ZeroMQCommunicator::send(IMessage &message) {
 
   uint16_t msg_type =
@@ -790,55 +1005,44 @@ void ZeroMQCommunicator::send(IMessage &message) {
   err_message += ", to address: " + address() +
                  ", msg type: " + proto_map.toString(msg_type);
   DL_DEBUG(log_context, err_message);
-  sendRoute(message, m_zmq_socket, m_zmq_socket_type);
-  sendCorrelationID(message, m_zmq_socket);
-  sendKey(message, m_zmq_socket);
-  sendID(message, m_zmq_socket);
-  sendFrame(message, m_zmq_socket);
-  sendBody(message, m_buffer, m_zmq_socket);
+  if (sendCompact(message)) {
+    sendEnvelope(message, m_zmq_socket, m_zmq_socket_type);
+  } else {
+    // Requests advertise that the compact envelope can be used in reply
+    const bool hint = std::get<MessageState>(message.get(
+                          MessageAttribute::STATE)) == MessageState::REQUEST;
+    sendRoute(message, m_zmq_socket, m_zmq_socket_type, hint);
+    sendCorrelationID(message, m_zmq_socket);
+    sendKey(message, m_zmq_socket);
+    sendID(message, m_zmq_socket);
+    sendFrame(message, m_zmq_socket);
+  }
+  sendBody(message, m_zmq_socket);
+}
+
+ICommunicator::Response
+ZeroMQCommunicator::poll(const MessageType message_type) {
+  return m_receive(message_type, m_timeout_on_poll_milliseconds);
 }
 
 ICommunicator::Response
 ZeroMQCommunicator::receive(const MessageType message_type) {
+  return m_receive(message_type, m_timeout_on_receive_milliseconds);
+}
 
-  Response response = m_poll(m_timeout_on_receive_milliseconds);
-  LogContext log_context = m_log_context;
-  if (response.error == false and response.time_out == false) {
-    response.message = m_msg_factory.create(message_type);
-    receiveRoute(*response.message, m_zmq_socket, log_context);
-    receiveCorrelationID(*response.message, m_zmq_socket, log_context);
-    receiveKey(*response.message, m_zmq_socket, log_context);
-    receiveID(*response.message, m_zmq_socket, log_context);
-    receiveFrame(*response.message, m_zmq_socket, log_context);
-    receiveBody(*response.message, m_buffer, m_protocol_factory, m_zmq_socket,
-                log_context);
+ICommunicator::Response
+ZeroMQCommunicator::tryReceive(const MessageType message_type) {
+  return m_receive(message_type, 0);
+}
 
-    uint16_t msg_type = std::get<uint16_t>(
-        response.message->get(constants::message::google::MSG_TYPE));
-    ProtoBufMap proto_map;
-    log_context.correlation_id = std::get<std::string>(
-        response.message->get(MessageAttribute::CORRELATION_ID));
-    std::string log_message = "Received message on communicator id: " + id();
-    log_message += ", msg type: " + proto_map.toString(msg_type);
-    log_message += ", receiving from address: " + address();
-    DL_DEBUG(log_context, log_message);
-  } else {
-    if (response.error) {
-      std::string err_message =
-          "Error encountered for communicator id: " + id();
-      err_message += ", error is: " + response.error_msg;
-      err_message += ", receiving from address: " + address();
-      DL_ERROR(log_context, err_message);
-    } else if (response.time_out) {
-      std::string err_message =
-          "Timeout encountered for communicator id: " + id();
-      err_message +=
-          ", timeout occurred after: " + m_timeout_on_poll_milliseconds;
-      err_message += ", receiving from address: " + address();
-      DL_TRACE(log_context, err_message);
-    }
+int ZeroMQCommunicator::fileDescriptor() const noexcept {
+  // Edge triggered, zmq clears it when the socket is checked for messages
+  int fd = -1;
+  size_t fd_size = sizeof(fd);
+  if (zmq_getsockopt(m_zmq_socket, ZMQ_FD, &fd, &fd_size) != 0) {
+    return -1;
   }
-  return response;
+  return fd;
 }
 
 const std::string ZeroMQCommunicator::id() const noexcept {
@@ -2,9 +2,6 @@
 #define ZEROMQ_COMMUNICATOR_HPP
 #pragma once
 
-// Local private includes
-#include "../Buffer.hpp"
-
 // Local public includes
 #include "../ProtoBufFactory.hpp"
 #include "common/DynaLog.hpp"
@@ -12,6 +9,7 @@
 #include "common/IMessage.hpp"
 #include "common/ISocket.hpp"
 #include "common/MessageFactory.hpp"
+#include "common/SocketOptions.hpp"
 
 // Third party includes
 #include <zmq.hpp>
@@ -19,6 +17,7 @@
 // Standard includes
 #include <memory>
 #include <string>
+#include <unordered_set>
 
 namespace SDMS {
 
@@ -33,11 +32,23 @@ protected:
   uint32_t m_timeout_on_receive_milliseconds = 0;
   long m_timeout_on_poll_milliseconds = 10;
   MessageFactory m_msg_factory;
-  Buffer m_buffer;
   ProtoBufFactory m_protocol_factory;
   ICommunicator::Response m_poll(uint32_t timeout_milliseconds);
+  ICommunicator::Response m_receive(const MessageType message_type,
+                                    long timeout_milliseconds);
 
   void zmqCurveSetup(const ICredentials &credentials);
+  void zmqHeartbeatSetup(const SocketOptions &socket_options);
+
+  /// Upper bound on the number of ROUTER peers remembered
+  static const size_t MAX_COMPACT_PEERS = 4096;
+  /// Set while the peer of a non-ROUTER socket accepts the compact envelope
+  bool m_peer_compact = false;
+  /// Identities of ROUTER peers that accept the compact envelope
+  std::unordered_set<std::string> m_compact_peers;
+
+  bool sendCompact(const IMessage &msg) const;
+  void rememberWireVersion(const IMessage &msg);
 
   LogContext m_log_context;
 
@@ -63,6 +74,13 @@ public:
 
   virtual void send(IMessage &message) final;
   virtual ICommunicator::Response receive(const MessageType) final;
+  virtual ICommunicator::Response tryReceive(const MessageType) final;
+
+  /// The zmq socket, so that several communicators can be waited on with a
+  /// single zmq_poll call
+  void *socket() const noexcept { return m_zmq_socket; }
+
+  virtual int fileDescriptor() const noexcept final;
 
   virtual const std::string id() const noexcept final;
   virtual const std::string address() const noexcept final;
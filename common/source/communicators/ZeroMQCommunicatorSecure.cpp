@@ -180,6 +180,7 @@ ZeroMQCommunicatorSecure::ZeroMQCommunicatorSecure(
                  sizeof(const int));
   zmq_setsockopt(m_zmq_socket, ZMQ_LINGER, &linger_milliseconds,
                  sizeof(const int));
+  zmqHeartbeatSetup(socket_options);
 
   std::string id = m_socket->getID();
 
@@ -3,7 +3,6 @@
 #pragma once
 
 // Local private includes
-#include "../Buffer.hpp"
 #include "ZeroMQCommunicator.hpp"
 
 // Local public includes
@@ -19,17 +19,28 @@
 
 namespace SDMS {
 
-GoogleProtoMessage::GoogleProtoMessage() {
+/**
+ * Correlation ids only need to be unique, not unpredictable, so each thread
+ * seeds a Mersenne Twister from the OS entropy source once and reuses it. The
+ * default boost generator reads from the entropy source for every id.
+ **/
+std::string newCorrelationID() {
+  thread_local boost::uuids::random_generator_mt19937 generator;
+  return boost::uuids::to_string(generator());
+}
+
+GoogleProtoMessage::GoogleProtoMessage(bool a_correlation_id) {
   m_dyn_attributes[constants::message::google::FRAME_SIZE] = (uint32_t)0;
   m_dyn_attributes[constants::message::google::PROTO_ID] = (uint8_t)0;
   m_dyn_attributes[constants::message::google::MSG_ID] = (uint8_t)0;
   m_dyn_attributes[constants::message::google::MSG_TYPE] = (uint16_t)0;
   m_dyn_attributes[constants::message::google::CONTEXT] = (uint16_t)0;
+  m_dyn_attributes[constants::message::google::WIRE_VERSION] = (uint8_t)1;
+  m_dyn_attributes[constants::message::google::CONNECTION_TOKEN] = (uint32_t)0;
 
-  boost::uuids::random_generator generator;
-  boost::uuids::uuid uuid = generator();
-  m_attributes[MessageAttribute::CORRELATION_ID] =
-      boost::uuids::to_string(uuid);
+  if (a_correlation_id) {
+    m_attributes[MessageAttribute::CORRELATION_ID] = newCorrelationID();
+  }
 }
 
 bool GoogleProtoMessage::exists(MessageAttribute attribute_type) const {
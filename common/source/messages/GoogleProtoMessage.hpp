@@ -18,6 +18,10 @@
 #include <variant>
 
 namespace SDMS {
+
+/// A new correlation id, made from a generator kept by the calling thread
+std::string newCorrelationID();
+
 /**
  * NOTES
  *
@@ -38,7 +42,12 @@ namespace SDMS {
  **/
 class GoogleProtoMessage : public IMessage {
 public:
-  GoogleProtoMessage();
+  /**
+   * Messages are built with a correlation id of their own unless
+   * a_correlation_id is false, for messages whose id is copied in from a
+   * request or from the wire.
+   **/
+  explicit GoogleProtoMessage(bool a_correlation_id = true);
 
 private:
   MessageState m_state = MessageState::REQUEST;
@@ -26,15 +26,21 @@ void AuthenticationOperator::execute(IMessage &message) {
     EXCEPT(1, "'KEY' attribute not defined.");
   }
 
-  m_authentication_manager->purge();
+  // The ID of a message from a connection the ZAP handler gave a token is the
+  // UID it resolved, it stays trusted until the key is revoked
+  const std::string &token_attribute =
+      constants::message::google::CONNECTION_TOKEN;
+  if (message.exists(token_attribute)) {
+    const uint32_t token = std::get<uint32_t>(message.get(token_attribute));
+    if (token && m_authentication_manager->isConnectionValid(token)) {
+      return;
+    }
+  }
 
   std::string key = std::get<std::string>(message.get(MessageAttribute::KEY));
 
   std::string uid = "anon";
-  if (m_authentication_manager->hasKey(key)) {
-    m_authentication_manager->incrementKeyAccessCounter(key);
-    uid = m_authentication_manager->getUID(key);
-  }
+  m_authentication_manager->findUID(key, uid);
   message.set(MessageAttribute::ID, uid);
 }
 
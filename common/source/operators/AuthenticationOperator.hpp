@@ -33,6 +33,10 @@ class AuthenticationOperator : public IOperator {
    * In addition to checking the public key and mapping it to a user id the
    * operator will count the number of times the key is accessed (If it is
    * known).
+   *
+   * Messages from connections that the ZAP handler already resolved carry a
+   * connection token, if the token is still valid the message keeps the UID
+   * stamped on the connection and none of the above is needed.
    **/
 public:
   explicit AuthenticationOperator(std::any &options);
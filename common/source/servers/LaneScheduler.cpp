@@ -0,0 +1,152 @@
+// Local private includes
+#include "LaneScheduler.hpp"
+
+// Local public includes
+#include "common/TraceException.hpp"
+
+namespace SDMS {
+
+LaneScheduler::LaneScheduler(size_t number_of_workers, size_t max_bulk_workers,
+                             size_t requests_per_worker)
+    : m_max_bulk_requests(max_bulk_workers * requests_per_worker),
+      m_requests_per_worker(requests_per_worker),
+      m_active_workers(number_of_workers), m_workers(number_of_workers) {
+  if (number_of_workers == 0) {
+    EXCEPT(1, "LaneScheduler requires at least one worker");
+  }
+  if (max_bulk_workers == 0) {
+    EXCEPT(1, "LaneScheduler must allow at least one worker to run BULK "
+              "requests");
+  }
+  if (requests_per_worker == 0) {
+    EXCEPT(1, "LaneScheduler workers must run at least one request");
+  }
+}
+
+void LaneScheduler::push(RequestLane lane, std::unique_ptr<IMessage> message,
+                         clock::time_point now) {
+  m_lanes[static_cast<size_t>(lane)].push_back(Queued{now, std::move(message)});
+}
+
+void LaneScheduler::setActiveWorkers(size_t workers, size_t max_bulk_workers) {
+  if (workers == 0 || workers > m_workers.size()) {
+    EXCEPT_PARAM(1, "LaneScheduler cannot activate " << workers << " of "
+                                                     << m_workers.size()
+                                                     << " workers");
+  }
+  if (max_bulk_workers == 0) {
+    EXCEPT(1, "LaneScheduler must allow at least one worker to run BULK "
+              "requests");
+  }
+  m_active_workers = workers;
+  m_max_bulk_requests = max_bulk_workers * m_requests_per_worker;
+}
+
+LaneScheduler::clock::duration
+LaneScheduler::oldestWait(clock::time_point now) const {
+  clock::duration wait = clock::duration::zero();
+  for (const auto &queue : m_lanes) {
+    if (!queue.empty() && now - queue.front().since > wait) {
+      wait = now - queue.front().since;
+    }
+  }
+  return wait;
+}
+
+bool LaneScheduler::next(size_t &worker, std::unique_ptr<IMessage> &message,
+                         clock::time_point now) {
+  // Least loaded active worker, the lowest numbered one on a tie so a lightly
+  // loaded proxy keeps using the same few workers
+  size_t least_loaded = m_active_workers;
+  for (size_t candidate = 0; candidate < m_active_workers; ++candidate) {
+    if (m_workers[candidate].stalled) {
+      continue;
+    }
+    if (least_loaded == m_active_workers ||
+        m_workers[candidate].running.size() <
+            m_workers[least_loaded].running.size()) {
+      least_loaded = candidate;
+    }
+  }
+  if (least_loaded == m_active_workers ||
+      m_workers[least_loaded].running.size() >= m_requests_per_worker) {
+    return false;
+  }
+
+  size_t lane = 0;
+  for (; lane < NUMBER_OF_LANES; ++lane) {
+    if (m_lanes[lane].empty()) {
+      continue;
+    }
+    if (lane == static_cast<size_t>(RequestLane::BULK) &&
+        m_busy_bulk >= m_max_bulk_requests) {
+      continue;
+    }
+    break;
+  }
+  if (lane == NUMBER_OF_LANES) {
+    return false;
+  }
+
+  worker = least_loaded;
+  message = std::move(m_lanes[lane].front().message);
+  m_lanes[lane].pop_front();
+
+  Running request;
+  if (message->exists(MessageAttribute::CORRELATION_ID)) {
+    request.correlation_id =
+        std::get<std::string>(message->get(MessageAttribute::CORRELATION_ID));
+  }
+  request.lane = static_cast<RequestLane>(lane);
+  request.started_at = now;
+  m_workers[worker].running.push_back(std::move(request));
+  ++m_busy;
+  if (lane == static_cast<size_t>(RequestLane::BULK)) {
+    ++m_busy_bulk;
+  }
+  return true;
+}
+
+void LaneScheduler::release(Worker &worker,
+                            std::deque<Running>::iterator request) {
+  --m_busy;
+  if (request->lane == RequestLane::BULK) {
+    --m_busy_bulk;
+  }
+  worker.running.erase(request);
+}
+
+bool LaneScheduler::done(size_t worker, const std::string &correlation_id) {
+  if (worker >= m_workers.size() || m_workers[worker].running.empty()) {
+    return false;
+  }
+  std::deque<Running> &running = m_workers[worker].running;
+  auto request = running.begin();
+  if (!correlation_id.empty()) {
+    for (auto it = running.begin(); it != running.end(); ++it) {
+      if (it->correlation_id == correlation_id) {
+        request = it;
+        break;
+      }
+    }
+  }
+  release(m_workers[worker], request);
+  return true;
+}
+
+size_t LaneScheduler::markStalled(clock::duration stale_after,
+                                  clock::time_point now) {
+  size_t stalled = 0;
+  for (Worker &worker : m_workers) {
+    // Requests are started in order, so the oldest one is at the front
+    const bool stale = !worker.running.empty() &&
+                       now - worker.running.front().started_at > stale_after;
+    if (stale && !worker.stalled) {
+      ++stalled;
+    }
+    worker.stalled = stale;
+  }
+  return stalled;
+}
+
+} // namespace SDMS
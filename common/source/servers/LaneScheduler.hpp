@@ -0,0 +1,124 @@
+#ifndef LANE_SCHEDULER_HPP
+#define LANE_SCHEDULER_HPP
+#pragma once
+
+// Local public includes
+#include "common/IMessage.hpp"
+#include "common/ServerFactory.hpp"
+
+// Standard includes
+#include <array>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace SDMS {
+
+/**
+ * Decides which worker runs which queued request, used by ProxyLanes.
+ *
+ * Requests wait in one FIFO queue per lane. Whenever a worker has room for a
+ * request it is given the oldest CHEAP request, else the oldest NORMAL
+ * request, else the oldest BULK request provided fewer than
+ * max_bulk_workers * requests_per_worker BULK requests are already running.
+ * A worker runs up to requests_per_worker requests at a time, the least
+ * loaded active worker is given the next request, and a request stops
+ * counting against its worker once the worker replies to it. Only the first
+ * activeWorkers() workers are given requests, so a pool can shrink by
+ * deactivating its last workers and waiting for them to finish. Workers that
+ * markStalled() finds stuck on a request are given none either.
+ *
+ * Not thread safe, the proxy owns it.
+ **/
+class LaneScheduler {
+public:
+  typedef std::chrono::steady_clock clock;
+  static const size_t NUMBER_OF_LANES = 3;
+
+  LaneScheduler(size_t number_of_workers, size_t max_bulk_workers,
+                size_t requests_per_worker = 1);
+
+  void push(RequestLane lane, std::unique_ptr<IMessage> message,
+            clock::time_point now = clock::now());
+
+  /**
+   * Takes the next request to run and the worker to run it, counting the
+   * request against the worker. Returns false if every worker is full or
+   * nothing can run.
+   **/
+  bool next(size_t &worker, std::unique_ptr<IMessage> &message,
+            clock::time_point now = clock::now());
+
+  /**
+   * Records that a worker replied to the request with the correlation ID, or
+   * to its oldest request if no running request has that ID. Returns false
+   * if the worker was not running any request.
+   **/
+  bool done(size_t worker, const std::string &correlation_id = "");
+
+  /**
+   * Marks as stalled the workers whose oldest request has been running for
+   * longer than stale_after, and clears the mark of those that have since
+   * replied to it. A stalled worker is given no requests, and its requests
+   * keep counting against it until it replies, since it may still be running
+   * them. Returns how many workers were newly marked.
+   **/
+  size_t markStalled(clock::duration stale_after,
+                     clock::time_point now = clock::now());
+
+  /**
+   * Gives requests only to the first workers, with at most max_bulk_workers
+   * of them running BULK requests. Requests already running on the others
+   * are unaffected.
+   **/
+  void setActiveWorkers(size_t workers, size_t max_bulk_workers);
+
+  size_t numberOfWorkers() const { return m_workers.size(); }
+  size_t activeWorkers() const { return m_active_workers; }
+  size_t requestsPerWorker() const { return m_requests_per_worker; }
+  /// Number of requests running on a worker
+  size_t running(size_t worker) const {
+    return m_workers[worker].running.size();
+  }
+  /// How long the oldest queued request has been waiting
+  clock::duration oldestWait(clock::time_point now = clock::now()) const;
+  size_t queued(RequestLane lane) const {
+    return m_lanes[static_cast<size_t>(lane)].size();
+  }
+  /// Number of requests running on all workers
+  size_t busy() const { return m_busy; }
+
+private:
+  struct Queued {
+    clock::time_point since;
+    std::unique_ptr<IMessage> message;
+  };
+
+  struct Running {
+    std::string correlation_id;
+    RequestLane lane = RequestLane::NORMAL;
+    clock::time_point started_at;
+  };
+
+  /// Running requests of a worker, oldest first
+  struct Worker {
+    std::deque<Running> running;
+    bool stalled = false;
+  };
+
+  void release(Worker &worker, std::deque<Running>::iterator request);
+
+  size_t m_max_bulk_requests;
+  size_t m_requests_per_worker;
+  size_t m_active_workers;
+  std::array<std::deque<Queued>, NUMBER_OF_LANES> m_lanes;
+  std::vector<Worker> m_workers;
+  size_t m_busy = 0;
+  size_t m_busy_bulk = 0;
+};
+
+} // namespace SDMS
+
+#endif // LANE_SCHEDULER_HPP
@@ -1,6 +1,8 @@
 
 // Local private includes
 #include "Proxy.hpp"
+#include "../communicators/ZeroMQCommunicator.hpp"
+#include "ProxyBatch.hpp"
 
 // Local public includes
 #include "common/CommunicatorFactory.hpp"
@@ -11,6 +13,9 @@
 #include "common/SDMS_Anon.pb.h"
 #include "common/SDMS_Auth.pb.h"
 
+// Third party includes
+#include <zmq.hpp>
+
 // Standard includes
 #include <exception>
 #include <iostream>
@@ -85,63 +90,58 @@ void Proxy::run() {
 
   auto end_time = std::chrono::steady_clock::now() + m_run_duration;
 
-  int count = 0;
+  // Both communicators are waited on with a single zmq_poll so a message
+  // arriving on either side is forwarded as soon as it is seen
+  auto client_comm = dynamic_cast<ZeroMQCommunicator *>(
+      m_communicators[SocketRole::CLIENT].get());
+  auto server_comm = dynamic_cast<ZeroMQCommunicator *>(
+      m_communicators[SocketRole::SERVER].get());
+  if (client_comm == nullptr or server_comm == nullptr) {
+    EXCEPT(1, "Custom proxy requires ZeroMQ communicators.");
+  }
+  zmq_pollitem_t items[] = {{client_comm->socket(), 0, ZMQ_POLLIN, 0},
+                            {server_comm->socket(), 0, ZMQ_POLLIN, 0}};
+
+  ProxyBatch batch(m_max_batch_size, m_log_context);
 
   while (m_run_infinite_loop or (end_time > std::chrono::steady_clock::now())) {
     try {
-      count++;
+      int events_detected = zmq_poll(items, 2, m_timeout_on_poll_milliseconds);
+      if (events_detected < 0) {
+        DL_ERROR(m_log_context,
+                 "Proxy::run - zmq_poll failed: " << zmq_strerror(zmq_errno()));
+        continue;
+      }
+
       // Coming from the client socket that is local so communication flow is
       // going from an internal thread/process
       //
       //                                              <- POLL_IN
       // Pub Client - Client Sock - Serv Sock - Proxy - Client Sock - Serv Sock
       // - Inter App
-      auto resp_from_client_socket = m_communicators[SocketRole::CLIENT]->poll(
-          MessageType::GOOGLE_PROTOCOL_BUFFER);
-
-      if (resp_from_client_socket.error) {
-        DL_ERROR(m_log_context, m_communicators[SocketRole::CLIENT]->id()
-                                    << " error detected: "
-                                    << resp_from_client_socket.error_msg);
-      }
-
-      // Coming from the server socket that is local so communication flow is
-      // coming from a public client thread/process
       //
-      //                              POLL_IN  ->
-      // Pub Client - Client Sock - Serv Sock - Proxy - Client Sock - Serv Sock
-      // - Inter App
-      auto resp_from_server_socket = m_communicators[SocketRole::SERVER]->poll(
-          MessageType::GOOGLE_PROTOCOL_BUFFER);
-      if (resp_from_server_socket.error) {
-        DL_ERROR(m_log_context, m_communicators[SocketRole::SERVER]->id()
-                                    << " error detected: "
-                                    << resp_from_server_socket.error_msg);
-      }
-
       // Essentially just route with out doing anything if flow is towards the
       // public
-      if (resp_from_client_socket.error == false and
-          resp_from_client_socket.time_out == false) {
-        m_communicators[SocketRole::SERVER]->send(
-            *resp_from_client_socket.message);
+      if (items[0].revents & ZMQ_POLLIN) {
+        batch.drain(*m_communicators[SocketRole::CLIENT]);
+        batch.send(*m_communicators[SocketRole::SERVER]);
       }
 
+      // Coming from the server socket that is local so communication flow is
+      // coming from a public client thread/process
+      //
       // If there are operations that need to happen on incoming messages,
       // messages headed to the internal server of which we are a client,
-      // they will now be executed.
+      // they will now be executed on the whole batch.
       //                 |            |
       //         POLL_IN ->           |
       //                 | Operate on -> Pass to internal Server
       //                 |            |
       // ... - Serv Sock - Proxy ------ Client Sock - Serv Sock - Inter App
-      if (resp_from_server_socket.error == false and
-          resp_from_server_socket.time_out == false) {
-        for (auto &in_operator : m_incoming_operators) {
-          in_operator->execute(*resp_from_server_socket.message);
-        }
-        m_communicators[SocketRole::CLIENT]->send(
-            *resp_from_server_socket.message);
+      if (items[1].revents & ZMQ_POLLIN) {
+        batch.drain(*m_communicators[SocketRole::SERVER]);
+        batch.operate(m_incoming_operators);
+        batch.send(*m_communicators[SocketRole::CLIENT]);
       }
 
     } catch (TraceException &e) {
@@ -22,6 +22,8 @@ class Proxy : public IServer {
 private:
   uint32_t m_timeout_on_receive_milliseconds = 50;
   long m_timeout_on_poll_milliseconds = 50;
+  /// Most messages forwarded in one direction before checking the other
+  size_t m_max_batch_size = 64;
   std::vector<std::unique_ptr<IOperator>> m_incoming_operators;
   std::unordered_map<SocketRole, std::unique_ptr<ICommunicator>>
       m_communicators;
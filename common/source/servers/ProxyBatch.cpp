@@ -0,0 +1,88 @@
+// Local private includes
+#include "ProxyBatch.hpp"
+
+// Local public includes
+#include "common/TraceException.hpp"
+
+// Standard includes
+#include <exception>
+
+using namespace std;
+
+namespace SDMS {
+
+ProxyBatch::ProxyBatch(size_t max_size, LogContext log_context)
+    : m_max_size(max_size), m_log_context(log_context) {
+  if (max_size == 0) {
+    EXCEPT(1, "ProxyBatch must hold at least one message");
+  }
+  m_messages.reserve(max_size);
+}
+
+size_t ProxyBatch::drain(ICommunicator &communicator) {
+  m_messages.clear();
+  while (m_messages.size() < m_max_size) {
+    ICommunicator::Response response;
+    try {
+      response = communicator.tryReceive(MessageType::GOOGLE_PROTOCOL_BUFFER);
+    } catch (TraceException &e) {
+      // The messages already received belong to other clients, keep them
+      DL_ERROR(m_log_context, communicator.id()
+                                  << " receive failed: " << e.toString());
+      break;
+    } catch (exception &e) {
+      DL_ERROR(m_log_context,
+               communicator.id() << " receive failed: " << e.what());
+      break;
+    }
+    if (response.error) {
+      DL_ERROR(m_log_context, communicator.id() << " error detected: "
+                                                << response.error_msg);
+      break;
+    }
+    if (response.time_out) {
+      break;
+    }
+    m_messages.push_back(std::move(response.message));
+  }
+  return m_messages.size();
+}
+
+void ProxyBatch::operate(std::vector<std::unique_ptr<IOperator>> &operators) {
+  for (auto &in_operator : operators) {
+    for (auto &message : m_messages) {
+      if (not message) {
+        continue;
+      }
+      try {
+        in_operator->execute(*message);
+      } catch (TraceException &e) {
+        DL_ERROR(m_log_context, "ProxyBatch::operate - " << e.toString());
+        message.reset();
+      } catch (exception &e) {
+        DL_ERROR(m_log_context, "ProxyBatch::operate - " << e.what());
+        message.reset();
+      }
+    }
+  }
+}
+
+void ProxyBatch::send(ICommunicator &communicator) {
+  for (auto &message : m_messages) {
+    if (not message) {
+      continue;
+    }
+    try {
+      communicator.send(*message);
+    } catch (TraceException &e) {
+      DL_ERROR(m_log_context, communicator.id()
+                                  << " send failed: " << e.toString());
+    } catch (exception &e) {
+      DL_ERROR(m_log_context,
+               communicator.id() << " send failed: " << e.what());
+    }
+  }
+  m_messages.clear();
+}
+
+} // namespace SDMS
@@ -0,0 +1,55 @@
+#ifndef PROXY_BATCH_HPP
+#define PROXY_BATCH_HPP
+#pragma once
+
+// Local public includes
+#include "common/DynaLog.hpp"
+#include "common/ICommunicator.hpp"
+#include "common/IMessage.hpp"
+#include "common/IOperator.hpp"
+
+// Standard includes
+#include <memory>
+#include <vector>
+
+namespace SDMS {
+
+/**
+ * The messages Proxy forwards in one direction in a single pass.
+ *
+ * A batch holds at most max_size messages, so one busy direction cannot
+ * starve the other, which the proxy serves in the same pass. A message that
+ * fails to be received, operated on or sent is logged and dropped on its own,
+ * the rest of the batch is still forwarded.
+ *
+ * Not thread safe, the proxy reuses one batch for both directions.
+ **/
+class ProxyBatch {
+public:
+  ProxyBatch(size_t max_size, LogContext log_context);
+
+  /**
+   * Receives the messages already waiting on the communicator, up to the
+   * limit. A failed receive ends the batch early and returns what was
+   * received before it.
+   **/
+  size_t drain(ICommunicator &communicator);
+
+  /// Runs every operator on every message of the batch
+  void operate(std::vector<std::unique_ptr<IOperator>> &operators);
+
+  /// Sends the messages of the batch in the order received and empties it
+  void send(ICommunicator &communicator);
+
+  size_t size() const noexcept { return m_messages.size(); }
+
+private:
+  size_t m_max_size;
+  LogContext m_log_context;
+  /// Dropped messages are left as null so the order of the rest is kept
+  std::vector<std::unique_ptr<IMessage>> m_messages;
+};
+
+} // namespace SDMS
+
+#endif // PROXY_BATCH_HPP
@@ -0,0 +1,265 @@
+// Local private includes
+#include "ProxyLanes.hpp"
+#include "../communicators/ZeroMQCommunicator.hpp"
+
+// Local public includes
+#include "common/CommunicatorFactory.hpp"
+#include "common/TraceException.hpp"
+
+// Third party includes
+#include <zmq.hpp>
+
+// Standard includes
+#include <algorithm>
+#include <exception>
+
+using namespace std;
+
+namespace SDMS {
+
+namespace {
+/// Replies carry the correlation ID of their request
+std::string correlationIdOf(IMessage &message) {
+  if (!message.exists(MessageAttribute::CORRELATION_ID)) {
+    return "";
+  }
+  return std::get<std::string>(message.get(MessageAttribute::CORRELATION_ID));
+}
+
+bool isScaling(const LaneOptions &lane_options) {
+  return lane_options.start_worker && lane_options.stop_worker;
+}
+
+/// One channel per worker of the largest pool
+size_t numberOfChannels(const LaneOptions &lane_options) {
+  if (!isScaling(lane_options)) {
+    return lane_options.number_of_workers;
+  }
+  return std::max(lane_options.number_of_workers,
+                  lane_options.scaling.max_workers);
+}
+} // namespace
+
+ProxyLanes::ProxyLanes(
+    const std::unordered_map<SocketRole, SocketOptions> &socket_options,
+    const std::unordered_map<SocketRole, ICredentials *> &socket_credentials,
+    const LaneOptions &lane_options, LogContext log_context)
+    : m_lanes(lane_options.lanes), m_stale_after(lane_options.stale_after),
+      m_scheduler(numberOfChannels(lane_options),
+                  lane_options.max_bulk_workers,
+                  lane_options.requests_per_worker),
+      m_start_worker(lane_options.start_worker),
+      m_stop_worker(lane_options.stop_worker),
+      m_started_workers(lane_options.number_of_workers),
+      m_initial_workers(lane_options.number_of_workers),
+      m_max_bulk_workers(lane_options.max_bulk_workers),
+      m_scale_period(lane_options.scale_period), m_log_context(log_context) {
+
+  if (socket_options.count(SocketRole::CLIENT) == 0) {
+    EXCEPT(1, "ProxyLanes must have socket options for Client");
+  }
+  if (socket_credentials.count(SocketRole::CLIENT) == 0) {
+    EXCEPT(1, "ProxyLanes must have socket credentials for Client");
+  }
+
+  if (socket_options.count(SocketRole::SERVER) == 0) {
+    EXCEPT(1, "ProxyLanes must have socket options for SERVER");
+  }
+  if (socket_credentials.count(SocketRole::SERVER) == 0) {
+    EXCEPT(1, "ProxyLanes must have socket credentials for SERVER");
+  }
+
+  if (socket_options.at(SocketRole::CLIENT).connection_life !=
+      SocketConnectionLife::PERSISTENT) {
+    EXCEPT(1, "ProxyLanes requires persistent worker channels, workers "
+              "connect to the proxy.");
+  }
+
+  CommunicatorFactory communication_factory(m_log_context);
+
+  m_server = communication_factory.create(
+      socket_options.at(SocketRole::SERVER),
+      *socket_credentials.at(SocketRole::SERVER),
+      m_timeout_on_receive_milliseconds, m_timeout_on_poll_milliseconds);
+
+  if (isScaling(lane_options)) {
+    m_scaler = std::make_unique<PoolScaler>(lane_options.scaling);
+    m_scheduler.setActiveWorkers(m_initial_workers,
+                                 lane_options.max_bulk_workers);
+  }
+
+  for (size_t worker = 0; worker < m_scheduler.numberOfWorkers(); ++worker) {
+    SocketOptions channel_options = socket_options.at(SocketRole::CLIENT);
+    channel_options.host += "_" + to_string(worker + 1);
+    if (channel_options.local_id) {
+      *channel_options.local_id += "_" + to_string(worker + 1);
+    }
+    m_channels.push_back(communication_factory.create(
+        channel_options, *socket_credentials.at(SocketRole::CLIENT),
+        m_timeout_on_receive_milliseconds, m_timeout_on_poll_milliseconds));
+  }
+
+  m_addresses[SocketRole::CLIENT] = m_channels.front()->address();
+  m_addresses[SocketRole::SERVER] = m_server->address();
+}
+
+void ProxyLanes::setRunDuration(std::chrono::duration<double> duration) {
+  m_run_infinite_loop = false;
+  m_run_duration = duration;
+}
+
+/**
+ * Receives every message already waiting on the communicator, up to the
+ * batch limit so that one busy socket cannot starve the others.
+ **/
+void ProxyLanes::drain(ICommunicator &communicator,
+                       std::vector<std::unique_ptr<IMessage>> &batch) {
+  batch.clear();
+  while (batch.size() < m_max_batch_size) {
+    auto response =
+        communicator.tryReceive(MessageType::GOOGLE_PROTOCOL_BUFFER);
+    if (response.error) {
+      DL_ERROR(m_log_context, communicator.id() << " error detected: "
+                                                << response.error_msg);
+      break;
+    }
+    if (response.time_out) {
+      break;
+    }
+    batch.push_back(std::move(response.message));
+  }
+}
+
+RequestLane ProxyLanes::laneOf(IMessage &message) const {
+  if (!message.exists(constants::message::google::MSG_TYPE)) {
+    return RequestLane::NORMAL;
+  }
+  const uint16_t msg_type =
+      std::get<uint16_t>(message.get(constants::message::google::MSG_TYPE));
+  auto lane = m_lanes.find(msg_type);
+  return lane == m_lanes.end() ? RequestLane::NORMAL : lane->second;
+}
+
+void ProxyLanes::dispatch() {
+  size_t worker = 0;
+  std::unique_ptr<IMessage> message;
+  while (m_scheduler.next(worker, message)) {
+    try {
+      m_channels[worker]->send(*message);
+    } catch (...) {
+      // The worker never saw the request, so it is free for the next one
+      m_scheduler.done(worker, correlationIdOf(*message));
+      throw;
+    }
+  }
+}
+
+/**
+ * Resizes the pool from a sample of its load. Deactivated workers are stopped
+ * once they have replied to all their requests, the last one first.
+ **/
+void ProxyLanes::scale() {
+  const size_t active = m_scheduler.activeWorkers();
+  const double busy_ratio =
+      static_cast<double>(m_scheduler.busy()) /
+      static_cast<double>(active * m_scheduler.requestsPerWorker());
+  const size_t target =
+      m_scaler->sample(active, busy_ratio, m_scheduler.oldestWait());
+  if (target != active) {
+    DL_INFO(m_log_context, "ProxyLanes::scale - resizing worker pool from "
+                               << active << " to " << target);
+    for (; m_started_workers < target; ++m_started_workers) {
+      m_start_worker(m_started_workers);
+    }
+    const size_t bulk_workers =
+        std::max<size_t>(1, target * m_max_bulk_workers / m_initial_workers);
+    m_scheduler.setActiveWorkers(target, bulk_workers);
+  }
+
+  while (m_started_workers > m_scheduler.activeWorkers() &&
+         m_scheduler.running(m_started_workers - 1) == 0) {
+    m_stop_worker(m_started_workers - 1);
+    --m_started_workers;
+  }
+}
+
+void ProxyLanes::run() {
+
+  auto end_time = std::chrono::steady_clock::now() + m_run_duration;
+
+  std::vector<zmq_pollitem_t> items;
+  auto server_comm = dynamic_cast<ZeroMQCommunicator *>(m_server.get());
+  if (server_comm == nullptr) {
+    EXCEPT(1, "ProxyLanes requires ZeroMQ communicators.");
+  }
+  items.push_back({server_comm->socket(), 0, ZMQ_POLLIN, 0});
+  for (auto &channel : m_channels) {
+    auto channel_comm = dynamic_cast<ZeroMQCommunicator *>(channel.get());
+    if (channel_comm == nullptr) {
+      EXCEPT(1, "ProxyLanes requires ZeroMQ communicators.");
+    }
+    items.push_back({channel_comm->socket(), 0, ZMQ_POLLIN, 0});
+  }
+
+  std::vector<std::unique_ptr<IMessage>> batch;
+  batch.reserve(m_max_batch_size);
+  auto next_scale = std::chrono::steady_clock::now() + m_scale_period;
+
+  while (m_run_infinite_loop or (end_time > std::chrono::steady_clock::now())) {
+    try {
+      int events_detected =
+          zmq_poll(items.data(), items.size(), m_timeout_on_poll_milliseconds);
+      if (events_detected < 0) {
+        DL_ERROR(m_log_context, "ProxyLanes::run - zmq_poll failed: "
+                                    << zmq_strerror(zmq_errno()));
+        continue;
+      }
+
+      // Replies free their worker and go straight back to the frontend
+      for (size_t worker = 0; worker < m_channels.size(); ++worker) {
+        if (items[worker + 1].revents & ZMQ_POLLIN) {
+          drain(*m_channels[worker], batch);
+          for (auto &message : batch) {
+            m_scheduler.done(worker, correlationIdOf(*message));
+            m_server->send(*message);
+          }
+        }
+      }
+
+      if (items[0].revents & ZMQ_POLLIN) {
+        drain(*m_server, batch);
+        for (auto &message : batch) {
+          const RequestLane lane = laneOf(*message);
+          m_scheduler.push(lane, std::move(message));
+        }
+      }
+
+      const size_t stalled = m_scheduler.markStalled(m_stale_after);
+      if (stalled) {
+        DL_WARNING(m_log_context,
+                   "ProxyLanes::run - "
+                       << stalled << " worker(s) did not reply within "
+                       << m_stale_after.count()
+                       << " seconds, giving them no requests until they do");
+      }
+
+      dispatch();
+
+      if (m_scaler && std::chrono::steady_clock::now() >= next_scale) {
+        scale();
+        next_scale = std::chrono::steady_clock::now() + m_scale_period;
+      }
+
+    } catch (TraceException &e) {
+      DL_ERROR(m_log_context, "ProxyLanes::run - " << e.toString());
+    } catch (exception &e) {
+      DL_ERROR(m_log_context, "ProxyLanes::run - " << e.what());
+    } catch (...) {
+      DL_ERROR(m_log_context, "ProxyLanes::run - unknown exception");
+    }
+  }
+  DL_INFO(m_log_context,
+          "ProxyLanes is gracefully exiting after specified timeout.");
+}
+
+} // namespace SDMS
@@ -0,0 +1,94 @@
+#ifndef PROXY_LANES_HPP
+#define PROXY_LANES_HPP
+#pragma once
+
+// Local private includes
+#include "LaneScheduler.hpp"
+
+// Local public includes
+#include "common/ICommunicator.hpp"
+#include "common/IServer.hpp"
+#include "common/PoolScaler.hpp"
+#include "common/SocketOptions.hpp"
+
+// Standard includes
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace SDMS {
+
+/**
+ * Proxy that schedules requests across a pool of workers by lane.
+ *
+ * Unlike the custom proxy, which hands requests to a single DEALER that deals
+ * them out round robin, each worker is reached through a channel of its own.
+ * The proxy therefore knows how busy each worker is and only gives a request
+ * to a worker with room for it, see LaneScheduler for the order requests are
+ * run in. Replies are passed back to the frontend unchanged.
+ **/
+class ProxyLanes : public IServer {
+private:
+  uint32_t m_timeout_on_receive_milliseconds = 50;
+  long m_timeout_on_poll_milliseconds = 50;
+  /// Most messages received from one socket before checking the others
+  size_t m_max_batch_size = 64;
+  std::unique_ptr<ICommunicator> m_server;
+  /// One channel per worker, indexed like the workers of the scheduler
+  std::vector<std::unique_ptr<ICommunicator>> m_channels;
+  std::unordered_map<uint16_t, RequestLane> m_lanes;
+  std::chrono::seconds m_stale_after;
+  LaneScheduler m_scheduler;
+  /// Resizes the pool, null if its size is fixed
+  std::unique_ptr<PoolScaler> m_scaler;
+  std::function<void(size_t)> m_start_worker;
+  std::function<void(size_t)> m_stop_worker;
+  /// Workers numbered below this have been started and not stopped
+  size_t m_started_workers;
+  size_t m_initial_workers;
+  size_t m_max_bulk_workers;
+  std::chrono::milliseconds m_scale_period;
+  bool m_run_infinite_loop = true;
+  std::chrono::duration<double> m_run_duration;
+  LogContext m_log_context;
+  std::unordered_map<SocketRole, std::string> m_addresses;
+
+  void drain(ICommunicator &communicator,
+             std::vector<std::unique_ptr<IMessage>> &batch);
+  RequestLane laneOf(IMessage &message) const;
+  /// Hands queued requests to workers until they are full or none can run
+  void dispatch();
+  void scale();
+
+public:
+  ProxyLanes(
+      const std::unordered_map<SocketRole, SocketOptions> &socket_options,
+      const std::unordered_map<SocketRole, ICredentials *> &socket_credentials,
+      const LaneOptions &lane_options, LogContext log_context);
+
+  virtual ServerType type() const noexcept final {
+    return ServerType::PROXY_LANES;
+  }
+  /**
+   * By default will run forever you can specify a time to run the for instead
+   *
+   * std::chrono::duration<double> duration = std::chrono::seconds(1);
+   * setRunDuration(duration)
+   **/
+  virtual void setRunDuration(std::chrono::duration<double> duration) final;
+
+  virtual void run() final;
+
+  /// The CLIENT address is that of the first worker channel
+  virtual std::unordered_map<SocketRole, std::string>
+  getAddresses() const final {
+    return m_addresses;
+  }
+};
+
+} // namespace SDMS
+
+#endif // PROXY_LANES_HPP
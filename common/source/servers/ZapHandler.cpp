@@ -0,0 +1,174 @@
+// Local private includes
+#include "../support/zeromq/Context.hpp"
+
+// Local public includes
+#include "common/TraceException.hpp"
+#include "common/ZapHandler.hpp"
+
+// Third party includes
+#include <zmq.h>
+
+// Standard includes
+#include <arpa/inet.h>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace SDMS {
+
+namespace {
+
+const std::string ZAP_VERSION = "1.0";
+const size_t CURVE_KEY_SIZE = 32;
+
+/**
+ * Encodes a single metadata property the way ZMTP does, a one byte name
+ * length, the name, a four byte value length in network order and the value.
+ **/
+std::string encodeProperty(const std::string &name, const std::string &value) {
+  std::string property;
+  property += static_cast<char>(name.size());
+  property += name;
+  const uint32_t length = htonl(static_cast<uint32_t>(value.size()));
+  property.append(reinterpret_cast<const char *>(&length), sizeof(length));
+  property += value;
+  return property;
+}
+
+} // namespace
+
+ZapHandler::ZapHandler(IAuthenticationManager &auth_manager,
+                       LogContext log_context)
+    : m_auth_manager(auth_manager), m_log_context(log_context) {
+  m_log_context.thread_name += "-zapHandler";
+  m_zmq_socket = zmq_socket(getContext(), ZMQ_REP);
+  if (!m_zmq_socket) {
+    EXCEPT_PARAM(1, "Unable to create ZAP handler socket: "
+                        << zmq_strerror(zmq_errno()));
+  }
+  const int linger_milliseconds = 0;
+  zmq_setsockopt(m_zmq_socket, ZMQ_LINGER, &linger_milliseconds,
+                 sizeof(const int));
+  if (zmq_bind(m_zmq_socket, constants::zap::ENDPOINT.c_str()) != 0) {
+    std::string err_message = "ZAP handler bind to '" +
+                              constants::zap::ENDPOINT +
+                              "' failed: " + zmq_strerror(zmq_errno());
+    zmq_close(m_zmq_socket);
+    EXCEPT_PARAM(1, err_message);
+  }
+}
+
+ZapHandler::~ZapHandler() { zmq_close(m_zmq_socket); }
+
+void ZapHandler::run() {
+  DL_INFO(m_log_context, "ZAP handler started on " << constants::zap::ENDPOINT);
+  std::vector<std::string> request;
+  while (true) {
+    if (!receive(request)) {
+      if (zmq_errno() == ETERM) {
+        DL_INFO(m_log_context, "ZAP handler stopping, context terminated.");
+        return;
+      }
+      DL_ERROR(m_log_context,
+               "ZAP handler receive failed: " << zmq_strerror(zmq_errno()));
+      continue;
+    }
+    handle(request);
+  }
+}
+
+bool ZapHandler::receive(std::vector<std::string> &request) {
+  request.clear();
+  bool more = true;
+  while (more) {
+    zmq_msg_t zmq_msg;
+    zmq_msg_init(&zmq_msg);
+    if (zmq_msg_recv(&zmq_msg, m_zmq_socket, 0) < 0) {
+      zmq_msg_close(&zmq_msg);
+      return false;
+    }
+    request.emplace_back(static_cast<const char *>(zmq_msg_data(&zmq_msg)),
+                         zmq_msg_size(&zmq_msg));
+    more = zmq_msg_more(&zmq_msg);
+    zmq_msg_close(&zmq_msg);
+  }
+  return true;
+}
+
+void ZapHandler::reply(const std::string &request_id,
+                       const std::string &status_code,
+                       const std::string &status_text,
+                       const std::string &user_id,
+                       const std::string &metadata) {
+  const std::vector<const std::string *> parts = {
+      &ZAP_VERSION, &request_id, &status_code, &status_text, &user_id,
+      &metadata};
+  for (size_t i = 0; i < parts.size(); ++i) {
+    const int flags = i + 1 < parts.size() ? ZMQ_SNDMORE : 0;
+    if (zmq_send(m_zmq_socket, parts[i]->data(), parts[i]->size(), flags) <
+        0) {
+      DL_ERROR(m_log_context,
+               "ZAP handler send failed: " << zmq_strerror(zmq_errno()));
+      return;
+    }
+  }
+}
+
+/**
+ * A request holds the version, request id, domain, address, identity,
+ * mechanism and then the credentials, which for CURVE is the 32 byte client
+ * public key.
+ **/
+void ZapHandler::handle(const std::vector<std::string> &request) {
+  if (request.size() < 6 || request[0] != ZAP_VERSION) {
+    DL_WARNING(m_log_context, "Malformed ZAP request with " << request.size()
+                                                            << " parts.");
+    reply(request.size() > 1 ? request[1] : "", "500", "Malformed request",
+          "", "");
+    return;
+  }
+  const std::string &request_id = request[1];
+  const std::string &mechanism = request[5];
+
+  if (mechanism != "CURVE") {
+    // Nothing to resolve, leave the connection anonymous
+    reply(request_id, "200", "OK", "", "");
+    return;
+  }
+
+  if (request.size() != 7 || request[6].size() != CURVE_KEY_SIZE) {
+    DL_WARNING(m_log_context, "ZAP CURVE request without a valid public key.");
+    reply(request_id, "400", "Invalid public key", "", "");
+    return;
+  }
+
+  char public_key[41];
+  zmq_z85_encode(public_key,
+                 reinterpret_cast<const uint8_t *>(request[6].data()),
+                 CURVE_KEY_SIZE);
+
+  std::string uid = "anon";
+  uint32_t token = 0;
+  try {
+    token = m_auth_manager.authenticateConnection(public_key, uid);
+  } catch (TraceException &e) {
+    DL_ERROR(m_log_context,
+             "ZAP handler unable to resolve key: " << e.toString());
+    uid = "anon";
+  } catch (std::exception &e) {
+    DL_ERROR(m_log_context, "ZAP handler unable to resolve key: " << e.what());
+    uid = "anon";
+  }
+
+  std::string metadata;
+  if (token) {
+    metadata =
+        encodeProperty(constants::zap::TOKEN_PROPERTY, std::to_string(token));
+  }
+  DL_DEBUG(m_log_context, "ZAP authenticated connection from "
+                              << request[3] << " as " << uid
+                              << (token ? "" : " without a token"));
+  reply(request_id, "200", "OK", uid == "anon" ? "" : uid, metadata);
+}
+
+} // namespace SDMS
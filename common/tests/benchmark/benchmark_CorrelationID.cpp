@@ -0,0 +1,84 @@
+// Local public includes
+#include "common/IMessage.hpp"
+#include "common/MessageFactory.hpp"
+
+// Third party includes
+#include <boost/uuid/uuid.hpp>
+#include <boost/uuid/uuid_generators.hpp>
+#include <boost/uuid/uuid_io.hpp>
+
+// Standard includes
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+
+using namespace SDMS;
+
+/**
+ * Measures the cost of correlation ids. The first two cases time generating
+ * an id alone, with a boost random_generator constructed for every id as
+ * before and with the per-thread generator GoogleProtoMessage now uses. The
+ * others time building messages: requests generate an id, response envelopes
+ * and received messages take theirs from elsewhere and generate none.
+ *
+ * Usage: benchmark_CorrelationID [iterations]
+ **/
+
+namespace {
+
+size_t g_sink = 0;
+
+void run(const std::string &name, size_t iterations,
+         const std::function<void()> &body) {
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; ++i) {
+    body();
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::cout << name << ": " << static_cast<size_t>(iterations / elapsed.count())
+            << " /s" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  size_t iterations = 200000;
+  if (argc > 1) {
+    iterations = std::strtoul(argv[1], nullptr, 10);
+  }
+
+  run("id, generator per id (before)", iterations, [&]() {
+    boost::uuids::random_generator generator;
+    g_sink += boost::uuids::to_string(generator()).size();
+  });
+
+  run("id, per-thread generator", iterations, [&]() {
+    thread_local boost::uuids::random_generator_mt19937 generator;
+    g_sink += boost::uuids::to_string(generator()).size();
+  });
+
+  MessageFactory msg_factory;
+
+  run("request message, id generated", iterations, [&]() {
+    auto msg = msg_factory.create(MessageType::GOOGLE_PROTOCOL_BUFFER);
+    g_sink += std::get<std::string>(msg->get(MessageAttribute::CORRELATION_ID))
+                  .size();
+  });
+
+  auto request = msg_factory.create(MessageType::GOOGLE_PROTOCOL_BUFFER);
+  run("response envelope, id copied", iterations, [&]() {
+    auto msg = msg_factory.createResponseEnvelope(*request);
+    g_sink += std::get<std::string>(msg->get(MessageAttribute::CORRELATION_ID))
+                  .size();
+  });
+
+  run("received message, no id generated", iterations, [&]() {
+    auto msg = msg_factory.createReceived(MessageType::GOOGLE_PROTOCOL_BUFFER);
+    g_sink += msg->exists(MessageAttribute::CORRELATION_ID);
+  });
+
+  return g_sink == 0;
+}
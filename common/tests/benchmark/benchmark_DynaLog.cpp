@@ -0,0 +1,78 @@
+// Local public includes
+#include "common/DynaLog.hpp"
+
+// Standard includes
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace SDMS;
+
+/**
+ * Measures the cost of a log statement whose level is disabled. The logger is
+ * left at INFO and DL_TRACE is given an argument that is expensive to format,
+ * the per statement cost should match the empty loop because the argument is
+ * never evaluated. The eager case reproduces the previous macros, which
+ * formatted the message before the level was checked.
+ *
+ * Usage: benchmark_DynaLog [iterations]
+ **/
+
+namespace {
+
+size_t g_evaluations = 0;
+volatile size_t g_sink = 0;
+
+std::string expensive(size_t i) {
+  ++g_evaluations;
+  return "value " + std::to_string(i) + " of a message nobody reads";
+}
+
+template <typename Body>
+void run(const std::string &name, size_t iterations, Body body) {
+  g_evaluations = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; ++i) {
+    body(i);
+    g_sink = g_sink + 1;
+  }
+  std::chrono::duration<double, std::nano> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::cout << name << ": " << elapsed.count() / iterations
+            << " ns/statement, arguments evaluated " << g_evaluations
+            << " times" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  size_t iterations = 10000000;
+  if (argc > 1) {
+    iterations = std::strtoul(argv[1], nullptr, 10);
+  }
+
+  global_logger.setLevel(LogLevel::INFO);
+  LogContext log_context;
+  log_context.thread_name = "benchmark";
+
+  run("empty loop", iterations, [](size_t) {});
+
+  run("disabled DL_TRACE", iterations, [&](size_t i) {
+    DL_TRACE(log_context, "Trace " << expensive(i) << " " << i);
+  });
+
+  run("disabled DL_DEBUG", iterations, [&](size_t i) {
+    DL_DEBUG(log_context, "Debug " << expensive(i) << " " << i);
+  });
+
+  run("disabled trace, formatted first (before)", iterations, [&](size_t i) {
+    std::stringstream temp_buffer;
+    temp_buffer << "Trace " << expensive(i) << " " << i;
+    global_logger.trace(__FILE__, __func__, __LINE__, log_context,
+                        temp_buffer.str());
+  });
+
+  return 0;
+}
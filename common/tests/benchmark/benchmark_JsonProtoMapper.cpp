@@ -0,0 +1,176 @@
+// Local public includes
+#include "common/JsonProtoMapper.hpp"
+#include "common/SDMS.pb.h"
+#include "common/libjson.hpp"
+
+// Standard includes
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace SDMS;
+using namespace libjson;
+
+/**
+ * Compares JsonProtoMapper with the hand-written translators of DatabaseAPI
+ * on a user listing as the DB sends it, with identities and allocations
+ * under keys named differently from their fields. Parsing is timed alone,
+ * then each translation alone and with the parse, since a reply is parsed
+ * once whichever translates it.
+ *
+ * Usage: benchmark_JsonProtoMapper [users] [iterations]
+ **/
+
+namespace {
+
+size_t g_sink = 0;
+
+void run(const std::string &name, size_t iterations,
+         const std::function<void()> &body) {
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; ++i) {
+    body();
+  }
+  std::chrono::duration<double, std::micro> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::cout << name << ": " << elapsed.count() / iterations << " us/reply"
+            << std::endl;
+}
+
+std::string userReply(size_t users) {
+  std::string reply = "[";
+  for (size_t i = 0; i < users; ++i) {
+    const std::string uid = "u/user" + std::to_string(i);
+    reply += (i ? ",{" : "{");
+    reply += "\"uid\":\"" + uid + "\",\"name_last\":\"Last\",";
+    reply += "\"name_first\":\"First\",\"email\":\"user@x.org\",";
+    reply += "\"is_admin\":false,\"is_repo_admin\":false,";
+    reply += "\"idents\":[\"" + uid + ".globus\",\"orcid:0000\"],";
+    reply += "\"allocs\":[{\"repo\":\"repo/r1\",\"data_limit\":1000000,";
+    reply += "\"data_size\":2048,\"rec_limit\":100,\"rec_count\":2,";
+    reply += "\"path\":\"/mnt/r1/" + uid + "/\",\"is_def\":true,";
+    reply += "\"id\":\"repo/r1\"}]}";
+  }
+  return reply + "]";
+}
+
+/// As DatabaseAPI::setUserData and setAllocData
+void translateByHand(std::vector<UserData> &users, const Value &reply) {
+  for (const Value &item : reply.asArray()) {
+    const Value::Object &obj = item.asObject();
+    users.emplace_back();
+    UserData &user = users.back();
+    user.set_uid(obj.getString("uid"));
+    user.set_name_last(obj.getString("name_last"));
+    user.set_name_first(obj.getString("name_first"));
+    if (obj.has("email"))
+      user.set_email(obj.asString());
+    if (obj.has("options"))
+      user.set_options(obj.asString());
+    if (obj.has("is_admin"))
+      user.set_is_admin(obj.asBool());
+    if (obj.has("is_repo_admin"))
+      user.set_is_repo_admin(obj.asBool());
+    if (obj.has("idents")) {
+      for (const Value &ident : obj.asArray())
+        user.add_ident(ident.asString());
+    }
+    if (obj.has("allocs")) {
+      for (const Value &value : obj.asArray()) {
+        const Value::Object &alloc_obj = value.asObject();
+        AllocData *alloc = user.add_alloc();
+        alloc->set_repo(alloc_obj.getString("repo"));
+        alloc->set_data_limit(alloc_obj.getNumber("data_limit"));
+        alloc->set_data_size(alloc_obj.getNumber("data_size"));
+        alloc->set_rec_limit(alloc_obj.getNumber("rec_limit"));
+        alloc->set_rec_count(alloc_obj.getNumber("rec_count"));
+        alloc->set_path(alloc_obj.getString("path"));
+        if (alloc_obj.has("is_def"))
+          alloc->set_is_def(alloc_obj.asBool());
+        if (alloc_obj.has("id"))
+          alloc->set_id(alloc_obj.asString());
+      }
+    }
+  }
+}
+
+void translateByMapper(std::vector<UserData> &users, const Value &reply) {
+  static const JsonProtoMapper mapper =
+      JsonProtoMapper(UserData::descriptor())
+          .key("idents", "ident")
+          .key("allocs", "alloc");
+  for (const Value &item : reply.asArray()) {
+    users.emplace_back();
+    mapper.fill(users.back(), item.asObject());
+  }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  size_t users = 1000;
+  size_t iterations = 200;
+  if (argc > 1) {
+    users = std::strtoul(argv[1], nullptr, 10);
+  }
+  if (argc > 2) {
+    iterations = std::strtoul(argv[2], nullptr, 10);
+  }
+
+  const std::string text = userReply(users);
+  Value reply;
+  reply.fromString(text);
+
+  // Both must give the same messages for the times to compare
+  std::vector<UserData> by_hand;
+  std::vector<UserData> by_mapper;
+  translateByHand(by_hand, reply);
+  translateByMapper(by_mapper, reply);
+  for (size_t i = 0; i < users; ++i) {
+    if (by_hand[i].SerializeAsString() != by_mapper[i].SerializeAsString()) {
+      std::cerr << "Translations differ for user " << i << std::endl;
+      return 1;
+    }
+  }
+
+  std::cout << users << " users per reply" << std::endl;
+
+  run("parse", iterations, [&]() {
+    Value value;
+    value.fromString(text);
+    g_sink += value.asArray().size();
+  });
+
+  run("translate, hand-written", iterations, [&]() {
+    std::vector<UserData> result;
+    translateByHand(result, reply);
+    g_sink += result.size();
+  });
+
+  run("translate, mapper", iterations, [&]() {
+    std::vector<UserData> result;
+    translateByMapper(result, reply);
+    g_sink += result.size();
+  });
+
+  run("parse and translate, hand-written", iterations, [&]() {
+    Value value;
+    value.fromString(text);
+    std::vector<UserData> result;
+    translateByHand(result, value);
+    g_sink += result.size();
+  });
+
+  run("parse and translate, mapper", iterations, [&]() {
+    Value value;
+    value.fromString(text);
+    std::vector<UserData> result;
+    translateByMapper(result, value);
+    g_sink += result.size();
+  });
+
+  return g_sink == 0;
+}
@@ -530,4 +530,107 @@ BOOST_AUTO_TEST_CASE(testing_CommunicatorFactoryReply) {
   /************************CLIENT END****************/
 }
 
+BOOST_AUTO_TEST_CASE(testing_CommunicatorFactoryCompactEnvelope) {
+
+  LogContext log_context;
+  log_context.thread_name = "test_communicator_factory_compact_envelope";
+  CommunicatorFactory factory(log_context);
+
+  auto create = [&](SocketClassType class_type, const std::string &local_id) {
+    SocketOptions socket_options = generateCommonOptions("test_channel3");
+    socket_options.class_type = class_type;
+    if (class_type == SocketClassType::CLIENT) {
+      socket_options.connection_life = SocketConnectionLife::INTERMITTENT;
+    }
+    socket_options.port = 1344;
+    socket_options.local_id = local_id;
+
+    CredentialFactory cred_factory;
+
+    std::unordered_map<CredentialType, std::string> cred_options;
+    cred_options[CredentialType::PUBLIC_KEY] = public_key;
+    cred_options[CredentialType::PRIVATE_KEY] = secret_key;
+    cred_options[CredentialType::SERVER_KEY] = server_key;
+
+    auto credentials = cred_factory.create(ProtocolType::ZQTP, cred_options);
+
+    uint32_t timeout_on_receive = 10;
+    long timeout_on_poll = 10;
+    return factory.create(socket_options, *credentials, timeout_on_receive,
+                          timeout_on_poll);
+  };
+
+  const std::string client_id = "minion";
+  auto server = create(SocketClassType::SERVER, "overlord");
+  auto client = create(SocketClassType::CLIENT, client_id);
+
+  MessageFactory msg_factory;
+  const std::string id = "Bob";
+  const std::string key = "skeleton";
+  const std::string token = "magic_token";
+
+  auto sendRequest = [&]() {
+    auto msg = msg_factory.create(MessageType::GOOGLE_PROTOCOL_BUFFER);
+    msg->set(MessageAttribute::ID, id);
+    msg->set(MessageAttribute::KEY, key);
+    auto auth_by_token_req =
+        std::make_unique<Anon::AuthenticateByTokenRequest>();
+    auth_by_token_req->set_token(token);
+    msg->setPayload(std::move(auth_by_token_req));
+    client->send(*msg);
+  };
+
+  auto receive = [](ICommunicator &comm) {
+    ICommunicator::Response response =
+        comm.receive(MessageType::GOOGLE_PROTOCOL_BUFFER);
+    while (response.time_out == true) {
+      response = comm.receive(MessageType::GOOGLE_PROTOCOL_BUFFER);
+    }
+    BOOST_CHECK(response.error == false);
+    return response;
+  };
+
+  auto wireVersion = [](const IMessage &msg) {
+    return std::get<uint8_t>(
+        msg.get(constants::message::google::WIRE_VERSION));
+  };
+
+  // The first request uses the legacy layout but tells the server that a
+  // compact reply can be read
+  sendRequest();
+  auto request = receive(*server);
+  BOOST_CHECK(wireVersion(*request.message) == 2);
+
+  auto reply_msg = msg_factory.createResponseEnvelope(*request.message);
+  auto nack_reply = std::make_unique<Anon::NackReply>();
+  nack_reply->set_err_code(ErrorCode::ID_SERVICE_ERROR);
+  reply_msg->setPayload(std::move(nack_reply));
+  server->send(*reply_msg);
+
+  auto reply = receive(*client);
+  BOOST_CHECK(wireVersion(*reply.message) == 2);
+  BOOST_CHECK(reply.message->getRoutes().size() == 0);
+  BOOST_CHECK(
+      std::get<std::string>(reply.message->get(MessageAttribute::CORRELATION_ID))
+          .compare(std::get<std::string>(
+              request.message->get(MessageAttribute::CORRELATION_ID))) == 0);
+
+  // Having heard back in the compact layout the client now uses it as well
+  sendRequest();
+  request = receive(*server);
+  BOOST_CHECK(wireVersion(*request.message) == 2);
+  BOOST_CHECK(request.message->getRoutes().size() == 1);
+  BOOST_CHECK(request.message->getRoutes().front().compare(client_id) == 0);
+  BOOST_CHECK(
+      std::get<std::string>(request.message->get(MessageAttribute::KEY))
+          .compare(key) == 0);
+  BOOST_CHECK(
+      std::get<std::string>(request.message->get(MessageAttribute::ID))
+          .compare(id) == 0);
+
+  auto payload = dynamic_cast<Anon::AuthenticateByTokenRequest *>(
+      std::get<::google::protobuf::Message *>(request.message->getPayload()));
+  BOOST_CHECK(payload->token().compare(token) == 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
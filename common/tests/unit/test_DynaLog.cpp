@@ -11,11 +11,46 @@
 #include <fstream>
 #include <iostream>
 #include <regex>
+#include <sstream>
+#include <thread>
+#include <vector>
 
 using namespace SDMS;
 
 BOOST_AUTO_TEST_SUITE(LogTest)
 
+BOOST_AUTO_TEST_CASE(testing_DisabledLevelSkipsFormatting) {
+
+  int evaluated = 0;
+  auto argument = [&evaluated]() {
+    ++evaluated;
+    return "formatted";
+  };
+
+  LogContext log_context;
+  // The logger keeps a reference to the stream for the rest of the module
+  static std::ostringstream stream;
+  global_logger.addStream(stream);
+  global_logger.setLevel(SDMS::LogLevel::INFO);
+  BOOST_CHECK(global_logger.isEnabled(SDMS::LogLevel::INFO));
+  BOOST_CHECK(!global_logger.isEnabled(SDMS::LogLevel::DEBUG));
+
+  DL_TRACE(log_context, argument());
+  DL_DEBUG(log_context, argument());
+  DL_LOG(SDMS::LogLevel::TRACE, log_context, argument());
+  BOOST_CHECK_EQUAL(evaluated, 0);
+  BOOST_CHECK(stream.str().empty());
+
+  DL_INFO(log_context, argument());
+  BOOST_CHECK_EQUAL(evaluated, 1);
+  BOOST_CHECK(stream.str().find("formatted") != std::string::npos);
+
+  // Level changes take effect for statements that were previously disabled
+  global_logger.setLevel(SDMS::LogLevel::TRACE);
+  DL_TRACE(log_context, argument());
+  BOOST_CHECK_EQUAL(evaluated, 2);
+}
+
 BOOST_AUTO_TEST_CASE(testing_LogOutput) {
 
   std::string file_name = "./log_output_test1.txt";
@@ -104,4 +139,82 @@ BOOST_AUTO_TEST_CASE(testing_LogOutput) {
   BOOST_CHECK(count == 6);
 }
 
+BOOST_AUTO_TEST_CASE(testing_AsyncJSONOutput) {
+
+  std::ostringstream stream;
+  Logger logger;
+  logger.addStream(stream);
+  logger.setLevel(SDMS::LogLevel::TRACE);
+  logger.setFormat(LogFormat::JSON);
+  logger.startAsync(64, LogOverflowPolicy::BLOCK);
+
+  const int number_of_threads = 4;
+  const int messages_per_thread = 1000;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < number_of_threads; ++i) {
+    threads.emplace_back([&logger, i]() {
+      LogContext log_context;
+      log_context.thread_name = "worker";
+      log_context.thread_id = i + 1;
+      for (int j = 0; j < messages_per_thread; ++j) {
+        logger.debug(__FILE__, __func__, __LINE__, log_context,
+                     "Message \"" + std::to_string(j) + "\"\n");
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  logger.flush();
+
+  // Nothing may be dropped when producers block
+  BOOST_CHECK_EQUAL(logger.droppedCount(), 0);
+
+  std::istringstream lines(stream.str());
+  std::string line;
+  int count = 0;
+  while (std::getline(lines, line)) {
+    BOOST_CHECK(line.front() == '{');
+    BOOST_CHECK(line.back() == '}');
+    BOOST_CHECK(line.find("\"level\": \"DEBUG\"") != std::string::npos);
+    BOOST_CHECK(line.find("\"thread_name\": \"worker\"") != std::string::npos);
+    BOOST_CHECK(line.find("\\\"\\n\"}") != std::string::npos);
+    ++count;
+  }
+  BOOST_CHECK_EQUAL(count, number_of_threads * messages_per_thread);
+}
+
+BOOST_AUTO_TEST_CASE(testing_AsyncCountDropped) {
+
+  std::ostringstream stream;
+  Logger logger;
+  logger.addStream(stream);
+  logger.startAsync(2, LogOverflowPolicy::COUNT_DROPPED);
+
+  LogContext log_context;
+  const size_t number_of_messages = 10000;
+  for (size_t i = 0; i < number_of_messages; ++i) {
+    logger.info(__FILE__, __func__, __LINE__, log_context, "queued message");
+  }
+  logger.stopAsync();
+
+  // Every message is either written or counted, the writer reports the
+  // dropped messages as warnings
+  size_t written = 0;
+  size_t reported = 0;
+  std::istringstream lines(stream.str());
+  std::string line;
+  std::regex dropped_pattern("Dropped ([0-9]+) log messages");
+  while (std::getline(lines, line)) {
+    std::smatch match;
+    if (line.find("queued message") != std::string::npos) {
+      ++written;
+    } else if (std::regex_search(line, match, dropped_pattern)) {
+      reported += std::stoul(match[1]);
+    }
+  }
+  BOOST_CHECK_EQUAL(written + logger.droppedCount(), number_of_messages);
+  BOOST_CHECK_EQUAL(reported, logger.droppedCount());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
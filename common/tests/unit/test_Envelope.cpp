@@ -0,0 +1,110 @@
+#define BOOST_TEST_MAIN
+
+#define BOOST_TEST_MODULE envelope
+#include <boost/test/unit_test.hpp>
+
+// Local private includes
+#include "Envelope.hpp"
+
+// Local public includes
+#include "common/MessageFactory.hpp"
+#include "common/TraceException.hpp"
+
+// Proto file includes
+#include "common/SDMS_Anon.pb.h"
+
+// Standard includes
+#include <list>
+#include <string>
+#include <vector>
+
+using namespace SDMS;
+
+namespace g_constants = constants::message::google;
+
+BOOST_AUTO_TEST_SUITE(EnvelopeTest)
+
+BOOST_AUTO_TEST_CASE(testing_Envelope_round_trip) {
+
+  MessageFactory msg_factory;
+  auto msg = msg_factory.create(MessageType::GOOGLE_PROTOCOL_BUFFER);
+  msg->set(MessageAttribute::KEY, "skeleton");
+  msg->set(MessageAttribute::ID, "Bob");
+  msg->set(g_constants::CONTEXT, (uint16_t)513);
+
+  auto auth_by_token_req = std::make_unique<Anon::AuthenticateByTokenRequest>();
+  auth_by_token_req->set_token("magic_token");
+  msg->setPayload(std::move(auth_by_token_req));
+
+  const std::list<std::string> routes = {"route_1", "route_2"};
+
+  EnvelopeConverter converter;
+  std::vector<char> buffer(converter.size(*msg, routes));
+  converter.encode(*msg, routes, buffer.data(), buffer.size());
+
+  BOOST_CHECK(EnvelopeConverter::isHeader(buffer.data(), buffer.size()));
+
+  auto decoded = msg_factory.create(MessageType::GOOGLE_PROTOCOL_BUFFER);
+  // Matches the identity a ROUTER socket would have added ahead of the header
+  decoded->addRoute("route_1");
+  converter.decode(buffer.data(), buffer.size(), *decoded);
+
+  BOOST_CHECK(decoded->getRoutes() == routes);
+  BOOST_CHECK(
+      std::get<std::string>(decoded->get(MessageAttribute::CORRELATION_ID)) ==
+      std::get<std::string>(msg->get(MessageAttribute::CORRELATION_ID)));
+  BOOST_CHECK(std::get<std::string>(decoded->get(MessageAttribute::KEY)) ==
+              "skeleton");
+  BOOST_CHECK(std::get<std::string>(decoded->get(MessageAttribute::ID)) ==
+              "Bob");
+  BOOST_CHECK(std::get<uint32_t>(decoded->get(g_constants::FRAME_SIZE)) ==
+              std::get<uint32_t>(msg->get(g_constants::FRAME_SIZE)));
+  BOOST_CHECK(std::get<uint16_t>(decoded->get(g_constants::MSG_TYPE)) ==
+              std::get<uint16_t>(msg->get(g_constants::MSG_TYPE)));
+  BOOST_CHECK(std::get<uint16_t>(decoded->get(g_constants::CONTEXT)) == 513);
+}
+
+BOOST_AUTO_TEST_CASE(testing_Envelope_missing_key_and_id) {
+
+  MessageFactory msg_factory;
+  auto msg = msg_factory.create(MessageType::GOOGLE_PROTOCOL_BUFFER);
+
+  EnvelopeConverter converter;
+  std::vector<char> buffer(converter.size(*msg, {}));
+  converter.encode(*msg, {}, buffer.data(), buffer.size());
+
+  auto decoded = msg_factory.create(MessageType::GOOGLE_PROTOCOL_BUFFER);
+  converter.decode(buffer.data(), buffer.size(), *decoded);
+
+  // Same placeholders as the legacy layout
+  BOOST_CHECK(decoded->getRoutes().size() == 0);
+  BOOST_CHECK(std::get<std::string>(decoded->get(MessageAttribute::KEY)) ==
+              "no key");
+  BOOST_CHECK(std::get<std::string>(decoded->get(MessageAttribute::ID)) ==
+              "no id");
+}
+
+BOOST_AUTO_TEST_CASE(testing_Envelope_malformed) {
+
+  const std::string legacy = "BEGIN_DATAFED";
+  BOOST_CHECK(!EnvelopeConverter::isHeader(legacy.data(), legacy.size()));
+  BOOST_CHECK(!EnvelopeConverter::isHeader("DF", 2));
+
+  MessageFactory msg_factory;
+  auto msg = msg_factory.create(MessageType::GOOGLE_PROTOCOL_BUFFER);
+
+  EnvelopeConverter converter;
+  std::vector<char> buffer(converter.size(*msg, {"route_1"}));
+  converter.encode(*msg, {"route_1"}, buffer.data(), buffer.size());
+
+  auto decoded = msg_factory.create(MessageType::GOOGLE_PROTOCOL_BUFFER);
+  BOOST_CHECK_THROW(
+      converter.decode(buffer.data(), buffer.size() - 1, *decoded),
+      TraceException);
+
+  buffer.push_back(0);
+  BOOST_CHECK_THROW(converter.decode(buffer.data(), buffer.size(), *decoded),
+                    TraceException);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,155 @@
+#define BOOST_TEST_MAIN
+
+#define BOOST_TEST_MODULE json_proto_mapper
+#include <boost/test/unit_test.hpp>
+
+// Local public includes
+#include "common/JsonProtoMapper.hpp"
+#include "common/SDMS.pb.h"
+#include "common/TraceException.hpp"
+
+// Standard includes
+#include <string>
+
+using namespace SDMS;
+
+namespace {
+libjson::Value parse(const std::string &a_json) {
+  libjson::Value value;
+  value.fromString(a_json);
+  return value;
+}
+
+/// Message of the exception thrown filling a_message from a_json
+std::string fillError(const JsonProtoMapper &a_mapper,
+                      google::protobuf::Message &a_message,
+                      const std::string &a_json) {
+  try {
+    a_mapper.fill(a_message, parse(a_json).asObject());
+  } catch (TraceException &e) {
+    return e.toString();
+  }
+  return "";
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(JsonProtoMapperTest)
+
+BOOST_AUTO_TEST_CASE(testing_JsonProtoMapper_Fields) {
+  const JsonProtoMapper &mapper =
+      JsonProtoMapper::forType(UserData::descriptor());
+  BOOST_TEST(&mapper == &JsonProtoMapper::forType(UserData::descriptor()));
+
+  UserData user;
+  mapper.fill(user, parse("{\"uid\":\"u/a\",\"name_last\":\"Last\","
+                          "\"name_first\":\"First\",\"email\":null,"
+                          "\"is_admin\":true,\"is_repo_admin\":0,"
+                          "\"ident\":[\"a\",\"b\"],\"unknown\":{\"x\":1},"
+                          "\"alloc\":[{\"repo\":\"r/1\",\"data_limit\":1e12,"
+                          "\"data_size\":5,\"rec_limit\":10,\"rec_count\":2,"
+                          "\"path\":\"/data\",\"is_def\":true}]}")
+                        .asObject());
+
+  BOOST_TEST(user.uid() == "u/a");
+  BOOST_TEST(user.name_first() == "First");
+  BOOST_TEST(!user.has_email());
+  BOOST_TEST(user.is_admin());
+  BOOST_TEST(user.has_is_repo_admin());
+  BOOST_TEST(!user.is_repo_admin());
+  BOOST_TEST(user.ident_size() == 2);
+  BOOST_TEST(user.ident(1) == "b");
+  BOOST_REQUIRE(user.alloc_size() == 1);
+  BOOST_TEST(user.alloc(0).data_limit() == 1000000000000ull);
+  BOOST_TEST(user.alloc(0).is_def());
+  BOOST_TEST(!user.alloc(0).has_stats());
+
+  // Objects and arrays given to string fields are kept as JSON text
+  SchemaData schema;
+  JsonProtoMapper::forType(SchemaData::descriptor())
+      .fill(schema, parse("{\"id\":\"s\",\"ver\":2,\"def\":{\"b\":[1],\"a\":"
+                          "true},\"uses\":[{\"id\":\"t\",\"ver\":0}]}")
+                        .asObject());
+  BOOST_TEST(schema.def() == "{\"a\":true,\"b\":[1]}");
+  BOOST_REQUIRE(schema.uses_size() == 1);
+  BOOST_TEST(schema.uses(0).id() == "t");
+}
+
+BOOST_AUTO_TEST_CASE(testing_JsonProtoMapper_Configured) {
+  static const JsonProtoMapper comment_mapper =
+      JsonProtoMapper(NoteComment::descriptor())
+          .key("new_type", "type")
+          .key("new_state", "state");
+  static const JsonProtoMapper note_mapper =
+      JsonProtoMapper(NoteData::descriptor())
+          .key("_id", "id")
+          .key("comments", "comment")
+          .nested("comment", comment_mapper)
+          .handle("ct", [](google::protobuf::Message &a_message,
+                           const libjson::Value &a_value,
+                           const libjson::Value::Object &a_object) {
+            NoteData &note = static_cast<NoteData &>(a_message);
+            note.set_ct(a_value.asNumber() + a_object.getNumber("ut"));
+          });
+
+  NoteData note;
+  note_mapper.fill(
+      note, parse("{\"_id\":\"n/1\",\"id\":\"ignored\",\"type\":2,\"state\":1,"
+                  "\"subject_id\":\"d/1\",\"title\":\"Note\",\"ct\":10,"
+                  "\"ut\":20,\"parent_id\":null,\"comments\":[{\"user\":"
+                  "\"u/a\",\"time\":5,\"comment\":\"Text\",\"new_type\":3,"
+                  "\"new_state\":null}]}")
+                .asObject());
+
+  BOOST_TEST(note.id() == "n/1");
+  BOOST_TEST(note.type() == NOTE_WARN);
+  BOOST_TEST(note.state() == NOTE_OPEN);
+  BOOST_TEST(note.ct() == 30u);
+  BOOST_TEST(!note.has_parent_id());
+  BOOST_REQUIRE(note.comment_size() == 1);
+  BOOST_TEST(note.comment(0).type() == NOTE_ERROR);
+  BOOST_TEST(!note.comment(0).has_state());
+
+  // Renamed required fields are reported by their key
+  NoteData missing;
+  BOOST_TEST(fillError(note_mapper, missing, "{\"id\":\"n/1\"}") ==
+             "Key not found: _id");
+
+  // Messages holding themselves
+  TopicData topic;
+  JsonProtoMapper::forType(TopicData::descriptor())
+      .fill(topic, parse("{\"id\":\"t/1\",\"title\":\"One\",\"coll_cnt\":1,"
+                         "\"path\":[{\"id\":\"t/0\",\"title\":\"Zero\","
+                         "\"coll_cnt\":0}]}")
+                       .asObject());
+  BOOST_REQUIRE(topic.path_size() == 1);
+  BOOST_TEST(topic.path(0).title() == "Zero");
+}
+
+BOOST_AUTO_TEST_CASE(testing_JsonProtoMapper_Errors) {
+  const JsonProtoMapper &mapper =
+      JsonProtoMapper::forType(TagData::descriptor());
+  TagData tag;
+
+  BOOST_TEST(fillError(mapper, tag, "{\"name\":\"tag\"}") ==
+             "Key not found: count");
+  BOOST_TEST(fillError(mapper, tag, "{\"name\":\"tag\",\"count\":null}") ==
+             "Key not found: count");
+  BOOST_TEST(fillError(mapper, tag, "{\"name\":7,\"count\":1}") ==
+             "Invalid conversion of NUMBER value to string for key name");
+  BOOST_TEST(fillError(mapper, tag, "{\"name\":\"tag\",\"count\":\"1\"}") ==
+             "Invalid conversion of STRING value to number for key count");
+
+  UserData user;
+  BOOST_TEST(fillError(JsonProtoMapper::forType(UserData::descriptor()), user,
+                       "{\"uid\":\"u\",\"name_last\":\"L\",\"name_first\":"
+                       "\"F\",\"ident\":\"a\"}") != "");
+
+  BOOST_CHECK_THROW(JsonProtoMapper(TagData::descriptor()).key("n", "none"),
+                    TraceException);
+  BOOST_CHECK_THROW(
+      JsonProtoMapper(UserData::descriptor())
+          .nested("alloc", JsonProtoMapper::forType(TagData::descriptor())),
+      TraceException);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
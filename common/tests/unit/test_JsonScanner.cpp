@@ -0,0 +1,95 @@
+#define BOOST_TEST_MAIN
+
+#define BOOST_TEST_MODULE json_scanner
+#include <boost/test/unit_test.hpp>
+
+// Local public includes
+#include "common/JsonScanner.hpp"
+
+// Standard includes
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace libjson;
+
+namespace {
+/// Text with runs of the characters each scan stops at or skips over
+std::string randomText(std::mt19937 &a_rand, size_t a_size) {
+  const std::string alphabet = "   \n\t\raz\"\\\x01\x1f\x7f\x80\xff"
+                               "0:";
+  std::uniform_int_distribution<size_t> pick(0, alphabet.size() - 1);
+  std::uniform_int_distribution<size_t> run(1, 40);
+  std::string text;
+  while (text.size() < a_size) {
+    text.append(run(a_rand), alphabet[pick(a_rand)]);
+  }
+  text.resize(a_size);
+  return text;
+}
+
+/// Compares every kernel with the scalar one from every start in a_text
+void checkKernels(const std::string &a_text) {
+  std::vector<std::string> names = scan::kernels();
+  std::vector<const char *> string_ends;
+  std::vector<const char *> whitespace_ends;
+  const char *begin = a_text.c_str();
+
+  BOOST_REQUIRE(scan::useKernel("scalar"));
+  for (size_t i = 0; i <= a_text.size(); i++) {
+    string_ends.push_back(scan::stringEnd(begin + i));
+    whitespace_ends.push_back(scan::skipWhitespace(begin + i));
+  }
+
+  for (const std::string &name : names) {
+    BOOST_REQUIRE(scan::useKernel(name));
+    for (size_t i = 0; i <= a_text.size(); i++) {
+      BOOST_TEST(scan::stringEnd(begin + i) - begin ==
+                 string_ends[i] - begin);
+      BOOST_TEST(scan::skipWhitespace(begin + i) - begin ==
+                 whitespace_ends[i] - begin);
+    }
+  }
+  BOOST_REQUIRE(scan::useKernel(names.front()));
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(JsonScannerTest)
+
+BOOST_AUTO_TEST_CASE(testing_JsonScanner_Kernels) {
+  std::vector<std::string> names = scan::kernels();
+  BOOST_REQUIRE(!names.empty());
+  BOOST_TEST(names.back() == "scalar");
+  BOOST_TEST(scan::kernel() == names.front());
+  BOOST_TEST(!scan::useKernel("none"));
+  BOOST_TEST(scan::kernel() == names.front());
+}
+
+BOOST_AUTO_TEST_CASE(testing_JsonScanner_StringEnd) {
+  const char *text = "plain text\\n and \"a quote\"";
+  BOOST_TEST(scan::stringEnd(text) - text == 10);
+  BOOST_TEST(scan::stringEnd(text + 12) - text == 17);
+
+  // Control characters and the terminator end a string, UTF-8 does not
+  const std::string utf8 = "\xc3\xa9t\xc3\xa9\x1f";
+  BOOST_TEST(scan::stringEnd(utf8.c_str()) - utf8.c_str() == 5);
+  const std::string unterminated(100, 'x');
+  BOOST_TEST(*scan::stringEnd(unterminated.c_str()) == '\0');
+}
+
+BOOST_AUTO_TEST_CASE(testing_JsonScanner_SkipWhitespace) {
+  const char *text = " \n\t\r  {";
+  BOOST_TEST(*scan::skipWhitespace(text) == '{');
+  BOOST_TEST(scan::skipWhitespace(text + 6) == text + 6);
+  const std::string blank(100, ' ');
+  BOOST_TEST(*scan::skipWhitespace(blank.c_str()) == '\0');
+}
+
+BOOST_AUTO_TEST_CASE(testing_JsonScanner_MatchScalar) {
+  std::mt19937 rand(42);
+  for (size_t size : {0, 1, 15, 31, 33, 64, 100, 1000}) {
+    checkKernels(randomText(rand, size));
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
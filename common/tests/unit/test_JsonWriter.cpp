@@ -0,0 +1,113 @@
+#define BOOST_TEST_MAIN
+
+#define BOOST_TEST_MODULE json_writer
+#include <boost/test/unit_test.hpp>
+
+// Local public includes
+#include "common/JsonWriter.hpp"
+#include "common/Util.hpp"
+#include "common/libjson.hpp"
+
+// Standard includes
+#include <cstdint>
+#include <string>
+
+using namespace libjson;
+
+BOOST_AUTO_TEST_SUITE(JsonWriterTest)
+
+BOOST_AUTO_TEST_CASE(testing_JsonWriter_escape) {
+  std::string buffer = "x";
+  escape(buffer, "plain");
+  BOOST_TEST(buffer == "xplain");
+
+  buffer.clear();
+  escape(buffer, std::string("a\"b\\c\nd\x1f\xc3\xa9"
+                             "e\0f",
+                             13));
+  BOOST_TEST(buffer == "a\\\"b\\\\c\\u000Ad\\u001F\xc3\xa9"
+                       "e\\u0000f");
+
+  // Long runs go through the scanner kernel a block at a time
+  std::string text(1000, 'a');
+  text[500] = '"';
+  text += "\t";
+  std::string expected(500, 'a');
+  expected += "\\\"" + std::string(499, 'a') + "\\u0009";
+  BOOST_TEST(escapeJSON(text) == expected);
+  BOOST_TEST(escapeJSON("") == "");
+}
+
+BOOST_AUTO_TEST_CASE(testing_JsonWriter_document) {
+  Writer writer;
+  writer.beginObject()
+      .key("title")
+      .string("A \"quoted\" title")
+      .key("tags")
+      .beginArray()
+      .string("t1")
+      .string(std::string("t2"))
+      .endArray()
+      .key("md")
+      .raw("{\"a\":[1,2]}")
+      .key("deps")
+      .beginArray();
+  for (int i = 0; i < 2; i++) {
+    writer.beginObject().key("id").string("d/1").key("type").number(i);
+    writer.endObject();
+  }
+  writer.endArray()
+      .key("size")
+      .number(uint64_t(18446744073709551615ull))
+      .key("offset")
+      .number(-12)
+      .key("ratio")
+      .number(0.25)
+      .key("external")
+      .boolean(false)
+      .key("parent")
+      .null()
+      .key("empty")
+      .beginObject()
+      .endObject()
+      .endObject();
+
+  const std::string expected =
+      "{\"title\":\"A \\\"quoted\\\" title\",\"tags\":[\"t1\",\"t2\"],"
+      "\"md\":{\"a\":[1,2]},\"deps\":[{\"id\":\"d/1\",\"type\":0},"
+      "{\"id\":\"d/1\",\"type\":1}],\"size\":18446744073709551615,"
+      "\"offset\":-12,\"ratio\":0.25,\"external\":false,\"parent\":null,"
+      "\"empty\":{}}";
+  BOOST_TEST(writer.str() == expected);
+
+  Value value;
+  value.fromString(writer.str());
+  BOOST_TEST(value.asObject().getString("title") == "A \"quoted\" title");
+}
+
+BOOST_AUTO_TEST_CASE(testing_JsonWriter_buffer) {
+  const char *data = nullptr;
+  {
+    Writer writer;
+    writer.beginArray();
+    for (int i = 0; i < 1000; i++)
+      writer.number(i);
+    writer.endArray();
+    data = writer.str().data();
+
+    // A nested writer starts empty with a buffer of its own
+    Writer nested;
+    nested.beginObject().key("a").number(1).endObject();
+    BOOST_TEST(nested.str() == "{\"a\":1}");
+    BOOST_TEST(nested.str().data() != data);
+  }
+
+  // The larger buffer is kept for the next document on the thread
+  Writer writer;
+  BOOST_TEST(writer.str().empty());
+  BOOST_TEST(writer.str().data() == data);
+  writer.beginArray().endArray();
+  BOOST_TEST(writer.str() == "[]");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
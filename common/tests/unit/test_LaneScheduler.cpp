@@ -0,0 +1,229 @@
+#define BOOST_TEST_MAIN
+
+#define BOOST_TEST_MODULE lane_scheduler
+#include <boost/test/unit_test.hpp>
+
+// Local private includes
+#include "servers/LaneScheduler.hpp"
+
+// Local public includes
+#include "common/MessageFactory.hpp"
+#include "common/TraceException.hpp"
+
+// Standard includes
+#include <chrono>
+#include <memory>
+#include <string>
+
+using namespace SDMS;
+
+namespace {
+std::unique_ptr<IMessage> request(const std::string &id) {
+  MessageFactory msg_factory;
+  auto message = msg_factory.create(MessageType::GOOGLE_PROTOCOL_BUFFER);
+  message->set(MessageAttribute::ID, id);
+  return message;
+}
+
+std::unique_ptr<IMessage> request(const std::string &id,
+                                  const std::string &correlation_id) {
+  auto message = request(id);
+  message->set(MessageAttribute::CORRELATION_ID, correlation_id);
+  return message;
+}
+
+std::string idOf(const std::unique_ptr<IMessage> &message) {
+  return std::get<std::string>(message->get(MessageAttribute::ID));
+}
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(LaneSchedulerTest)
+
+BOOST_AUTO_TEST_CASE(testing_LaneSchedulerLaneOrder) {
+  LaneScheduler scheduler(1, 1);
+  scheduler.push(RequestLane::BULK, request("bulk"));
+  scheduler.push(RequestLane::NORMAL, request("normal"));
+  scheduler.push(RequestLane::CHEAP, request("cheap_1"));
+  scheduler.push(RequestLane::CHEAP, request("cheap_2"));
+
+  // Cheap requests first and in order, then normal, then bulk
+  const std::string expected[] = {"cheap_1", "cheap_2", "normal", "bulk"};
+  size_t worker = 0;
+  std::unique_ptr<IMessage> message;
+  for (const std::string &id : expected) {
+    BOOST_REQUIRE(scheduler.next(worker, message));
+    BOOST_TEST(worker == 0);
+    BOOST_TEST(idOf(message) == id);
+
+    // The only worker is busy until it replies
+    BOOST_TEST(!scheduler.next(worker, message));
+    BOOST_TEST(scheduler.done(worker));
+  }
+  BOOST_TEST(!scheduler.next(worker, message));
+  BOOST_TEST(!scheduler.done(0));
+}
+
+BOOST_AUTO_TEST_CASE(testing_LaneSchedulerIdleWorkers) {
+  LaneScheduler scheduler(3, 3);
+  for (int i = 0; i < 4; ++i) {
+    scheduler.push(RequestLane::NORMAL, request(std::to_string(i)));
+  }
+
+  size_t worker = 0;
+  std::unique_ptr<IMessage> message;
+  for (size_t expected = 0; expected < 3; ++expected) {
+    BOOST_REQUIRE(scheduler.next(worker, message));
+    BOOST_TEST(worker == expected);
+  }
+  BOOST_TEST(scheduler.busy() == 3);
+  BOOST_TEST(scheduler.queued(RequestLane::NORMAL) == 1);
+  BOOST_TEST(!scheduler.next(worker, message));
+
+  // Whichever worker finishes first takes the waiting request
+  BOOST_TEST(scheduler.done(1));
+  BOOST_REQUIRE(scheduler.next(worker, message));
+  BOOST_TEST(worker == 1);
+  BOOST_TEST(idOf(message) == "3");
+}
+
+BOOST_AUTO_TEST_CASE(testing_LaneSchedulerBulkLimit) {
+  LaneScheduler scheduler(3, 2);
+  for (int i = 0; i < 3; ++i) {
+    scheduler.push(RequestLane::BULK, request("bulk"));
+  }
+
+  size_t worker = 0;
+  std::unique_ptr<IMessage> message;
+  BOOST_TEST(scheduler.next(worker, message));
+  BOOST_TEST(scheduler.next(worker, message));
+  // The last worker is kept for other lanes while two bulk requests run
+  BOOST_TEST(!scheduler.next(worker, message));
+  BOOST_TEST(scheduler.queued(RequestLane::BULK) == 1);
+
+  scheduler.push(RequestLane::CHEAP, request("cheap"));
+  BOOST_REQUIRE(scheduler.next(worker, message));
+  BOOST_TEST(worker == 2);
+  BOOST_TEST(idOf(message) == "cheap");
+
+  // A bulk worker finishing lets the next bulk request run
+  BOOST_TEST(scheduler.done(0));
+  BOOST_REQUIRE(scheduler.next(worker, message));
+  BOOST_TEST(worker == 0);
+  BOOST_TEST(idOf(message) == "bulk");
+}
+
+BOOST_AUTO_TEST_CASE(testing_LaneSchedulerMarkStalled) {
+  LaneScheduler scheduler(2, 2, 2);
+  for (const char *id : {"a", "b", "c", "d"}) {
+    scheduler.push(RequestLane::NORMAL, request(id));
+  }
+
+  const auto start = LaneScheduler::clock::now();
+  const auto later = start + std::chrono::minutes(10);
+  size_t worker = 0;
+  std::unique_ptr<IMessage> message;
+  BOOST_REQUIRE(scheduler.next(worker, message, start));
+  BOOST_TEST(worker == 0);
+  BOOST_REQUIRE(scheduler.next(worker, message, later));
+  BOOST_TEST(worker == 1);
+
+  // Only the worker that has not replied for too long is stalled, and it
+  // keeps its request since it may still be running it
+  BOOST_TEST(scheduler.markStalled(std::chrono::minutes(5), later) == 1);
+  BOOST_TEST(scheduler.markStalled(std::chrono::minutes(5), later) == 0);
+  BOOST_TEST(scheduler.busy() == 2);
+  BOOST_TEST(scheduler.running(0) == 1);
+
+  // Worker 0 has room, yet the next requests go to worker 1 until it is full
+  BOOST_REQUIRE(scheduler.next(worker, message, later));
+  BOOST_TEST(worker == 1);
+  BOOST_TEST(!scheduler.next(worker, message, later));
+
+  // Replying to its request makes the stalled worker available again
+  BOOST_TEST(scheduler.done(0));
+  BOOST_TEST(scheduler.markStalled(std::chrono::minutes(5), later) == 0);
+  BOOST_REQUIRE(scheduler.next(worker, message, later));
+  BOOST_TEST(worker == 0);
+}
+
+BOOST_AUTO_TEST_CASE(testing_LaneSchedulerRequestsPerWorker) {
+  LaneScheduler scheduler(2, 1, 2);
+  for (int i = 1; i <= 3; ++i) {
+    scheduler.push(RequestLane::BULK, request("bulk_" + std::to_string(i),
+                                              "b" + std::to_string(i)));
+  }
+
+  // Requests go to the least loaded worker, at most two BULK ones at a time
+  size_t worker = 0;
+  std::unique_ptr<IMessage> message;
+  BOOST_REQUIRE(scheduler.next(worker, message));
+  BOOST_TEST(worker == 0);
+  BOOST_REQUIRE(scheduler.next(worker, message));
+  BOOST_TEST(worker == 1);
+  BOOST_TEST(!scheduler.next(worker, message));
+
+  // Both workers still have room for other lanes
+  scheduler.push(RequestLane::CHEAP, request("cheap", "c"));
+  BOOST_REQUIRE(scheduler.next(worker, message));
+  BOOST_TEST(worker == 0);
+  BOOST_TEST(scheduler.busy() == 3);
+
+  BOOST_TEST(scheduler.done(1, "b2"));
+  BOOST_REQUIRE(scheduler.next(worker, message));
+  BOOST_TEST(worker == 1);
+  BOOST_TEST(idOf(message) == "bulk_3");
+
+  // A reply frees the request it answers rather than the oldest one
+  scheduler.push(RequestLane::BULK, request("bulk_4", "b4"));
+  BOOST_TEST(scheduler.done(0, "c"));
+  BOOST_TEST(!scheduler.next(worker, message));
+  // Without a known correlation ID the oldest request is freed
+  BOOST_TEST(scheduler.done(0));
+  BOOST_REQUIRE(scheduler.next(worker, message));
+  BOOST_TEST(worker == 0);
+  BOOST_TEST(idOf(message) == "bulk_4");
+  BOOST_TEST(scheduler.busy() == 2);
+}
+
+BOOST_AUTO_TEST_CASE(testing_LaneSchedulerActiveWorkers) {
+  LaneScheduler scheduler(3, 3);
+  scheduler.setActiveWorkers(1, 1);
+  BOOST_TEST(scheduler.activeWorkers() == 1);
+
+  const auto start = LaneScheduler::clock::now();
+  scheduler.push(RequestLane::NORMAL, request("a"), start);
+  scheduler.push(RequestLane::CHEAP, request("b"),
+                 start + std::chrono::seconds(1));
+  BOOST_TEST((scheduler.oldestWait(start + std::chrono::seconds(3)) ==
+              std::chrono::seconds(3)));
+
+  // Only the active worker is given requests
+  size_t worker = 0;
+  std::unique_ptr<IMessage> message;
+  BOOST_REQUIRE(scheduler.next(worker, message));
+  BOOST_TEST(worker == 0);
+  BOOST_TEST(!scheduler.next(worker, message));
+
+  scheduler.setActiveWorkers(2, 1);
+  BOOST_REQUIRE(scheduler.next(worker, message));
+  BOOST_TEST(worker == 1);
+  BOOST_TEST(idOf(message) == "a");
+  BOOST_TEST((scheduler.oldestWait() == LaneScheduler::clock::duration(0)));
+
+  // A deactivated worker keeps its request until it replies
+  scheduler.setActiveWorkers(1, 1);
+  BOOST_TEST(scheduler.running(1) == 1);
+  BOOST_TEST(scheduler.done(1));
+  BOOST_TEST(scheduler.running(1) == 0);
+
+  BOOST_CHECK_THROW(scheduler.setActiveWorkers(0, 1), TraceException);
+  BOOST_CHECK_THROW(scheduler.setActiveWorkers(4, 1), TraceException);
+}
+
+BOOST_AUTO_TEST_CASE(testing_LaneSchedulerInvalid) {
+  BOOST_CHECK_THROW(LaneScheduler(0, 1), TraceException);
+  BOOST_CHECK_THROW(LaneScheduler(1, 0), TraceException);
+  BOOST_CHECK_THROW(LaneScheduler(1, 1, 0), TraceException);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -56,6 +56,16 @@ BOOST_AUTO_TEST_CASE(testing_MessageFactory) {
   BOOST_CHECK(message->getRoutes().size() == 1);
   BOOST_CHECK(message->getRoutes().front().compare(route) == 0);
 
+  // Every message is built with a correlation id of its own
+  auto other = msg_factory.create(MessageType::GOOGLE_PROTOCOL_BUFFER);
+  BOOST_CHECK(message->exists(MessageAttribute::CORRELATION_ID));
+  BOOST_CHECK(
+      std::get<std::string>(message->get(MessageAttribute::CORRELATION_ID))
+          .size() == 36);
+  BOOST_CHECK(
+      std::get<std::string>(message->get(MessageAttribute::CORRELATION_ID)) !=
+      std::get<std::string>(other->get(MessageAttribute::CORRELATION_ID)));
+
   /**
    * Payload will be empty in the response_message and so will the frame
    * but should include the routes
@@ -68,6 +78,15 @@ BOOST_AUTO_TEST_CASE(testing_MessageFactory) {
                   MessageAttribute::STATE)) == MessageState::RESPONSE);
   BOOST_CHECK(std::get<uint16_t>(response_message->get(
                   constants::message::google::CONTEXT)) == context);
+  BOOST_CHECK(
+      std::get<std::string>(
+          response_message->get(MessageAttribute::CORRELATION_ID)) ==
+      std::get<std::string>(message->get(MessageAttribute::CORRELATION_ID)));
+
+  // Received messages only carry the id they are sent with
+  auto received =
+      msg_factory.createReceived(MessageType::GOOGLE_PROTOCOL_BUFFER);
+  BOOST_CHECK(received->exists(MessageAttribute::CORRELATION_ID) == false);
 }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -21,6 +21,7 @@ using namespace SDMS;
 class DummyAuthManager : public IAuthenticationManager {
 private:
   std::unordered_map<std::string, int> m_counters;
+  uint32_t m_valid_token = 7;
 
   /**
    * Methods only available via the interface
@@ -37,10 +38,29 @@ private:
     return "authenticated_uid";
   }
 
+  virtual bool findUID(const std::string &pub_key, std::string &uid) final {
+    if (!m_counters.count(pub_key)) {
+      return false;
+    }
+    ++m_counters.at(pub_key);
+    uid = "authenticated_uid";
+    return true;
+  }
+
   virtual void purge() final {
     std::cout << "Purge not implemented" << std::endl;
   }
 
+  virtual uint32_t authenticateConnection(const std::string &,
+                                          std::string &uid) final {
+    uid = "authenticated_uid";
+    return m_valid_token;
+  }
+
+  virtual bool isConnectionValid(uint32_t token) const noexcept final {
+    return token == m_valid_token;
+  }
+
 public:
   /**
    * Method for adding known keys
@@ -117,6 +137,41 @@ BOOST_AUTO_TEST_CASE(testing_OperatorFactoryKnown) {
   BOOST_CHECK(dummy_manager.getAccessCount("skeleton_key") == 1);
 }
 
+BOOST_AUTO_TEST_CASE(testing_OperatorFactoryConnectionToken) {
+
+  OperatorFactory oper_factory;
+  DummyAuthManager dummy_manager;
+  dummy_manager.addKey("skeleton_key");
+  std::any argument = dynamic_cast<IAuthenticationManager *>(&dummy_manager);
+
+  auto auth_operator =
+      oper_factory.create(OperatorType::Authenticator, argument);
+
+  // The communicator sets the ID to the UID the ZAP handler resolved for the
+  // connection along with the token, a valid token means the key is not
+  // looked up or counted
+  MessageFactory msg_factory;
+  auto msg = msg_factory.create(MessageType::GOOGLE_PROTOCOL_BUFFER);
+  msg->set(MessageAttribute::KEY, "skeleton_key");
+  msg->set(MessageAttribute::ID, "u/zap_user");
+  msg->set(constants::message::google::CONNECTION_TOKEN, (uint32_t)7);
+
+  auth_operator->execute(*msg);
+  BOOST_CHECK(std::get<std::string>(msg->get(MessageAttribute::ID))
+                  .compare("u/zap_user") == 0);
+  BOOST_CHECK(dummy_manager.getAccessCount("skeleton_key") == 0);
+
+  // A revoked token falls back to looking up the key
+  auto revoked_msg = msg_factory.create(MessageType::GOOGLE_PROTOCOL_BUFFER);
+  revoked_msg->set(MessageAttribute::KEY, "bad_key");
+  revoked_msg->set(MessageAttribute::ID, "u/zap_user");
+  revoked_msg->set(constants::message::google::CONNECTION_TOKEN, (uint32_t)3);
+
+  auth_operator->execute(*revoked_msg);
+  BOOST_CHECK(std::get<std::string>(revoked_msg->get(MessageAttribute::ID))
+                  .compare("anon") == 0);
+}
+
 BOOST_AUTO_TEST_CASE(testing_RouterBookKeepingOperator) {
 
   OperatorFactory oper_factory;
@@ -0,0 +1,92 @@
+#define BOOST_TEST_MAIN
+
+#define BOOST_TEST_MODULE pool_scaler
+#include <boost/test/unit_test.hpp>
+
+// Local public includes
+#include "common/PoolScaler.hpp"
+#include "common/TraceException.hpp"
+
+// Standard includes
+#include <chrono>
+
+using namespace SDMS;
+
+namespace {
+PoolScaler::Options options() {
+  PoolScaler::Options options;
+  options.min_workers = 2;
+  options.max_workers = 4;
+  options.grow_busy_ratio = 0.8;
+  options.grow_queue_wait = std::chrono::milliseconds(50);
+  options.shrink_busy_ratio = 0.3;
+  options.grow_after = 2;
+  options.shrink_after = 3;
+  return options;
+}
+
+const auto NO_WAIT = std::chrono::milliseconds(0);
+const auto LONG_WAIT = std::chrono::milliseconds(200);
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(PoolScalerTest)
+
+BOOST_AUTO_TEST_CASE(testing_PoolScalerGrow) {
+  PoolScaler scaler(options());
+
+  // Busy without anything waiting is not a reason to grow
+  BOOST_TEST(scaler.sample(2, 1.0, NO_WAIT) == 2);
+  BOOST_TEST(scaler.sample(2, 1.0, NO_WAIT) == 2);
+
+  BOOST_TEST(scaler.sample(2, 1.0, LONG_WAIT) == 2);
+  BOOST_TEST(scaler.sample(2, 1.0, LONG_WAIT) == 3);
+  // Every resize starts the count over
+  BOOST_TEST(scaler.sample(3, 1.0, LONG_WAIT) == 3);
+  BOOST_TEST(scaler.sample(3, 1.0, LONG_WAIT) == 4);
+  BOOST_TEST(scaler.sample(4, 1.0, LONG_WAIT) == 4);
+  BOOST_TEST(scaler.sample(4, 1.0, LONG_WAIT) == 4);
+}
+
+BOOST_AUTO_TEST_CASE(testing_PoolScalerHysteresis) {
+  PoolScaler scaler(options());
+
+  // A sample that is neither hot nor cold interrupts a run of samples
+  BOOST_TEST(scaler.sample(3, 1.0, LONG_WAIT) == 3);
+  BOOST_TEST(scaler.sample(3, 0.5, NO_WAIT) == 3);
+  BOOST_TEST(scaler.sample(3, 1.0, LONG_WAIT) == 3);
+  BOOST_TEST(scaler.sample(3, 1.0, LONG_WAIT) == 4);
+
+  BOOST_TEST(scaler.sample(4, 0.1, NO_WAIT) == 4);
+  BOOST_TEST(scaler.sample(4, 0.1, NO_WAIT) == 4);
+  BOOST_TEST(scaler.sample(4, 0.5, NO_WAIT) == 4);
+  BOOST_TEST(scaler.sample(4, 0.1, NO_WAIT) == 4);
+  BOOST_TEST(scaler.sample(4, 0.1, NO_WAIT) == 4);
+  BOOST_TEST(scaler.sample(4, 0.1, NO_WAIT) == 3);
+}
+
+BOOST_AUTO_TEST_CASE(testing_PoolScalerShrink) {
+  PoolScaler scaler(options());
+
+  for (int i = 0; i < 2; ++i) {
+    BOOST_TEST(scaler.sample(3, 0.0, NO_WAIT) == 3);
+  }
+  BOOST_TEST(scaler.sample(3, 0.0, NO_WAIT) == 2);
+  // Never below the minimum
+  for (int i = 0; i < 10; ++i) {
+    BOOST_TEST(scaler.sample(2, 0.0, NO_WAIT) == 2);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(testing_PoolScalerBounds) {
+  PoolScaler scaler(options());
+  BOOST_TEST(scaler.sample(1, 0.0, NO_WAIT) == 2);
+  BOOST_TEST(scaler.sample(8, 1.0, LONG_WAIT) == 4);
+
+  BOOST_CHECK_THROW(PoolScaler(PoolScaler::Options{0, 1}), TraceException);
+  BOOST_CHECK_THROW(PoolScaler(PoolScaler::Options{3, 2}), TraceException);
+  PoolScaler::Options inverted = options();
+  inverted.shrink_busy_ratio = 0.9;
+  BOOST_CHECK_THROW(PoolScaler{inverted}, TraceException);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
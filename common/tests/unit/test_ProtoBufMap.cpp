@@ -9,6 +9,7 @@
 
 // Local public includes
 #include "common/ProtoBufMap.hpp"
+#include "common/TraceException.hpp"
 
 // Standard includes
 #include <iostream>
@@ -44,4 +45,39 @@ BOOST_AUTO_TEST_CASE(testing_ProtoBufMap_toString) {
   BOOST_CHECK(name.compare("VersionRequest") == 0);
 }
 
+BOOST_AUTO_TEST_CASE(testing_ProtoBufMap_all_types) {
+  ProtoBufMap proto_map;
+  ProtoBufFactory proto_factory;
+
+  size_t number_of_types = 0;
+  for (auto protocol : {MessageProtocol::GOOGLE_ANONONYMOUS,
+                        MessageProtocol::GOOGLE_AUTHORIZED}) {
+    uint16_t msg_type = proto_map.getProtocolID(protocol) << 8;
+    for (; proto_map.exists(msg_type); ++msg_type, ++number_of_types) {
+      auto msg = proto_factory.create(msg_type);
+      BOOST_CHECK(msg->GetDescriptor() ==
+                  proto_map.getDescriptorType(msg_type));
+      BOOST_CHECK(proto_map.getMessageType(*msg) == msg_type);
+      BOOST_CHECK(proto_map.getPrototype(msg_type)->GetDescriptor() ==
+                  msg->GetDescriptor());
+    }
+  }
+  BOOST_CHECK(number_of_types > 0);
+
+  // Any instance refers to the same registry
+  ProtoBufMap other_map;
+  SDMS::Auth::RepoCreateRequest repo_create_request;
+  BOOST_CHECK(proto_map.getMessageType(repo_create_request) ==
+              other_map.getMessageType(2, "RepoCreateRequest"));
+}
+
+BOOST_AUTO_TEST_CASE(testing_ProtoBufMap_unknown_type) {
+  ProtoBufMap proto_map;
+  BOOST_CHECK(proto_map.exists(0xFFFF) == false);
+  BOOST_CHECK_THROW(proto_map.getDescriptorType(0xFFFF), TraceException);
+  BOOST_CHECK_THROW(proto_map.toString(0xFFFF), TraceException);
+  BOOST_CHECK_THROW(proto_map.getMessageType(255, "VersionRequest"),
+                    TraceException);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
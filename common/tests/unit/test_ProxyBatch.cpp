@@ -0,0 +1,191 @@
+#define BOOST_TEST_MAIN
+
+#define BOOST_TEST_MODULE proxy_batch
+#include <boost/test/unit_test.hpp>
+
+// Local private includes
+#include "servers/ProxyBatch.hpp"
+
+// Local public includes
+#include "common/ICommunicator.hpp"
+#include "common/MessageFactory.hpp"
+#include "common/TraceException.hpp"
+
+// Standard includes
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace SDMS;
+
+namespace {
+
+std::unique_ptr<IMessage> request(const std::string &id) {
+  MessageFactory msg_factory;
+  auto message = msg_factory.create(MessageType::GOOGLE_PROTOCOL_BUFFER);
+  message->set(MessageAttribute::ID, id);
+  return message;
+}
+
+std::string idOf(IMessage &message) {
+  return std::get<std::string>(message.get(MessageAttribute::ID));
+}
+
+/**
+ * Stands in for one side of the proxy. Queued messages are handed out by
+ * tryReceive, which throws when the message with the id in fail_on is next,
+ * and the ids of sent messages are recorded.
+ **/
+class QueueCommunicator : public ICommunicator {
+public:
+  void queue(const std::string &prefix, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+      m_waiting.push_back(request(prefix + std::to_string(i)));
+    }
+  }
+
+  virtual Response poll(const MessageType type) final {
+    return tryReceive(type);
+  }
+  virtual void send(IMessage &message) final {
+    sent.push_back(idOf(message));
+  }
+  virtual Response receive(const MessageType type) final {
+    return tryReceive(type);
+  }
+  virtual Response tryReceive(const MessageType) final {
+    Response response;
+    if (m_waiting.empty()) {
+      response.time_out = true;
+      return response;
+    }
+    if (idOf(*m_waiting.front()) == fail_on) {
+      m_waiting.pop_front();
+      EXCEPT(1, "RCV zmq_msg_recv (body) failed.");
+    }
+    response.message = std::move(m_waiting.front());
+    m_waiting.pop_front();
+    return response;
+  }
+  virtual const std::string id() const noexcept final { return "queue"; }
+  virtual const std::string address() const noexcept final { return ""; }
+
+  size_t waiting() const { return m_waiting.size(); }
+
+  std::string fail_on;
+  std::vector<std::string> sent;
+
+private:
+  std::deque<std::unique_ptr<IMessage>> m_waiting;
+};
+
+/// Refuses messages with the id it is given
+class RefuseOperator : public IOperator {
+public:
+  explicit RefuseOperator(const std::string &id) : m_id(id) {}
+  virtual OperatorType type() const noexcept final {
+    return OperatorType::Authenticator;
+  }
+  virtual void execute(IMessage &message) final {
+    if (idOf(message) == m_id) {
+      EXCEPT(1, "refused");
+    }
+  }
+
+private:
+  std::string m_id;
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(ProxyBatchTest)
+
+BOOST_AUTO_TEST_CASE(testing_ProxyBatchLimit) {
+  LogContext log_context;
+  ProxyBatch batch(4, log_context);
+  QueueCommunicator from, to;
+  from.queue("m", 10);
+
+  BOOST_TEST(batch.drain(from) == 4);
+  BOOST_TEST(from.waiting() == 6);
+  batch.send(to);
+  BOOST_TEST(batch.size() == 0);
+  BOOST_TEST(batch.drain(from) == 4);
+  batch.send(to);
+  BOOST_TEST(batch.drain(from) == 2);
+  batch.send(to);
+  BOOST_TEST(batch.drain(from) == 0);
+
+  // Every message is forwarded once, in the order received
+  BOOST_REQUIRE(to.sent.size() == 10);
+  for (size_t i = 0; i < 10; ++i) {
+    BOOST_TEST(to.sent[i] == "m" + std::to_string(i));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(testing_ProxyBatchAlternating) {
+  LogContext log_context;
+  ProxyBatch batch(4, log_context);
+  QueueCommunicator client, server;
+  client.queue("c", 6);
+  server.queue("s", 6);
+
+  // Each pass forwards at most a batch per direction, as Proxy::run does
+  batch.drain(client);
+  batch.send(server);
+  batch.drain(server);
+  batch.send(client);
+  BOOST_TEST(server.sent.size() == 4);
+  BOOST_TEST(client.sent.size() == 4);
+  BOOST_TEST(client.sent.front() == "s0");
+
+  batch.drain(client);
+  batch.send(server);
+  batch.drain(server);
+  batch.send(client);
+  BOOST_TEST(server.sent.size() == 6);
+  BOOST_TEST(client.sent.size() == 6);
+  BOOST_TEST(server.sent.back() == "c5");
+  BOOST_TEST(client.sent.back() == "s5");
+}
+
+BOOST_AUTO_TEST_CASE(testing_ProxyBatchReceiveFailure) {
+  LogContext log_context;
+  ProxyBatch batch(8, log_context);
+  QueueCommunicator from, to;
+  from.queue("m", 6);
+  from.fail_on = "m3";
+
+  // The messages received before the failure are still forwarded
+  BOOST_TEST(batch.drain(from) == 3);
+  batch.send(to);
+  BOOST_REQUIRE(to.sent.size() == 3);
+  BOOST_TEST(to.sent.back() == "m2");
+
+  // Only the failed message is lost
+  BOOST_TEST(batch.drain(from) == 2);
+  batch.send(to);
+  BOOST_REQUIRE(to.sent.size() == 5);
+  BOOST_TEST(to.sent.back() == "m5");
+}
+
+BOOST_AUTO_TEST_CASE(testing_ProxyBatchOperatorFailure) {
+  LogContext log_context;
+  ProxyBatch batch(8, log_context);
+  QueueCommunicator from, to;
+  from.queue("m", 3);
+  std::vector<std::unique_ptr<IOperator>> operators;
+  operators.push_back(std::make_unique<RefuseOperator>("m1"));
+
+  batch.drain(from);
+  batch.operate(operators);
+  batch.send(to);
+  BOOST_REQUIRE(to.sent.size() == 2);
+  BOOST_TEST(to.sent[0] == "m0");
+  BOOST_TEST(to.sent[1] == "m2");
+
+  BOOST_CHECK_THROW(ProxyBatch(0, log_context), TraceException);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,328 @@
+#define BOOST_TEST_MAIN
+
+#define BOOST_TEST_MODULE libjson
+#include <boost/test/unit_test.hpp>
+
+// Local public includes
+#include "common/TraceException.hpp"
+#include "common/libjson.hpp"
+
+// Standard includes
+#include <cstdlib>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+using namespace libjson;
+
+namespace {
+const char *DOCUMENT =
+    "{\"status\":\"ok\",\"count\":3,\"items\":[{\"id\":\"d/1\",\"size\":10},"
+    "{\"id\":\"d/2\",\"size\":20,\"tags\":[\"a\",\"b\"]},{\"id\":\"d/3\","
+    "\"title\":\"a title long enough to need a buffer of its own\"}],"
+    "\"done\":true,\"next\":null}";
+
+const char *SORTED =
+    "{\"count\":3,\"done\":true,\"items\":[{\"id\":\"d/1\",\"size\":10},"
+    "{\"id\":\"d/2\",\"size\":20,\"tags\":[\"a\",\"b\"]},{\"id\":\"d/3\","
+    "\"title\":\"a title long enough to need a buffer of its own\"}],"
+    "\"next\":null,\"status\":\"ok\"}";
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(LibJSONTest)
+
+BOOST_AUTO_TEST_CASE(testing_libjson_ObjectOrder) {
+  Value value;
+  value.fromString(DOCUMENT);
+
+  // Members are iterated in key order whatever order they were parsed in
+  BOOST_TEST(value.toString() == SORTED);
+
+  const Value::Object &obj = value.asObject();
+  BOOST_TEST(obj.size() == 5);
+  BOOST_TEST(obj.getString("status") == "ok");
+  BOOST_TEST(obj.getNumber("count") == 3);
+  BOOST_TEST(obj.getBool("done"));
+  BOOST_TEST(obj.at("next").isNull());
+  BOOST_TEST(obj.getArray("items").size() == 3);
+  BOOST_CHECK(obj.find("missing") == obj.end());
+  BOOST_CHECK_THROW(obj.getString("missing"), TraceException);
+
+  std::vector<std::string> keys;
+  for (Value::ObjectConstIter i = obj.begin(); i != obj.end(); i++) {
+    keys.push_back(i->first);
+  }
+  std::vector<std::string> expected = {"count", "done", "items", "next",
+                                       "status"};
+  BOOST_TEST(keys == expected);
+
+  // A repeated key keeps the last value
+  value.fromString("{\"b\":1,\"a\":2,\"b\":3}");
+  BOOST_TEST(value.asObject().size() == 2);
+  BOOST_TEST(value.asObject().getNumber("b") == 3);
+}
+
+BOOST_AUTO_TEST_CASE(testing_libjson_ObjectMutation) {
+  Value value;
+  Value::Object &obj = value.initObject();
+  obj["zeta"] = "last";
+  obj["alpha"] = 1;
+  obj["mid"] = true;
+  obj["alpha"] = 2;
+  BOOST_TEST(obj.size() == 3);
+  BOOST_TEST(value.toString() ==
+             "{\"alpha\":2,\"mid\":true,\"zeta\":\"last\"}");
+
+  BOOST_TEST(obj.has("mid"));
+  BOOST_TEST(obj.asBool());
+  BOOST_TEST(!obj.has("none"));
+  BOOST_CHECK_THROW(obj.value(), TraceException);
+
+  obj.erase("mid");
+  obj.erase("none");
+  BOOST_TEST(obj.size() == 2);
+  BOOST_TEST(obj.getString("zeta") == "last");
+
+  obj.clear();
+  BOOST_TEST(obj.size() == 0);
+  BOOST_TEST(value.toString() == "{}");
+}
+
+BOOST_AUTO_TEST_CASE(testing_libjson_Arena) {
+  Value value;
+  value.fromString(DOCUMENT, true);
+  BOOST_TEST(value.toString() == SORTED);
+
+  const Value::Array &items = value.asObject().getArray("items");
+  BOOST_TEST(items[1].asObject().getArray("tags")[1].asString() == "b");
+
+  // Taking a value out of a document has to be spelled out
+  static_assert(!std::is_assignable<Value &, Value &>::value,
+                "Value must not be moved by a copy assignment");
+
+  // The arena moves with the root of its document
+  Value moved(std::move(value));
+  BOOST_TEST(value.isNull());
+  BOOST_TEST(moved.asObject().getString("status") == "ok");
+
+  // Values may still be changed and added
+  moved.asObject()["status"] = "changed";
+  moved.asObject()["added"] = "value";
+  BOOST_TEST(moved.asObject().getString("status") == "changed");
+
+  // Parsing again replaces the document and its arena
+  moved.fromString("[1,2,3]", true);
+  BOOST_TEST(moved.toString() == "[1,2,3]");
+
+  // Large documents take more than one block
+  std::string large = "[";
+  for (int i = 0; i < 2000; i++) {
+    large += (i ? ",\"" : "\"") + std::to_string(i) + "\"";
+  }
+  large += "]";
+  moved.fromString(large, true);
+  BOOST_TEST(moved.asArray().size() == 2000);
+  BOOST_TEST(moved.asArray()[1999].asString() == "1999");
+  BOOST_TEST(moved.toString() == large);
+}
+
+BOOST_AUTO_TEST_CASE(testing_libjson_ArenaParseError) {
+  Value value;
+  BOOST_CHECK_THROW(value.fromString("{\"a\":[1,2", true), ParseError);
+  BOOST_CHECK_THROW(value.fromString("x", true), ParseError);
+  BOOST_TEST(value.isNull());
+
+  value.fromString("{\"a\":1}", true);
+  BOOST_TEST(value.asObject().getNumber("a") == 1);
+}
+
+BOOST_AUTO_TEST_CASE(testing_libjson_Numbers) {
+  // Numbers are read as strtod reads them, whether or not they take the
+  // exact fast path
+  std::vector<std::string> numbers = {"0",
+                                      "-0",
+                                      "7",
+                                      "-42",
+                                      "3.25",
+                                      "0.1",
+                                      "-0.001",
+                                      ".5",
+                                      "1e3",
+                                      "1E-3",
+                                      "2.5e+2",
+                                      "1e22",
+                                      "1e23",
+                                      "1e-22",
+                                      "1e-300",
+                                      "1.7976931348623157e308",
+                                      "4.9e-324",
+                                      "9007199254740993",
+                                      "12345678901234567890123",
+                                      "0.30000000000000004",
+                                      "123456789.123456789",
+                                      "1690000000",
+                                      "0x1A",
+                                      "1.",
+                                      "00012"};
+
+  for (const std::string &number : numbers) {
+    Value value;
+    value.fromString("[" + number + "]");
+    BOOST_TEST_CONTEXT(number) {
+      BOOST_TEST(value.asArray()[0].asNumber() ==
+                 strtod(number.c_str(), nullptr));
+    }
+  }
+
+  Value value;
+  value.fromString(" [ 1 ,\n\t-2.5e1 , 3e-1 ] ");
+  BOOST_TEST(value.toString() == "[1,-25,0.3]");
+  BOOST_CHECK_THROW(value.fromString("[1.5.5]"), ParseError);
+  BOOST_CHECK_THROW(value.fromString("[-]"), ParseError);
+  BOOST_CHECK_THROW(value.fromString("[1e+]"), ParseError);
+}
+
+BOOST_AUTO_TEST_CASE(testing_libjson_Whitespace) {
+  // Runs of whitespace around every token, longer than a scanning block
+  const std::string pad(70, ' ');
+  const std::string pretty = pad + "{" + pad + "\"a\"" + pad + ":" + pad +
+                             "[" + pad + "true" + pad + "," + pad + "null" +
+                             pad + "]" + pad + "}\n\t\r" + pad;
+  Value value;
+  value.fromString(pretty);
+  BOOST_TEST(value.toString() == "{\"a\":[true,null]}");
+  BOOST_CHECK_THROW(value.fromString(pad + "{" + pad), ParseError);
+}
+
+BOOST_AUTO_TEST_CASE(testing_libjson_Strings) {
+  Value value;
+  value.fromString("[\"tab\\there\",\"\\u00e9\\\"\\\\\",\"\xc3\xa9\"]");
+  const Value::Array &strings = value.asArray();
+  BOOST_TEST(strings[0].asString() == "tab\there");
+  BOOST_TEST(strings[1].asString() == "\xc3\xa9\"\\");
+  BOOST_TEST(strings[2].asString() == "\xc3\xa9");
+
+  std::string long_string(1000, 'x');
+  value.fromString("[\"" + long_string + "\\n" + long_string + "\"]");
+  BOOST_TEST(value.asArray()[0].asString() ==
+             long_string + "\n" + long_string);
+
+  BOOST_CHECK_THROW(value.fromString("[\"a\tb\"]"), ParseError);
+  BOOST_CHECK_THROW(value.fromString("[\"" + long_string), ParseError);
+  BOOST_CHECK_THROW(value.fromString("[\"\\q\"]"), ParseError);
+}
+
+BOOST_AUTO_TEST_CASE(testing_libjson_Reader) {
+  Reader reader(DOCUMENT);
+  std::string events;
+
+  // Events come in document order, keys and all
+  for (Reader::Event event = reader.next(); event != Reader::EV_END;
+       event = reader.next()) {
+    switch (event) {
+    case Reader::EV_OBJECT_BEGIN:
+      events += "{ ";
+      break;
+    case Reader::EV_OBJECT_END:
+      events += "} ";
+      break;
+    case Reader::EV_ARRAY_BEGIN:
+      events += "[ ";
+      break;
+    case Reader::EV_ARRAY_END:
+      events += "] ";
+      break;
+    case Reader::EV_KEY:
+      events += std::string(reader.text()) + ": ";
+      break;
+    case Reader::EV_STRING:
+      events += "'" + std::string(reader.text()) + "' ";
+      break;
+    case Reader::EV_NUMBER:
+      events += std::to_string((int)reader.number()) + " ";
+      break;
+    case Reader::EV_BOOL:
+      events += reader.boolean() ? "true " : "false ";
+      break;
+    default:
+      events += std::string(reader.eventName()) + " ";
+      break;
+    }
+  }
+
+  BOOST_TEST(events ==
+             "{ status: 'ok' count: 3 items: [ { id: 'd/1' size: 10 } { id: "
+             "'d/2' size: 20 tags: [ 'a' 'b' ] } { id: 'd/3' title: 'a title "
+             "long enough to need a buffer of its own' } ] done: true next: "
+             "null } ");
+  BOOST_TEST(reader.depth() == 0);
+  BOOST_TEST(reader.next() == Reader::EV_END);
+}
+
+BOOST_AUTO_TEST_CASE(testing_libjson_ReaderValues) {
+  Reader reader(" { \"a\" : null, \"b\":\"x\\ty\", \"c\":[1,{\"d\":[]},"
+                "null], \"e\":{\"z\":1,\"y\":[true]}, \"f\":2.5, "
+                "\"g\":false } ");
+
+  BOOST_TEST(reader.next() == Reader::EV_OBJECT_BEGIN);
+  BOOST_TEST(!reader.readNull());
+  BOOST_TEST(reader.next() == Reader::EV_KEY);
+  BOOST_TEST(reader.readNull());
+
+  BOOST_TEST(reader.next() == Reader::EV_KEY);
+  BOOST_TEST(!reader.readNull());
+  BOOST_TEST(reader.readString() == "x\ty");
+
+  // Skipping a value skips everything in it
+  BOOST_TEST(reader.next() == Reader::EV_KEY);
+  reader.skip();
+  BOOST_TEST(reader.depth() == 1);
+
+  // Or it can be read whole into a Value
+  BOOST_TEST(reader.next() == Reader::EV_KEY);
+  Value value;
+  reader.readValue(value);
+  BOOST_TEST(value.toString() == "{\"y\":[true],\"z\":1}");
+
+  BOOST_TEST(reader.next() == Reader::EV_KEY);
+  BOOST_CHECK_THROW(reader.readString(), TraceException);
+  BOOST_TEST(reader.number() == 2.5);
+
+  BOOST_TEST(reader.next() == Reader::EV_KEY);
+  BOOST_TEST(!reader.readBool());
+  BOOST_TEST(reader.next() == Reader::EV_OBJECT_END);
+  BOOST_TEST(reader.next() == Reader::EV_END);
+
+  Reader nulls("[null,1,null]");
+  BOOST_TEST(nulls.next() == Reader::EV_ARRAY_BEGIN);
+  BOOST_TEST(nulls.readNull());
+  BOOST_TEST(!nulls.readNull());
+  BOOST_TEST(nulls.readNumber() == 1);
+  BOOST_TEST(nulls.readNull());
+  BOOST_TEST(nulls.next() == Reader::EV_ARRAY_END);
+}
+
+BOOST_AUTO_TEST_CASE(testing_libjson_ReaderErrors) {
+  auto readAll = [](const char *a_json) {
+    Reader reader(a_json);
+    while (reader.next() != Reader::EV_END) {
+    }
+  };
+
+  const char *invalid[] = {"{\"a\":1",   "[1,2",  "{\"a\" 1}", "{1:2}",
+                           "[1 2]",     "[tru]", "{\"\":1}",  "[1]]",
+                           "{\"a\":[}", "[\"abc", ""};
+  for (const char *json : invalid) {
+    BOOST_TEST_CONTEXT(json) { BOOST_CHECK_THROW(readAll(json), ParseError); }
+  }
+
+  try {
+    readAll("[1,\n x]");
+    BOOST_FAIL("expected a parse error");
+  } catch (ParseError &e) {
+    BOOST_TEST(e.getPos() == 5);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
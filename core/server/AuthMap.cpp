@@ -1,279 +1,324 @@
-
 // Local private includes
 #include "AuthMap.hpp"
 #include "DatabaseAPI.hpp"
 
+// Local common includes
+#include "common/TraceException.hpp"
+
+// Standard includes
+#include <mutex>
+#include <unordered_set>
+
 using namespace std;
 
 namespace SDMS {
 
 namespace Core {
-AuthMap::AuthMap(const AuthMap &auth_map) {
-
-  m_trans_active_increment = auth_map.m_trans_active_increment;
-  m_session_active_increment = auth_map.m_session_active_increment;
-
-  auth_map.m_trans_clients_mtx.lock();
-  m_trans_auth_clients = auth_map.m_trans_auth_clients;
-  auth_map.m_trans_clients_mtx.unlock();
 
-  auth_map.m_session_clients_mtx.lock();
-  m_session_auth_clients = auth_map.m_session_auth_clients;
-  auth_map.m_session_clients_mtx.unlock();
+PublicKey::PublicKey(std::string_view key) {
+  if (!assign(key)) {
+    EXCEPT_PARAM(1, "Public key is " << key.size()
+                                     << " characters, longer than the "
+                                     << MAX_SIZE << " allowed.");
+  }
+}
 
-  auth_map.m_persistent_clients_mtx.lock();
-  m_persistent_auth_clients = auth_map.m_persistent_auth_clients;
-  auth_map.m_persistent_clients_mtx.unlock();
+AuthMap::AuthMap(const AuthMap &auth_map) { copyFrom(auth_map); }
 
-  m_db_url = auth_map.m_db_url;
-  m_db_user = auth_map.m_db_user;
-  m_db_pass = auth_map.m_db_pass;
+AuthMap &AuthMap::operator=(const AuthMap &auth_map) {
+  if (this != &auth_map) {
+    copyFrom(auth_map);
+  }
+  return *this;
 }
 
-AuthMap &AuthMap::operator=(const AuthMap &&auth_map) {
-
+void AuthMap::copyFrom(const AuthMap &auth_map) {
   m_trans_active_increment = auth_map.m_trans_active_increment;
   m_session_active_increment = auth_map.m_session_active_increment;
 
-  auth_map.m_trans_clients_mtx.lock();
-  const auto trans = auth_map.m_trans_auth_clients;
-  auth_map.m_trans_clients_mtx.unlock();
-
-  m_trans_clients_mtx.lock();
-  m_trans_auth_clients = trans;
-  m_trans_clients_mtx.unlock();
-
-  auth_map.m_session_clients_mtx.lock();
-  const auto session = auth_map.m_session_auth_clients;
-  auth_map.m_session_clients_mtx.unlock();
-
-  m_session_clients_mtx.lock();
-  m_session_auth_clients = session;
-  m_session_clients_mtx.unlock();
-
-  auth_map.m_persistent_clients_mtx.lock();
-  const auto persistent = auth_map.m_persistent_auth_clients;
-  auth_map.m_persistent_clients_mtx.unlock();
-
-  m_persistent_clients_mtx.lock();
-  m_persistent_auth_clients = persistent;
-  m_persistent_clients_mtx.unlock();
+  for (size_t i = 0; i < NUMBER_OF_SHARDS; ++i) {
+    shared_lock<shared_mutex> other_lock(auth_map.m_shards[i].mutex);
+    unique_lock<shared_mutex> lock(m_shards[i].mutex);
+    m_shards[i].clients = auth_map.m_shards[i].clients;
+  }
+  for (size_t i = 0; i < m_sizes.size(); ++i) {
+    m_sizes[i].store(auth_map.m_sizes[i].load());
+  }
+  {
+    lock_guard<mutex> other_lock(auth_map.m_expiry_mutex);
+    lock_guard<mutex> lock(m_expiry_mutex);
+    m_expiry = auth_map.m_expiry;
+  }
 
   m_db_url = auth_map.m_db_url;
   m_db_user = auth_map.m_db_user;
   m_db_pass = auth_map.m_db_pass;
-  return *this;
+}
+
+bool AuthMap::find(const std::string &public_key, Lookup &result,
+                   bool count_access) const {
+  PublicKey key;
+  if (!key.assign(public_key)) {
+    return false;
+  }
+  const Shard &shard = m_shards[shardIndex(key)];
+  shared_lock<shared_mutex> lock(shard.mutex);
+  auto it = shard.clients.find(key);
+  if (it == shard.clients.end()) {
+    return false;
+  }
+  result.type = it->second.type;
+  result.uid = it->second.uid;
+  if (count_access && it->second.type != PublicKeyType::PERSISTENT) {
+    result.access_count =
+        it->second.access_count.fetch_add(1, memory_order_relaxed) + 1;
+  } else {
+    result.access_count = it->second.access_count.load(memory_order_relaxed);
+  }
+  return true;
 }
 
 std::vector<std::string>
 AuthMap::getExpiredKeys(const PublicKeyType pub_key_type,
                         const time_t threshold) const noexcept {
-
-  auto expiredKeys = [=](const AuthMap::client_map_t &client_map,
-                         const time_t expire_time) -> std::vector<std::string> {
-    std::vector<std::string> expired_keys;
-    for (const auto &element : client_map) {
-      if (element.second.expiration_time >= expire_time) {
-        expired_keys.push_back(element.first);
+  std::vector<std::string> expired_keys;
+  if (PublicKeyType::PERSISTENT == pub_key_type) {
+    return expired_keys;
+  }
+  for (const Shard &shard : m_shards) {
+    shared_lock<shared_mutex> lock(shard.mutex);
+    for (const auto &element : shard.clients) {
+      if (element.second.type == pub_key_type &&
+          element.second.expiration_time <= threshold) {
+        expired_keys.emplace_back(element.first.view());
       }
     }
-    return expired_keys;
-  };
+  }
+  return expired_keys;
+}
+
+void AuthMap::scheduleExpiry(const PublicKeyType pub_key_type,
+                             const PublicKey &key, time_t expiration_time) {
+  lock_guard<mutex> lock(m_expiry_mutex);
+  m_expiry[static_cast<size_t>(pub_key_type)].emplace(expiration_time, key);
+}
 
-  if (PublicKeyType::TRANSIENT == pub_key_type) {
-    lock_guard<mutex> lock(m_trans_clients_mtx);
-    return expiredKeys(m_trans_auth_clients, threshold);
-  } else if (PublicKeyType::SESSION == pub_key_type) {
-    lock_guard<mutex> lock(m_session_clients_mtx);
-    return expiredKeys(m_session_auth_clients, threshold);
+std::vector<std::string>
+AuthMap::takeExpiredKeys(const PublicKeyType pub_key_type,
+                         const time_t threshold) {
+  std::vector<std::string> expired_keys;
+  if (PublicKeyType::PERSISTENT == pub_key_type) {
+    return expired_keys;
   }
-  return std::vector<std::string>();
+  std::vector<expiry_t> due;
+  {
+    lock_guard<mutex> lock(m_expiry_mutex);
+    auto &expiry = m_expiry[static_cast<size_t>(pub_key_type)];
+    while (!expiry.empty() && expiry.top().first <= threshold) {
+      due.push_back(expiry.top());
+      expiry.pop();
+    }
+  }
+  // A key added or reset twice within a second is in the index twice
+  std::unordered_set<PublicKey, PublicKeyHash> seen;
+  for (const expiry_t &entry : due) {
+    if (!seen.insert(entry.second).second) {
+      continue;
+    }
+    const Shard &shard = m_shards[shardIndex(entry.second)];
+    shared_lock<shared_mutex> lock(shard.mutex);
+    auto it = shard.clients.find(entry.second);
+    // Skip entries left behind by keys that were removed, reset or re-added
+    if (it != shard.clients.end() && it->second.type == pub_key_type &&
+        it->second.expiration_time == entry.first) {
+      expired_keys.emplace_back(entry.second.view());
+    }
+  }
+  return expired_keys;
 }
 
 void AuthMap::removeKey(const PublicKeyType pub_key_type,
                         const std::string &pub_key) {
 
-  if (PublicKeyType::TRANSIENT == pub_key_type) {
-    lock_guard<mutex> lock(m_trans_clients_mtx);
-    if (m_trans_auth_clients.count(pub_key)) {
-      m_trans_auth_clients.erase(pub_key);
-    }
-  } else if (PublicKeyType::SESSION == pub_key_type) {
-    lock_guard<mutex> lock(m_session_clients_mtx);
-    if (m_session_auth_clients.count(pub_key)) {
-      m_session_auth_clients.erase(pub_key);
-    }
-  } else {
+  if (PublicKeyType::PERSISTENT == pub_key_type) {
     EXCEPT(1, "Unsupported PublicKey Type during execution of removeKey.");
   }
+  PublicKey key;
+  if (!key.assign(pub_key)) {
+    return;
+  }
+  Shard &shard = m_shards[shardIndex(key)];
+  unique_lock<shared_mutex> lock(shard.mutex);
+  auto it = shard.clients.find(key);
+  if (it != shard.clients.end() && it->second.type == pub_key_type) {
+    shard.clients.erase(it);
+    sizeOf(pub_key_type)--;
+  }
 }
 
 void AuthMap::resetKey(const PublicKeyType pub_key_type,
                        const std::string &public_key) {
+  time_t increment = 0;
   if (pub_key_type == PublicKeyType::TRANSIENT) {
-    lock_guard<mutex> lock(m_trans_clients_mtx);
-    if (m_trans_auth_clients.count(public_key)) {
-      m_trans_auth_clients[public_key].expiration_time =
-          time(0) + m_trans_active_increment;
-      m_trans_auth_clients[public_key].access_count = 0;
-    } else {
-      EXCEPT(1, "Missing public key cannot reset transient expiration.");
-    }
+    increment = m_trans_active_increment;
   } else if (pub_key_type == PublicKeyType::SESSION) {
-    lock_guard<mutex> lock(m_session_clients_mtx);
-    if (m_session_auth_clients.count(public_key)) {
-      m_session_auth_clients[public_key].expiration_time =
-          time(0) + m_session_active_increment;
-      m_session_auth_clients[public_key].access_count = 0;
-    } else {
-      EXCEPT(1, "Missing public key cannot reset session expiration.");
-    }
+    increment = m_session_active_increment;
   } else {
-    EXCEPT(1, "Unsupported PublicKey Type during execution of addKey.");
+    EXCEPT(1, "Unsupported PublicKey Type during execution of resetKey.");
   }
+
+  PublicKey key;
+  if (key.assign(public_key)) {
+    Shard &shard = m_shards[shardIndex(key)];
+    unique_lock<shared_mutex> lock(shard.mutex);
+    auto it = shard.clients.find(key);
+    if (it != shard.clients.end() && it->second.type == pub_key_type) {
+      it->second.expiration_time = time(0) + increment;
+      it->second.access_count.store(0, memory_order_relaxed);
+      scheduleExpiry(pub_key_type, key, it->second.expiration_time);
+      return;
+    }
+  }
+  if (pub_key_type == PublicKeyType::TRANSIENT) {
+    EXCEPT(1, "Missing public key cannot reset transient expiration.");
+  }
+  EXCEPT(1, "Missing public key cannot reset session expiration.");
 }
 
 void AuthMap::addKey(const PublicKeyType pub_key_type,
                      const std::string &public_key, const std::string &id) {
+  time_t expiration_time = 0;
   if (pub_key_type == PublicKeyType::TRANSIENT) {
-    lock_guard<mutex> lock(m_trans_clients_mtx);
-    AuthElement element = {id, time(0) + m_trans_active_increment, 0};
-    m_trans_auth_clients[public_key] = element;
+    expiration_time = time(0) + m_trans_active_increment;
   } else if (pub_key_type == PublicKeyType::SESSION) {
-    lock_guard<mutex> lock(m_session_clients_mtx);
-    AuthElement element = {id, time(0) + m_session_active_increment, 0};
-    m_session_auth_clients[public_key] = element;
-  } else if (pub_key_type == PublicKeyType::PERSISTENT) {
-    lock_guard<mutex> lock(m_persistent_clients_mtx);
-    m_persistent_auth_clients[public_key] = id;
-  } else {
+    expiration_time = time(0) + m_session_active_increment;
+  } else if (pub_key_type != PublicKeyType::PERSISTENT) {
     EXCEPT(1, "Unsupported PublicKey Type during execution of addKey.");
   }
+
+  const PublicKey key(public_key);
+  Shard &shard = m_shards[shardIndex(key)];
+  unique_lock<shared_mutex> lock(shard.mutex);
+  auto it = shard.clients.find(key);
+  if (it != shard.clients.end()) {
+    sizeOf(it->second.type)--;
+    it->second = AuthElement(id, pub_key_type, expiration_time);
+  } else {
+    shard.clients.emplace(std::piecewise_construct, std::forward_as_tuple(key),
+                          std::forward_as_tuple(id, pub_key_type,
+                                                expiration_time));
+  }
+  sizeOf(pub_key_type)++;
+  if (pub_key_type != PublicKeyType::PERSISTENT) {
+    scheduleExpiry(pub_key_type, key, expiration_time);
+  }
 }
 
 size_t AuthMap::size(const PublicKeyType pub_key_type) const {
-  if (pub_key_type == PublicKeyType::TRANSIENT) {
-    lock_guard<mutex> lock(m_trans_clients_mtx);
-    return m_trans_auth_clients.size();
-  } else if (pub_key_type == PublicKeyType::SESSION) {
-    lock_guard<mutex> lock(m_session_clients_mtx);
-    return m_session_auth_clients.size();
-  } else {
+  if (pub_key_type == PublicKeyType::PERSISTENT) {
     // Don't support size of persistent keys
     EXCEPT(1, "Unsupported PublicKey Type during execution of size.");
   }
+  return m_sizes[static_cast<size_t>(pub_key_type)].load();
 }
 
 void AuthMap::incrementKeyAccessCounter(const PublicKeyType pub_key_type,
                                         const std::string &public_key) {
-  if (pub_key_type == PublicKeyType::TRANSIENT) {
-    lock_guard<mutex> lock(m_trans_clients_mtx);
-    if (m_trans_auth_clients.count(public_key)) {
-      m_trans_auth_clients.at(public_key).access_count++;
-    }
-  } else if (pub_key_type == PublicKeyType::SESSION) {
-    lock_guard<mutex> lock(m_session_clients_mtx);
-    if (m_session_auth_clients.count(public_key)) {
-      m_session_auth_clients.at(public_key).access_count++;
-    }
+  if (pub_key_type == PublicKeyType::PERSISTENT) {
+    return;
+  }
+  PublicKey key;
+  if (!key.assign(public_key)) {
+    return;
+  }
+  const Shard &shard = m_shards[shardIndex(key)];
+  shared_lock<shared_mutex> lock(shard.mutex);
+  auto it = shard.clients.find(key);
+  if (it != shard.clients.end() && it->second.type == pub_key_type) {
+    it->second.access_count.fetch_add(1, memory_order_relaxed);
   }
 }
 
 bool AuthMap::hasKey(const PublicKeyType pub_key_type,
                      const std::string &public_key) const {
-
-  if (pub_key_type == PublicKeyType::TRANSIENT) {
-    lock_guard<mutex> lock(m_trans_clients_mtx);
-    if (m_trans_auth_clients.count(public_key)) {
-      return true;
-    }
-  } else if (pub_key_type == PublicKeyType::SESSION) {
-    lock_guard<mutex> lock(m_session_clients_mtx);
-    if (m_session_auth_clients.count(public_key))
-      return true;
-  } else if (pub_key_type == PublicKeyType::PERSISTENT) {
-    // Check to see if it is a repository key
-    if (m_persistent_auth_clients.count(public_key))
-      return true;
-
+  Lookup lookup;
+  if (find(public_key, lookup) && lookup.type == pub_key_type) {
+    return true;
+  }
+  if (pub_key_type == PublicKeyType::PERSISTENT) {
     // Check to see if it is a user key
-    DatabaseAPI db(m_db_url, m_db_user, m_db_pass);
     std::string uid;
-    if (db.uidByPubKey(public_key, uid)) {
-      return true;
-    }
-  } else {
-    EXCEPT(1, "Unrecognized PublicKey Type during execution of hasKey.");
+    return findPersistentUser(public_key, uid);
   }
   return false;
 }
 
+bool AuthMap::findPersistentUser(const std::string &public_key,
+                                 std::string &uid) const {
+  bool found = false;
+  if (m_persistent_user_cache.lookup(public_key, found, uid)) {
+    return found;
+  }
+
+  DatabaseAPI db(m_db_url, m_db_user, m_db_pass);
+  std::string found_uid;
+  try {
+    found = db.uidByPubKey(public_key, found_uid);
+  } catch (TraceException &) {
+    // Only an answer from the DB is cached, so an outage is not remembered
+    return false;
+  }
+  m_persistent_user_cache.insert(public_key, found, found_uid);
+  if (found) {
+    uid = found_uid;
+  }
+  return found;
+}
+
+void AuthMap::invalidatePersistentUser(const std::string &public_key) {
+  m_persistent_user_cache.invalidate(public_key);
+}
+
 std::string AuthMap::getUID(const PublicKeyType pub_key_type,
                             const std::string &public_key) const {
-  if (pub_key_type == PublicKeyType::TRANSIENT) {
-    lock_guard<mutex> lock(m_trans_clients_mtx);
-    if (m_trans_auth_clients.count(public_key)) {
-      return m_trans_auth_clients.at(public_key).uid;
-    } else {
-      EXCEPT(1, "Missing transient public key unable to map to uid.");
-    }
+  Lookup lookup;
+  if (find(public_key, lookup) && lookup.type == pub_key_type) {
+    return lookup.uid;
+  }
 
+  if (pub_key_type == PublicKeyType::TRANSIENT) {
+    EXCEPT(1, "Missing transient public key unable to map to uid.");
   } else if (pub_key_type == PublicKeyType::SESSION) {
-    lock_guard<mutex> lock(m_session_clients_mtx);
-    if (m_session_auth_clients.count(public_key)) {
-      return m_session_auth_clients.at(public_key).uid;
-    } else {
-      EXCEPT(1, "Missing session public key unable to map to uid.");
-    }
-
-  } else if (pub_key_type == PublicKeyType::PERSISTENT) {
-    // If it is a repository key get it
-    // auto auth_clients = m_config.getAuthClients();
-    if (m_persistent_auth_clients.count(public_key)) {
-      return m_persistent_auth_clients.at(public_key);
-    }
+    EXCEPT(1, "Missing session public key unable to map to uid.");
+  }
 
-    // It must be a persistent user key
-    DatabaseAPI db(m_db_url, m_db_user, m_db_pass);
-    std::string uid;
-    if (db.uidByPubKey(public_key, uid)) {
-      return uid;
-    } else {
-      EXCEPT(1, "Missing persistent public key unable to map to user id or "
-                "repo id. Possibly, cannot connect to database.");
-    }
+  // It must be a persistent user key
+  std::string uid;
+  if (findPersistentUser(public_key, uid)) {
+    return uid;
   }
-  EXCEPT(1, "Unrecognized PublicKey Type during execution of getId.");
+  EXCEPT(1, "Missing persistent public key unable to map to user id or "
+            "repo id. Possibly, cannot connect to database.");
 }
 
 bool AuthMap::hasKeyType(const PublicKeyType pub_key_type,
                          const std::string &public_key) const {
-  if (pub_key_type == PublicKeyType::TRANSIENT) {
-    lock_guard<mutex> lock(m_trans_clients_mtx);
-    return m_trans_auth_clients.count(public_key);
-  } else if (pub_key_type == PublicKeyType::SESSION) {
-    lock_guard<mutex> lock(m_session_clients_mtx);
-    return m_session_auth_clients.count(public_key);
-  } else {
+  if (pub_key_type == PublicKeyType::PERSISTENT) {
     EXCEPT(1, "Unsupported PublicKey Type during execution of hasKeyType.");
   }
+  Lookup lookup;
+  return find(public_key, lookup) && lookup.type == pub_key_type;
 }
 
 size_t AuthMap::getAccessCount(const PublicKeyType pub_key_type,
                                const std::string &public_key) const {
-  if (pub_key_type == PublicKeyType::TRANSIENT) {
-    lock_guard<mutex> lock(m_trans_clients_mtx);
-    if (m_trans_auth_clients.count(public_key)) {
-      return m_trans_auth_clients.at(public_key).access_count;
-    }
-  } else if (pub_key_type == PublicKeyType::SESSION) {
-    lock_guard<mutex> lock(m_session_clients_mtx);
-    if (m_session_auth_clients.count(public_key)) {
-      return m_session_auth_clients.at(public_key).access_count;
-    }
-  } else {
+  if (pub_key_type == PublicKeyType::PERSISTENT) {
     EXCEPT(1, "Unsupported PublicKey Type during execution of hasKeyType.");
   }
+  Lookup lookup;
+  if (find(public_key, lookup) && lookup.type == pub_key_type) {
+    return lookup.access_count;
+  }
   return 0;
 }
 
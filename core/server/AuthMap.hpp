@@ -3,52 +3,169 @@
 #pragma once
 
 // Local includes
-#include "AuthMap.hpp"
+#include "PublicKeyCache.hpp"
 #include "PublicKeyTypes.hpp"
 
 // Local common includes
 #include "common/IAuthenticationManager.hpp"
 
 // Standard includes
-#include <map>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <functional>
 #include <mutex>
+#include <queue>
+#include <shared_mutex>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 namespace SDMS {
 namespace Core {
 
+/**
+ * Keys are Z85 encoded CURVE public keys, which are always 40 characters. They
+ * are stored inline so a lookup never allocates.
+ **/
+class PublicKey {
+public:
+  static const size_t MAX_SIZE = 40;
+
+  PublicKey() = default;
+  /// Throws if the key is longer than MAX_SIZE
+  explicit PublicKey(std::string_view key);
+
+  /// Returns false, leaving the key empty, if it is longer than MAX_SIZE
+  bool assign(std::string_view key) noexcept {
+    if (key.size() > MAX_SIZE) {
+      return false;
+    }
+    m_size = static_cast<uint8_t>(key.size());
+    memcpy(m_data.data(), key.data(), key.size());
+    return true;
+  }
+
+  std::string_view view() const noexcept {
+    return std::string_view(m_data.data(), m_size);
+  }
+
+  bool operator==(const PublicKey &other) const noexcept {
+    return view() == other.view();
+  }
+
+private:
+  std::array<char, MAX_SIZE> m_data{};
+  uint8_t m_size = 0;
+};
+
+struct PublicKeyHash {
+  size_t operator()(const PublicKey &key) const noexcept {
+    return std::hash<std::string_view>()(key.view());
+  }
+};
+
+/**
+ * Maps public keys to user ids
+ *
+ * All key types share a single table which is split into shards, each behind
+ * its own reader/writer lock, so lookups from the I/O and worker threads only
+ * contend when they hit the same shard while it is being modified. A key is
+ * only ever held with one type, adding it again with another type replaces
+ * the previous entry.
+ *
+ * Persistent repository keys are held in the table, persistent user keys are
+ * looked up in the database and the result is cached.
+ *
+ * TRANSIENT and SESSION keys are also indexed by expiration time so expired
+ * keys can be collected without scanning the table. The index is only updated
+ * when a key is added or reset, entries for keys that were removed or reset
+ * since are discarded when they come due.
+ **/
 class AuthMap {
 public:
   struct AuthElement {
     std::string uid = "";
+    PublicKeyType type = PublicKeyType::TRANSIENT;
     time_t expiration_time = 0;
+    /// Counted with the shard read lock held
+    mutable std::atomic<size_t> access_count{0};
+
+    AuthElement() = default;
+    AuthElement(const std::string &id, PublicKeyType key_type, time_t expires)
+        : uid(id), type(key_type), expiration_time(expires) {}
+    AuthElement(const AuthElement &other)
+        : uid(other.uid), type(other.type),
+          expiration_time(other.expiration_time),
+          access_count(other.access_count.load(std::memory_order_relaxed)) {}
+    AuthElement &operator=(const AuthElement &other) {
+      uid = other.uid;
+      type = other.type;
+      expiration_time = other.expiration_time;
+      access_count.store(other.access_count.load(std::memory_order_relaxed),
+                         std::memory_order_relaxed);
+      return *this;
+    }
+  };
+
+  /// Everything known about a key, filled in by a single find
+  struct Lookup {
+    PublicKeyType type = PublicKeyType::TRANSIENT;
+    std::string uid;
+    /// Number of accesses, including the one counted by the find
     size_t access_count = 0;
   };
 
-  typedef std::map<std::string, AuthElement> client_map_t;
-  typedef std::map<std::string, std::string> persistent_client_map_t;
+  typedef std::unordered_map<PublicKey, AuthElement, PublicKeyHash>
+      client_map_t;
 
 private:
+  static const size_t NUMBER_OF_SHARDS = 32;
+
+  struct alignas(64) Shard {
+    mutable std::shared_mutex mutex;
+    client_map_t clients;
+  };
+
   time_t m_trans_active_increment = 0;
   time_t m_session_active_increment = 0;
 
-  mutable std::mutex
-      m_trans_clients_mtx; ///< Mutex for transient client data access
-  mutable std::mutex
-      m_session_clients_mtx; ///< Mutex for session client data access
-  mutable std::mutex
-      m_persistent_clients_mtx; ///< Mutex for persistent client data access
+  std::array<Shard, NUMBER_OF_SHARDS> m_shards;
+  /// Number of keys of each type
+  std::array<std::atomic<size_t>, 3> m_sizes{};
 
-  client_map_t m_trans_auth_clients; ///< Map of transient authenticated clients
-  client_map_t m_session_auth_clients; ///< Map of session authenticated clients
-  persistent_client_map_t
-      m_persistent_auth_clients; ///< Map of known persistent authenticated
-                                 ///< clients
+  typedef std::pair<time_t, PublicKey> expiry_t;
+  struct ExpiresLater {
+    bool operator()(const expiry_t &lhs, const expiry_t &rhs) const noexcept {
+      return lhs.first > rhs.first;
+    }
+  };
+  /// Soonest expiration first, one queue for TRANSIENT and one for SESSION
+  std::array<std::priority_queue<expiry_t, std::vector<expiry_t>, ExpiresLater>,
+             2>
+      m_expiry;
+  mutable std::mutex m_expiry_mutex;
 
   std::string m_db_url;
   std::string m_db_user;
   std::string m_db_pass;
+  /// Database lookups of persistent user keys, not copied with the map
+  mutable PublicKeyCache m_persistent_user_cache;
+
+  size_t shardIndex(const PublicKey &key) const noexcept {
+    // The low bits select the bucket within the shard
+    return (PublicKeyHash()(key) >> 16) % NUMBER_OF_SHARDS;
+  }
+
+  std::atomic<size_t> &sizeOf(const PublicKeyType pub_key_type) noexcept {
+    return m_sizes[static_cast<size_t>(pub_key_type)];
+  }
+
+  void copyFrom(const AuthMap &auth_map);
+  /// Called with the shard of the key locked
+  void scheduleExpiry(const PublicKeyType pub_key_type, const PublicKey &key,
+                      time_t expiration_time);
 
 public:
   AuthMap(){};
@@ -62,11 +179,19 @@ public:
 
   AuthMap(const AuthMap &);
 
-  AuthMap &operator=(const AuthMap &&);
+  AuthMap &operator=(const AuthMap &);
   /***********************************************************************************
    * Getters
    ***********************************************************************************/
 
+  /**
+   * Looks the key up in a single probe of the table, the database is not
+   *consulted. If count_access is true the access counter of TRANSIENT and
+   *SESSION keys is incremented as part of the same probe.
+   **/
+  bool find(const std::string &public_key, Lookup &result,
+            bool count_access = false) const;
+
   /**
    * Determines if the key has the specified type
    *
@@ -83,7 +208,7 @@ public:
                   const std::string &public_key) const;
 
   /**
-   * Will grab all the public keys that have expired.
+   * Will grab all the public keys that have expired, by scanning the table.
    **/
   std::vector<std::string>
   getExpiredKeys(const PublicKeyType pub_key_type,
@@ -112,6 +237,15 @@ public:
   bool hasKey(const PublicKeyType pub_key_type,
               const std::string &public_key) const;
 
+  /**
+   * Looks up a persistent user key in the database, uid is left untouched if
+   *the key is not found. Recent results, including keys that were not found,
+   *are answered from the cache. A key the database could not be asked about
+   *is reported as not found and is not cached.
+   **/
+  bool findPersistentUser(const std::string &public_key,
+                          std::string &uid) const;
+
   /***********************************************************************************
    * Manipulators
    ***********************************************************************************/
@@ -139,6 +273,21 @@ public:
   void removeKey(const PublicKeyType pub_key_type,
                  const std::string &public_key);
 
+  /**
+   * Drops the cached database lookup of a persistent user key, must be called
+   *whenever a user key is generated or revoked.
+   **/
+  void invalidatePersistentUser(const std::string &public_key);
+
+  /**
+   * Removes the keys that expired at or before the threshold from the expiry
+   *index and returns them, only keys that are due are visited. The keys stay
+   *in the table, the caller is expected to remove or reset each of them,
+   *otherwise they will not be returned again until they are next reset.
+   **/
+  std::vector<std::string> takeExpiredKeys(const PublicKeyType pub_key_type,
+                                           const time_t threshold);
+
   /**
    * Will reset the access counter of the key to 0 and the allowed expiration
    *time of the key..
@@ -19,13 +19,9 @@ AuthenticationManager::AuthenticationManager(
     const std::string &db_pass)
     : m_purge_interval(purge_intervals),
       m_purge_conditions(std::move(purge_conditions)) {
-  m_auth_mapper = std::move(AuthMap(m_purge_interval[PublicKeyType::TRANSIENT],
-                                    m_purge_interval[PublicKeyType::SESSION],
-                                    db_url, db_user, db_pass));
-
-  for (const auto &purge_int : m_purge_interval) {
-    m_next_purge[purge_int.first] = time(0) + purge_int.second;
-  }
+  m_auth_mapper = AuthMap(m_purge_interval[PublicKeyType::TRANSIENT],
+                          m_purge_interval[PublicKeyType::SESSION], db_url,
+                          db_user, db_pass);
 }
 
 AuthenticationManager &
@@ -33,9 +29,9 @@ AuthenticationManager::operator=(AuthenticationManager &&other) {
   // Only need to lock the mutex moving from
   if (this != &other) {
     std::lock_guard<std::mutex> lock(other.m_lock);
-    m_next_purge = other.m_next_purge;
     m_purge_interval = other.m_purge_interval;
     m_purge_conditions = std::move(other.m_purge_conditions);
+    m_auth_mapper = std::move(other.m_auth_mapper);
   }
   return *this;
 }
@@ -48,68 +44,108 @@ void AuthenticationManager::purge() {
 void AuthenticationManager::purge(const PublicKeyType pub_key_type) {
 
   std::lock_guard<std::mutex> lock(m_lock);
-  if (m_auth_mapper.size(pub_key_type)) {
-    const time_t now = time(0);
-    if (now >= m_next_purge[pub_key_type]) {
-      const std::vector<std::string> expired_keys =
-          m_auth_mapper.getExpiredKeys(pub_key_type, now);
-      for (const auto &pub_key : expired_keys) {
-        if (m_purge_conditions[pub_key_type].size()) {
-          for (std::unique_ptr<Condition> &condition :
-               m_purge_conditions[pub_key_type]) {
-            condition->enforce(m_auth_mapper, pub_key);
-          }
-        } else {
-          m_auth_mapper.removeKey(pub_key_type, pub_key);
-        }
+  const std::vector<std::string> expired_keys =
+      m_auth_mapper.takeExpiredKeys(pub_key_type, time(0));
+  for (const auto &pub_key : expired_keys) {
+    if (m_purge_conditions[pub_key_type].size()) {
+      for (std::unique_ptr<Condition> &condition :
+           m_purge_conditions[pub_key_type]) {
+        condition->enforce(m_auth_mapper, pub_key);
       }
-      m_next_purge[pub_key_type] = now + m_purge_interval[pub_key_type];
+    } else {
+      m_auth_mapper.removeKey(pub_key_type, pub_key);
     }
   }
 }
 
 void AuthenticationManager::incrementKeyAccessCounter(
     const std::string &public_key) {
-  std::lock_guard<std::mutex> lock(m_lock);
-  if (m_auth_mapper.hasKey(PublicKeyType::TRANSIENT, public_key)) {
-    m_auth_mapper.incrementKeyAccessCounter(PublicKeyType::TRANSIENT,
-                                            public_key);
-  } else if (m_auth_mapper.hasKey(PublicKeyType::SESSION, public_key)) {
-    m_auth_mapper.incrementKeyAccessCounter(PublicKeyType::SESSION, public_key);
-  }
-  // Ignore persistent cases because counter does nothing for them
+  // Persistent keys are ignored because the counter does nothing for them
+  AuthMap::Lookup lookup;
+  m_auth_mapper.find(public_key, lookup, true);
 }
 
 bool AuthenticationManager::hasKey(const std::string &public_key) const {
-  std::lock_guard<std::mutex> lock(m_lock);
-  if (m_auth_mapper.hasKey(PublicKeyType::TRANSIENT, public_key)) {
-    return true;
-  } else if (m_auth_mapper.hasKey(PublicKeyType::SESSION, public_key)) {
-    return true;
-  } else if (m_auth_mapper.hasKey(PublicKeyType::PERSISTENT, public_key)) {
+  AuthMap::Lookup lookup;
+  if (m_auth_mapper.find(public_key, lookup)) {
     return true;
   }
-  return false;
+  return m_auth_mapper.hasKey(PublicKeyType::PERSISTENT, public_key);
 }
 
 std::string AuthenticationManager::getUID(const std::string &public_key) const {
-  std::lock_guard<std::mutex> lock(m_lock);
-
-  if (m_auth_mapper.hasKey(PublicKeyType::TRANSIENT, public_key))
-    return m_auth_mapper.getUID(PublicKeyType::TRANSIENT, public_key);
-  if (m_auth_mapper.hasKey(PublicKeyType::SESSION, public_key))
-    return m_auth_mapper.getUID(PublicKeyType::SESSION, public_key);
-  if (m_auth_mapper.hasKey(PublicKeyType::PERSISTENT, public_key))
-    return m_auth_mapper.getUID(PublicKeyType::PERSISTENT, public_key);
+  AuthMap::Lookup lookup;
+  if (m_auth_mapper.find(public_key, lookup)) {
+    return lookup.uid;
+  }
+  std::string uid;
+  if (m_auth_mapper.findPersistentUser(public_key, uid)) {
+    return uid;
+  }
   EXCEPT(1, "Unrecognized public_key during execution of getUID.");
 }
 
+bool AuthenticationManager::findUID(const std::string &public_key,
+                                    std::string &uid) {
+  AuthMap::Lookup lookup;
+  if (m_auth_mapper.find(public_key, lookup, true)) {
+    uid = lookup.uid;
+    return true;
+  }
+  return m_auth_mapper.findPersistentUser(public_key, uid);
+}
+
 void AuthenticationManager::addKey(const PublicKeyType pub_key_type,
                                    const std::string public_key,
                                    const std::string uid) {
-  std::lock_guard<std::mutex> lock(m_lock);
   m_auth_mapper.addKey(pub_key_type, public_key, uid);
 }
 
+uint32_t
+AuthenticationManager::authenticateConnection(const std::string &public_key,
+                                              std::string &uid) {
+  // Held while resolving the key so a revocation cannot slip in between
+  std::lock_guard<std::mutex> connections_lock(m_connections_lock);
+  AuthMap::Lookup lookup;
+  if (m_auth_mapper.find(public_key, lookup)) {
+    uid = lookup.uid;
+    if (lookup.type != PublicKeyType::PERSISTENT) {
+      return 0;
+    }
+  } else if (!m_auth_mapper.findPersistentUser(public_key, uid)) {
+    uid = "anon";
+    return 0;
+  }
+
+  if (++m_last_token == 0) {
+    ++m_last_token;
+  }
+  Connection &connection = m_connections[m_last_token % MAX_CONNECTIONS];
+  connection.public_key = public_key;
+  connection.token.store(m_last_token, std::memory_order_release);
+  return m_last_token;
+}
+
+bool AuthenticationManager::isConnectionValid(uint32_t token) const noexcept {
+  return token != 0 &&
+         m_connections[token % MAX_CONNECTIONS].token.load(
+             std::memory_order_acquire) == token;
+}
+
+void AuthenticationManager::revokeConnections(const std::string &public_key) {
+  std::lock_guard<std::mutex> lock(m_connections_lock);
+  for (size_t i = 0; i < MAX_CONNECTIONS; ++i) {
+    Connection &connection = m_connections[i];
+    if (connection.token.load(std::memory_order_relaxed) &&
+        connection.public_key == public_key) {
+      connection.token.store(0, std::memory_order_release);
+    }
+  }
+}
+
+void AuthenticationManager::invalidateKey(const std::string &public_key) {
+  m_auth_mapper.invalidatePersistentUser(public_key);
+}
+
 } // namespace Core
 } // namespace SDMS
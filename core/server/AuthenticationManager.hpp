@@ -11,6 +11,7 @@
 #include "common/IAuthenticationManager.hpp"
 
 // Standard includes
+#include <atomic>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -21,8 +22,6 @@ namespace Core {
 
 class AuthenticationManager : public IAuthenticationManager {
 private:
-  // The next purge time for each type of public key
-  std::map<PublicKeyType, time_t> m_next_purge;
   // The purge interval for each type of public key
   std::map<PublicKeyType, time_t> m_purge_interval;
   // The purge conditions for each type of public key
@@ -31,8 +30,25 @@ private:
 
   AuthMap m_auth_mapper;
 
+  // Serializes purges, lookups and additions go straight to the AuthMap
   mutable std::mutex m_lock;
 
+  /**
+   * Connections the ZAP handler issued a token for, a token lives in slot
+   * token % MAX_CONNECTIONS until it is revoked or the slot is reused by a
+   * newer connection, which sends the older one back to per message lookups.
+   **/
+  struct Connection {
+    std::atomic<uint32_t> token{0};
+    std::string public_key;
+  };
+  static const size_t MAX_CONNECTIONS = 4096;
+  std::unique_ptr<Connection[]> m_connections =
+      std::make_unique<Connection[]>(MAX_CONNECTIONS);
+  uint32_t m_last_token = 0;
+  // Guards issuing and revoking tokens
+  std::mutex m_connections_lock;
+
 public:
   AuthenticationManager(){};
 
@@ -55,7 +71,8 @@ public:
   virtual void incrementKeyAccessCounter(const std::string &public_key) final;
 
   /**
-   * This will purge all keys of a particular type that have expired.
+   * This will purge all keys of a particular type that have expired. Only the
+   *keys that are due are visited.
    *
    * The session key counter will be set back to 0 if it has been used and is
    *not purged.
@@ -64,7 +81,7 @@ public:
 
   /**
    * Calls purge for both TRANSIENT and SESSION keys. If they need to be
-   * purged they are.
+   * purged they are. Called periodically by the core server key expiry thread.
    */
   virtual void purge() final;
 
@@ -91,6 +108,35 @@ public:
    * - PERSISTENT
    **/
   virtual std::string getUID(const std::string &pub_key) const final;
+
+  /**
+   * Resolves the key with a single probe of the AuthMap, counting the access,
+   *and only asks the database when the key is not held in memory.
+   **/
+  virtual bool findUID(const std::string &pub_key, std::string &uid) final;
+
+  /**
+   * Only connections using a PERSISTENT key are given a token. TRANSIENT and
+   *SESSION keys are promoted and expire based on how often they are used, so
+   *their messages still go through hasKey and incrementKeyAccessCounter.
+   **/
+  virtual uint32_t authenticateConnection(const std::string &pub_key,
+                                          std::string &uid) final;
+
+  virtual bool isConnectionValid(uint32_t token) const noexcept final;
+
+  /**
+   * Revokes the tokens of all connections authenticated with the key, their
+   *messages are looked up again and will no longer map to the uid once the
+   *key has been removed.
+   **/
+  void revokeConnections(const std::string &pub_key);
+
+  /**
+   * Forgets any cached database lookup of the key, called when a user key is
+   *generated or revoked.
+   **/
+  void invalidateKey(const std::string &pub_key);
 };
 
 } // namespace Core
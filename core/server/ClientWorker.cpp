@@ -1,6 +1,8 @@
 
 // Local DataFed includes
 #include "ClientWorker.hpp"
+#include "DeferredRequests.hpp"
+#include "MetricsRegistry.hpp"
 #include "TaskMgr.hpp"
 #include "Version.hpp"
 
@@ -24,6 +26,7 @@
 
 // Standard includes
 #include <atomic>
+#include <chrono>
 #include <iostream>
 
 using namespace std;
@@ -35,7 +38,8 @@ using namespace SDMS::Auth;
 
 namespace Core {
 
-map<uint16_t, ClientWorker::msg_fun_t> ClientWorker::m_msg_handlers;
+std::array<std::unique_ptr<ClientWorker::msg_handler_page_t>, 256>
+    ClientWorker::m_msg_handlers;
 
 // TODO - This should be defined in proto files
 #define NOTE_MASK_MD_ERR 0x2000
@@ -45,9 +49,12 @@ ClientWorker::ClientWorker(ICoreServer &a_core, size_t a_tid,
     : m_config(Config::getInstance()), m_core(a_core), m_tid(a_tid),
       m_run(true),
       m_db_client(m_config.db_url, m_config.db_user, m_config.db_pass),
-      m_log_context(log_context_in) {
+      m_log_context(log_context_in),
+      m_msg_counts(a_core.getMsgCountShard(a_tid)) {
   // This should be hidden behind a factory or some other builder
   m_msg_mapper = std::unique_ptr<IMessageMapper>(new ProtoBufMap);
+  m_task_list_msg_type = m_msg_mapper->getMessageType(2, "TaskListRequest");
+  m_db_client.setStreamReplies(m_config.db_stream_replies);
   setupMsgHandlers();
   LogContext log_context = m_log_context;
   log_context.thread_name +=
@@ -81,20 +88,41 @@ void ClientWorker::wait() {
   }
 }
 
-#define SET_MSG_HANDLER(proto_id, msg, func)                                   \
-  m_msg_handlers[m_msg_mapper->getMessageType(proto_id, #msg)] = func
+void ClientWorker::setMsgHandler(uint8_t a_proto_id,
+                                 const std::string &a_msg_name,
+                                 msg_fun_t a_function, bool a_deferrable) {
+  const uint16_t msg_type =
+      m_msg_mapper->getMessageType(a_proto_id, a_msg_name);
+  std::unique_ptr<msg_handler_page_t> &page = m_msg_handlers[msg_type >> 8];
+  if (!page) {
+    page = std::make_unique<msg_handler_page_t>();
+  }
+  MsgHandler &handler = (*page)[msg_type & 0xFF];
+  handler.function = a_function;
+  handler.name = a_msg_name;
+  MetricsRegistry &metrics = MetricsRegistry::getInstance();
+  handler.duration_us =
+      &metrics.histogram(metrics::HANDLER_DURATION, a_msg_name);
+  handler.request_bytes =
+      &metrics.histogram(metrics::HANDLER_REQUEST_SIZE, a_msg_name);
+  handler.errors = &metrics.counter(metrics::HANDLER_ERRORS, a_msg_name);
+  handler.deferrable = a_deferrable;
+}
+
+#define SET_MSG_HANDLER(proto_id, msg, func) setMsgHandler(proto_id, #msg, func)
 #define SET_MSG_HANDLER_DB(proto_id, rq, rp, func)                             \
-  m_msg_handlers[m_msg_mapper->getMessageType(proto_id, #rq)] =                \
-      &ClientWorker::dbPassThrough<rq, rp, &DatabaseAPI::func>
+  setMsgHandler(proto_id, #rq,                                                 \
+                &ClientWorker::dbPassThrough<rq, rp, &DatabaseAPI::func>,      \
+                true)
 
 /**
- * This method configures message handling by creating a map from message type
- * to handler function. There are currently two protocol levels: anonymous and
- * authenticated. Each is supported by a Google protobuf interface (in
- * /common/proto). Most requests can be handled directly by the DB (via
- * DatabaseAPI class), but some require local processing. This method maps the
- * two classes of requests using the macros SET_MSG_HANDLER (for local) and
- * SET_MSG_HANDLER_DB (for DB only).
+ * This method configures message handling by filling in the dense table from
+ * message type to handler function. There are currently two protocol levels:
+ * anonymous and authenticated. Each is supported by a Google protobuf
+ * interface (in /common/proto). Most requests can be handled directly by the
+ * DB (via DatabaseAPI class), but some require local processing. This method
+ * maps the two classes of requests using the macros SET_MSG_HANDLER (for local)
+ * and SET_MSG_HANDLER_DB (for DB only).
  */
 void ClientWorker::setupMsgHandlers() {
   static std::atomic_flag lock = ATOMIC_FLAG_INIT;
@@ -316,7 +344,8 @@ void ClientWorker::workerThread(LogContext log_context) {
     socket_options.connection_life = SocketConnectionLife::INTERMITTENT;
     socket_options.connection_security = SocketConnectionSecurity::INSECURE;
     socket_options.protocol_type = ProtocolType::ZQTP;
-    socket_options.host = "workers";
+    // The message router gives every worker a channel of its own
+    socket_options.host = "workers_" + std::to_string(m_tid);
     socket_options.local_id = client_id;
 
     std::unordered_map<CredentialType, std::string> cred_options;
@@ -334,17 +363,42 @@ void ClientWorker::workerThread(LogContext log_context) {
                           timeout_on_poll);
   }();
 
-  ProtoBufMap proto_map;
-  uint16_t task_list_msg_type = proto_map.getMessageType(2, "TaskListRequest");
+  // Requests that only need the DB wait for it without blocking the worker
+  std::unique_ptr<DeferredRequests> deferred;
+  if (m_config.num_client_worker_requests > 1) {
+    deferred = std::make_unique<DeferredRequests>(
+        m_db_client, m_config.num_client_worker_requests, log_context);
+  }
+  // Longest wait on the DB and the worker channel before checking m_run, a
+  // channel that cannot be waited on is checked for requests every 1 ms
+  const int client_fd = client->fileDescriptor();
+  const int deferred_wait_ms = client_fd < 0 ? 1 : 1000;
 
   DL_DEBUG(log_context, "W" << m_tid << " m_run " << m_run);
 
   LogContext message_log_context = log_context;
-  while (isRunning()) {
+  // Requests already in flight are completed once stopped
+  while (isRunning() || (deferred && deferred->size())) {
     message_log_context.correlation_id = "";
     try {
-      ICommunicator::Response response =
-          client->receive(MessageType::GOOGLE_PROTOCOL_BUFFER);
+      ICommunicator::Response response;
+      if (deferred && deferred->size()) {
+        // New requests are taken while there is room for them. Without one
+        // waiting, sleep until the DB answers or the channel signals one,
+        // which it does for any arriving after tryReceive has timed out.
+        const bool accepting = !deferred->full() && isRunning();
+        if (accepting) {
+          response = client->tryReceive(MessageType::GOOGLE_PROTOCOL_BUFFER);
+        }
+        const bool waiting = !response.message;
+        deferred->poll(waiting ? deferred_wait_ms : 0,
+                       accepting ? client_fd : -1);
+        if (waiting) {
+          continue;
+        }
+      } else {
+        response = client->receive(MessageType::GOOGLE_PROTOCOL_BUFFER);
+      }
       if (response.time_out == false and response.error == false) {
 
         IMessage &message = *response.message;
@@ -352,12 +406,14 @@ void ClientWorker::workerThread(LogContext log_context) {
             message.get(constants::message::google::MSG_TYPE));
         message_log_context.correlation_id = std::get<std::string>(
             message.get(MessageAttribute::CORRELATION_ID));
-        DL_DEBUG(message_log_context, "W" << m_tid << " received message: "
-                                          << proto_map.toString(msg_type));
+        const MsgHandler *handler = getMsgHandler(msg_type);
+        DL_DEBUG(message_log_context,
+                 "W" << m_tid << " received message: "
+                     << (handler ? handler->name : std::to_string(msg_type)));
 
         const std::string uid =
             std::get<std::string>(message.get(MessageAttribute::ID));
-        if (msg_type != task_list_msg_type) {
+        if (msg_type != m_task_list_msg_type) {
           DL_DEBUG(message_log_context,
                    "W" << m_tid << " msg " << msg_type << " [" << uid << "]");
         }
@@ -366,46 +422,39 @@ void ClientWorker::workerThread(LogContext log_context) {
           DL_WARNING(message_log_context,
                      "W" << m_tid
                          << " unauthorized access attempt from anon user");
-          auto response_msg = m_msg_factory.createResponseEnvelope(message);
-
-          // I know this is not great... allocating memory here slow
-          // This will need to be fixed
-          auto nack = std::make_unique<Anon::NackReply>();
-          nack->set_err_code(ID_AUTHN_REQUIRED);
-          nack->set_err_msg("Authentication required");
-          response_msg->setPayload(std::move(nack));
-          client->send(*response_msg);
+          sendNack(*client, message, ID_AUTHN_REQUIRED,
+                   "Authentication required");
         } else {
-          DL_DEBUG(message_log_context,
-                   "W" << m_tid << " getting handler from map: msg_type = "
-                       << proto_map.toString(msg_type));
-          if (m_msg_handlers.count(msg_type)) {
-
-            auto handler = m_msg_handlers.find(msg_type);
-
+          if (handler) {
             DL_TRACE(message_log_context,
                      "W" << m_tid
                          << " calling handler/attempting to call "
                             "function of worker");
 
-            // Have to move the actual unique_ptr, change ownership not simply
-            // passing a reference
-            auto response_msg = (this->*handler->second)(
-                uid, std::move(response.message), message_log_context);
-            if (response_msg) {
-              // Gather msg metrics except on task lists (web clients poll)
-              if (msg_type != task_list_msg_type)
-                m_core.metricsUpdateMsgCount(uid, msg_type);
-
-              DL_DEBUG(message_log_context,
-                       "W" << m_tid << " sending msg of type "
-                           << proto_map.toString(msg_type));
-              client->send(*response_msg);
-              DL_TRACE(message_log_context, "Message sent ");
+            if (message.exists(constants::message::google::FRAME_SIZE)) {
+              handler->request_bytes->record(std::get<uint32_t>(
+                  message.get(constants::message::google::FRAME_SIZE)));
+            }
+            const auto start = std::chrono::steady_clock::now();
+            if (deferred && handler->deferrable) {
+              // The request is run again each time its DB calls complete
+              auto request = std::make_shared<std::unique_ptr<IMessage>>(
+                  std::move(response.message));
+              ICommunicator &channel = *client;
+              deferred->start([this, &channel, handler, uid, msg_type, request,
+                               start, message_log_context]() {
+                handleRequest(channel, *handler, uid, msg_type, *request,
+                              start, message_log_context);
+              });
+            } else {
+              handleRequest(*client, *handler, uid, msg_type,
+                            response.message, start, message_log_context);
             }
           } else {
             DL_ERROR(message_log_context,
                      "W" << m_tid << " recvd unregistered msg: " << msg_type);
+            sendNack(*client, message, ID_BAD_REQUEST,
+                     "Unregistered message type");
           }
         }
       }
@@ -421,6 +470,55 @@ void ClientWorker::workerThread(LogContext log_context) {
   DL_DEBUG(log_context, "W exiting loop");
 }
 
+void ClientWorker::handleRequest(ICommunicator &a_client,
+                                 const MsgHandler &a_handler,
+                                 const std::string &a_uid, uint16_t a_msg_type,
+                                 std::unique_ptr<IMessage> &a_request,
+                                 std::chrono::steady_clock::time_point a_start,
+                                 LogContext log_context) {
+  // Have to move the actual unique_ptr, change ownership not simply passing a
+  // reference
+  auto response_msg =
+      (this->*a_handler.function)(a_uid, std::move(a_request), log_context);
+  a_handler.duration_us->record(
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - a_start)
+          .count());
+  if (response_msg) {
+    const auto *reply =
+        std::get<google::protobuf::Message *>(response_msg->getPayload());
+    if (reply && reply->GetDescriptor() == Anon::NackReply::descriptor()) {
+      a_handler.errors->fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Gather msg metrics except on task lists (web clients poll)
+    if (a_msg_type != m_task_list_msg_type)
+      m_msg_counts->increment(a_uid, a_msg_type);
+
+    DL_DEBUG(log_context,
+             "W" << m_tid << " sending msg of type " << a_handler.name);
+    a_client.send(*response_msg);
+    DL_TRACE(log_context, "Message sent ");
+  } else {
+    // The router counts on a reply to know the worker is idle
+    if (a_request) {
+      sendNack(a_client, *a_request, ID_INTERNAL_ERROR,
+               "Request could not be processed");
+    }
+  }
+}
+
+void ClientWorker::sendNack(ICommunicator &a_client, const IMessage &a_request,
+                            ErrorCode a_err_code,
+                            const std::string &a_err_msg) {
+  auto response_msg = m_msg_factory.createResponseEnvelope(a_request);
+  auto nack = std::make_unique<Anon::NackReply>();
+  nack->set_err_code(a_err_code);
+  nack->set_err_msg(a_err_msg);
+  response_msg->setPayload(std::move(nack));
+  a_client.send(*response_msg);
+}
+
 // TODO The macros below should be replaced with templates
 
 /// This macro defines the begining of the common message handling code for all
@@ -449,6 +547,9 @@ void ClientWorker::workerThread(LogContext log_context) {
     return msg_reply;                                                          \
   }                                                                            \
   }                                                                            \
+  catch (DatabaseAPI::CallDeferred &) {                                        \
+    throw;                                                                     \
+  }                                                                            \
   catch (TraceException & e) {                                                 \
     DL_ERROR(log_context, "W" << m_tid << " " << e.toString());                \
     if (send_reply) {                                                          \
@@ -693,6 +794,7 @@ std::unique_ptr<IMessage> ClientWorker::procGenerateCredentialsRequest(
     priv_key = secret_key;
 
     m_db_client.userSetKeys(pub_key, priv_key, log_context);
+    m_core.invalidateClientKey(pub_key);
   }
 
   reply.set_pub_key(pub_key);
@@ -717,7 +819,12 @@ std::unique_ptr<IMessage> ClientWorker::procRevokeCredentialsRequest(
   DL_INFO(log_context, "Revoking credentials for " << a_uid);
 
   m_db_client.setClient(a_uid);
+  string pub_key, priv_key;
+  const bool has_keys = m_db_client.userGetKeys(pub_key, priv_key, log_context);
   m_db_client.userClearKeys(log_context);
+  if (has_keys) {
+    m_core.revokeClientKey(pub_key);
+  }
 
   PROC_MSG_END(log_context);
 }
@@ -1037,6 +1144,8 @@ ClientWorker::procRecordUpdateRequest(const std::string &a_uid,
       request->has_sch_enforce()) {
     string metadata, cur_metadata, sch_id;
     bool merge = true;
+    libjson::Value sch;
+    bool sch_loaded = false;
 
     if (request->has_mdset() && request->mdset())
       merge = false;
@@ -1050,7 +1159,15 @@ ClientWorker::procRecordUpdateRequest(const std::string &a_uid,
 
       view_request.set_id(request->id());
 
-      m_db_client.recordView(view_request, view_reply, log_context);
+      if (request->has_metadata() && request->metadata().size() &&
+          request->has_sch_id() && request->sch_id().size()) {
+        // Schema is known up front and will be needed, fetch both at once
+        m_db_client.recordViewWithSchema(view_request, view_reply,
+                                         request->sch_id(), sch, log_context);
+        sch_loaded = true;
+      } else {
+        m_db_client.recordView(view_request, view_reply, log_context);
+      }
 
       if (request->has_metadata() && merge) {
         metadata = request->metadata();
@@ -1075,8 +1192,8 @@ ClientWorker::procRecordUpdateRequest(const std::string &a_uid,
     if (metadata.size() && sch_id.size()) {
       DL_TRACE(log_context, "Must validate JSON, schema " << sch_id);
 
-      libjson::Value sch;
-      m_db_client.schemaView(sch_id, sch, log_context);
+      if (!sch_loaded)
+        m_db_client.schemaView(sch_id, sch, log_context);
 
       DL_TRACE(log_context, "Schema record JSON:" << sch.toString());
 
@@ -5,10 +5,13 @@
 // Local private includes
 #include "DatabaseAPI.hpp"
 #include "GlobusAPI.hpp"
+#include "Histogram.hpp"
 #include "ICoreServer.hpp"
+#include "MsgCountShard.hpp"
 
 // DataFed Common public includes
 #include "common/DynaLog.hpp"
+#include "common/ICommunicator.hpp"
 #include "common/IMessage.hpp"
 #include "common/IMessageMapper.hpp"
 #include "common/MessageFactory.hpp"
@@ -21,6 +24,9 @@
 
 // Standard includes
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -38,6 +44,11 @@ namespace Core {
  * processes requests directly or passes them on to the DB. Most requests can be
  * handled by the database alone, but requests that require orchestration with
  * other parts of the system are handled by the ClientWorker.
+ *
+ * When Config::num_client_worker_requests is above one, requests that only
+ * need the DB do not block the worker while they wait for it. They are run
+ * through DeferredRequests, so a single worker can have that many of them in
+ * flight while it goes on receiving requests.
  */
 class ClientWorker : public nlohmann::json_schema::basic_error_handler {
 public:
@@ -195,6 +206,33 @@ private:
       const std::string &a_uid, std::unique_ptr<IMessage> &&request,
       LogContext log_context);
 
+  /**
+   * Slot of the dispatch table, empty if the type has no handler. The metrics
+   * are owned by the MetricsRegistry and shared by all workers.
+   **/
+  struct MsgHandler {
+    msg_fun_t function = nullptr;
+    std::string name;
+    Histogram *duration_us = nullptr;        ///< Time spent in the handler
+    Histogram *request_bytes = nullptr;      ///< Size of the request payload
+    std::atomic<uint64_t> *errors = nullptr; ///< Requests answered with a nack
+    bool deferrable = false; ///< Only calls the DB, may run deferred
+  };
+
+  /// The handlers of one protocol, indexed by the low byte of the type
+  typedef std::array<MsgHandler, 256> msg_handler_page_t;
+
+  void setMsgHandler(uint8_t a_proto_id, const std::string &a_msg_name,
+                     msg_fun_t a_function, bool a_deferrable = false);
+  static const MsgHandler *getMsgHandler(uint16_t a_msg_type) noexcept {
+    const msg_handler_page_t *page = m_msg_handlers[a_msg_type >> 8].get();
+    if (page == nullptr) {
+      return nullptr;
+    }
+    const MsgHandler &handler = (*page)[a_msg_type & 0xFF];
+    return handler.function ? &handler : nullptr;
+  }
+
   void schemaLoader(const nlohmann::json_uri &a_uri, nlohmann::json &a_value,
                     LogContext log_context);
 
@@ -213,6 +251,19 @@ private:
   }
 
   bool isRunning() const;
+  /**
+   * Runs the handler of a request and sends its reply, a_start is when the
+   * request was received. Throws DatabaseAPI::CallDeferred if the handler is
+   * run deferred and has to wait for the DB.
+   **/
+  void handleRequest(ICommunicator &a_client, const MsgHandler &a_handler,
+                     const std::string &a_uid, uint16_t a_msg_type,
+                     std::unique_ptr<IMessage> &a_request,
+                     std::chrono::steady_clock::time_point a_start,
+                     LogContext log_context);
+  /// Replies to a request with a NackReply, every request must get a reply
+  void sendNack(ICommunicator &a_client, const IMessage &a_request,
+                ErrorCode a_err_code, const std::string &a_err_msg);
 
   Config &m_config;    ///< Ref to configuration singleton
   ICoreServer &m_core; ///< Ref to parent CoreServer interface
@@ -224,10 +275,18 @@ private:
   GlobusAPI m_globus_api;      ///< Local GlobusAPI instance
   std::string m_validator_err; ///< String buffer for metadata validation errors
   LogContext m_log_context;
+  /// Message counts of this worker, drained by the CoreServer metrics thread
+  std::shared_ptr<MsgCountShard> m_msg_counts;
   MessageFactory m_msg_factory;
   std::unique_ptr<IMessageMapper> m_msg_mapper;
-  /// Map of message type to message handler functions
-  static std::map<uint16_t, msg_fun_t> m_msg_handlers;
+  /// Task lists are polled by web clients and left out of message counts
+  uint16_t m_task_list_msg_type = 0;
+  /**
+   * Message handlers indexed by protocol ID, the high byte of the message
+   * type, and then by message index. Built once by setupMsgHandlers and only
+   * read afterwards.
+   **/
+  static std::array<std::unique_ptr<msg_handler_page_t>, 256> m_msg_handlers;
 };
 
 } // namespace Core
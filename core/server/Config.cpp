@@ -88,6 +88,7 @@ void Config::loadRepositoryConfig(AuthenticationManager &auth_manager,
 void Config::triggerRepoCacheRefresh() {
   std::lock_guard<std::mutex> lock(m_repos_mtx);
   m_trigger_repo_refresh = true;
+  ++m_repo_generation;
 }
 
 bool Config::repoCacheInvalid() {
@@ -95,6 +96,11 @@ bool Config::repoCacheInvalid() {
   return m_trigger_repo_refresh;
 }
 
+uint64_t Config::repoCacheGeneration() const {
+  std::lock_guard<std::mutex> lock(m_repos_mtx);
+  return m_repo_generation;
+}
+
 std::map<std::string, RepoData> Config::getRepos() const {
   std::lock_guard<std::mutex> lock(m_repos_mtx);
   std::map<std::string, RepoData> repos = m_repos;
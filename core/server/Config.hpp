@@ -33,17 +33,21 @@ private:
   Config()
       : glob_oauth_url("https://auth.globus.org/v2/oauth2/"),
         glob_xfr_url("https://transfer.api.globus.org/v0.10/"), port(7512),
-        timeout(5), num_client_worker_threads(4), num_task_worker_threads(10),
-        task_purge_age(14 * 24 * 3600), task_purge_period(6 * 3600),
-        task_retry_time_fail(3600),
+        timeout(5), num_client_worker_threads(4), max_client_worker_threads(0),
+        num_client_worker_requests(1), num_task_worker_threads(10),
+        max_task_worker_threads(0), db_max_connections(0),
+        db_stream_replies(false), task_purge_age(14 * 24 * 3600),
+        task_purge_period(6 * 3600), task_retry_time_fail(3600),
         task_retry_time_init(30), // Double every retry until max backoff
-        task_retry_backoff_max(4), repo_chunk_size(100), repo_timeout(60000),
+        task_retry_backoff_max(4), task_xfr_poll_period(5),
+        repo_chunk_size(100), repo_timeout(60000),
         note_purge_age(7 * 24 * 3600), note_purge_period(6 * 3600),
         metrics_period(300), metrics_purge_period(3600),
-        metrics_purge_age(24 * 3600) {}
+        metrics_purge_age(24 * 3600), metrics_file_period(15) {}
 
   std::map<std::string, RepoData> m_repos;
   bool m_trigger_repo_refresh = true; // Default on startup
+  uint64_t m_repo_generation = 0;     // Incremented on every refresh trigger
   mutable std::mutex m_repos_mtx;
 
 public:
@@ -51,6 +55,7 @@ public:
                             LogContext log_context);
   void triggerRepoCacheRefresh();
   bool repoCacheInvalid();
+  uint64_t repoCacheGeneration() const;
 
   std::map<std::string, RepoData> getRepos() const;
 
@@ -64,13 +69,26 @@ public:
   std::string client_secret;
   uint32_t port;
   uint32_t timeout;
+  /// Initial and smallest number of client workers
   uint32_t num_client_worker_threads;
+  /// Client workers added under load, no more than num_* if zero
+  uint32_t max_client_worker_threads;
+  /// Requests a client worker keeps in flight while they wait on the DB
+  uint32_t num_client_worker_requests;
+  /// Initial and smallest number of task workers
   uint32_t num_task_worker_threads;
+  /// Task workers added under load, no more than num_* if zero
+  uint32_t max_task_worker_threads;
+  /// DB connections the worker pools may hold at once, unlimited if zero
+  uint32_t db_max_connections;
+  /// Translate listing and record replies without building a JSON tree
+  bool db_stream_replies;
   uint32_t task_purge_age;
   uint32_t task_purge_period;
   uint32_t task_retry_time_fail;
   uint32_t task_retry_time_init;
   uint32_t task_retry_backoff_max;
+  uint32_t task_xfr_poll_period;
   uint32_t repo_chunk_size;
   uint32_t repo_timeout;
   uint32_t note_purge_age;
@@ -78,6 +96,9 @@ public:
   uint32_t metrics_period;
   uint32_t metrics_purge_period;
   uint32_t metrics_purge_age;
+  /// Prometheus text file of latency metrics, not written if empty
+  std::string metrics_file;
+  uint32_t metrics_file_period;
 
   // MsgComm::SecurityContext            sec_ctx;
   std::unique_ptr<ICredentials> sec_ctx;
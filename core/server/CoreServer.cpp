@@ -3,6 +3,7 @@
 #include "ClientWorker.hpp"
 #include "Condition.hpp"
 #include "DatabaseAPI.hpp"
+#include "MetricsRegistry.hpp"
 #include "PublicKeyTypes.hpp"
 #include "TaskMgr.hpp"
 
@@ -11,6 +12,7 @@
 #include "common/DynaLog.hpp"
 #include "common/IServer.hpp"
 #include "common/OperatorFactory.hpp"
+#include "common/ProtoBufMap.hpp"
 #include "common/ServerFactory.hpp"
 #include "common/SocketOptions.hpp"
 #include "common/Util.hpp"
@@ -21,6 +23,7 @@
 // Standard includes
 #include <chrono>
 #include <fstream>
+#include <algorithm>
 #include <memory>
 #include <time.h>
 #include <vector>
@@ -40,11 +43,139 @@ namespace SDMS {
 
 namespace Core {
 
+namespace {
+
+/**
+ * Lanes of the client worker pool. Cheap requests are what the web UI polls
+ * for and are never queued behind anything else, bulk requests can run for a
+ * long time and never occupy every worker. A pool of one worker therefore has
+ * no bulk lane, bulk requests are queued as normal ones.
+ **/
+LaneOptions clientWorkerLanes(size_t number_of_workers,
+                              size_t requests_per_worker) {
+  const char *cheap[] = {"VersionRequest", "GetAuthStatusRequest",
+                         "DailyMessageRequest"};
+  const char *cheap_authorized[] = {"TaskListRequest",
+                                    "TaskViewRequest",
+                                    "CheckPermsRequest",
+                                    "GetPermsRequest",
+                                    "UserGetRecentEPRequest",
+                                    "UserViewRequest",
+                                    "RepoListRequest",
+                                    "ProjectGetRoleRequest",
+                                    "CollGetParentsRequest",
+                                    "TagListByCountRequest"};
+  const char *bulk_authorized[] = {"SearchRequest",
+                                   "RecordExportRequest",
+                                   "RecordCreateBatchRequest",
+                                   "RecordUpdateBatchRequest",
+                                   "RecordDeleteRequest",
+                                   "RecordGetDependencyGraphRequest",
+                                   "RecordAllocChangeRequest",
+                                   "RecordOwnerChangeRequest",
+                                   "CollDeleteRequest",
+                                   "ProjectDeleteRequest",
+                                   "ProjectSearchRequest",
+                                   "QueryExecRequest",
+                                   "DataGetRequest",
+                                   "DataPutRequest",
+                                   "RepoCalcSizeRequest"};
+
+  ProtoBufMap proto_map;
+  const uint8_t anon =
+      proto_map.getProtocolID(MessageProtocol::GOOGLE_ANONONYMOUS);
+  const uint8_t authorized =
+      proto_map.getProtocolID(MessageProtocol::GOOGLE_AUTHORIZED);
+
+  LaneOptions options;
+  options.number_of_workers = number_of_workers;
+  options.requests_per_worker = requests_per_worker;
+  for (const char *name : cheap) {
+    options.lanes[proto_map.getMessageType(anon, name)] = RequestLane::CHEAP;
+  }
+  for (const char *name : cheap_authorized) {
+    options.lanes[proto_map.getMessageType(authorized, name)] =
+        RequestLane::CHEAP;
+  }
+  if (number_of_workers > 1) {
+    // Leave a quarter of the workers, at least one, for everything else
+    options.max_bulk_workers =
+        number_of_workers - std::max<size_t>(1, number_of_workers / 4);
+    for (const char *name : bulk_authorized) {
+      options.lanes[proto_map.getMessageType(authorized, name)] =
+          RequestLane::BULK;
+    }
+  }
+  return options;
+}
+
+/// DB connections a client worker holds with all its requests in flight
+size_t clientWorkerConnections(size_t requests_per_worker) {
+  return requests_per_worker > 1 ? requests_per_worker + 1 : 1;
+}
+
+/**
+ * Settles the bounds of the worker pools. A pool without a maximum keeps its
+ * initial size, and the maxima are lowered so the pools never hold more DB
+ * connections than Config::db_max_connections, sharing what the initial
+ * pools leave in proportion to what each could add.
+ **/
+void boundWorkerPools(Config &config, LogContext log_context) {
+  config.max_client_worker_threads = std::max(
+      config.max_client_worker_threads, config.num_client_worker_threads);
+  config.max_task_worker_threads =
+      std::max(config.max_task_worker_threads, config.num_task_worker_threads);
+  if (config.db_max_connections == 0) {
+    return;
+  }
+
+  const size_t per_client =
+      clientWorkerConnections(config.num_client_worker_requests);
+  const size_t initial =
+      config.num_client_worker_threads * per_client +
+      config.num_task_worker_threads;
+  if (initial > config.db_max_connections) {
+    EXCEPT_PARAM(1, "Initial worker pools need " << initial
+                                                 << " DB connections, above "
+                                                 << "the limit of "
+                                                 << config.db_max_connections);
+  }
+  const size_t spare = config.db_max_connections - initial;
+  const size_t client_extra = (config.max_client_worker_threads -
+                               config.num_client_worker_threads) *
+                              per_client;
+  const size_t task_extra =
+      config.max_task_worker_threads - config.num_task_worker_threads;
+  if (client_extra + task_extra <= spare) {
+    return;
+  }
+
+  const size_t client_workers =
+      spare * client_extra / (client_extra + task_extra) / per_client;
+  const size_t task_workers =
+      std::min(task_extra, spare - client_workers * per_client);
+  config.max_client_worker_threads =
+      config.num_client_worker_threads + client_workers;
+  config.max_task_worker_threads =
+      config.num_task_worker_threads + task_workers;
+  DL_WARNING(log_context, "Worker pools limited to "
+                              << config.max_client_worker_threads
+                              << " client and "
+                              << config.max_task_worker_threads
+                              << " task workers by the limit of "
+                              << config.db_max_connections
+                              << " DB connections");
+}
+
+} // namespace
+
 Server::Server(LogContext log_context)
     : m_config(Config::getInstance()), m_log_context(log_context) {
   // One-time global libcurl init
   curl_global_init(CURL_GLOBAL_DEFAULT);
 
+  boundWorkerPools(m_config, m_log_context);
+
   // Load ZMQ keys
   loadKeys(m_config.cred_dir);
 
@@ -80,16 +211,17 @@ Server::Server(LogContext log_context)
   purge_conditions[PublicKeyType::SESSION].emplace_back(
       std::make_unique<Reset>(accesses_to_reset, key_type_to_apply_reset));
 
-  // Load repository config from DB
-  m_config.loadRepositoryConfig(m_auth_manager, log_context);
-
-  // Must occur after loading config settings
   m_auth_manager = std::move(AuthenticationManager(
       purge_intervals, std::move(purge_conditions), m_config.db_url,
       m_config.db_user, m_config.db_pass));
 
+  // Load repository config from DB, must occur after the authentication
+  // manager is created so the repository keys are added to its AuthMap
+  m_config.loadRepositoryConfig(m_auth_manager, log_context);
+
   // Start ZAP handler must be started before any other socket binds are called
-  // m_zap_thread = thread( &Server::zapHandler, this );
+  m_zap_handler = std::make_unique<ZapHandler>(m_auth_manager, m_log_context);
+  m_zap_thread = thread(&ZapHandler::run, m_zap_handler.get());
 
   // Start DB maintenance thread
   m_db_maint_thread =
@@ -99,10 +231,20 @@ Server::Server(LogContext log_context)
   m_repo_cache_thread =
       thread(&Server::repoCacheThread, this, m_log_context, getNewThreadId());
 
+  // Start client key expiry thread
+  m_key_expiry_thread =
+      thread(&Server::keyExpiryThread, this, m_log_context, getNewThreadId());
+
   // Start DB maintenance thread
   m_metrics_thread =
       thread(&Server::metricsThread, this, m_log_context, getNewThreadId());
 
+  // Start latency metrics export thread, only if a file was configured
+  if (!m_config.metrics_file.empty()) {
+    m_metrics_export_thread = thread(&Server::metricsExportThread, this,
+                                     m_log_context, getNewThreadId());
+  }
+
   // Create task mgr (starts it's own threads)
   TaskMgr::getInstance(m_log_context, getNewThreadId());
 }
@@ -111,10 +253,13 @@ Server::~Server() {
   // There is no way to cleanly shutdown the server, so this code really has no
   // effect since the o/s cleans-up for us
 
-  // m_zap_thread.join();
+  m_zap_thread.join();
   m_db_maint_thread.join();
   m_repo_cache_thread.join();
+  m_key_expiry_thread.join();
   m_metrics_thread.join();
+  if (m_metrics_export_thread.joinable())
+    m_metrics_export_thread.join();
 }
 
 void Server::loadKeys(const std::string &a_cred_dir) {
@@ -239,15 +384,38 @@ void Server::msgRouter(LogContext log_context, int thread_count) {
     socket_credentials[SocketRole::SERVER] = server_credentials.get();
   }
 
-  ServerFactory server_factory(log_context);
-  auto proxy = server_factory.create(ServerType::PROXY_BASIC_ZMQ,
-                                     socket_options, socket_credentials);
+  // Each worker has a channel of its own, so the proxy only hands requests to
+  // workers with room for them and fast requests never wait behind slow ones
+  LaneOptions lane_options = clientWorkerLanes(
+      m_config.num_client_worker_threads, m_config.num_client_worker_requests);
 
-  // Ceate worker threads
-  for (uint16_t t = 0; t < m_config.num_client_worker_threads; ++t) {
+  // A worker is numbered after its channel. A stopped worker is left to
+  // finish its requests and only joined when its channel is used again.
+  m_workers.resize(m_config.max_client_worker_threads);
+  auto start_worker = [&](size_t worker) {
+    m_workers[worker].reset();
     LogContext log_context_client = log_context;
     log_context_client.thread_id = getNewThreadId();
-    m_workers.emplace_back(new ClientWorker(*this, t + 1, log_context_client));
+    m_workers[worker] =
+        std::make_shared<ClientWorker>(*this, worker + 1, log_context_client);
+  };
+  if (m_config.max_client_worker_threads >
+      m_config.num_client_worker_threads) {
+    lane_options.scaling.min_workers = m_config.num_client_worker_threads;
+    lane_options.scaling.max_workers = m_config.max_client_worker_threads;
+    lane_options.start_worker = start_worker;
+    lane_options.stop_worker = [&](size_t worker) {
+      m_workers[worker]->stop();
+    };
+  }
+
+  ServerFactory server_factory(log_context);
+  auto proxy = server_factory.create(ServerType::PROXY_LANES, socket_options,
+                                     socket_credentials, lane_options);
+
+  // Ceate worker threads
+  for (size_t t = 0; t < m_config.num_client_worker_threads; ++t) {
+    start_worker(t);
   }
 
   proxy->run();
@@ -256,7 +424,8 @@ void Server::msgRouter(LogContext log_context, int thread_count) {
   vector<std::shared_ptr<ClientWorker>>::iterator iwrk;
 
   for (iwrk = m_workers.begin(); iwrk != m_workers.end(); ++iwrk)
-    (*iwrk)->stop();
+    if (*iwrk)
+      (*iwrk)->stop();
 }
 
 int Server::getNewThreadId() {
@@ -494,6 +663,28 @@ void Server::repoCacheThread(LogContext log_context, int thread_count) {
   DL_ERROR(log_context, "DB maintenance thread exiting");
 }
 
+void Server::keyExpiryThread(LogContext log_context, int thread_count) {
+  // Keys expire with a resolution of one second, only keys that are due are
+  // visited so the purge is cheap when nothing has expired
+  log_context.thread_name += "-keyExpiryThread";
+  log_context.thread_id = thread_count;
+  std::chrono::seconds key_expiry_poll(1);
+
+  while (1) {
+    try {
+      m_auth_manager.purge();
+    } catch (TraceException &e) {
+      DL_ERROR(log_context, "Key expiry: " << e.toString());
+    } catch (const std::exception &e) {
+      DL_ERROR(log_context, "Key expiry: " << e.what());
+    } catch (...) {
+      DL_ERROR(log_context, "Key expiry: unknown exception");
+    }
+    std::this_thread::sleep_for(key_expiry_poll);
+  }
+  DL_ERROR(log_context, "Key expiry thread exiting");
+}
+
 void Server::metricsThread(LogContext log_context, int thread_count) {
   log_context.thread_name += "-metricsThread";
   log_context.thread_id = thread_count;
@@ -502,6 +693,7 @@ void Server::metricsThread(LogContext log_context, int thread_count) {
   DatabaseAPI db(m_config.db_url, m_config.db_user, m_config.db_pass);
   map<string, MsgMetrics_t>::iterator u;
   MsgMetrics_t::iterator m;
+  vector<shared_ptr<MsgCountShard>> shards;
   uint32_t pc,
       purge_count = m_config.metrics_purge_period / m_config.metrics_period;
   uint32_t total, subtot;
@@ -516,11 +708,15 @@ void Server::metricsThread(LogContext log_context, int thread_count) {
 
   while (1) {
     try {
-      // Lock mutex, swap metrics to local store, release lock
+      // Copy the list of shards so workers can register while merging
       {
-        lock_guard<mutex> lock(m_msg_metrics_mutex);
-
-        m_msg_metrics.swap(metrics);
+        lock_guard<mutex> lock(m_msg_count_shards_mutex);
+        shards.clear();
+        for (auto &entry : m_msg_count_shards)
+          shards.push_back(entry.second);
+      }
+      for (shared_ptr<MsgCountShard> &shard : shards) {
+        shard->drainInto(metrics);
       }
 
       timestamp = std::chrono::duration_cast<std::chrono::seconds>(
@@ -559,6 +755,29 @@ void Server::metricsThread(LogContext log_context, int thread_count) {
   DL_ERROR(log_context, "Metrics thread exiting");
 }
 
+void Server::metricsExportThread(LogContext log_context, int thread_count) {
+  log_context.thread_name += "-metricsExportThread";
+  log_context.thread_id = thread_count;
+  chrono::seconds export_per(m_config.metrics_file_period);
+  MetricsRegistry &metrics = MetricsRegistry::getInstance();
+
+  DL_INFO(log_context, "Writing metrics to " << m_config.metrics_file);
+
+  while (1) {
+    try {
+      metrics.writePrometheusFile(m_config.metrics_file);
+    } catch (TraceException &e) {
+      DL_ERROR(log_context, "Metrics export: " << e.toString());
+    } catch (const std::exception &e) {
+      DL_ERROR(log_context, "Metrics export: " << e.what());
+    } catch (...) {
+      DL_ERROR(log_context, "Metrics export: unknown exception");
+    }
+    this_thread::sleep_for(export_per);
+  }
+  DL_ERROR(log_context, "Metrics export thread exiting");
+}
+
 // Triggered by client worker
 void Server::authenticateClient(const std::string &a_cert_uid,
                                 const std::string &a_key,
@@ -572,20 +791,21 @@ void Server::authenticateClient(const std::string &a_cert_uid,
   }
 }
 
-void Server::metricsUpdateMsgCount(const std::string &a_uid,
-                                   uint16_t a_msg_type) {
-  lock_guard<mutex> lock(m_msg_metrics_mutex);
-  map<string, MsgMetrics_t>::iterator u = m_msg_metrics.find(a_uid);
-  if (u == m_msg_metrics.end()) {
-    m_msg_metrics[a_uid][a_msg_type] = 1;
-  } else {
-    MsgMetrics_t::iterator m = u->second.find(a_msg_type);
-    if (m == u->second.end()) {
-      u->second[a_msg_type] = 1;
-    } else {
-      m->second++;
-    }
-  }
+void Server::revokeClientKey(const std::string &a_key) {
+  m_auth_manager.invalidateKey(a_key);
+  m_auth_manager.revokeConnections(a_key);
+}
+
+void Server::invalidateClientKey(const std::string &a_key) {
+  m_auth_manager.invalidateKey(a_key);
+}
+
+std::shared_ptr<MsgCountShard> Server::getMsgCountShard(size_t a_tid) {
+  lock_guard<mutex> lock(m_msg_count_shards_mutex);
+  std::shared_ptr<MsgCountShard> &shard = m_msg_count_shards[a_tid];
+  if (!shard)
+    shard = std::make_shared<MsgCountShard>();
+  return shard;
 }
 
 } // namespace Core
@@ -9,6 +9,7 @@
 
 // Public common includes
 #include "common/DynaLog.hpp"
+#include "common/ZapHandler.hpp"
 
 // Standard includes
 #include <condition_variable>
@@ -20,6 +21,7 @@
 #include <sys/types.h>
 #include <thread>
 #include <unistd.h>
+#include <vector>
 
 namespace SDMS {
 namespace Core {
@@ -69,9 +71,6 @@ private:
   /// Used to manage purging and public auth keys
   AuthenticationManager m_auth_manager;
 
-  /// Message request metrics - maps message type to count per metrics period
-  typedef std::map<uint16_t, uint32_t> MsgMetrics_t;
-
   void waitForDB();
 
   /**
@@ -81,7 +80,9 @@ private:
   void authenticateClient(const std::string &a_cert_uid,
                           const std::string &a_key, const std::string &a_uid,
                           LogContext log_context);
-  void metricsUpdateMsgCount(const std::string &a_uid, uint16_t a_msg_type);
+  void revokeClientKey(const std::string &a_key);
+  void invalidateClientKey(const std::string &a_key);
+  std::shared_ptr<MsgCountShard> getMsgCountShard(size_t a_tid);
   // bool isClientAuthenticated( const std::string & a_client_key, std::string &
   // a_uid );
   void loadKeys(const std::string &a_cred_dir);
@@ -91,7 +92,9 @@ private:
   void ioInsecure(LogContext log_context, int thread_count);
   void dbMaintenance(LogContext log_context, int thread_count);
   void metricsThread(LogContext log_context, int thread_count);
+  void metricsExportThread(LogContext log_context, int thread_count);
   void repoCacheThread(LogContext log_context, int thread_count);
+  void keyExpiryThread(LogContext log_context, int thread_count);
   int getNewThreadId();
 
   Config &m_config;                 ///< Ref to configuration singleton
@@ -105,13 +108,19 @@ private:
   std::thread m_db_maint_thread;   ///< DB maintenance thread handle
   std::thread m_metrics_thread;    ///< Metrics gathering thread handle
   std::thread m_repo_cache_thread; ///< Thread for updating the repo cache
-  std::map<std::string, MsgMetrics_t>
-      m_msg_metrics;              ///< Map of UID to message request metrics
-  std::mutex m_msg_metrics_mutex; ///< Mutex for metrics updates
+  std::thread m_key_expiry_thread; ///< Thread purging expired client keys
+  /// Thread writing the latency metrics file, if one is configured
+  std::thread m_metrics_export_thread;
+  /// Message counts of the client workers keyed by worker channel
+  std::map<size_t, std::shared_ptr<MsgCountShard>> m_msg_count_shards;
+  std::mutex m_msg_count_shards_mutex; ///< Mutex for the list of shards
   LogContext m_log_context;
   std::mutex m_thread_count_mutex; ///< Mutex for metrics updates
   int m_thread_count = 0; // Keep track of the number of threads created
   int m_main_thread_id = 0;
+
+  std::unique_ptr<ZapHandler> m_zap_handler; ///< Resolves CURVE client keys
+  std::thread m_zap_thread;                  ///< ZAP handler thread handle
 };
 
 } // namespace Core
@@ -1,9 +1,12 @@
 
 // Local private includes
 #include "DatabaseAPI.hpp"
+#include "DatabaseConnectionPool.hpp"
+#include "MetricsRegistry.hpp"
 
 // Local public includes
 #include "common/DynaLog.hpp"
+#include "common/JsonWriter.hpp"
 #include "common/TraceException.hpp"
 #include "common/Util.hpp"
 
@@ -15,9 +18,13 @@
 
 // Standard includes
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cctype>
+#include <chrono>
 #include <memory>
 #include <unistd.h>
+#include <unordered_map>
 
 using namespace std;
 
@@ -27,6 +34,121 @@ namespace Core {
 using namespace SDMS::Auth;
 using namespace libjson;
 
+namespace {
+
+/// The metrics of one Foxx route
+struct RouteMetrics {
+  Histogram &duration;
+  std::atomic<uint64_t> &errors;
+};
+
+/**
+ * Returns the metrics of a route, looked up in the registry only the first
+ * time the thread sees it. Routes are string literals, so the table is keyed
+ * by their address, and is per thread so that it needs no lock.
+ */
+RouteMetrics &routeMetrics(const char *a_url_path) {
+  thread_local std::unordered_map<const char *, RouteMetrics> routes;
+  auto route = routes.find(a_url_path);
+  if (route == routes.end()) {
+    MetricsRegistry &metrics = MetricsRegistry::getInstance();
+    route = routes
+                .emplace(a_url_path,
+                         RouteMetrics{
+                             metrics.histogram(metrics::DB_DURATION,
+                                               a_url_path),
+                             metrics.counter(metrics::DB_ERRORS, a_url_path)})
+                .first;
+  }
+  return route->second;
+}
+
+/// Records the duration of a request to a Foxx route and whether it failed
+void recordRequest(const char *a_url_path,
+                   std::chrono::steady_clock::time_point a_start, CURL *a_curl,
+                   CURLcode a_res) {
+  RouteMetrics &route = routeMetrics(a_url_path);
+  route.duration.record(std::chrono::duration_cast<std::chrono::microseconds>(
+                            std::chrono::steady_clock::now() - a_start)
+                            .count());
+  long http_code = 0;
+  curl_easy_getinfo(a_curl, CURLINFO_RESPONSE_CODE, &http_code);
+  if (a_res != CURLE_OK || http_code < 200 || http_code >= 300) {
+    route.errors.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+/// Reads the start of an object from a streamed reply
+void readObjectBegin(Reader &a_reader) {
+  if (a_reader.next() != Reader::EV_OBJECT_BEGIN)
+    EXCEPT_PARAM(1, "Expected an object, not " << a_reader.eventName());
+}
+
+/// Reads the start of an array from a streamed reply
+void readArrayBegin(Reader &a_reader) {
+  if (a_reader.next() != Reader::EV_ARRAY_BEGIN)
+    EXCEPT_PARAM(1, "Expected an array, not " << a_reader.eventName());
+}
+
+/// Reads the start of the next object of an array, false at its end
+bool readArrayObject(Reader &a_reader) {
+  Reader::Event event = a_reader.next();
+  if (event == Reader::EV_ARRAY_END)
+    return false;
+  if (event != Reader::EV_OBJECT_BEGIN)
+    EXCEPT_PARAM(1, "Expected an object, not " << a_reader.eventName());
+  return true;
+}
+
+/// Reads the next string of an array, false at its end
+bool readArrayString(Reader &a_reader) {
+  Reader::Event event = a_reader.next();
+  if (event == Reader::EV_ARRAY_END)
+    return false;
+  if (event != Reader::EV_STRING)
+    EXCEPT_PARAM(1, "Expected a string, not " << a_reader.eventName());
+  return true;
+}
+
+/// Fails a streamed translation if an object lacked a required key
+void requireKey(bool a_found, const char *a_key) {
+  if (!a_found)
+    EXCEPT_PARAM(1, "Key not found: " << a_key);
+}
+
+/// Reads the dependency object begun by the last event of a streamed reply
+void readDependency(DependencyData *a_dep, Reader &a_reader, bool a_notes) {
+  bool id = false, type = false, dir = false;
+
+  while (a_reader.next() == Reader::EV_KEY) {
+    const string_view key = a_reader.text();
+
+    if (key == "id") {
+      a_dep->set_id(string(a_reader.readString()));
+      id = true;
+    } else if (key == "type") {
+      a_dep->set_type((DependencyType)(unsigned short)a_reader.readNumber());
+      type = true;
+    } else if (key == "dir") {
+      a_dep->set_dir((DependencyDir)(unsigned short)a_reader.readNumber());
+      dir = true;
+    } else if (key == "alias") {
+      if (!a_reader.readNull())
+        a_dep->set_alias(string(a_reader.readString()));
+    } else if (key == "notes" && a_notes) {
+      a_dep->set_notes(a_reader.readNumber());
+    } else {
+      a_reader.skip();
+    }
+  }
+
+  requireKey(id, "id");
+  requireKey(type, "type");
+  requireKey(dir, "dir");
+}
+
+} // namespace
+
 #define TRANSLATE_BEGIN() try {
 #define TRANSLATE_END(json, log_context)                                       \
   }                                                                            \
@@ -36,29 +158,50 @@ using namespace libjson;
     throw;                                                                     \
   }
 
+// Ends the translation of a reply read as text with a libjson::Reader
+#define TRANSLATE_TEXT_END(res_json, log_context)                              \
+  }                                                                            \
+  catch (libjson::ParseError & e) {                                            \
+    DL_DEBUG(log_context, "PARSE [" << res_json << "]");                       \
+    EXCEPT_PARAM(ID_SERVICE_ERROR,                                             \
+                 "Invalid JSON returned from DB: " << e.toString());           \
+  }                                                                            \
+  catch (TraceException & e) {                                                 \
+    DL_ERROR(log_context, "INVALID JSON FROM DB: " << res_json);               \
+    EXCEPT_CONTEXT(e, "Invalid response from DB");                             \
+    throw;                                                                     \
+  }
+
 DatabaseAPI::DatabaseAPI(const std::string &a_db_url,
                          const std::string &a_db_user,
                          const std::string &a_db_pass)
-    : m_client(0), m_db_url(a_db_url) {
-  m_curl = curl_easy_init();
-  if (!m_curl)
-    EXCEPT(ID_INTERNAL_ERROR, "libcurl init failed");
+    : m_client(0), m_db_url(a_db_url), m_db_user(a_db_user),
+      m_db_pass(a_db_pass) {
+  m_curl = DatabaseConnectionPool::getInstance().acquire();
 
   setClient("");
-
-  curl_easy_setopt(m_curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_1_1);
-  curl_easy_setopt(m_curl, CURLOPT_USERNAME, a_db_user.c_str());
-  curl_easy_setopt(m_curl, CURLOPT_PASSWORD, a_db_pass.c_str());
-  curl_easy_setopt(m_curl, CURLOPT_WRITEFUNCTION, curlResponseWriteCB);
-  curl_easy_setopt(m_curl, CURLOPT_SSL_VERIFYPEER, 0);
-  curl_easy_setopt(m_curl, CURLOPT_TCP_NODELAY, 1);
+  initHandle(m_curl);
 }
 
 DatabaseAPI::~DatabaseAPI() {
   if (m_client)
     curl_free(m_client);
 
-  curl_easy_cleanup(m_curl);
+  DatabaseConnectionPool::getInstance().release(m_curl);
+}
+
+/**
+ * Applies the DB connection options to a pooled curl handle. Pooled handles
+ * may have been used by another DatabaseAPI instance, so credentials are always
+ * (re)applied.
+ */
+void DatabaseAPI::initHandle(CURL *a_curl) {
+  curl_easy_setopt(a_curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_1_1);
+  curl_easy_setopt(a_curl, CURLOPT_USERNAME, m_db_user.c_str());
+  curl_easy_setopt(a_curl, CURLOPT_PASSWORD, m_db_pass.c_str());
+  curl_easy_setopt(a_curl, CURLOPT_WRITEFUNCTION, curlResponseWriteCB);
+  curl_easy_setopt(a_curl, CURLOPT_SSL_VERIFYPEER, 0);
+  curl_easy_setopt(a_curl, CURLOPT_TCP_NODELAY, 1);
 }
 
 void DatabaseAPI::setClient(const std::string &a_client) {
@@ -89,43 +232,49 @@ long DatabaseAPI::dbGet(const char *a_url_path,
 
   error[0] = 0;
 
-  url.reserve(512);
+  buildURL(a_url_path, a_params, url);
 
-  // TODO Get URL base from ctor
-  url.append(m_db_url);
-  url.append(a_url_path);
-  url.append("?client=");
-  url.append(m_client);
-
-  char *esc_txt;
-
-  for (vector<pair<string, string>>::const_iterator iparam = a_params.begin();
-       iparam != a_params.end(); ++iparam) {
-    url.append("&");
-    url.append(iparam->first.c_str());
-    url.append("=");
-    esc_txt = curl_easy_escape(m_curl, iparam->second.c_str(), 0);
-    url.append(esc_txt);
-    curl_free(esc_txt);
+  DL_DEBUG(log_context, "get url: " << url);
+  if (deferring()) {
+    DeferredCall *call = deferredCall(a_url_path, url, nullptr, false);
+    if (call == nullptr)
+      throw CallDeferred();
+    return checkResponse(call->res, call->http_code, call->response,
+                         call->error.data(), a_result, log_context);
   }
 
-  DL_DEBUG(log_context, "get url: " << url);
   curl_easy_setopt(m_curl, CURLOPT_URL, url.c_str());
   curl_easy_setopt(m_curl, CURLOPT_WRITEDATA, &res_json);
   curl_easy_setopt(m_curl, CURLOPT_ERRORBUFFER, error);
   curl_easy_setopt(m_curl, CURLOPT_HTTPGET, 1);
 
+  const auto start = std::chrono::steady_clock::now();
   CURLcode res = curl_easy_perform(m_curl);
+  recordRequest(a_url_path, start, m_curl, res);
 
+  return checkResponse(m_curl, res, res_json, error, a_result, log_context);
+}
+
+long DatabaseAPI::checkResponse(CURL *a_curl, CURLcode a_res,
+                                const string &a_res_json, const char *a_error,
+                                Value &a_result, LogContext log_context) {
   long http_code = 0;
-  curl_easy_getinfo(m_curl, CURLINFO_RESPONSE_CODE, &http_code);
+  curl_easy_getinfo(a_curl, CURLINFO_RESPONSE_CODE, &http_code);
 
-  if (res == CURLE_OK) {
-    if (res_json.size()) {
+  return checkResponse(a_res, http_code, a_res_json, a_error, a_result,
+                       log_context);
+}
+
+long DatabaseAPI::checkResponse(CURLcode a_res, long http_code,
+                                const string &a_res_json, const char *a_error,
+                                Value &a_result, LogContext log_context) {
+  if (a_res == CURLE_OK) {
+    if (a_res_json.size()) {
       try {
-        a_result.fromString(res_json);
+        // Replies are read and dropped, parse them into an arena
+        a_result.fromString(a_res_json, true);
       } catch (libjson::ParseError &e) {
-        DL_DEBUG(log_context, "PARSE [" << res_json << "]");
+        DL_DEBUG(log_context, "PARSE [" << a_res_json << "]");
         EXCEPT_PARAM(ID_SERVICE_ERROR,
                      "Invalid JSON returned from DB: " << e.toString());
       }
@@ -134,64 +283,234 @@ long DatabaseAPI::dbGet(const char *a_url_path,
     if (http_code >= 200 && http_code < 300) {
       return http_code;
     } else {
-      if (res_json.size() && a_result.asObject().has("errorMessage")) {
+      if (a_res_json.size() && a_result.asObject().has("errorMessage")) {
         EXCEPT_PARAM(ID_BAD_REQUEST, a_result.asObject().asString());
       } else {
         EXCEPT_PARAM(ID_BAD_REQUEST, "SDMS DB service call failed. Code: "
-                                         << http_code << ", err: " << error);
+                                         << http_code << ", err: " << a_error);
       }
     }
   } else {
     EXCEPT_PARAM(ID_SERVICE_ERROR, "SDMS DB interface failed. error: "
-                                       << error << ", "
-                                       << curl_easy_strerror(res));
+                                       << a_error << ", "
+                                       << curl_easy_strerror(a_res));
   }
 }
 
-bool DatabaseAPI::dbGetRaw(const char *a_url_path,
-                           const vector<pair<string, string>> &a_params,
-                           string &a_result) {
-  a_result.clear();
+/**
+ * Whether the next DB call is deferred. Calls replayed from the deferral are,
+ * new calls only until the code has waited once, see Deferral.
+ */
+bool DatabaseAPI::deferring() const {
+  return m_deferral && (!m_deferral->waited ||
+                        m_deferral->next < m_deferral->calls.size());
+}
 
-  string url;
-  char error[CURL_ERROR_SIZE];
+/**
+ * Returns the deferred call at the current position of the deferral if its
+ * response is known, or nullptr if the caller has to wait for it. A call made
+ * for the first time is recorded so the owner of the deferral can start it.
+ */
+DatabaseAPI::DeferredCall *DatabaseAPI::deferredCall(const char *a_url_path,
+                                                     const string &a_url,
+                                                     const string *a_body,
+                                                     bool a_post) {
+  vector<unique_ptr<DeferredCall>> &calls = m_deferral->calls;
+  if (m_deferral->next == calls.size()) {
+    auto call = std::make_unique<DeferredCall>();
+    call->url_path = a_url_path;
+    call->url = a_url;
+    call->post = a_post;
+    if (a_body)
+      call->body = *a_body;
+    calls.push_back(std::move(call));
+  }
 
-  a_result.clear();
-  error[0] = 0;
+  DeferredCall &call = *calls[m_deferral->next++];
+  if (call.url != a_url || call.post != a_post ||
+      call.body != (a_body ? *a_body : string()))
+    EXCEPT_PARAM(ID_INTERNAL_ERROR,
+                 "Deferred DB call replayed out of order: " << a_url);
+
+  return call.state == DeferredCall::State::COMPLETE ? &call : nullptr;
+}
+
+CURL *DatabaseAPI::startDeferred(DeferredCall &a_call) {
+  CURL *curl = DatabaseConnectionPool::getInstance().acquire();
+  initHandle(curl);
+
+  a_call.response.clear();
+  a_call.error[0] = 0;
+  curl_easy_setopt(curl, CURLOPT_URL, a_call.url.c_str());
+  curl_easy_setopt(curl, CURLOPT_WRITEDATA, &a_call.response);
+  curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, a_call.error.data());
+  if (a_call.post) {
+    curl_easy_setopt(curl, CURLOPT_POST, 1);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, a_call.body.c_str());
+  } else {
+    curl_easy_setopt(curl, CURLOPT_HTTPGET, 1);
+  }
+
+  a_call.state = DeferredCall::State::RUNNING;
+  a_call.start = std::chrono::steady_clock::now();
+  return curl;
+}
+
+void DatabaseAPI::finishDeferred(CURL *a_curl, DeferredCall &a_call,
+                                 CURLcode a_res) {
+  recordRequest(a_call.url_path, a_call.start, a_curl, a_res);
+  a_call.res = a_res;
+  curl_easy_getinfo(a_curl, CURLINFO_RESPONSE_CODE, &a_call.http_code);
+  a_call.state = DeferredCall::State::COMPLETE;
+  DatabaseConnectionPool::getInstance().release(a_curl);
+}
+
+/**
+ * Issues a set of independent GET requests to the DB concurrently. The first
+ * request reuses this instance's handle, the others borrow handles from the
+ * process-wide pool. Responses are checked in request order, so the first
+ * failing request determines the exception that is thrown.
+ */
+void DatabaseAPI::dbGetConcurrent(vector<DbGetRequest> &a_requests,
+                                  LogContext log_context) {
+  size_t count = a_requests.size();
+
+  if (deferring()) {
+    // Every request is recorded before waiting so they still run together
+    vector<DeferredCall *> calls(count, nullptr);
+    bool pending = false;
+    string url;
+    for (size_t i = 0; i < count; i++) {
+      DbGetRequest &req = a_requests[i];
+      req.result->clear();
+      buildURL(req.url_path, req.params, url);
+      DL_DEBUG(log_context, "get url: " << url);
+      calls[i] = deferredCall(req.url_path, url, nullptr, false);
+      pending = pending || calls[i] == nullptr;
+    }
+    if (pending)
+      throw CallDeferred();
+
+    for (size_t i = 0; i < count; i++)
+      checkResponse(calls[i]->res, calls[i]->http_code, calls[i]->response,
+                    calls[i]->error.data(), *a_requests[i].result,
+                    log_context);
+    return;
+  }
+
+  DatabaseConnectionPool &pool = DatabaseConnectionPool::getInstance();
+  vector<CURL *> handles(count, nullptr);
+  vector<string> urls(count);
+  vector<string> responses(count);
+  vector<array<char, CURL_ERROR_SIZE>> errors(count);
+  vector<CURLcode> results;
+
+  // Pooled handles are reset on release, this instance's handle must not keep
+  // pointing at the buffers above once they are gone
+  auto release = [&]() {
+    curl_easy_setopt(m_curl, CURLOPT_WRITEDATA, nullptr);
+    curl_easy_setopt(m_curl, CURLOPT_ERRORBUFFER, nullptr);
+    for (size_t i = 1; i < count; i++)
+      pool.release(handles[i]);
+  };
+
+  try {
+    for (size_t i = 0; i < count; i++) {
+      if (i == 0) {
+        handles[i] = m_curl;
+      } else {
+        handles[i] = pool.acquire();
+        initHandle(handles[i]);
+      }
+
+      DbGetRequest &req = a_requests[i];
+
+      req.result->clear();
+      errors[i][0] = 0;
+      buildURL(req.url_path, req.params, urls[i]);
+
+      DL_DEBUG(log_context, "get url: " << urls[i]);
+      curl_easy_setopt(handles[i], CURLOPT_URL, urls[i].c_str());
+      curl_easy_setopt(handles[i], CURLOPT_WRITEDATA, &responses[i]);
+      curl_easy_setopt(handles[i], CURLOPT_ERRORBUFFER, errors[i].data());
+      curl_easy_setopt(handles[i], CURLOPT_HTTPGET, 1);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    pool.performConcurrent(handles, results);
+    // The requests run together, each is charged the time of the batch
+    for (size_t i = 0; i < count; i++)
+      recordRequest(a_requests[i].url_path, start, handles[i], results[i]);
+
+    for (size_t i = 0; i < count; i++)
+      checkResponse(handles[i], results[i], responses[i], errors[i].data(),
+                    *a_requests[i].result, log_context);
+  } catch (...) {
+    release();
+    throw;
+  }
 
-  url.reserve(512);
+  release();
+}
+
+void DatabaseAPI::buildURL(const char *a_url_path,
+                           const vector<pair<string, string>> &a_params,
+                           string &a_url) const {
+  a_url.clear();
+  a_url.reserve(512);
 
-  // TODO Get URL base from ctor
-  url.append(m_db_url);
-  url.append(a_url_path);
-  url.append("?client=");
-  url.append(m_client);
+  a_url.append(m_db_url);
+  a_url.append(a_url_path);
+  a_url.append("?client=");
+  a_url.append(m_client);
 
   char *esc_txt;
 
   for (vector<pair<string, string>>::const_iterator iparam = a_params.begin();
        iparam != a_params.end(); ++iparam) {
-    url.append("&");
-    url.append(iparam->first.c_str());
-    url.append("=");
+    a_url.append("&");
+    a_url.append(iparam->first.c_str());
+    a_url.append("=");
     esc_txt = curl_easy_escape(m_curl, iparam->second.c_str(), 0);
-    url.append(esc_txt);
+    a_url.append(esc_txt);
     curl_free(esc_txt);
   }
+}
+
+long DatabaseAPI::dbGetRaw(const char *a_url_path,
+                           const vector<pair<string, string>> &a_params,
+                           string &a_result) {
+  a_result.clear();
+
+  string url;
+  char error[CURL_ERROR_SIZE];
+
+  a_result.clear();
+  error[0] = 0;
+
+  buildURL(a_url_path, a_params, url);
+
+  if (deferring()) {
+    DeferredCall *call = deferredCall(a_url_path, url, nullptr, false);
+    if (call == nullptr)
+      throw CallDeferred();
+    a_result = call->response;
+    return call->res == CURLE_OK ? call->http_code : 0;
+  }
 
   curl_easy_setopt(m_curl, CURLOPT_URL, url.c_str());
   curl_easy_setopt(m_curl, CURLOPT_WRITEDATA, &a_result);
   curl_easy_setopt(m_curl, CURLOPT_ERRORBUFFER, error);
   curl_easy_setopt(m_curl, CURLOPT_HTTPGET, 1);
 
+  const auto start = std::chrono::steady_clock::now();
   CURLcode res = curl_easy_perform(m_curl);
+  recordRequest(a_url_path, start, m_curl, res);
 
   long http_code = 0;
-  curl_easy_getinfo(m_curl, CURLINFO_RESPONSE_CODE, &http_code);
-  if (res == CURLE_OK && (http_code >= 200 && http_code < 300))
-    return true;
-  else
-    return false;
+  if (res == CURLE_OK)
+    curl_easy_getinfo(m_curl, CURLINFO_RESPONSE_CODE, &http_code);
+  return http_code;
 }
 
 long DatabaseAPI::dbPost(const char *a_url_path,
@@ -208,24 +527,14 @@ long DatabaseAPI::dbPost(const char *a_url_path,
 
   error[0] = 0;
 
-  url.reserve(512);
-
-  // TODO Get URL base from ctor
-  url.append(m_db_url);
-  url.append(a_url_path);
-  url.append("?client=");
-  url.append(m_client);
-
-  char *esc_txt;
+  buildURL(a_url_path, a_params, url);
 
-  for (vector<pair<string, string>>::const_iterator iparam = a_params.begin();
-       iparam != a_params.end(); ++iparam) {
-    url.append("&");
-    url.append(iparam->first.c_str());
-    url.append("=");
-    esc_txt = curl_easy_escape(m_curl, iparam->second.c_str(), 0);
-    url.append(esc_txt);
-    curl_free(esc_txt);
+  if (deferring()) {
+    DeferredCall *call = deferredCall(a_url_path, url, a_body, true);
+    if (call == nullptr)
+      throw CallDeferred();
+    return checkResponse(call->res, call->http_code, call->response,
+                         call->error.data(), a_result, log_context);
   }
 
   curl_easy_setopt(m_curl, CURLOPT_URL, url.c_str());
@@ -238,7 +547,9 @@ long DatabaseAPI::dbPost(const char *a_url_path,
   curl_easy_setopt(m_curl, CURLOPT_POSTFIELDS,
                    a_body ? a_body->c_str() : empty_body);
 
+  const auto start = std::chrono::steady_clock::now();
   CURLcode res = curl_easy_perform(m_curl);
+  recordRequest(a_url_path, start, m_curl, res);
 
   long http_code = 0;
   curl_easy_getinfo(m_curl, CURLINFO_RESPONSE_CODE, &http_code);
@@ -246,7 +557,7 @@ long DatabaseAPI::dbPost(const char *a_url_path,
   if (res == CURLE_OK) {
     if (res_json.size()) {
       try {
-        a_result.fromString(res_json);
+        a_result.fromString(res_json, true);
       } catch (libjson::ParseError &e) {
         DL_DEBUG(log_context, "PARSE [" << res_json << "]");
         EXCEPT_PARAM(ID_SERVICE_ERROR,
@@ -275,6 +586,96 @@ long DatabaseAPI::dbPost(const char *a_url_path,
   }
 }
 
+long DatabaseAPI::dbText(const char *a_url_path,
+                         const vector<pair<string, string>> &a_params,
+                         const string *a_body, string &a_res_json,
+                         LogContext log_context) {
+  string url;
+  char error[CURL_ERROR_SIZE];
+  const char *error_text = error;
+  CURLcode res;
+  long http_code = 0;
+
+  a_res_json.clear();
+  error[0] = 0;
+
+  buildURL(a_url_path, a_params, url);
+
+  DL_DEBUG(log_context, (a_body ? "post url: " : "get url: ") << url);
+  if (deferring()) {
+    DeferredCall *call =
+        deferredCall(a_url_path, url, a_body, a_body != nullptr);
+    if (call == nullptr)
+      throw CallDeferred();
+    a_res_json = call->response;
+    res = call->res;
+    http_code = call->http_code;
+    error_text = call->error.data();
+  } else {
+    curl_easy_setopt(m_curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(m_curl, CURLOPT_WRITEDATA, &a_res_json);
+    curl_easy_setopt(m_curl, CURLOPT_ERRORBUFFER, error);
+    if (a_body) {
+      curl_easy_setopt(m_curl, CURLOPT_POST, 1);
+      curl_easy_setopt(m_curl, CURLOPT_POSTFIELDS, a_body->c_str());
+    } else {
+      curl_easy_setopt(m_curl, CURLOPT_HTTPGET, 1);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    res = curl_easy_perform(m_curl);
+    recordRequest(a_url_path, start, m_curl, res);
+    curl_easy_getinfo(m_curl, CURLINFO_RESPONSE_CODE, &http_code);
+  }
+
+  if (res == CURLE_OK && http_code >= 200 && http_code < 300)
+    return http_code;
+
+  // Failed replies are small, report them as any other call would
+  Value result;
+  return checkResponse(res, http_code, a_res_json, error_text, result,
+                       log_context);
+}
+
+void DatabaseAPI::dbListing(const char *a_url_path,
+                            const vector<pair<string, string>> &a_params,
+                            const string *a_body, Auth::ListingReply &a_reply,
+                            LogContext log_context) {
+  if (m_stream_replies) {
+    string res_json;
+    dbText(a_url_path, a_params, a_body, res_json, log_context);
+    setListingDataReply(a_reply, res_json, log_context);
+    return;
+  }
+
+  Value result;
+  if (a_body)
+    dbPost(a_url_path, a_params, a_body, result, log_context);
+  else
+    dbGet(a_url_path, a_params, result, log_context);
+  setListingDataReply(a_reply, result, log_context);
+}
+
+void DatabaseAPI::dbRecord(const char *a_url_path,
+                           const vector<pair<string, string>> &a_params,
+                           const string *a_body,
+                           Auth::RecordDataReply &a_reply,
+                           LogContext log_context) {
+  if (m_stream_replies) {
+    string res_json;
+    dbText(a_url_path, a_params, a_body, res_json, log_context);
+    setRecordData(a_reply, res_json, log_context);
+    return;
+  }
+
+  Value result;
+  if (a_body)
+    dbPost(a_url_path, a_params, a_body, result, log_context);
+  else
+    dbGet(a_url_path, a_params, result, log_context);
+  setRecordData(a_reply, result, log_context);
+}
+
 void DatabaseAPI::serverPing(LogContext log_context) {
   Value result;
 
@@ -315,8 +716,18 @@ void DatabaseAPI::clientLinkIdentity(const std::string &a_identity,
 
 bool DatabaseAPI::uidByPubKey(const std::string &a_pub_key,
                               std::string &a_uid) {
-  bool found = dbGetRaw("usr/find/by_pub_key", {{"pub_key", a_pub_key}}, a_uid);
-  return found;
+  const long http_code =
+      dbGetRaw("usr/find/by_pub_key", {{"pub_key", a_pub_key}}, a_uid);
+  if (http_code >= 200 && http_code < 300)
+    return true;
+
+  // The DB refuses a key it does not know, anything else is a failure
+  if (http_code == 400 || http_code == 404) {
+    a_uid.clear();
+    return false;
+  }
+  EXCEPT_PARAM(ID_SERVICE_ERROR,
+               "Public key lookup failed. Code: " << http_code);
 }
 
 bool DatabaseAPI::userGetKeys(std::string &a_pub_key, std::string &a_priv_key,
@@ -668,25 +1079,21 @@ void DatabaseAPI::projCreate(const Auth::ProjectCreateRequest &a_request,
     params.push_back({"desc", a_request.desc()});
 
   if (a_request.admin_size() > 0) {
-    string members = "[";
-    for (int i = 0; i < a_request.admin_size(); ++i) {
-      if (i > 0)
-        members += ",";
-      members += "\"" + a_request.admin(i) + "\"";
-    }
-    members += "]";
-    params.push_back({"admins", members});
+    Writer admins;
+    admins.beginArray();
+    for (int i = 0; i < a_request.admin_size(); ++i)
+      admins.string(a_request.admin(i));
+    admins.endArray();
+    params.push_back({"admins", admins.str()});
   }
 
   if (a_request.member_size() > 0) {
-    string members = "[";
-    for (int i = 0; i < a_request.member_size(); ++i) {
-      if (i > 0)
-        members += ",";
-      members += "\"" + a_request.member(i) + "\"";
-    }
-    members += "]";
-    params.push_back({"members", members});
+    Writer members;
+    members.beginArray();
+    for (int i = 0; i < a_request.member_size(); ++i)
+      members.string(a_request.member(i));
+    members.endArray();
+    params.push_back({"members", members.str()});
   }
 
   dbGet("prj/create", params, result, log_context);
@@ -747,7 +1154,6 @@ void DatabaseAPI::projView(const Auth::ProjectViewRequest &a_request,
 void DatabaseAPI::projList(const Auth::ProjectListRequest &a_request,
                            Auth::ListingReply &a_reply,
                            LogContext log_context) {
-  Value result;
   vector<pair<string, string>> params;
   if (a_request.has_subject())
     params.push_back({"subject", a_request.subject()});
@@ -766,9 +1172,7 @@ void DatabaseAPI::projList(const Auth::ProjectListRequest &a_request,
   if (a_request.has_count())
     params.push_back({"count", to_string(a_request.count())});
 
-  dbGet("prj/list", params, result, log_context);
-
-  setListingDataReply(a_reply, result, log_context);
+  dbListing("prj/list", params, nullptr, a_reply, log_context);
 }
 
 void DatabaseAPI::projGetRole(const Auth::ProjectGetRoleRequest &a_request,
@@ -853,7 +1257,6 @@ void DatabaseAPI::setProjectData(Auth::ProjectDataReply &a_reply,
 void DatabaseAPI::recordListByAlloc(
     const Auth::RecordListByAllocRequest &a_request,
     Auth::ListingReply &a_reply, LogContext log_context) {
-  Value result;
   vector<pair<string, string>> params;
   params.push_back({"repo", a_request.repo()});
   params.push_back({"subject", a_request.subject()});
@@ -862,17 +1265,26 @@ void DatabaseAPI::recordListByAlloc(
   if (a_request.has_count())
     params.push_back({"count", to_string(a_request.count())});
 
-  dbGet("/dat/list/by_alloc", params, result, log_context);
-
-  setListingDataReply(a_reply, result, log_context);
+  dbListing("/dat/list/by_alloc", params, nullptr, a_reply, log_context);
 }
 
 void DatabaseAPI::recordView(const Auth::RecordViewRequest &a_request,
                              Auth::RecordDataReply &a_reply,
                              LogContext log_context) {
+  dbRecord("dat/view", {{"id", a_request.id()}}, nullptr, a_reply, log_context);
+}
+
+void DatabaseAPI::recordViewWithSchema(const Auth::RecordViewRequest &a_request,
+                                       Auth::RecordDataReply &a_reply,
+                                       const std::string &a_sch_id,
+                                       libjson::Value &a_schema,
+                                       LogContext log_context) {
   Value result;
+  vector<DbGetRequest> requests = {
+      {"dat/view", {{"id", a_request.id()}}, &result},
+      {"schema/view", {{"id", a_sch_id}}, &a_schema}};
 
-  dbGet("dat/view", {{"id", a_request.id()}}, result, log_context);
+  dbGetConcurrent(requests, log_context);
 
   setRecordData(a_reply, result, log_context);
 }
@@ -880,147 +1292,121 @@ void DatabaseAPI::recordView(const Auth::RecordViewRequest &a_request,
 void DatabaseAPI::recordCreate(const Auth::RecordCreateRequest &a_request,
                                Auth::RecordDataReply &a_reply,
                                LogContext log_context) {
-  Value result;
-
-  string body;
-
-  if (a_request.has_metadata())
-    body.reserve(a_request.metadata().size() + 4 * 1024);
-  else
-    body.reserve(4 * 1024);
+  Writer body;
 
-  body.append("{\"title\":\"");
-  body.append(escapeJSON(a_request.title()));
-  body.append("\"");
+  body.beginObject().key("title").string(a_request.title());
 
   if (a_request.has_desc())
-    body += ",\"desc\":\"" + escapeJSON(a_request.desc()) + "\"";
+    body.key("desc").string(a_request.desc());
   if (a_request.has_alias())
-    body += ",\"alias\":\"" + a_request.alias() + "\"";
+    body.key("alias").string(a_request.alias());
 
   if (a_request.tags_size()) {
-    body += ",\"tags\":[";
-    for (int i = 0; i < a_request.tags_size(); i++) {
-      if (i)
-        body += ",";
-      body += "\"" + a_request.tags(i) + "\"";
-    }
-    body += "]";
+    body.key("tags").beginArray();
+    for (int i = 0; i < a_request.tags_size(); i++)
+      body.string(a_request.tags(i));
+    body.endArray();
   }
 
   if (a_request.has_metadata())
-    body += ",\"md\":" + a_request.metadata();
+    body.key("md").raw(a_request.metadata());
   if (a_request.has_sch_id())
-    body += string(",\"sch_id\":\"") + a_request.sch_id() + "\"";
+    body.key("sch_id").string(a_request.sch_id());
   if (a_request.has_parent_id())
-    body += ",\"parent\":\"" + a_request.parent_id() + "\"";
+    body.key("parent").string(a_request.parent_id());
   if (a_request.has_external()) {
-    body.append(",\"external\":\"");
-    body.append(a_request.external() ? "true" : "false");
-    body.append("\"");
+    body.key("external").string(a_request.external() ? "true" : "false");
   } else {
     if (a_request.has_ext())
-      body += ",\"ext\":\"" + a_request.ext() + "\"";
+      body.key("ext").string(a_request.ext());
     if (a_request.has_ext_auto())
-      body +=
-          string(",\"ext_auto\":") + (a_request.ext_auto() ? "true" : "false");
+      body.key("ext_auto").boolean(a_request.ext_auto());
   }
   if (a_request.has_source())
-    body += ",\"source\":\"" + a_request.source() + "\"";
+    body.key("source").string(a_request.source());
   if (a_request.has_repo_id())
-    body += ",\"repo\":\"" + a_request.repo_id() + "\"";
+    body.key("repo").string(a_request.repo_id());
   if (a_request.deps_size()) {
-    body += ",\"deps\":[";
-
+    body.key("deps").beginArray();
     for (int i = 0; i < a_request.deps_size(); i++) {
-      body += string(i > 0 ? "," : "") + "{\"id\":\"" + a_request.deps(i).id() +
-              "\",\"type\":" + to_string(a_request.deps(i).type()) + "}";
+      body.beginObject().key("id").string(a_request.deps(i).id());
+      body.key("type").number(a_request.deps(i).type()).endObject();
     }
-    body += "]";
+    body.endArray();
   }
-  body += "}";
+  body.endObject();
 
-  DL_DEBUG(log_context, "dat create: " << body);
+  DL_DEBUG(log_context, "dat create: " << body.str());
 
-  dbPost("dat/create", {}, &body, result, log_context);
-
-  setRecordData(a_reply, result, log_context);
+  dbRecord("dat/create", {}, &body.str(), a_reply, log_context);
 }
 
 void DatabaseAPI::recordCreateBatch(
     const Auth::RecordCreateBatchRequest &a_request,
     Auth::RecordDataReply &a_reply, LogContext log_context) {
-  Value result;
-
-  dbPost("dat/create/batch", {}, &a_request.records(), result, log_context);
-
-  setRecordData(a_reply, result, log_context);
+  dbRecord("dat/create/batch", {}, &a_request.records(), a_reply, log_context);
 }
 
 void DatabaseAPI::recordUpdate(const Auth::RecordUpdateRequest &a_request,
                                Auth::RecordDataReply &a_reply,
                                libjson::Value &result, LogContext log_context) {
-  string body = "{\"id\":\"" + a_request.id() + "\"";
+  Writer body;
+
+  body.beginObject().key("id").string(a_request.id());
   if (a_request.has_title())
-    body += ",\"title\":\"" + escapeJSON(a_request.title()) + "\"";
+    body.key("title").string(a_request.title());
   if (a_request.has_desc())
-    body += ",\"desc\":\"" + escapeJSON(a_request.desc()) + "\"";
+    body.key("desc").string(a_request.desc());
   if (a_request.has_alias())
-    body += ",\"alias\":\"" + a_request.alias() + "\"";
+    body.key("alias").string(a_request.alias());
 
   if (a_request.has_tags_clear() && a_request.tags_clear()) {
-    body += ",\"tags_clear\":true";
+    body.key("tags_clear").boolean(true);
   } else if (a_request.tags_size()) {
-    body += ",\"tags\":[";
-    for (int i = 0; i < a_request.tags_size(); i++) {
-      if (i)
-        body += ",";
-      body += "\"" + a_request.tags(i) + "\"";
-    }
-    body += "]";
+    body.key("tags").beginArray();
+    for (int i = 0; i < a_request.tags_size(); i++)
+      body.string(a_request.tags(i));
+    body.endArray();
   }
 
   if (a_request.has_metadata()) {
-    body += ",\"md\":" +
-            (a_request.metadata().size() ? a_request.metadata() : "\"\"");
-    if (a_request.has_mdset()) {
-      body += ",\"mdset\":";
-      body += (a_request.mdset() ? "true" : "false");
-    }
+    if (a_request.metadata().size())
+      body.key("md").raw(a_request.metadata());
+    else
+      body.key("md").string("");
+    if (a_request.has_mdset())
+      body.key("mdset").boolean(a_request.mdset());
   }
   if (a_request.has_sch_id())
-    body += string(",\"sch_id\":\"") + a_request.sch_id() + "\"";
+    body.key("sch_id").string(a_request.sch_id());
   if (a_request.has_source())
-    body += ",\"source\":\"" + a_request.source() + "\"";
+    body.key("source").string(a_request.source());
   if (a_request.has_ext())
-    body += ",\"ext\":\"" + a_request.ext() + "\"";
+    body.key("ext").string(a_request.ext());
   if (a_request.has_ext_auto())
-    body +=
-        string(",\"ext_auto\":") + (a_request.ext_auto() ? "true" : "false");
+    body.key("ext_auto").boolean(a_request.ext_auto());
 
   if (a_request.dep_add_size()) {
-    body += ",\"dep_add\":[";
+    body.key("dep_add").beginArray();
     for (int i = 0; i < a_request.dep_add_size(); i++) {
-      body += string(i > 0 ? "," : "") + "{\"id\":\"" +
-              a_request.dep_add(i).id() +
-              "\",\"type\":" + to_string(a_request.dep_add(i).type()) + "}";
+      body.beginObject().key("id").string(a_request.dep_add(i).id());
+      body.key("type").number(a_request.dep_add(i).type()).endObject();
     }
-    body += "]";
+    body.endArray();
   }
 
   if (a_request.dep_rem_size()) {
-    body += ",\"dep_rem\":[";
+    body.key("dep_rem").beginArray();
     for (int i = 0; i < a_request.dep_rem_size(); i++) {
-      body += string(i > 0 ? "," : "") + "{\"id\":\"" +
-              a_request.dep_rem(i).id() +
-              "\",\"type\":" + to_string(a_request.dep_rem(i).type()) + "}";
+      body.beginObject().key("id").string(a_request.dep_rem(i).id());
+      body.key("type").number(a_request.dep_rem(i).type()).endObject();
     }
-    body += "]";
+    body.endArray();
   }
 
-  body += "}";
+  body.endObject();
 
-  dbPost("dat/update", {}, &body, result, log_context);
+  dbPost("dat/update", {}, &body.str(), result, log_context);
 
   setRecordData(a_reply, result, log_context);
 }
@@ -1039,18 +1425,18 @@ void DatabaseAPI::recordUpdateSize(const Auth::RepoDataSizeReply &a_size_rep,
                                    LogContext log_context) {
   libjson::Value result;
 
-  string body = "{\"records\":[";
+  Writer body;
+
+  body.beginObject().key("records").beginArray();
 
   for (int i = 0; i < a_size_rep.size_size(); i++) {
-    if (i > 0)
-      body += ",";
-    body += "{\"id\":\"" + a_size_rep.size(i).id() +
-            "\",\"size\":" + to_string(a_size_rep.size(i).size()) + "}";
+    body.beginObject().key("id").string(a_size_rep.size(i).id());
+    body.key("size").number(a_size_rep.size(i).size()).endObject();
   }
 
-  body += "]}";
+  body.endArray().endObject();
 
-  dbPost("dat/update/size", {}, &body, result, log_context);
+  dbPost("dat/update/size", {}, &body.str(), result, log_context);
 }
 
 void DatabaseAPI::recordUpdateSchemaError(const std::string &a_rec_id,
@@ -1067,17 +1453,16 @@ void DatabaseAPI::recordExport(const Auth::RecordExportRequest &a_request,
                                LogContext log_context) {
   Value result;
 
-  string body = "{\"id\":[";
+  Writer body;
 
-  for (int i = 0; i < a_request.id_size(); i++) {
-    if (i > 0)
-      body += ",";
-    body += "\"" + a_request.id(i) + "\"";
-  }
+  body.beginObject().key("id").beginArray();
 
-  body += "]}";
+  for (int i = 0; i < a_request.id_size(); i++)
+    body.string(a_request.id(i));
 
-  dbPost("dat/export", {}, &body, result, log_context);
+  body.endArray().endObject();
+
+  dbPost("dat/export", {}, &body.str(), result, log_context);
 
   TRANSLATE_BEGIN()
 
@@ -1092,7 +1477,6 @@ void DatabaseAPI::recordExport(const Auth::RecordExportRequest &a_request,
 void DatabaseAPI::recordLock(const Auth::RecordLockRequest &a_request,
                              Auth::ListingReply &a_reply,
                              LogContext log_context) {
-  Value result;
   string ids;
 
   if (a_request.id_size() > 0) {
@@ -1107,21 +1491,16 @@ void DatabaseAPI::recordLock(const Auth::RecordLockRequest &a_request,
   } else
     ids = "[]";
 
-  dbGet("dat/lock",
-        {{"ids", ids}, {"lock", a_request.lock() ? "true" : "false"}}, result,
-        log_context);
-
-  setListingDataReply(a_reply, result, log_context);
+  dbListing("dat/lock",
+            {{"ids", ids}, {"lock", a_request.lock() ? "true" : "false"}},
+            nullptr, a_reply, log_context);
 }
 
 void DatabaseAPI::recordGetDependencyGraph(
     const Auth::RecordGetDependencyGraphRequest &a_request,
     Auth::ListingReply &a_reply, LogContext log_context) {
-  Value result;
-
-  dbGet("dat/dep/graph/get", {{"id", a_request.id()}}, result, log_context);
-
-  setListingDataReply(a_reply, result, log_context);
+  dbListing("dat/dep/graph/get", {{"id", a_request.id()}}, nullptr, a_reply,
+            log_context);
 }
 
 void DatabaseAPI::setRecordData(Auth::RecordDataReply &a_reply,
@@ -1240,6 +1619,102 @@ void DatabaseAPI::setRecordData(Auth::RecordDataReply &a_reply,
   TRANSLATE_END(a_result, log_context)
 }
 
+void DatabaseAPI::setRecordData(Auth::RecordDataReply &a_reply,
+                                const string &a_res_json,
+                                LogContext log_context) {
+  Reader reader(a_res_json);
+  RecordData *rec;
+
+  TRANSLATE_BEGIN()
+
+  readObjectBegin(reader);
+  while (reader.next() == Reader::EV_KEY) {
+    if (reader.text() == "results") {
+      readArrayBegin(reader);
+
+      while (readArrayObject(reader)) {
+        bool id = false, title = false;
+
+        rec = a_reply.add_data();
+        while (reader.next() == Reader::EV_KEY) {
+          const string_view key = reader.text();
+
+          if (key == "id") {
+            rec->set_id(string(reader.readString()));
+            id = true;
+          } else if (key == "title") {
+            rec->set_title(string(reader.readString()));
+            title = true;
+          } else if (key == "alias") {
+            if (!reader.readNull())
+              rec->set_alias(string(reader.readString()));
+          } else if (key == "owner") {
+            rec->set_owner(string(reader.readString()));
+          } else if (key == "creator") {
+            rec->set_creator(string(reader.readString()));
+          } else if (key == "desc") {
+            rec->set_desc(string(reader.readString()));
+          } else if (key == "tags") {
+            readArrayBegin(reader);
+            while (readArrayString(reader))
+              rec->add_tags(string(reader.text()));
+          } else if (key == "md") {
+            // Metadata is passed on as text, normalized as the tree would be
+            Value md;
+            reader.readValue(md);
+            rec->set_metadata(md.toString());
+          } else if (key == "md_err_msg") {
+            rec->set_md_err_msg(string(reader.readString()));
+          } else if (key == "sch_id") {
+            rec->set_sch_id(string(reader.readString()));
+          } else if (key == "external") {
+            rec->set_external(reader.readBool());
+          } else if (key == "repo_id") {
+            rec->set_repo_id(string(reader.readString()));
+          } else if (key == "size") {
+            rec->set_size(reader.readNumber());
+          } else if (key == "source") {
+            rec->set_source(string(reader.readString()));
+          } else if (key == "ext") {
+            rec->set_ext(string(reader.readString()));
+          } else if (key == "ext_auto") {
+            rec->set_ext_auto(reader.readBool());
+          } else if (key == "ct") {
+            rec->set_ct(reader.readNumber());
+          } else if (key == "ut") {
+            rec->set_ut(reader.readNumber());
+          } else if (key == "dt") {
+            rec->set_dt(reader.readNumber());
+          } else if (key == "locked") {
+            rec->set_locked(reader.readBool());
+          } else if (key == "parent_id") {
+            rec->set_parent_id(string(reader.readString()));
+          } else if (key == "notes") {
+            rec->set_notes(reader.readNumber());
+          } else if (key == "deps") {
+            readArrayBegin(reader);
+            while (readArrayObject(reader))
+              readDependency(rec->add_deps(), reader, false);
+          } else {
+            reader.skip();
+          }
+        }
+
+        requireKey(id, "id");
+        requireKey(title, "title");
+      }
+    } else if (reader.text() == "updates") {
+      readArrayBegin(reader);
+      while (readArrayObject(reader))
+        setListingData(a_reply.add_update(), reader, nullptr, log_context);
+    } else {
+      reader.skip();
+    }
+  }
+
+  TRANSLATE_TEXT_END(a_res_json, log_context)
+}
+
 void DatabaseAPI::dataPath(const Auth::DataPathRequest &a_request,
                            Auth::DataPathReply &a_reply,
                            LogContext log_context) {
@@ -1268,31 +1743,31 @@ void DatabaseAPI::dataPath(const Auth::DataPathRequest &a_request,
 void DatabaseAPI::generalSearch(const Auth::SearchRequest &a_request,
                                 Auth::ListingReply &a_reply,
                                 LogContext log_context) {
-  Value result;
-  string qry_begin, qry_end, qry_filter, params;
+  string qry_begin, qry_end, qry_filter;
+  Writer body;
 
+  // The bind parameters are written straight into the body, escaped
+  body.beginObject().key("params");
   uint32_t cnt = parseSearchRequest(a_request, qry_begin, qry_end, qry_filter,
-                                    params, log_context);
+                                    body, log_context);
 
-  string body =
-      "{\"mode\":" + to_string(a_request.mode()) + ",\"published\":" +
-      ((a_request.has_published() && a_request.published()) ? "true"
-                                                            : "false") +
-      ",\"qry_begin\":\"" + qry_begin + "\",\"qry_end\":\"" + qry_end +
-      "\",\"qry_filter\":\"" + qry_filter + "\",\"params\":{" + params +
-      "},\"limit\":" + to_string(cnt) + "}";
+  body.key("mode").number(a_request.mode());
+  body.key("published")
+      .boolean(a_request.has_published() && a_request.published());
+  body.key("qry_begin").string(qry_begin);
+  body.key("qry_end").string(qry_end);
+  body.key("qry_filter").string(qry_filter);
+  body.key("limit").number(cnt);
+  body.endObject();
 
-  DL_DEBUG(log_context, "Query: [" << body << "]");
+  DL_DEBUG(log_context, "Query: [" << body.str() << "]");
 
-  dbPost("qry/exec/direct", {}, &body, result, log_context);
-
-  setListingDataReply(a_reply, result, log_context);
+  dbListing("qry/exec/direct", {}, &body.str(), a_reply, log_context);
 }
 
 void DatabaseAPI::collListPublished(
     const Auth::CollListPublishedRequest &a_request,
     Auth::ListingReply &a_reply, LogContext log_context) {
-  Value result;
   vector<pair<string, string>> params;
 
   if (a_request.has_subject())
@@ -1302,42 +1777,39 @@ void DatabaseAPI::collListPublished(
   if (a_request.has_count())
     params.push_back({"count", to_string(a_request.count())});
 
-  dbGet("col/published/list", params, result, log_context);
-
-  setListingDataReply(a_reply, result, log_context);
+  dbListing("col/published/list", params, nullptr, a_reply, log_context);
 }
 
 void DatabaseAPI::collCreate(const Auth::CollCreateRequest &a_request,
                              Auth::CollDataReply &a_reply,
                              LogContext log_context) {
   Value result;
-  string body = "{\"title\":\"" + escapeJSON(a_request.title()) + "\"";
+  Writer body;
+
+  body.beginObject().key("title").string(a_request.title());
 
   if (a_request.has_desc())
-    body += ",\"desc\":\"" + escapeJSON(a_request.desc()) + "\"";
+    body.key("desc").string(a_request.desc());
 
   if (a_request.has_alias())
-    body += ",\"alias\":\"" + a_request.alias() + "\"";
+    body.key("alias").string(a_request.alias());
 
   if (a_request.has_parent_id())
-    body += ",\"parent\":\"" + a_request.parent_id() + "\"";
+    body.key("parent").string(a_request.parent_id());
 
   if (a_request.has_topic())
-    body += ",\"topic\":\"" + escapeJSON(a_request.topic()) + "\"";
+    body.key("topic").string(a_request.topic());
 
   if (a_request.tags_size()) {
-    body += ",\"tags\":[";
-    for (int i = 0; i < a_request.tags_size(); i++) {
-      if (i)
-        body += ",";
-      body += "\"" + a_request.tags(i) + "\"";
-    }
-    body += "]";
+    body.key("tags").beginArray();
+    for (int i = 0; i < a_request.tags_size(); i++)
+      body.string(a_request.tags(i));
+    body.endArray();
   }
 
-  body += "}";
+  body.endObject();
 
-  dbPost("col/create", {}, &body, result, log_context);
+  dbPost("col/create", {}, &body.str(), result, log_context);
 
   setCollData(a_reply, result, log_context);
 }
@@ -1346,35 +1818,34 @@ void DatabaseAPI::collUpdate(const Auth::CollUpdateRequest &a_request,
                              Auth::CollDataReply &a_reply,
                              LogContext log_context) {
   Value result;
-  string body = "{\"id\":\"" + a_request.id() + "\"";
+  Writer body;
+
+  body.beginObject().key("id").string(a_request.id());
 
   if (a_request.has_title())
-    body += ",\"title\":\"" + escapeJSON(a_request.title()) + "\"";
+    body.key("title").string(a_request.title());
 
   if (a_request.has_desc())
-    body += ",\"desc\":\"" + escapeJSON(a_request.desc()) + "\"";
+    body.key("desc").string(a_request.desc());
 
   if (a_request.has_alias())
-    body += ",\"alias\":\"" + a_request.alias() + "\"";
+    body.key("alias").string(a_request.alias());
 
   if (a_request.has_topic())
-    body += ",\"topic\":\"" + escapeJSON(a_request.topic()) + "\"";
+    body.key("topic").string(a_request.topic());
 
   if (a_request.has_tags_clear() && a_request.tags_clear()) {
-    body += ",\"tags_clear\":true";
+    body.key("tags_clear").boolean(true);
   } else if (a_request.tags_size()) {
-    body += ",\"tags\":[";
-    for (int i = 0; i < a_request.tags_size(); i++) {
-      if (i)
-        body += ",";
-      body += "\"" + a_request.tags(i) + "\"";
-    }
-    body += "]";
+    body.key("tags").beginArray();
+    for (int i = 0; i < a_request.tags_size(); i++)
+      body.string(a_request.tags(i));
+    body.endArray();
   }
 
-  body += "}";
+  body.endObject();
 
-  dbPost("col/update", {}, &body, result, log_context);
+  dbPost("col/update", {}, &body.str(), result, log_context);
 
   setCollData(a_reply, result, log_context);
 }
@@ -1392,7 +1863,6 @@ void DatabaseAPI::collView(const Auth::CollViewRequest &a_request,
 void DatabaseAPI::collRead(const Auth::CollReadRequest &a_request,
                            Auth::ListingReply &a_reply,
                            LogContext log_context) {
-  Value result;
   vector<pair<string, string>> params;
   params.push_back({"id", a_request.id()});
   if (a_request.has_offset())
@@ -1400,9 +1870,7 @@ void DatabaseAPI::collRead(const Auth::CollReadRequest &a_request,
   if (a_request.has_count())
     params.push_back({"count", to_string(a_request.count())});
 
-  dbGet("col/read", params, result, log_context);
-
-  setListingDataReply(a_reply, result, log_context);
+  dbListing("col/read", params, nullptr, a_reply, log_context);
 }
 
 void DatabaseAPI::collWrite(const Auth::CollWriteRequest &a_request,
@@ -1437,11 +1905,7 @@ void DatabaseAPI::collWrite(const Auth::CollWriteRequest &a_request,
     params.push_back({"remove", rem_list});
   }
 
-  Value result;
-
-  dbGet("col/write", params, result, log_context);
-
-  setListingDataReply(a_reply, result, log_context);
+  dbListing("col/write", params, nullptr, a_reply, log_context);
 }
 
 void DatabaseAPI::collMove(const Auth::CollMoveRequest &a_request,
@@ -1695,19 +2159,125 @@ void DatabaseAPI::setListingData(ListingData *a_item,
   }
 }
 
+void DatabaseAPI::setListingDataReply(Auth::ListingReply &a_reply,
+                                      const string &a_res_json,
+                                      LogContext log_context) {
+  Reader reader(a_res_json);
+
+  TRANSLATE_BEGIN()
+
+  readArrayBegin(reader);
+  while (readArrayObject(reader)) {
+    if (!setListingData(a_reply.add_item(), reader, &a_reply, log_context))
+      a_reply.mutable_item()->RemoveLast();
+  }
+
+  TRANSLATE_TEXT_END(a_res_json, log_context)
+}
+
+/**
+ * Reads the listing object begun by the last event of a streamed reply.
+ * Given a_paging, an object holding "paging" sets the paging of that reply
+ * instead and false is returned, as the item is then not part of the reply.
+ **/
+bool DatabaseAPI::setListingData(ListingData *a_item, Reader &a_reader,
+                                 Auth::ListingReply *a_paging,
+                                 LogContext log_context) {
+  bool id = false, title = false, paging = false;
+
+  while (a_reader.next() == Reader::EV_KEY) {
+    const string_view key = a_reader.text();
+
+    if (key == "id" || (key == "_id" && !id)) {
+      // The key is only valid until the value is read
+      const bool is_id = key == "id";
+      a_item->set_id(string(a_reader.readString()));
+      DL_TRACE(log_context, a_item->id());
+      id = is_id;
+    } else if (key == "title") {
+      a_item->set_title(string(a_reader.readString()));
+      DL_TRACE(log_context, a_item->title());
+      title = true;
+    } else if (key == "alias") {
+      if (!a_reader.readNull())
+        a_item->set_alias(string(a_reader.readString()));
+    } else if (key == "owner") {
+      if (!a_reader.readNull())
+        a_item->set_owner(string(a_reader.readString()));
+    } else if (key == "owner_name") {
+      if (!a_reader.readNull())
+        a_item->set_owner_name(string(a_reader.readString()));
+    } else if (key == "creator") {
+      if (!a_reader.readNull())
+        a_item->set_creator(string(a_reader.readString()));
+    } else if (key == "desc") {
+      if (!a_reader.readNull())
+        a_item->set_desc(string(a_reader.readString()));
+    } else if (key == "size") {
+      if (!a_reader.readNull())
+        a_item->set_size(a_reader.readNumber());
+    } else if (key == "external") {
+      if (!a_reader.readNull())
+        a_item->set_external(a_reader.readBool());
+    } else if (key == "notes") {
+      a_item->set_notes(a_reader.readNumber());
+    } else if (key == "locked") {
+      if (!a_reader.readNull())
+        a_item->set_locked(a_reader.readBool());
+    } else if (key == "gen") {
+      a_item->set_gen(a_reader.readNumber());
+    } else if (key == "deps") {
+      a_item->set_deps_avail(true);
+      readArrayBegin(a_reader);
+      while (readArrayObject(a_reader))
+        readDependency(a_item->add_dep(), a_reader, true);
+    } else if (key == "paging" && a_paging) {
+      bool off = false, cnt = false, tot = false;
+
+      readObjectBegin(a_reader);
+      while (a_reader.next() == Reader::EV_KEY) {
+        const string_view field = a_reader.text();
+
+        if (field == "off") {
+          a_paging->set_offset(a_reader.readNumber());
+          off = true;
+        } else if (field == "cnt") {
+          a_paging->set_count(a_reader.readNumber());
+          cnt = true;
+        } else if (field == "tot") {
+          a_paging->set_total(a_reader.readNumber());
+          tot = true;
+        } else {
+          a_reader.skip();
+        }
+      }
+
+      requireKey(off, "off");
+      requireKey(cnt, "cnt");
+      requireKey(tot, "tot");
+      paging = true;
+    } else {
+      a_reader.skip();
+    }
+  }
+
+  if (paging)
+    return false;
+
+  requireKey(title, "title");
+  return true;
+}
+
 void DatabaseAPI::queryList(const Auth::QueryListRequest &a_request,
                             Auth::ListingReply &a_reply,
                             LogContext log_context) {
-  Value result;
   vector<pair<string, string>> params;
   if (a_request.has_offset())
     params.push_back({"offset", to_string(a_request.offset())});
   if (a_request.has_count())
     params.push_back({"count", to_string(a_request.count())});
 
-  dbGet("qry/list", params, result, log_context);
-
-  setListingDataReply(a_reply, result, log_context);
+  dbListing("qry/list", params, nullptr, a_reply, log_context);
 }
 
 void DatabaseAPI::queryCreate(const Auth::QueryCreateRequest &a_request,
@@ -1716,10 +2286,12 @@ void DatabaseAPI::queryCreate(const Auth::QueryCreateRequest &a_request,
   Value result;
   // vector<pair<string,string>> params;
 
-  string qry_begin, qry_end, qry_filter, params;
+  string qry_begin, qry_end, qry_filter;
+  Writer body;
 
+  body.beginObject().key("params");
   uint32_t cnt = parseSearchRequest(a_request.query(), qry_begin, qry_end,
-                                    qry_filter, params, log_context);
+                                    qry_filter, body, log_context);
 
   google::protobuf::util::JsonPrintOptions options;
   string query_json;
@@ -1734,13 +2306,15 @@ void DatabaseAPI::queryCreate(const Auth::QueryCreateRequest &a_request,
     EXCEPT(1, "Invalid search request");
   }
 
-  string body =
-      string("{") + "\"qry_begin\":\"" + qry_begin + "\",\"qry_end\":\"" +
-      qry_end + "\",\"qry_filter\":\"" + qry_filter + "\",\"params\":{" +
-      params + "},\"limit\":" + to_string(cnt) + ",\"title\":\"" +
-      escapeJSON(a_request.title()) + "\"" + ",\"query\":" + query_json + "}";
+  body.key("qry_begin").string(qry_begin);
+  body.key("qry_end").string(qry_end);
+  body.key("qry_filter").string(qry_filter);
+  body.key("limit").number(cnt);
+  body.key("title").string(a_request.title());
+  body.key("query").raw(query_json);
+  body.endObject();
 
-  dbPost("qry/create", {}, &body, result, log_context);
+  dbPost("qry/create", {}, &body.str(), result, log_context);
 
   setQueryData(a_reply, result, log_context);
 }
@@ -1749,17 +2323,20 @@ void DatabaseAPI::queryUpdate(const Auth::QueryUpdateRequest &a_request,
                               Auth::QueryDataReply &a_reply,
                               LogContext log_context) {
   Value result;
-  string body = "{\"id\":\"" + a_request.id() + "\"";
+  Writer body;
+
+  body.beginObject().key("id").string(a_request.id());
 
   if (a_request.has_title()) {
-    body += ",\"title\":\"" + escapeJSON(a_request.title()) + "\"";
+    body.key("title").string(a_request.title());
   }
 
   if (a_request.has_query()) {
-    string qry_begin, qry_end, qry_filter, params;
+    string qry_begin, qry_end, qry_filter;
 
+    body.key("params");
     uint32_t cnt = parseSearchRequest(a_request.query(), qry_begin, qry_end,
-                                      qry_filter, params, log_context);
+                                      qry_filter, body, log_context);
 
     google::protobuf::util::JsonPrintOptions options;
     string query_json;
@@ -1774,14 +2351,16 @@ void DatabaseAPI::queryUpdate(const Auth::QueryUpdateRequest &a_request,
       EXCEPT(1, "Invalid search request");
     }
 
-    body += ",\"qry_begin\":\"" + qry_begin + "\",\"qry_end\":\"" + qry_end +
-            "\",\"qry_filter\":\"" + qry_filter + "\",\"params\":{" + params +
-            "},\"limit\":" + to_string(cnt) + ",\"query\":" + query_json;
+    body.key("qry_begin").string(qry_begin);
+    body.key("qry_end").string(qry_end);
+    body.key("qry_filter").string(qry_filter);
+    body.key("limit").number(cnt);
+    body.key("query").raw(query_json);
   }
 
-  body += "}";
+  body.endObject();
 
-  dbPost("qry/update", {}, &body, result, log_context);
+  dbPost("qry/update", {}, &body.str(), result, log_context);
 
   setQueryData(a_reply, result, log_context);
 }
@@ -1817,7 +2396,6 @@ void DatabaseAPI::queryView(const Auth::QueryViewRequest &a_request,
 void DatabaseAPI::queryExec(const Auth::QueryExecRequest &a_request,
                             Auth::ListingReply &a_reply,
                             LogContext log_context) {
-  Value result;
   vector<pair<string, string>> params;
 
   params.push_back({"id", a_request.id()});
@@ -1826,9 +2404,7 @@ void DatabaseAPI::queryExec(const Auth::QueryExecRequest &a_request,
   if (a_request.has_count())
     params.push_back({"count", to_string(a_request.count())});
 
-  dbGet("/qry/exec", params, result, log_context);
-
-  setListingDataReply(a_reply, result, log_context);
+  dbListing("/qry/exec", params, nullptr, a_reply, log_context);
 }
 
 void DatabaseAPI::setQueryData(QueryDataReply &a_reply,
@@ -1880,7 +2456,6 @@ void DatabaseAPI::aclUpdate(const Auth::ACLUpdateRequest &a_request,
 void DatabaseAPI::aclSharedList(const Auth::ACLSharedListRequest &a_request,
                                 Auth::ListingReply &a_reply,
                                 LogContext log_context) {
-  Value result;
   vector<pair<string, string>> params;
 
   if (a_request.has_inc_users())
@@ -1889,22 +2464,17 @@ void DatabaseAPI::aclSharedList(const Auth::ACLSharedListRequest &a_request,
     params.push_back(
         {"inc_projects", a_request.inc_projects() ? "true" : "false"});
 
-  dbGet("acl/shared/list", params, result, log_context);
-
-  setListingDataReply(a_reply, result, log_context);
+  dbListing("acl/shared/list", params, nullptr, a_reply, log_context);
 }
 
 void DatabaseAPI::aclSharedListItems(
     const Auth::ACLSharedListItemsRequest &a_request,
     Auth::ListingReply &a_reply, LogContext log_context) {
-  Value result;
   vector<pair<string, string>> params;
 
   params.push_back({"owner", a_request.owner()});
 
-  dbGet("acl/shared/list/items", params, result, log_context);
-
-  setListingDataReply(a_reply, result, log_context);
+  dbListing("acl/shared/list/items", params, nullptr, a_reply, log_context);
 }
 
 void DatabaseAPI::setACLData(ACLDataReply &a_reply,
@@ -2135,33 +2705,32 @@ void DatabaseAPI::repoCreate(const Auth::RepoCreateRequest &a_request,
                              LogContext log_context) {
   Value result;
 
-  string body = "{\"id\":\"" + a_request.id() + "\"";
-  body += ",\"title\":\"" + escapeJSON(a_request.title()) + "\"";
-  body += ",\"path\":\"" + escapeJSON(a_request.path()) + "\"";
-  body += ",\"pub_key\":\"" + escapeJSON(a_request.pub_key()) + "\"";
-  body += ",\"address\":\"" + a_request.address() + "\"";
-  body += ",\"endpoint\":\"" + a_request.endpoint() + "\"";
-  body += ",\"capacity\":\"" + to_string(a_request.capacity()) + "\"";
+  Writer body;
+
+  body.beginObject().key("id").string(a_request.id());
+  body.key("title").string(a_request.title());
+  body.key("path").string(a_request.path());
+  body.key("pub_key").string(a_request.pub_key());
+  body.key("address").string(a_request.address());
+  body.key("endpoint").string(a_request.endpoint());
+  body.key("capacity").string(to_string(a_request.capacity()));
 
   if (a_request.has_desc())
-    body += ",\"desc\":\"" + escapeJSON(a_request.desc()) + "\"";
+    body.key("desc").string(a_request.desc());
   if (a_request.has_domain())
-    body += ",\"domain\":\"" + a_request.domain() + "\"";
+    body.key("domain").string(a_request.domain());
   if (a_request.has_exp_path())
-    body += ",\"exp_path\":\"" + escapeJSON(a_request.exp_path()) + "\"";
+    body.key("exp_path").string(a_request.exp_path());
 
   if (a_request.admin_size() > 0) {
-    body += ",\"admins\":[";
-    for (int i = 0; i < a_request.admin_size(); ++i) {
-      if (i > 0)
-        body += ",";
-      body += "\"" + a_request.admin(i) + "\"";
-    }
-    body += "]";
+    body.key("admins").beginArray();
+    for (int i = 0; i < a_request.admin_size(); ++i)
+      body.string(a_request.admin(i));
+    body.endArray();
   }
-  body += "}";
+  body.endObject();
 
-  dbPost("repo/create", {}, &body, result, log_context);
+  dbPost("repo/create", {}, &body.str(), result, log_context);
 
   std::vector<RepoData> temp;
   setRepoData(&a_reply, temp, result, log_context);
@@ -2172,38 +2741,37 @@ void DatabaseAPI::repoUpdate(const Auth::RepoUpdateRequest &a_request,
                              LogContext log_context) {
   Value result;
 
-  string body = "{\"id\":\"" + a_request.id() + "\"";
+  Writer body;
+
+  body.beginObject().key("id").string(a_request.id());
   if (a_request.has_title())
-    body += ",\"title\":\"" + escapeJSON(a_request.title()) + "\"";
+    body.key("title").string(a_request.title());
   if (a_request.has_desc())
-    body += ",\"desc\":\"" + escapeJSON(a_request.desc()) + "\"";
+    body.key("desc").string(a_request.desc());
   if (a_request.has_path())
-    body += ",\"path\":\"" + escapeJSON(a_request.path()) + "\"";
+    body.key("path").string(a_request.path());
   if (a_request.has_exp_path())
-    body += ",\"exp_path\":\"" + escapeJSON(a_request.exp_path()) + "\"";
+    body.key("exp_path").string(a_request.exp_path());
   if (a_request.has_domain())
-    body += ",\"domain\":\"" + a_request.domain() + "\"";
+    body.key("domain").string(a_request.domain());
   if (a_request.has_pub_key())
-    body += ",\"pub_key\":\"" + escapeJSON(a_request.pub_key()) + "\"";
+    body.key("pub_key").string(a_request.pub_key());
   if (a_request.has_address())
-    body += ",\"address\":\"" + a_request.address() + "\"";
+    body.key("address").string(a_request.address());
   if (a_request.has_endpoint())
-    body += ",\"endpoint\":\"" + a_request.endpoint() + "\"";
+    body.key("endpoint").string(a_request.endpoint());
   if (a_request.has_capacity())
-    body += ",\"capacity\":\"" + to_string(a_request.capacity()) + "\"";
+    body.key("capacity").string(to_string(a_request.capacity()));
 
   if (a_request.admin_size() > 0) {
-    body += ",\"admins\":[";
-    for (int i = 0; i < a_request.admin_size(); ++i) {
-      if (i > 0)
-        body += ",";
-      body += "\"" + a_request.admin(i) + "\"";
-    }
-    body += "]";
+    body.key("admins").beginArray();
+    for (int i = 0; i < a_request.admin_size(); ++i)
+      body.string(a_request.admin(i));
+    body.endArray();
   }
-  body += "}";
+  body.endObject();
 
-  dbPost("repo/update", {}, &body, result, log_context);
+  dbPost("repo/update", {}, &body.str(), result, log_context);
 
   std::vector<RepoData> temp;
   setRepoData(&a_reply, temp, result, log_context);
@@ -2859,111 +3427,58 @@ void DatabaseAPI::schemaView(const Auth::SchemaViewRequest &a_request,
 void DatabaseAPI::schemaCreate(const Auth::SchemaCreateRequest &a_request,
                                LogContext log_context) {
   libjson::Value result;
-  string body = "{\"id\":\"";
-  body.append(a_request.id());
-  body.append("\",\"desc\":\"");
-  body.append(escapeJSON(a_request.desc()));
-  body.append("\",\"pub\":");
-  body.append(a_request.pub() ? "true" : "false");
-  body.append(",\"sys\":");
-  body.append(a_request.sys() ? "true" : "false");
-  body.append(",\"def\":");
-  body.append(a_request.def());
-  body.append("}");
+  Writer body;
+
+  body.beginObject().key("id").string(a_request.id());
+  body.key("desc").string(a_request.desc());
+  body.key("pub").boolean(a_request.pub());
+  body.key("sys").boolean(a_request.sys());
+  body.key("def").raw(a_request.def());
+  body.endObject();
 
-  dbPost("schema/create", {}, &body, result, log_context);
+  dbPost("schema/create", {}, &body.str(), result, log_context);
 }
 
 void DatabaseAPI::schemaRevise(const Auth::SchemaReviseRequest &a_request,
                                LogContext log_context) {
   libjson::Value result;
-  string body = "{";
+  Writer body;
 
-  if (a_request.has_desc()) {
-    body.append("\"desc\":\"");
-    body.append(a_request.desc());
-    body.append("\"");
-  }
-
-  if (a_request.has_pub()) {
-    if (body.size() > 1)
-      body.append(",");
-
-    body.append("\"pub\":");
-    body.append(a_request.pub() ? "true" : "false");
-  }
-
-  if (a_request.has_sys()) {
-    if (body.size() > 1)
-      body.append(",");
-
-    body.append("\"sys\":");
-    body.append(a_request.sys() ? "true" : "false");
-  }
-
-  if (a_request.has_def()) {
-    if (body.size() > 1)
-      body.append(",");
-
-    body.append("\"def\":");
-    body.append(a_request.def());
-  }
-
-  body.append("}");
-
-  dbPost("schema/revise", {{"id", a_request.id()}}, &body, result, log_context);
+  body.beginObject();
+  if (a_request.has_desc())
+    body.key("desc").string(a_request.desc());
+  if (a_request.has_pub())
+    body.key("pub").boolean(a_request.pub());
+  if (a_request.has_sys())
+    body.key("sys").boolean(a_request.sys());
+  if (a_request.has_def())
+    body.key("def").raw(a_request.def());
+  body.endObject();
+
+  dbPost("schema/revise", {{"id", a_request.id()}}, &body.str(), result,
+         log_context);
 }
 
 void DatabaseAPI::schemaUpdate(const Auth::SchemaUpdateRequest &a_request,
                                LogContext log_context) {
   libjson::Value result;
-  string body = "{";
-
-  if (a_request.has_id_new()) {
-    if (body.size() > 1)
-      body.append(",");
-
-    body.append("\"id\":\"");
-    body.append(a_request.id_new());
-    body.append("\"");
-  }
-
-  if (a_request.has_desc()) {
-    if (body.size() > 1)
-      body.append(",");
-
-    body.append("\"desc\":\"");
-    body.append(a_request.desc());
-    body.append("\"");
-  }
-
-  if (a_request.has_pub()) {
-    if (body.size() > 1)
-      body.append(",");
-
-    body.append("\"pub\":");
-    body.append(a_request.pub() ? "true" : "false");
-  }
-
-  if (a_request.has_sys()) {
-    if (body.size() > 1)
-      body.append(",");
+  Writer body;
 
-    body.append("\"sys\":");
-    body.append(a_request.sys() ? "true" : "false");
-  }
-
-  if (a_request.has_def()) {
-    if (body.size() > 1)
-      body.append(",");
-
-    body.append("\"def\":");
-    body.append(a_request.def());
-  }
-
-  body.append("}");
-
-  dbPost("schema/update", {{"id", a_request.id()}}, &body, result, log_context);
+  body.beginObject();
+  if (a_request.has_id_new())
+    body.key("id").string(a_request.id_new());
+  if (a_request.has_desc())
+    body.key("desc").string(a_request.desc());
+  if (a_request.has_pub())
+    body.key("pub").boolean(a_request.pub());
+  if (a_request.has_sys())
+    body.key("sys").boolean(a_request.sys());
+  if (a_request.has_def())
+    body.key("def").raw(a_request.def());
+  body.endObject();
+
+  dbPost("schema/update", {{"id", a_request.id()}}, &body.str(), result,
+         log_context);
 }
 
 void DatabaseAPI::schemaDelete(const Auth::SchemaDeleteRequest &a_request,
@@ -3106,10 +3621,11 @@ void DatabaseAPI::taskAbort(const std::string &a_task_id,
                             const std::string &a_msg,
                             libjson::Value &a_task_reply,
                             LogContext log_context) {
-  libjson::Value doc = a_msg;
-  string body = doc.toString();
+  Writer body;
+
+  body.string(a_msg);
 
-  dbPost("task/abort", {{"task_id", a_task_id}}, &body, a_task_reply,
+  dbPost("task/abort", {{"task_id", a_task_id}}, &body.str(), a_task_reply,
          log_context);
 }
 
@@ -3117,31 +3633,30 @@ void DatabaseAPI::taskInitDataGet(const Auth::DataGetRequest &a_request,
                                   Auth::DataGetReply &a_reply,
                                   libjson::Value &a_result,
                                   LogContext log_context) {
-  string body = "{\"id\":[";
+  Writer body;
 
-  for (int i = 0; i < a_request.id_size(); i++) {
-    if (i > 0)
-      body += ",";
+  body.beginObject().key("id").beginArray();
 
-    body += "\"" + a_request.id(i) + "\"";
-  }
-  body += "]";
+  for (int i = 0; i < a_request.id_size(); i++)
+    body.string(a_request.id(i));
+
+  body.endArray();
 
   if (a_request.has_path())
-    body += ",\"path\":\"" + a_request.path() + "\"";
+    body.key("path").string(a_request.path());
 
   if (a_request.has_encrypt())
-    body += ",\"encrypt\":" + to_string(a_request.encrypt());
+    body.key("encrypt").number(a_request.encrypt());
 
   if (a_request.has_orig_fname() && a_request.orig_fname())
-    body += ",\"orig_fname\":true";
+    body.key("orig_fname").boolean(true);
 
   if (a_request.has_check() && a_request.check())
-    body += ",\"check\":true";
+    body.key("check").boolean(true);
 
-  body += "}";
+  body.endObject();
 
-  dbPost("dat/get", {}, &body, a_result, log_context);
+  dbPost("dat/get", {}, &body.str(), a_result, log_context);
 
   setDataGetReply(a_reply, a_result, log_context);
 }
@@ -3181,23 +3696,25 @@ void DatabaseAPI::taskInitDataPut(const Auth::DataPutRequest &a_request,
                                   Auth::DataPutReply &a_reply,
                                   libjson::Value &a_result,
                                   LogContext log_context) {
-  string body = "{\"id\":[\"" + a_request.id() + "\"]";
+  Writer body;
+
+  body.beginObject().key("id").beginArray().string(a_request.id()).endArray();
 
   if (a_request.has_path())
-    body += ",\"path\":\"" + a_request.path() + "\"";
+    body.key("path").string(a_request.path());
 
   if (a_request.has_encrypt())
-    body += ",\"encrypt\":" + to_string(a_request.encrypt());
+    body.key("encrypt").number(a_request.encrypt());
 
   if (a_request.has_ext())
-    body += ",\"ext\":\"" + a_request.ext() + "\"";
+    body.key("ext").string(a_request.ext());
 
   if (a_request.has_check() && a_request.check())
-    body += ",\"check\":true";
+    body.key("check").boolean(true);
 
-  body += "}";
+  body.endObject();
 
-  dbPost("dat/put", {}, &body, a_result, log_context);
+  dbPost("dat/put", {}, &body.str(), a_result, log_context);
 
   setDataPutReply(a_reply, a_result, log_context);
 }
@@ -3241,18 +3758,17 @@ void DatabaseAPI::setDataPutReply(Auth::DataPutReply &a_reply,
 void DatabaseAPI::taskInitRecordCollectionDelete(
     const std::vector<std::string> &a_ids, TaskDataReply &a_reply,
     libjson::Value &a_result, LogContext log_context) {
-  string body = "{\"ids\":[";
+  Writer body;
+
+  body.beginObject().key("ids").beginArray();
 
   for (vector<string>::const_iterator i = a_ids.begin(); i != a_ids.end();
-       ++i) {
-    if (i != a_ids.begin())
-      body += ",";
+       ++i)
+    body.string(*i);
 
-    body += "\"" + *i + "\"";
-  }
-  body += "]}";
+  body.endArray().endObject();
 
-  dbPost("dat/delete", {}, &body, a_result, log_context);
+  dbPost("dat/delete", {}, &body.str(), a_result, log_context);
 
   setTaskDataReply(a_reply, a_result, log_context);
 }
@@ -3261,23 +3777,21 @@ void DatabaseAPI::taskInitRecordAllocChange(
     const Auth::RecordAllocChangeRequest &a_request,
     Auth::RecordAllocChangeReply &a_reply, libjson::Value &a_result,
     LogContext log_context) {
-  string body = "{\"ids\":[";
+  Writer body;
 
-  for (int i = 0; i < a_request.id_size(); i++) {
-    if (i > 0)
-      body += ",";
+  body.beginObject().key("ids").beginArray();
 
-    body += "\"" + a_request.id(i) + "\"";
-  }
-  body += "],\"repo_id\":\"" + a_request.repo_id() + "\"";
+  for (int i = 0; i < a_request.id_size(); i++)
+    body.string(a_request.id(i));
+
+  body.endArray().key("repo_id").string(a_request.repo_id());
   if (a_request.has_proj_id())
-    body += string(",\"proj_id\":\"") + a_request.proj_id() + "\"";
+    body.key("proj_id").string(a_request.proj_id());
   if (a_request.has_check())
-    body +=
-        string(",\"check\":\"") + (a_request.check() ? "true" : "false") + "\"";
-  body += "}";
+    body.key("check").string(a_request.check() ? "true" : "false");
+  body.endObject();
 
-  dbPost("dat/alloc_chg", {}, &body, a_result, log_context);
+  dbPost("dat/alloc_chg", {}, &body.str(), a_result, log_context);
 
   TRANSLATE_BEGIN()
 
@@ -3301,25 +3815,23 @@ void DatabaseAPI::taskInitRecordOwnerChange(
     const Auth::RecordOwnerChangeRequest &a_request,
     Auth::RecordOwnerChangeReply &a_reply, libjson::Value &a_result,
     LogContext log_context) {
-  string body = "{\"ids\":[";
+  Writer body;
 
-  for (int i = 0; i < a_request.id_size(); i++) {
-    if (i > 0)
-      body += ",";
+  body.beginObject().key("ids").beginArray();
 
-    body += "\"" + a_request.id(i) + "\"";
-  }
-  body += "],\"coll_id\":\"" + a_request.coll_id() + "\"";
+  for (int i = 0; i < a_request.id_size(); i++)
+    body.string(a_request.id(i));
+
+  body.endArray().key("coll_id").string(a_request.coll_id());
   if (a_request.has_repo_id())
-    body += ",\"repo_id\":\"" + a_request.repo_id() + "\"";
+    body.key("repo_id").string(a_request.repo_id());
   // if ( a_request.has_proj_id() )
-  //    body += string(",\"proj_id\":\"") + a_request.proj_id() + "\"";
+  //    body.key("proj_id").string(a_request.proj_id());
   if (a_request.has_check())
-    body +=
-        string(",\"check\":\"") + (a_request.check() ? "true" : "false") + "\"";
-  body += "}";
+    body.key("check").string(a_request.check() ? "true" : "false");
+  body.endObject();
 
-  dbPost("dat/owner_chg", {}, &body, a_result, log_context);
+  dbPost("dat/owner_chg", {}, &body.str(), a_result, log_context);
 
   TRANSLATE_BEGIN()
 
@@ -3346,17 +3858,16 @@ void DatabaseAPI::taskInitRecordOwnerChange(
 void DatabaseAPI::taskInitProjectDelete(
     const Auth::ProjectDeleteRequest &a_request, Auth::TaskDataReply &a_reply,
     libjson::Value &a_result, LogContext log_context) {
-  string body = "{\"ids\":[";
+  Writer body;
 
-  for (int i = 0; i < a_request.id_size(); i++) {
-    if (i > 0)
-      body += ",";
+  body.beginObject().key("ids").beginArray();
 
-    body += "\"" + a_request.id(i) + "\"";
-  }
-  body += "]}";
+  for (int i = 0; i < a_request.id_size(); i++)
+    body.string(a_request.id(i));
 
-  dbPost("prj/delete", {}, &body, a_result, log_context);
+  body.endArray().endObject();
+
+  dbPost("prj/delete", {}, &body.str(), a_result, log_context);
 
   setTaskDataReply(a_reply, a_result, log_context);
 }
@@ -3530,34 +4041,26 @@ void DatabaseAPI::taskUpdate(const std::string &a_id, LogContext log_context,
   if (!a_status && !a_progress && !a_state)
     return;
 
-  string body = "{";
-  string delim = "";
+  Writer body;
 
-  if (a_status) {
-    body += "\"status\":" + to_string(*a_status);
-    delim = ",";
-  }
+  body.beginObject();
 
-  if (a_message) {
-    body += delim + "\"message\":\"" + *a_message + "\"";
-    if (!delim.size())
-      delim = ",";
-  }
+  if (a_status)
+    body.key("status").number(*a_status);
 
-  if (a_progress) {
-    body += delim + "\"progress\":" + to_string(*a_progress);
-    if (!delim.size())
-      delim = ",";
-  }
+  if (a_message)
+    body.key("message").string(*a_message);
 
-  if (a_state) {
-    body += delim + "\"state\":" + a_state->toString();
-  }
+  if (a_progress)
+    body.key("progress").number(*a_progress);
+
+  if (a_state)
+    body.key("state").raw(a_state->toString());
 
-  body += "}";
+  body.endObject();
 
   Value result;
-  dbPost("task/update", {{"task_id", a_id}}, &body, result, log_context);
+  dbPost("task/update", {{"task_id", a_id}}, &body.str(), result, log_context);
 }
 
 void DatabaseAPI::taskFinalize(const std::string &a_task_id, bool a_succeeded,
@@ -3628,37 +4131,28 @@ void DatabaseAPI::metricsUpdateMsgCounts(
     LogContext log_context) {
   map<string, std::map<uint16_t, uint32_t>>::const_iterator u;
   map<uint16_t, uint32_t>::const_iterator m;
-  string body = "{\"timestamp\":" + to_string(a_timestamp) +
-                ",\"total\":" + to_string(a_total) + ",\"uids\":{";
-  bool c = false, cc;
-
-  for (u = a_metrics.begin(); u != a_metrics.end(); ++u) {
-    if (c)
-      body += ",";
-    else
-      c = true;
+  Writer body;
 
-    body += "\"" + u->first + "\":{\"tot\":" + to_string(u->second.at(0)) +
-            ",\"msg\":{";
+  body.beginObject().key("timestamp").number(a_timestamp);
+  body.key("total").number(a_total);
+  body.key("uids").beginObject();
 
-    for (cc = false, m = u->second.begin(); m != u->second.end(); ++m) {
-      if (m->first != 0) {
-        if (cc)
-          body += ",";
-        else
-          cc = true;
+  for (u = a_metrics.begin(); u != a_metrics.end(); ++u) {
+    body.key(u->first).beginObject().key("tot").number(u->second.at(0));
+    body.key("msg").beginObject();
 
-        body += "\"" + to_string(m->first) + "\":" + to_string(m->second);
-      }
+    for (m = u->second.begin(); m != u->second.end(); ++m) {
+      if (m->first != 0)
+        body.key(to_string(m->first)).number(m->second);
     }
-    body += "}}";
+    body.endObject().endObject();
   }
 
-  body += "}}";
+  body.endObject().endObject();
 
   libjson::Value result;
 
-  dbPost("metrics/msg_count/update", {}, &body, result, log_context);
+  dbPost("metrics/msg_count/update", {}, &body.str(), result, log_context);
 }
 
 void DatabaseAPI::metricsPurge(uint32_t a_timestamp, LogContext log_context) {
@@ -3672,21 +4166,22 @@ uint32_t DatabaseAPI::parseSearchRequest(const Auth::SearchRequest &a_request,
                                          std::string &a_qry_begin,
                                          std::string &a_qry_end,
                                          std::string &a_qry_filter,
-                                         std::string &a_params,
+                                         Writer &a_params,
                                          LogContext log_context) {
   string view = (a_request.mode() == SM_DATA ? "dataview" : "collview");
 
+  a_params.beginObject();
+
   if (a_request.has_published() && a_request.published()) {
     a_qry_begin = string("for i in ") + view + " search i.public == true";
     if (a_request.has_owner()) {
       a_qry_begin += " and i.owner == @owner";
-      a_params += ",\"owner\":\"" + a_request.owner() + "\"";
+      a_params.key("owner").string(a_request.owner());
     }
   } else {
     a_qry_begin = string("for i in ") + view + " search i.owner == @owner";
-    a_params += ",\"owner\":\"" +
-                (a_request.has_owner() ? a_request.owner() : m_client_uid) +
-                "\"";
+    a_params.key("owner").string(a_request.has_owner() ? a_request.owner()
+                                                       : m_client_uid);
   }
 
   if (a_request.has_text() > 0) {
@@ -3697,25 +4192,19 @@ uint32_t DatabaseAPI::parseSearchRequest(const Auth::SearchRequest &a_request,
   if (a_request.cat_tags_size() > 0) {
     a_qry_begin += " and @ctags all in i.cat_tags";
 
-    a_params += ",\"ctags\":[";
-    for (int i = 0; i < a_request.cat_tags_size(); ++i) {
-      if (i > 0)
-        a_params += ",";
-      a_params += "\"" + a_request.cat_tags(i) + "\"";
-    }
-    a_params += "]";
+    a_params.key("ctags").beginArray();
+    for (int i = 0; i < a_request.cat_tags_size(); ++i)
+      a_params.string(a_request.cat_tags(i));
+    a_params.endArray();
   }
 
   if (a_request.tags_size() > 0) {
     a_qry_begin += " and @tags all in i.tags";
 
-    a_params += ",\"tags\":[";
-    for (int i = 0; i < a_request.tags_size(); ++i) {
-      if (i > 0)
-        a_params += ",";
-      a_params += "\"" + a_request.tags(i) + "\"";
-    }
-    a_params += "]";
+    a_params.key("tags").beginArray();
+    for (int i = 0; i < a_request.tags_size(); ++i)
+      a_params.string(a_request.tags(i));
+    a_params.endArray();
   }
 
   if (a_request.has_id()) {
@@ -3724,24 +4213,24 @@ uint32_t DatabaseAPI::parseSearchRequest(const Auth::SearchRequest &a_request,
 
   if (a_request.has_creator()) {
     a_qry_begin += " and i.creator == @creator";
-    a_params += ",\"creator\":\"" + a_request.creator() + "\"";
+    a_params.key("creator").string(a_request.creator());
   }
 
   if (a_request.has_from()) {
     a_qry_begin += " and i.ut >= @utfr";
-    a_params += ",\"utfr\":" + to_string(a_request.from());
+    a_params.key("utfr").number(a_request.from());
   }
 
   if (a_request.has_to()) {
     a_qry_begin += " and i.ut <= @utto";
-    a_params += ",\"utto\":" + to_string(a_request.to());
+    a_params.key("utto").number(a_request.to());
   }
 
   // Data-only search options
   if (a_request.mode() == SM_DATA) {
     if (a_request.has_sch_id() > 0) {
       a_qry_begin += " and i.sch_id == @sch";
-      a_params += ",\"sch_id\":\"" + a_request.sch_id() + "\"";
+      a_params.key("sch_id").string(a_request.sch_id());
     }
 
     if (a_request.has_meta_err()) {
@@ -3754,13 +4243,10 @@ uint32_t DatabaseAPI::parseSearchRequest(const Auth::SearchRequest &a_request,
   }
 
   if (a_request.coll_size() > 0) {
-    a_params += ",\"cols\":[";
-    for (int i = 0; i < a_request.coll_size(); i++) {
-      if (i > 0)
-        a_params += ",";
-      a_params += "\"" + a_request.coll(i) + "\"";
-    }
-    a_params += "]";
+    a_params.key("cols").beginArray();
+    for (int i = 0; i < a_request.coll_size(); i++)
+      a_params.string(a_request.coll(i));
+    a_params.endArray();
   }
 
   bool sort_relevance = false;
@@ -3805,11 +4291,9 @@ uint32_t DatabaseAPI::parseSearchRequest(const Auth::SearchRequest &a_request,
   uint32_t cnt = a_request.has_count() ? a_request.count() : 50,
            off = a_request.has_offset() ? a_request.offset() : 0;
 
-  a_params += ",\"off\":" + to_string(off);
-  a_params += ",\"cnt\":" + to_string(cnt);
-
-  // Get rid of leading delimiter
-  a_params[0] = ' ';
+  a_params.key("off").number(off);
+  a_params.key("cnt").number(cnt);
+  a_params.endObject();
 
   a_qry_end +=
       string(" return distinct "
@@ -3817,10 +4301,6 @@ uint32_t DatabaseAPI::parseSearchRequest(const Auth::SearchRequest &a_request,
              "name:name,alias:i.alias") +
       (a_request.mode() == SM_DATA ? ",size:i.size,md_err:i.md_err" : "") + "}";
 
-  a_qry_begin = escapeJSON(a_qry_begin);
-  a_qry_end = escapeJSON(a_qry_end);
-  a_qry_filter = escapeJSON(a_qry_filter);
-
   return cnt;
 }
 
@@ -4,6 +4,7 @@
 
 // Local public includes
 #include "common/DynaLog.hpp"
+#include "common/JsonWriter.hpp"
 #include "common/SDMS.pb.h"
 #include "common/SDMS_Anon.pb.h"
 #include "common/SDMS_Auth.pb.h"
@@ -13,6 +14,8 @@
 #include <curl/curl.h>
 
 // Standard includes
+#include <array>
+#include <chrono>
 #include <memory>
 #include <string>
 #include <vector>
@@ -29,6 +32,48 @@ public:
     uint32_t expiration;
   };
 
+  /**
+   * A DB request recorded by an instance in deferred mode. The transfer is
+   * driven by the owner of the Deferral, which stores the outcome here before
+   * the calling code is run again.
+   **/
+  struct DeferredCall {
+    enum class State { NEW, RUNNING, COMPLETE };
+
+    State state = State::NEW;
+    const char *url_path = nullptr;
+    std::string url;
+    bool post = false;
+    std::string body;
+    std::chrono::steady_clock::time_point start;
+    CURLcode res = CURLE_OK;
+    long http_code = 0;
+    std::string response;
+    std::array<char, CURL_ERROR_SIZE> error{};
+  };
+
+  /**
+   * The DB calls made by one run of some code against a deferred instance.
+   * Calls are matched by order and content when the code is run again, so the
+   * code must issue the same calls in the same order given the same
+   * responses.
+   *
+   * Only the calls made before the code first waits are deferred. Once it has
+   * waited, calls it had not made before are performed blocking, so code is
+   * run at most twice whatever the number of its calls.
+   **/
+  struct Deferral {
+    std::vector<std::unique_ptr<DeferredCall>> calls;
+    size_t next = 0;
+    bool waited = false; ///< Set by the owner once the calls are started
+  };
+
+  /**
+   * Thrown by a DB call of a deferred instance whose response is not known
+   * yet. Deliberately not a std::exception so handlers let it pass.
+   **/
+  struct CallDeferred {};
+
   DatabaseAPI(const std::string &a_db_url, const std::string &a_db_user,
               const std::string &a_db_pass);
   ~DatabaseAPI();
@@ -37,6 +82,24 @@ public:
 
   void setClient(const std::string &a_client);
 
+  /**
+   * Puts the instance in deferred mode, or back in blocking mode if nullptr.
+   * In deferred mode DB calls are recorded in the deferral instead of being
+   * performed, and throw CallDeferred until their response has been stored.
+   **/
+  void setDeferral(Deferral *a_deferral) { m_deferral = a_deferral; }
+
+  /**
+   * Translates listing and record replies straight from the response text
+   * with a pull parser instead of parsing it into a libjson::Value first,
+   * which saves the time and memory of the tree on large replies.
+   **/
+  void setStreamReplies(bool a_stream) { m_stream_replies = a_stream; }
+  /// Borrows a pooled handle and prepares it to perform a deferred call
+  CURL *startDeferred(DeferredCall &a_call);
+  /// Stores the outcome of a deferred call and returns its handle to the pool
+  void finishDeferred(CURL *a_curl, DeferredCall &a_call, CURLcode a_res);
+
   void clientAuthenticateByPassword(const std::string &a_password,
                                     Anon::AuthStatusReply &a_reply,
                                     LogContext log_context);
@@ -45,6 +108,7 @@ public:
                                  LogContext log_context);
   void clientLinkIdentity(const std::string &a_identity,
                           LogContext log_context);
+  /// False if the DB does not know the key, throws if it could not be asked
   bool uidByPubKey(const std::string &a_pub_key, std::string &a_uid);
   bool userGetKeys(std::string &a_pub_key, std::string &a_priv_key,
                    LogContext log_context);
@@ -101,6 +165,11 @@ public:
 
   void recordView(const Auth::RecordViewRequest &a_request,
                   Auth::RecordDataReply &a_reply, LogContext log_context);
+  /// Fetch a record and a schema definition with concurrent DB calls
+  void recordViewWithSchema(const Auth::RecordViewRequest &a_request,
+                            Auth::RecordDataReply &a_reply,
+                            const std::string &a_sch_id,
+                            libjson::Value &a_schema, LogContext log_context);
   void recordCreate(const Auth::RecordCreateRequest &a_request,
                     Auth::RecordDataReply &a_reply, LogContext log_context);
   void recordCreateBatch(const Auth::RecordCreateBatchRequest &a_request,
@@ -321,16 +390,50 @@ public:
   void metricsPurge(uint32_t a_timestamp, LogContext);
 
 private:
+  struct DbGetRequest {
+    const char *url_path;
+    std::vector<std::pair<std::string, std::string>> params;
+    libjson::Value *result;
+  };
+
+  void initHandle(CURL *a_curl);
+  void buildURL(const char *a_url_path,
+                const std::vector<std::pair<std::string, std::string>> &a_params,
+                std::string &a_url) const;
+  long checkResponse(CURL *a_curl, CURLcode a_res,
+                     const std::string &a_res_json, const char *a_error,
+                     libjson::Value &a_result, LogContext log_context);
+  long checkResponse(CURLcode a_res, long a_http_code,
+                     const std::string &a_res_json, const char *a_error,
+                     libjson::Value &a_result, LogContext log_context);
+  bool deferring() const;
+  DeferredCall *deferredCall(const char *a_url_path, const std::string &a_url,
+                             const std::string *a_body, bool a_post);
+  void dbGetConcurrent(std::vector<DbGetRequest> &a_requests, LogContext);
   long dbGet(const char *a_url_path,
              const std::vector<std::pair<std::string, std::string>> &a_params,
              libjson::Value &a_result, LogContext, bool a_log = true);
-  bool
+  /// Returns the HTTP code of the reply, or 0 if none was received
+  long
   dbGetRaw(const char *a_url_path,
            const std::vector<std::pair<std::string, std::string>> &a_params,
            std::string &a_result);
   long dbPost(const char *a_url_path,
               const std::vector<std::pair<std::string, std::string>> &a_params,
               const std::string *a_body, libjson::Value &a_result, LogContext);
+  /// Performs a GET, or a POST given a body, leaving a good reply as text
+  long dbText(const char *a_url_path,
+              const std::vector<std::pair<std::string, std::string>> &a_params,
+              const std::string *a_body, std::string &a_res_json, LogContext);
+  void
+  dbListing(const char *a_url_path,
+            const std::vector<std::pair<std::string, std::string>> &a_params,
+            const std::string *a_body, Auth::ListingReply &a_reply, LogContext);
+  void
+  dbRecord(const char *a_url_path,
+           const std::vector<std::pair<std::string, std::string>> &a_params,
+           const std::string *a_body, Auth::RecordDataReply &a_reply,
+           LogContext);
 
   void setAuthStatus(Anon::AuthStatusReply &a_reply,
                      const libjson::Value &a_result);
@@ -340,6 +443,8 @@ private:
                       const libjson::Value &a_result, LogContext log_context);
   void setRecordData(Auth::RecordDataReply &a_reply,
                      const libjson::Value &a_result, LogContext log_context);
+  void setRecordData(Auth::RecordDataReply &a_reply,
+                     const std::string &a_res_json, LogContext log_context);
   void setCollData(Auth::CollDataReply &a_reply, const libjson::Value &a_result,
                    LogContext log_context);
   void setCollPathData(Auth::CollPathReply &a_reply,
@@ -351,6 +456,11 @@ private:
                            LogContext log_context);
   void setListingData(ListingData *a_item, const libjson::Value::Object &a_obj,
                       LogContext log_context);
+  void setListingDataReply(Auth::ListingReply &a_reply,
+                           const std::string &a_res_json,
+                           LogContext log_context);
+  bool setListingData(ListingData *a_item, libjson::Reader &a_reader,
+                      Auth::ListingReply *a_paging, LogContext log_context);
   void setGroupData(Auth::GroupDataReply &a_reply,
                     const libjson::Value &a_result, LogContext log_context);
   void setACLData(Auth::ACLDataReply &a_reply, const libjson::Value &a_result,
@@ -391,9 +501,10 @@ private:
                           LogContext log_context);
   void setSchemaData(SchemaData *a_schema, const libjson::Value::Object &a_obj);
 
+  /// Writes the bind parameters of the query to a_params as an object
   uint32_t parseSearchRequest(const Auth::SearchRequest &a_request,
                               std::string &a_qry_begin, std::string &a_qry_end,
-                              std::string &a_filter, std::string &a_params,
+                              std::string &a_filter, libjson::Writer &a_params,
                               LogContext log_context);
   std::string parseSearchTextPhrase(const std::string &a_phrase,
                                     const std::string &a_iter);
@@ -406,10 +517,14 @@ private:
   std::string parseSearchIdAlias(const std::string &a_query,
                                  const std::string &a_iter);
 
-  CURL *m_curl;
+  CURL *m_curl; ///< Handle borrowed from DatabaseConnectionPool
   char *m_client;
   std::string m_client_uid;
   std::string m_db_url;
+  std::string m_db_user;
+  std::string m_db_pass;
+  Deferral *m_deferral = nullptr; ///< Set while in deferred mode
+  bool m_stream_replies = false;
 };
 
 } // namespace Core
@@ -0,0 +1,184 @@
+// Local private includes
+#include "DatabaseConnectionPool.hpp"
+
+// Local public includes
+#include "common/SDMS.pb.h"
+#include "common/TraceException.hpp"
+
+// Standard includes
+#include <algorithm>
+
+using namespace std;
+
+namespace SDMS {
+namespace Core {
+
+DatabaseConnectionPool::DatabaseConnectionPool(size_t a_max_idle)
+    : m_max_idle(a_max_idle) {
+  m_share = curl_share_init();
+  if (!m_share)
+    EXCEPT(ID_INTERNAL_ERROR, "libcurl share init failed");
+
+  curl_share_setopt(m_share, CURLSHOPT_LOCKFUNC, lockShare);
+  curl_share_setopt(m_share, CURLSHOPT_UNLOCKFUNC, unlockShare);
+  curl_share_setopt(m_share, CURLSHOPT_USERDATA, this);
+  curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+  curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+  // The connection cache is not shared, libcurl does not support using a
+  // shared one from several threads at once. Each handle keeps its own.
+}
+
+DatabaseConnectionPool::~DatabaseConnectionPool() {
+  for (CURLM *multi : m_idle_multi)
+    curl_multi_cleanup(multi);
+
+  // Easy handles must be released before the share they are attached to
+  for (CURL *curl : m_idle_easy)
+    curl_easy_cleanup(curl);
+
+  curl_share_cleanup(m_share);
+}
+
+void DatabaseConnectionPool::lockShare(CURL *a_curl, curl_lock_data a_data,
+                                       curl_lock_access a_access,
+                                       void *a_user) {
+  (void)a_curl;
+  (void)a_access;
+  static_cast<DatabaseConnectionPool *>(a_user)->m_share_mutex[a_data].lock();
+}
+
+void DatabaseConnectionPool::unlockShare(CURL *a_curl, curl_lock_data a_data,
+                                         void *a_user) {
+  (void)a_curl;
+  static_cast<DatabaseConnectionPool *>(a_user)->m_share_mutex[a_data].unlock();
+}
+
+CURL *DatabaseConnectionPool::acquire() {
+  {
+    lock_guard<mutex> lock(m_pool_mutex);
+    if (m_idle_easy.size()) {
+      CURL *curl = m_idle_easy.back();
+      m_idle_easy.pop_back();
+      return curl;
+    }
+  }
+
+  CURL *curl = curl_easy_init();
+  if (!curl)
+    EXCEPT(ID_INTERNAL_ERROR, "libcurl init failed");
+
+  initHandle(curl);
+
+  return curl;
+}
+
+void DatabaseConnectionPool::initHandle(CURL *a_curl) {
+  curl_easy_setopt(a_curl, CURLOPT_SHARE, m_share);
+  // Handles are used from many threads; never rely on signals for timeouts
+  curl_easy_setopt(a_curl, CURLOPT_NOSIGNAL, 1L);
+  curl_easy_setopt(a_curl, CURLOPT_TCP_KEEPALIVE, 1L);
+  curl_easy_setopt(a_curl, CURLOPT_TCP_KEEPIDLE, 60L);
+  curl_easy_setopt(a_curl, CURLOPT_TCP_KEEPINTVL, 30L);
+}
+
+void DatabaseConnectionPool::release(CURL *a_curl) {
+  if (!a_curl)
+    return;
+
+  // Drop the options of the last request, buffers they point at may be gone.
+  // Open connections and cached sessions are kept.
+  curl_easy_reset(a_curl);
+  initHandle(a_curl);
+
+  {
+    lock_guard<mutex> lock(m_pool_mutex);
+    if (m_idle_easy.size() < m_max_idle) {
+      m_idle_easy.push_back(a_curl);
+      return;
+    }
+  }
+
+  // Pool is full, the handle and its connections are closed
+  curl_easy_cleanup(a_curl);
+}
+
+size_t DatabaseConnectionPool::idleCount() const {
+  lock_guard<mutex> lock(m_pool_mutex);
+  return m_idle_easy.size();
+}
+
+CURLM *DatabaseConnectionPool::acquireMulti() {
+  {
+    lock_guard<mutex> lock(m_pool_mutex);
+    if (m_idle_multi.size()) {
+      CURLM *multi = m_idle_multi.back();
+      m_idle_multi.pop_back();
+      return multi;
+    }
+  }
+
+  CURLM *multi = curl_multi_init();
+  if (!multi)
+    EXCEPT(ID_INTERNAL_ERROR, "libcurl multi init failed");
+
+  return multi;
+}
+
+void DatabaseConnectionPool::releaseMulti(CURLM *a_multi) {
+  {
+    lock_guard<mutex> lock(m_pool_mutex);
+    if (m_idle_multi.size() < m_max_idle) {
+      m_idle_multi.push_back(a_multi);
+      return;
+    }
+  }
+
+  curl_multi_cleanup(a_multi);
+}
+
+void DatabaseConnectionPool::performConcurrent(
+    const vector<CURL *> &a_handles, vector<CURLcode> &a_results) {
+  a_results.assign(a_handles.size(), CURLE_GOT_NOTHING);
+
+  if (a_handles.empty())
+    return;
+
+  CURLM *multi = acquireMulti();
+
+  for (CURL *curl : a_handles)
+    curl_multi_add_handle(multi, curl);
+
+  CURLMcode mc;
+  int running = 0;
+
+  do {
+    mc = curl_multi_perform(multi, &running);
+
+    if (mc == CURLM_OK && running)
+      mc = curl_multi_poll(multi, nullptr, 0, 1000, nullptr);
+  } while (mc == CURLM_OK && running);
+
+  CURLMsg *msg;
+  int msgs_left;
+
+  while ((msg = curl_multi_info_read(multi, &msgs_left))) {
+    if (msg->msg != CURLMSG_DONE)
+      continue;
+
+    auto h = find(a_handles.begin(), a_handles.end(), msg->easy_handle);
+    if (h != a_handles.end())
+      a_results[h - a_handles.begin()] = msg->data.result;
+  }
+
+  for (CURL *curl : a_handles)
+    curl_multi_remove_handle(multi, curl);
+
+  releaseMulti(multi);
+
+  if (mc != CURLM_OK)
+    EXCEPT_PARAM(ID_SERVICE_ERROR,
+                 "SDMS DB interface failed. error: " << curl_multi_strerror(mc));
+}
+
+} // namespace Core
+} // namespace SDMS
@@ -0,0 +1,81 @@
+#ifndef DATABASECONNECTIONPOOL_HPP
+#define DATABASECONNECTIONPOOL_HPP
+#pragma once
+
+// Third party includes
+#include <curl/curl.h>
+
+// Standard includes
+#include <mutex>
+#include <vector>
+
+namespace SDMS {
+namespace Core {
+
+/**
+ * @brief Process-wide pool of libcurl handles used to talk to the Foxx
+ * services of the DataFed ArangoDB database.
+ *
+ * All easy handles handed out by the pool are attached to a single curl share
+ * object so that DNS lookups and TLS sessions are reused by every DatabaseAPI
+ * instance in the process, regardless of which thread created it. Open TCP
+ * connections stay with the handle that made them, as libcurl cannot use a
+ * shared connection cache from several threads at once. Released easy and
+ * multi handles are kept on idle lists instead of being destroyed so that
+ * connection state stays warm between requests.
+ *
+ * NOTE: curl_global_init must be called before the first call to
+ * getInstance().
+ */
+class DatabaseConnectionPool {
+public:
+  static DatabaseConnectionPool &getInstance() {
+    static DatabaseConnectionPool inst;
+    return inst;
+  }
+
+  DatabaseConnectionPool(const DatabaseConnectionPool &) = delete;
+  DatabaseConnectionPool &operator=(const DatabaseConnectionPool &) = delete;
+
+  /// Get an easy handle bound to the shared DNS/TLS caches
+  CURL *acquire();
+  /// Return an easy handle to the pool; per-request options are reset
+  void release(CURL *a_curl);
+
+  /**
+   * @brief Perform several prepared easy handles concurrently.
+   *
+   * Uses a pooled multi handle to drive all transfers in parallel and blocks
+   * until every transfer has completed. The CURLcode of each transfer is
+   * written to a_results in the same order as a_handles.
+   */
+  void performConcurrent(const std::vector<CURL *> &a_handles,
+                         std::vector<CURLcode> &a_results);
+
+  size_t idleCount() const;
+
+private:
+  DatabaseConnectionPool(size_t a_max_idle = 64);
+  ~DatabaseConnectionPool();
+
+  /// Applies the options every pooled handle carries
+  void initHandle(CURL *a_curl);
+  CURLM *acquireMulti();
+  void releaseMulti(CURLM *a_multi);
+
+  static void lockShare(CURL *a_curl, curl_lock_data a_data,
+                        curl_lock_access a_access, void *a_user);
+  static void unlockShare(CURL *a_curl, curl_lock_data a_data, void *a_user);
+
+  CURLSH *m_share;
+  std::mutex m_share_mutex[CURL_LOCK_DATA_LAST];
+  mutable std::mutex m_pool_mutex;
+  std::vector<CURL *> m_idle_easy;
+  std::vector<CURLM *> m_idle_multi;
+  size_t m_max_idle;
+};
+
+} // namespace Core
+} // namespace SDMS
+
+#endif
@@ -0,0 +1,148 @@
+// Local private includes
+#include "DeferredRequests.hpp"
+#include "DatabaseConnectionPool.hpp"
+
+// Local public includes
+#include "common/TraceException.hpp"
+
+// Standard includes
+#include <iterator>
+#include <vector>
+
+using namespace std;
+
+namespace SDMS {
+namespace Core {
+
+DeferredRequests::DeferredRequests(DatabaseAPI &a_db_client, size_t a_capacity,
+                                   LogContext log_context)
+    : m_db_client(a_db_client), m_capacity(a_capacity),
+      m_log_context(log_context), m_multi(curl_multi_init()) {
+  if (m_multi == nullptr) {
+    EXCEPT(1, "Unable to create curl multi handle");
+  }
+}
+
+DeferredRequests::~DeferredRequests() {
+  DatabaseConnectionPool &pool = DatabaseConnectionPool::getInstance();
+  for (auto &transfer : m_transfers) {
+    curl_multi_remove_handle(m_multi, transfer.first);
+    pool.release(transfer.first);
+  }
+  curl_multi_cleanup(m_multi);
+}
+
+void DeferredRequests::start(Run a_run) {
+  m_requests.emplace_back();
+  auto request = std::prev(m_requests.end());
+  request->run = std::move(a_run);
+  if (run(request)) {
+    m_requests.erase(request);
+  }
+}
+
+/**
+ * Runs a request from the start against the deferred DB client. Returns true
+ * if it completed, false if it is waiting for DB calls.
+ */
+bool DeferredRequests::run(std::list<Request>::iterator a_request) {
+  while (true) {
+    a_request->deferral.next = 0;
+    m_db_client.setDeferral(&a_request->deferral);
+    try {
+      a_request->run();
+    } catch (DatabaseAPI::CallDeferred &) {
+      m_db_client.setDeferral(nullptr);
+      a_request->deferral.waited = true;
+      if (startCalls(a_request) == 0) {
+        DL_ERROR(m_log_context, "Deferred request made no new DB call");
+        return true;
+      }
+      if (a_request->running) {
+        return false;
+      }
+      // None of the calls could be started, run again to report the errors
+      continue;
+    } catch (TraceException &e) {
+      DL_ERROR(m_log_context, "Deferred request failed: " << e.toString());
+    } catch (exception &e) {
+      DL_ERROR(m_log_context, "Deferred request failed: " << e.what());
+    } catch (...) {
+      DL_ERROR(m_log_context, "Deferred request failed: unknown exception");
+    }
+    m_db_client.setDeferral(nullptr);
+    return true;
+  }
+}
+
+/// Starts the calls the last run of a request added, returns how many
+size_t DeferredRequests::startCalls(std::list<Request>::iterator a_request) {
+  size_t started = 0;
+  for (auto &call : a_request->deferral.calls) {
+    if (call->state != DatabaseAPI::DeferredCall::State::NEW) {
+      continue;
+    }
+    ++started;
+    CURL *curl = m_db_client.startDeferred(*call);
+    CURLMcode res = curl_multi_add_handle(m_multi, curl);
+    if (res != CURLM_OK) {
+      DL_ERROR(m_log_context, "Unable to start deferred DB call: "
+                                  << curl_multi_strerror(res));
+      m_db_client.finishDeferred(curl, *call, CURLE_FAILED_INIT);
+      continue;
+    }
+    m_transfers[curl] = Transfer{a_request, call.get()};
+    ++a_request->running;
+  }
+
+  // Get the new transfers connecting before waiting on them
+  int running = 0;
+  curl_multi_perform(m_multi, &running);
+  return started;
+}
+
+size_t DeferredRequests::poll(int a_timeout_ms, int a_fd) {
+  if (m_transfers.empty()) {
+    return 0;
+  }
+
+  int running = 0;
+  curl_waitfd extra = {a_fd, CURL_WAIT_POLLIN, 0};
+  curl_multi_poll(m_multi, a_fd < 0 ? nullptr : &extra, a_fd < 0 ? 0 : 1,
+                  a_timeout_ms, nullptr);
+  curl_multi_perform(m_multi, &running);
+
+  vector<std::list<Request>::iterator> ready;
+  int queued = 0;
+  while (CURLMsg *msg = curl_multi_info_read(m_multi, &queued)) {
+    if (msg->msg != CURLMSG_DONE) {
+      continue;
+    }
+    // The message is freed by removing its handle
+    CURL *curl = msg->easy_handle;
+    const CURLcode res = msg->data.result;
+    auto transfer = m_transfers.find(curl);
+    if (transfer == m_transfers.end()) {
+      continue;
+    }
+    curl_multi_remove_handle(m_multi, curl);
+    m_db_client.finishDeferred(curl, *transfer->second.call, res);
+    auto request = transfer->second.request;
+    m_transfers.erase(transfer);
+    if (--request->running == 0) {
+      ready.push_back(request);
+    }
+  }
+
+  size_t completed = 0;
+  for (auto request : ready) {
+    if (run(request)) {
+      m_requests.erase(request);
+      ++completed;
+    }
+  }
+  return completed;
+}
+
+} // namespace Core
+} // namespace SDMS
@@ -0,0 +1,87 @@
+#ifndef DEFERREDREQUESTS_HPP
+#define DEFERREDREQUESTS_HPP
+#pragma once
+
+// Local private includes
+#include "DatabaseAPI.hpp"
+
+// Local public includes
+#include "common/DynaLog.hpp"
+
+// Third party includes
+#include <curl/curl.h>
+
+// Standard includes
+#include <functional>
+#include <list>
+#include <unordered_map>
+
+namespace SDMS {
+namespace Core {
+
+/**
+ * Keeps many client requests waiting on the DB in flight on one thread.
+ *
+ * A request is a function run against a DatabaseAPI instance in deferred
+ * mode. When it makes a DB call whose response is not known yet, the call
+ * throws DatabaseAPI::CallDeferred, the calls it recorded are added to a curl
+ * multi handle, and once they have all completed the function is run again
+ * from the start, this time getting the stored responses. The function must
+ * therefore issue the same DB calls given the same responses, and should do
+ * nothing else that cannot be repeated until its first call has returned,
+ * such as sending its reply. Calls it makes after that are blocking, see
+ * DatabaseAPI::Deferral, so deferring suits requests with a single DB call.
+ *
+ * Not thread safe, owned by the thread that calls poll.
+ **/
+class DeferredRequests {
+public:
+  typedef std::function<void()> Run;
+
+  DeferredRequests(DatabaseAPI &a_db_client, size_t a_capacity,
+                   LogContext log_context);
+  ~DeferredRequests();
+
+  DeferredRequests(const DeferredRequests &) = delete;
+  DeferredRequests &operator=(const DeferredRequests &) = delete;
+
+  /// Runs a request, which either completes now or waits for its DB calls
+  void start(Run a_run);
+
+  /**
+   * Waits up to a_timeout_ms for DB responses, or for a_fd to become readable
+   * if it is not -1, then runs again the requests whose calls have all
+   * completed. Returns the number of requests that completed.
+   **/
+  size_t poll(int a_timeout_ms, int a_fd = -1);
+
+  /// Number of requests waiting on DB calls
+  size_t size() const { return m_requests.size(); }
+  bool full() const { return m_requests.size() >= m_capacity; }
+
+private:
+  struct Request {
+    Run run;
+    DatabaseAPI::Deferral deferral;
+    size_t running = 0; ///< Calls added to the multi handle
+  };
+
+  struct Transfer {
+    std::list<Request>::iterator request;
+    DatabaseAPI::DeferredCall *call;
+  };
+
+  bool run(std::list<Request>::iterator a_request);
+  size_t startCalls(std::list<Request>::iterator a_request);
+
+  DatabaseAPI &m_db_client;
+  size_t m_capacity;
+  LogContext m_log_context;
+  CURLM *m_multi;
+  std::list<Request> m_requests;
+  std::unordered_map<CURL *, Transfer> m_transfers;
+};
+
+} // namespace Core
+} // namespace SDMS
+#endif // DEFERREDREQUESTS_HPP
@@ -460,6 +460,83 @@ bool GlobusAPI::checkTransferStatus(const std::string &a_task_id,
   }
 }
 
+/**
+ * @brief Get the summary status of several transfer tasks in one API call
+ *
+ * @param a_task_ids - Globus task IDs (all owned by the a_acc_tok user)
+ * @param a_acc_tok - Globus access token
+ * @param a_status - Receives status and error message for each task whose
+ * state can be determined from the task summary
+ *
+ * Uses the task_list API with a task_id filter. Tasks that are ACTIVE with
+ * faults, or have an unexpected status, are omitted from a_status and must be
+ * checked individually with checkTransferStatus() so that the event list can
+ * be inspected.
+ */
+void GlobusAPI::checkTransferStatus(
+    const std::vector<std::string> &a_task_ids, const std::string &a_acc_tok,
+    std::map<std::string, std::pair<XfrStatus, std::string>> &a_status) {
+  if (a_task_ids.empty())
+    return;
+
+  string filter = "task_id:";
+  for (vector<string>::const_iterator t = a_task_ids.begin();
+       t != a_task_ids.end(); t++) {
+    if (t != a_task_ids.begin())
+      filter.append(",");
+    filter.append(*t);
+  }
+
+  string raw_result;
+  long code = get(m_curl_xfr, m_config.glob_xfr_url, "task_list", a_acc_tok,
+                  {{"filter", filter},
+                   {"fields", "task_id,status,nice_status,faults"},
+                   {"limit", to_string(a_task_ids.size())}},
+                  raw_result);
+
+  try {
+    if (!raw_result.size())
+      EXCEPT_PARAM(ID_SERVICE_ERROR, "Empty response. Code: " << code);
+
+    Value result;
+
+    result.fromString(raw_result);
+
+    Value::Object &resp_obj = result.asObject();
+
+    checkResponsCode(code, resp_obj);
+
+    Value::Array &arr = resp_obj.getArray("DATA");
+
+    for (Value::ArrayIter i = arr.begin(); i != arr.end(); i++) {
+      Value::Object &tobj = i->asObject();
+      const string &task_id = tobj.getString("task_id");
+      const string &status = tobj.getString("status");
+
+      if (status == "ACTIVE") {
+        if (tobj.getNumber("faults") == 0.0)
+          a_status[task_id] = make_pair(XS_ACTIVE, string());
+      } else if (status == "SUCCEEDED") {
+        a_status[task_id] = make_pair(XS_SUCCEEDED, string());
+      } else if (status == "FAILED" || status == "INACTIVE") {
+        a_status[task_id] = make_pair(XS_FAILED, tobj.getString("nice_status"));
+      }
+    }
+  } catch (libjson::ParseError &e) {
+    DL_ERROR(m_log_context, "PARSE FAILED! " << raw_result);
+    EXCEPT_PARAM(ID_SERVICE_ERROR,
+                 "Globus task list API call returned invalid JSON.");
+  } catch (TraceException &e) {
+    DL_ERROR(m_log_context, raw_result);
+    e.addContext("Globus task list API call failed.");
+    throw;
+  } catch (...) {
+    DL_ERROR(m_log_context, "UNEXPECTED/MISSING JSON! " << raw_result);
+    EXCEPT_PARAM(ID_SERVICE_ERROR,
+                 "Globus task list API call returned unexpected content");
+  }
+}
+
 void GlobusAPI::cancelTask(const std::string &a_task_id,
                            const std::string &a_acc_tok) {
 
@@ -14,6 +14,7 @@
 #include <curl/curl.h>
 
 // Standard includes
+#include <map>
 #include <string>
 #include <vector>
 
@@ -61,6 +62,10 @@ public:
   bool checkTransferStatus(const std::string &a_task_id,
                            const std::string &a_acc_tok, XfrStatus &a_status,
                            std::string &a_err_msg);
+  void checkTransferStatus(
+      const std::vector<std::string> &a_task_ids,
+      const std::string &a_acc_tok,
+      std::map<std::string, std::pair<XfrStatus, std::string>> &a_status);
   void cancelTask(const std::string &a_task_id, const std::string &a_acc_tok);
   void getEndpointInfo(const std::string &a_ep_id,
                        const std::string &a_acc_token, EndpointInfo &a_ep_info);
@@ -0,0 +1,91 @@
+// Local private includes
+#include "Histogram.hpp"
+
+// Standard includes
+#include <cmath>
+
+namespace SDMS {
+namespace Core {
+
+size_t Histogram::bucketIndex(uint64_t value) noexcept {
+  if (value < SUB_BUCKETS) {
+    return value;
+  }
+  const unsigned msb = 63 - __builtin_clzll(value);
+  if (msb >= MAX_VALUE_BITS) {
+    return NUMBER_OF_BUCKETS - 1;
+  }
+  const size_t group = msb - SUB_BUCKET_BITS + 1;
+  const size_t sub_bucket =
+      (value >> (msb - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+  return group * SUB_BUCKETS + sub_bucket;
+}
+
+uint64_t Histogram::bucketUpperBound(size_t index) noexcept {
+  if (index < SUB_BUCKETS) {
+    return index;
+  }
+  const unsigned shift = index / SUB_BUCKETS - 1;
+  const uint64_t lower =
+      static_cast<uint64_t>(SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+  return lower + (uint64_t(1) << shift) - 1;
+}
+
+void Histogram::record(uint64_t value) noexcept {
+  m_buckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+  m_count.fetch_add(1, std::memory_order_relaxed);
+  m_sum.fetch_add(value, std::memory_order_relaxed);
+  uint64_t max = m_max.load(std::memory_order_relaxed);
+  while (value > max &&
+         !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+  }
+}
+
+uint64_t Histogram::percentile(double percent) const noexcept {
+  const uint64_t total = count();
+  if (total == 0) {
+    return 0;
+  }
+  uint64_t target = static_cast<uint64_t>(std::ceil(total * percent / 100.0));
+  if (target == 0) {
+    target = 1;
+  }
+  uint64_t seen = 0;
+  for (size_t i = 0; i < NUMBER_OF_BUCKETS; ++i) {
+    seen += m_buckets[i].load(std::memory_order_relaxed);
+    if (seen >= target) {
+      // Never report more than the largest value actually recorded
+      const uint64_t upper = bucketUpperBound(i);
+      return upper < max() ? upper : max();
+    }
+  }
+  return max();
+}
+
+void Histogram::merge(const Histogram &other) noexcept {
+  for (size_t i = 0; i < NUMBER_OF_BUCKETS; ++i) {
+    const uint64_t bucket = other.m_buckets[i].load(std::memory_order_relaxed);
+    if (bucket) {
+      m_buckets[i].fetch_add(bucket, std::memory_order_relaxed);
+    }
+  }
+  m_count.fetch_add(other.count(), std::memory_order_relaxed);
+  m_sum.fetch_add(other.sum(), std::memory_order_relaxed);
+  const uint64_t other_max = other.max();
+  uint64_t max = m_max.load(std::memory_order_relaxed);
+  while (other_max > max && !m_max.compare_exchange_weak(
+                                max, other_max, std::memory_order_relaxed)) {
+  }
+}
+
+void Histogram::reset() noexcept {
+  for (std::atomic<uint64_t> &bucket : m_buckets) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+  m_count.store(0, std::memory_order_relaxed);
+  m_sum.store(0, std::memory_order_relaxed);
+  m_max.store(0, std::memory_order_relaxed);
+}
+
+} // namespace Core
+} // namespace SDMS
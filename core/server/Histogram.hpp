@@ -0,0 +1,73 @@
+#ifndef HISTOGRAM_HPP
+#define HISTOGRAM_HPP
+#pragma once
+
+// Standard includes
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace SDMS {
+namespace Core {
+
+/**
+ * Lock free histogram of unsigned values, such as latencies in microseconds
+ * or sizes in bytes.
+ *
+ * Values are counted in log linear buckets in the manner of an HDR histogram,
+ * every power of two is split into 8 equal sub buckets, so a percentile is
+ * reported with at most 12.5% relative error regardless of magnitude. Values
+ * of 2^40 or more are counted in the last bucket.
+ *
+ * record can be called from any number of threads, it is a handful of relaxed
+ * atomic increments. Readers see a consistent enough snapshot for reporting.
+ **/
+class Histogram {
+public:
+  static const unsigned SUB_BUCKET_BITS = 3;
+  static const unsigned SUB_BUCKETS = 1u << SUB_BUCKET_BITS;
+  static const unsigned MAX_VALUE_BITS = 40;
+  static const size_t NUMBER_OF_BUCKETS =
+      (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+  Histogram() = default;
+  Histogram(const Histogram &) = delete;
+  Histogram &operator=(const Histogram &) = delete;
+
+  void record(uint64_t value) noexcept;
+
+  uint64_t count() const noexcept {
+    return m_count.load(std::memory_order_relaxed);
+  }
+  uint64_t sum() const noexcept {
+    return m_sum.load(std::memory_order_relaxed);
+  }
+  uint64_t max() const noexcept {
+    return m_max.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Returns the upper bound of the bucket holding the value at the given
+   *percentile, between 0 and 100, or 0 if nothing has been recorded.
+   **/
+  uint64_t percentile(double percent) const noexcept;
+
+  /// Adds the counts of another histogram to this one
+  void merge(const Histogram &other) noexcept;
+  void reset() noexcept;
+
+  static size_t bucketIndex(uint64_t value) noexcept;
+  /// Largest value counted in the bucket
+  static uint64_t bucketUpperBound(size_t index) noexcept;
+
+private:
+  std::array<std::atomic<uint64_t>, NUMBER_OF_BUCKETS> m_buckets{};
+  std::atomic<uint64_t> m_count{0};
+  std::atomic<uint64_t> m_sum{0};
+  std::atomic<uint64_t> m_max{0};
+};
+
+} // namespace Core
+} // namespace SDMS
+#endif // HISTOGRAM_HPP
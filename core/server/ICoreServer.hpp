@@ -2,10 +2,14 @@
 #define ICORESERVER_HPP
 #pragma once
 
+// Local private includes
+#include "MsgCountShard.hpp"
+
 // Common public libraries
 #include "common/DynaLog.hpp"
 
 // Standard includes
+#include <memory>
 #include <string>
 
 namespace SDMS {
@@ -17,8 +21,13 @@ public:
                                   const std::string &a_key,
                                   const std::string &a_uid,
                                   LogContext log_context) = 0;
-  virtual void metricsUpdateMsgCount(const std::string &a_uid,
-                                     uint16_t a_msg_type) = 0;
+  /// Called when a key is revoked, connections using it are looked up again
+  virtual void revokeClientKey(const std::string &a_key) = 0;
+  /// Called when a user key is generated so a cached miss is not served
+  virtual void invalidateClientKey(const std::string &a_key) = 0;
+  /// Message counts of the client worker on channel a_tid, merged by the
+  /// server. A worker restarted on the same channel gets the same shard.
+  virtual std::shared_ptr<MsgCountShard> getMsgCountShard(size_t a_tid) = 0;
 };
 
 } // namespace Core
@@ -31,7 +31,8 @@ public:
 
   struct Task {
     Task(const std::string &a_id)
-        : task_id(a_id), cancel(false), retry_count(0) {}
+        : task_id(a_id), cancel(false), retry_count(0), resume(false),
+          resume_step(0) {}
 
     ~Task() {}
 
@@ -40,13 +41,22 @@ public:
     uint32_t retry_count;
     timepoint_t retry_time;
     timepoint_t retry_fail_time;
+    timepoint_t ready_time; ///< Last placed on the ready queue
+    bool resume;            ///< Step finished outside of a worker (transfer)
+    int resume_step;        ///< Step to report as complete on resume
+    std::string resume_err; ///< Error to report instead of step on resume
   };
 
+  /// Blocks until a task is ready, returns none once the worker is retired
   virtual std::unique_ptr<Task> getNextTask(ITaskWorker *a_worker) = 0;
   virtual bool retryTask(std::unique_ptr<Task> a_task,
                          LogContext log_context) = 0;
   virtual void newTasks(const libjson::Value &a_tasks,
                         LogContext log_context) = 0;
+  virtual void monitorTransfer(std::unique_ptr<Task> a_task, int a_step,
+                               const std::string &a_xfr_task_id,
+                               const std::string &a_acc_tok,
+                               LogContext log_context) = 0;
 };
 
 } // namespace Core
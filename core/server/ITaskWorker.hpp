@@ -19,7 +19,8 @@ namespace Core {
 class ITaskWorker {
 public:
   ITaskWorker(uint32_t a_id, LogContext log_context)
-      : m_id(a_id), m_run(false), m_next(0), m_log_context(log_context) {}
+      : m_id(a_id), m_run(false), m_retire(false), m_next(0),
+        m_log_context(log_context) {}
 
   virtual ~ITaskWorker() {}
 
@@ -28,6 +29,7 @@ public:
 private:
   uint32_t m_id;
   bool m_run;
+  bool m_retire; ///< Set to have getNextTask return no task
   ITaskWorker *m_next;
   LogContext m_log_context;
   // ITaskWorker *               m_prev;
@@ -0,0 +1,144 @@
+// Local private includes
+#include "MetricsRegistry.hpp"
+
+// Local public includes
+#include "common/TraceException.hpp"
+
+// Standard includes
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+
+using namespace std;
+
+namespace SDMS {
+namespace Core {
+
+namespace {
+
+const double QUANTILES[] = {0.5, 0.99, 0.999};
+
+std::string escapeLabel(const std::string &value) {
+  std::string escaped;
+  escaped.reserve(value.size());
+  for (char c : value) {
+    if (c == '\\' || c == '"') {
+      escaped += '\\';
+      escaped += c;
+    } else if (c == '\n') {
+      escaped += "\\n";
+    } else {
+      escaped += c;
+    }
+  }
+  return escaped;
+}
+
+} // namespace
+
+MetricsRegistry::Family &
+MetricsRegistry::family(const MetricFamily &description) {
+  Family &family = m_families[description.name];
+  family.description = &description;
+  return family;
+}
+
+Histogram &MetricsRegistry::histogram(const MetricFamily &description,
+                                      const std::string &label) {
+  {
+    shared_lock<shared_mutex> lock(m_mutex);
+    auto family = m_families.find(description.name);
+    if (family != m_families.end()) {
+      auto found = family->second.histograms.find(label);
+      if (found != family->second.histograms.end()) {
+        return *found->second;
+      }
+    }
+  }
+  unique_lock<shared_mutex> lock(m_mutex);
+  std::unique_ptr<Histogram> &histogram =
+      family(description).histograms[label];
+  if (!histogram) {
+    histogram = std::make_unique<Histogram>();
+  }
+  return *histogram;
+}
+
+std::atomic<uint64_t> &
+MetricsRegistry::counter(const MetricFamily &description,
+                         const std::string &label) {
+  {
+    shared_lock<shared_mutex> lock(m_mutex);
+    auto family = m_families.find(description.name);
+    if (family != m_families.end()) {
+      auto found = family->second.counters.find(label);
+      if (found != family->second.counters.end()) {
+        return *found->second;
+      }
+    }
+  }
+  unique_lock<shared_mutex> lock(m_mutex);
+  std::unique_ptr<std::atomic<uint64_t>> &counter =
+      family(description).counters[label];
+  if (!counter) {
+    counter = std::make_unique<std::atomic<uint64_t>>(0);
+  }
+  return *counter;
+}
+
+void MetricsRegistry::writePrometheus(std::ostream &out) const {
+  shared_lock<shared_mutex> lock(m_mutex);
+  for (const auto &entry : m_families) {
+    const Family &family = entry.second;
+    const MetricFamily &description = *family.description;
+    const std::string name = description.name;
+
+    out << "# HELP " << name << " " << description.help << "\n";
+    if (description.kind == MetricFamily::Kind::COUNTER) {
+      out << "# TYPE " << name << " counter\n";
+      for (const auto &counter : family.counters) {
+        out << name << "{" << description.label << "=\""
+            << escapeLabel(counter.first)
+            << "\"} " << counter.second->load(memory_order_relaxed) << "\n";
+      }
+      continue;
+    }
+
+    out << "# TYPE " << name << " summary\n";
+    for (const auto &histogram : family.histograms) {
+      const std::string label = std::string(description.label) + "=\"" +
+                                escapeLabel(histogram.first) + "\"";
+      for (double quantile : QUANTILES) {
+        out << name << "{" << label << ",quantile=\"" << quantile << "\"} "
+            << histogram.second->percentile(quantile * 100) *
+                   description.scale
+            << "\n";
+      }
+      out << name << "_sum{" << label << "} "
+          << histogram.second->sum() * description.scale << "\n";
+      out << name << "_count{" << label << "} " << histogram.second->count()
+          << "\n";
+    }
+  }
+}
+
+void MetricsRegistry::writePrometheusFile(const std::string &path) const {
+  const std::string temp_path = path + ".tmp";
+  {
+    std::ofstream out(temp_path, std::ios::trunc);
+    if (!out.is_open()) {
+      EXCEPT_PARAM(1, "Unable to open metrics file: " << temp_path);
+    }
+    writePrometheus(out);
+    out.close();
+    if (out.fail()) {
+      EXCEPT_PARAM(1, "Unable to write metrics file: " << temp_path);
+    }
+  }
+  if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+    EXCEPT_PARAM(1, "Unable to rename metrics file to: " << path);
+  }
+}
+
+} // namespace Core
+} // namespace SDMS
@@ -0,0 +1,119 @@
+#ifndef METRICSREGISTRY_HPP
+#define METRICSREGISTRY_HPP
+#pragma once
+
+// Local private includes
+#include "Histogram.hpp"
+
+// Standard includes
+#include <atomic>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <shared_mutex>
+#include <string>
+
+namespace SDMS {
+namespace Core {
+
+/**
+ * Describes a family of metrics, one histogram or counter per label value.
+ * Histograms are reported as Prometheus summaries, recorded values are
+ * multiplied by scale when written, e.g. microseconds to seconds.
+ **/
+struct MetricFamily {
+  enum class Kind { SUMMARY, COUNTER };
+
+  const char *name;
+  const char *label;
+  const char *help;
+  Kind kind;
+  double scale;
+};
+
+namespace metrics {
+const MetricFamily HANDLER_DURATION = {
+    "datafed_core_handler_duration_seconds", "type",
+    "Time spent by client workers handling a message type",
+    MetricFamily::Kind::SUMMARY, 1e-6};
+const MetricFamily HANDLER_REQUEST_SIZE = {
+    "datafed_core_handler_request_bytes", "type",
+    "Size of the request payloads of a message type",
+    MetricFamily::Kind::SUMMARY, 1};
+const MetricFamily HANDLER_ERRORS = {
+    "datafed_core_handler_errors_total", "type",
+    "Messages of a type answered with a NackReply", MetricFamily::Kind::COUNTER,
+    1};
+const MetricFamily DB_DURATION = {
+    "datafed_core_db_request_duration_seconds", "route",
+    "Time spent waiting on a Foxx route of the database",
+    MetricFamily::Kind::SUMMARY, 1e-6};
+const MetricFamily DB_ERRORS = {
+    "datafed_core_db_request_errors_total", "route",
+    "Requests to a Foxx route that failed or returned an error status",
+    MetricFamily::Kind::COUNTER, 1};
+const MetricFamily REPO_DURATION = {
+    "datafed_core_repo_request_duration_seconds", "repo",
+    "Round trip time of requests sent to a repository server",
+    MetricFamily::Kind::SUMMARY, 1e-6};
+const MetricFamily REPO_ERRORS = {
+    "datafed_core_repo_request_errors_total", "repo",
+    "Requests to a repository server that timed out or failed",
+    MetricFamily::Kind::COUNTER, 1};
+} // namespace metrics
+
+/**
+ * Process wide registry of the latency histograms and error counters of the
+ * core server.
+ *
+ * Looking a metric up takes a shared lock, so callers on hot paths should
+ * look it up once and keep the reference, which remains valid for the life of
+ * the process. Recording into a metric never takes a lock.
+ **/
+class MetricsRegistry {
+public:
+  static MetricsRegistry &getInstance() {
+    static MetricsRegistry inst;
+    return inst;
+  }
+
+  MetricsRegistry(const MetricsRegistry &) = delete;
+  MetricsRegistry &operator=(const MetricsRegistry &) = delete;
+
+  /// Histogram of a SUMMARY family for the label value, created on first use
+  Histogram &histogram(const MetricFamily &family, const std::string &label);
+  /// Counter of a COUNTER family for the label value, created on first use
+  std::atomic<uint64_t> &counter(const MetricFamily &family,
+                                 const std::string &label);
+
+  /**
+   * Writes every metric in the Prometheus text exposition format, summaries
+   *report the 0.5, 0.99 and 0.999 quantiles.
+   **/
+  void writePrometheus(std::ostream &out) const;
+
+  /**
+   * Writes the metrics to a temporary file and renames it over path, so a
+   *reader such as the node exporter textfile collector never sees a partial
+   *file. Throws if the file cannot be written.
+   **/
+  void writePrometheusFile(const std::string &path) const;
+
+private:
+  MetricsRegistry() {}
+
+  struct Family {
+    const MetricFamily *description = nullptr;
+    std::map<std::string, std::unique_ptr<Histogram>> histograms;
+    std::map<std::string, std::unique_ptr<std::atomic<uint64_t>>> counters;
+  };
+
+  Family &family(const MetricFamily &description);
+
+  mutable std::shared_mutex m_mutex;
+  std::map<std::string, Family> m_families;
+};
+
+} // namespace Core
+} // namespace SDMS
+#endif // METRICSREGISTRY_HPP
@@ -0,0 +1,41 @@
+// Local private includes
+#include "MsgCountShard.hpp"
+
+using namespace std;
+
+namespace SDMS {
+namespace Core {
+
+void MsgCountShard::increment(const std::string &a_uid, uint16_t a_msg_type) {
+  lock_guard<mutex> lock(m_mutex);
+  auto uid = m_uid_ids.find(a_uid);
+  if (uid == m_uid_ids.end()) {
+    uid = m_uid_ids.emplace(a_uid, uint32_t(m_uids.size())).first;
+    m_uids.push_back(&uid->first);
+  }
+  ++m_counts[key(uid->second, a_msg_type)];
+}
+
+void MsgCountShard::drainInto(std::map<std::string, MsgMetrics_t> &a_metrics) {
+  lock_guard<mutex> lock(m_mutex);
+  for (auto entry = m_counts.begin(); entry != m_counts.end();) {
+    if (entry->second == 0) {
+      entry = m_counts.erase(entry);
+      continue;
+    }
+    const std::string &uid = *m_uids[entry->first >> 16];
+    a_metrics[uid][uint16_t(entry->first & 0xFFFF)] += entry->second;
+    entry->second = 0;
+    ++entry;
+  }
+
+  // Interned ids stay valid as long as a count refers to them
+  if (m_counts.empty() || m_uids.size() > MAX_INTERNED_UIDS) {
+    m_counts.clear();
+    m_uid_ids.clear();
+    m_uids.clear();
+  }
+}
+
+} // namespace Core
+} // namespace SDMS
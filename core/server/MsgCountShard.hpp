@@ -0,0 +1,57 @@
+#ifndef MSGCOUNTSHARD_HPP
+#define MSGCOUNTSHARD_HPP
+#pragma once
+
+// Standard includes
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace SDMS {
+namespace Core {
+
+/// Message request metrics - maps message type to count per metrics period
+typedef std::map<uint16_t, uint32_t> MsgMetrics_t;
+
+/**
+ * Message counts of a single client worker for the current metrics period.
+ *
+ * Each worker increments its own shard so workers never contend with each
+ * other. The lock of the shard is only ever contended by the metrics thread
+ * when it drains the shard at the end of a period.
+ *
+ * UIDs are interned to a small integer the first time they are seen, so a
+ * count is a single lookup keyed by the interned UID and the message type.
+ * Entries are kept across periods, so a busy client does not allocate on
+ * every period, and are dropped once they sit idle for a whole period.
+ **/
+class MsgCountShard {
+public:
+  /// Interned UIDs are forgotten when more than this many accumulate
+  static const size_t MAX_INTERNED_UIDS = 4096;
+
+  void increment(const std::string &a_uid, uint16_t a_msg_type);
+
+  /**
+   * Adds the counts of the period to a_metrics, keyed by UID then message
+   * type, and starts a new period.
+   **/
+  void drainInto(std::map<std::string, MsgMetrics_t> &a_metrics);
+
+private:
+  static uint64_t key(uint32_t a_uid_id, uint16_t a_msg_type) {
+    return (uint64_t(a_uid_id) << 16) | a_msg_type;
+  }
+
+  std::mutex m_mutex;
+  std::unordered_map<std::string, uint32_t> m_uid_ids;
+  std::vector<const std::string *> m_uids; ///< Interned id to UID
+  std::unordered_map<uint64_t, uint32_t> m_counts;
+};
+
+} // namespace Core
+} // namespace SDMS
+#endif // MSGCOUNTSHARD_HPP
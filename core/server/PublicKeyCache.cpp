@@ -0,0 +1,69 @@
+// Local private includes
+#include "PublicKeyCache.hpp"
+
+// Standard includes
+#include <iterator>
+#include <mutex>
+
+using namespace std;
+
+namespace SDMS {
+namespace Core {
+
+bool PublicKeyCache::lookup(const std::string &public_key, bool &found,
+                            std::string &uid) const {
+  shared_lock<shared_mutex> lock(m_mutex);
+  auto it = m_entries.find(public_key);
+  if (it == m_entries.end() || it->second.expiration_time <= time(0)) {
+    return false;
+  }
+  found = it->second.found;
+  if (found) {
+    uid = it->second.uid;
+  }
+  return true;
+}
+
+void PublicKeyCache::insert(const std::string &public_key, bool found,
+                            const std::string &uid) {
+  if (m_capacity == 0) {
+    return;
+  }
+  const time_t expiration_time =
+      time(0) + (found ? m_found_ttl : m_missing_ttl);
+
+  unique_lock<shared_mutex> lock(m_mutex);
+  auto it = m_entries.find(public_key);
+  if (it != m_entries.end()) {
+    // Refreshed entries move to the back of the eviction order
+    m_order.splice(m_order.end(), m_order, it->second.order);
+  } else {
+    if (m_entries.size() >= m_capacity) {
+      m_entries.erase(m_order.front());
+      m_order.pop_front();
+    }
+    m_order.push_back(public_key);
+    it = m_entries.emplace(public_key, Entry()).first;
+    it->second.order = std::prev(m_order.end());
+  }
+  it->second.uid = found ? uid : "";
+  it->second.found = found;
+  it->second.expiration_time = expiration_time;
+}
+
+void PublicKeyCache::invalidate(const std::string &public_key) {
+  unique_lock<shared_mutex> lock(m_mutex);
+  auto it = m_entries.find(public_key);
+  if (it != m_entries.end()) {
+    m_order.erase(it->second.order);
+    m_entries.erase(it);
+  }
+}
+
+size_t PublicKeyCache::size() const {
+  shared_lock<shared_mutex> lock(m_mutex);
+  return m_entries.size();
+}
+
+} // namespace Core
+} // namespace SDMS
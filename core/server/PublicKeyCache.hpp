@@ -0,0 +1,69 @@
+#ifndef PUBLICKEYCACHE_HPP
+#define PUBLICKEYCACHE_HPP
+#pragma once
+
+// Standard includes
+#include <ctime>
+#include <list>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+namespace SDMS {
+namespace Core {
+
+/**
+ * Bounded cache of persistent user key lookups made against the database.
+ *
+ * Both outcomes are cached, keys that map to a user for found_ttl seconds and
+ * keys that are unknown for missing_ttl seconds, so clients presenting an
+ * unknown key do not cause a database request per message. Entries are
+ * evicted oldest first once the capacity is reached, and must be invalidated
+ * explicitly when a user key is generated or revoked.
+ **/
+class PublicKeyCache {
+public:
+  PublicKeyCache(size_t capacity = 10000, time_t found_ttl = 300,
+                 time_t missing_ttl = 60)
+      : m_capacity(capacity), m_found_ttl(found_ttl),
+        m_missing_ttl(missing_ttl){};
+
+  PublicKeyCache(const PublicKeyCache &) = delete;
+  PublicKeyCache &operator=(const PublicKeyCache &) = delete;
+
+  /**
+   * Returns true if the key has an entry that has not expired. found is set to
+   *whether the key maps to a user, in which case uid is set as well.
+   **/
+  bool lookup(const std::string &public_key, bool &found,
+              std::string &uid) const;
+
+  /// Records the result of a database lookup, uid is ignored if not found
+  void insert(const std::string &public_key, bool found,
+              const std::string &uid);
+
+  void invalidate(const std::string &public_key);
+
+  size_t size() const;
+
+private:
+  struct Entry {
+    std::string uid;
+    bool found = false;
+    time_t expiration_time = 0;
+    std::list<std::string>::iterator order;
+  };
+
+  size_t m_capacity;
+  time_t m_found_ttl;
+  time_t m_missing_ttl;
+
+  mutable std::shared_mutex m_mutex;
+  std::unordered_map<std::string, Entry> m_entries;
+  /// Keys in the order they were inserted, oldest first
+  std::list<std::string> m_order;
+};
+
+} // namespace Core
+} // namespace SDMS
+#endif // PUBLICKEYCACHE_HPP
@@ -0,0 +1,109 @@
+// Local private includes
+#include "RepoCommunicatorPool.hpp"
+#include "Config.hpp"
+
+// Common public includes
+#include "common/CommunicatorFactory.hpp"
+#include "common/CredentialFactory.hpp"
+#include "common/SocketOptions.hpp"
+
+// Standard includes
+#include <unordered_map>
+
+using namespace std;
+
+namespace SDMS {
+namespace Core {
+
+RepoCommunicatorPool::RepoCommunicatorPool(const std::string &a_client_id)
+    : m_client_id(a_client_id),
+      m_repo_generation(Config::getInstance().repoCacheGeneration()) {}
+
+/**
+ * @brief Get the connection to a repo server, connecting if needed
+ *
+ * If the repo cache was invalidated since the last call, all connections are
+ * dropped first so that repo address or key changes take effect.
+ */
+ICommunicator &RepoCommunicatorPool::get(const RepoData &a_repo,
+                                         LogContext log_context) {
+  uint64_t generation = Config::getInstance().repoCacheGeneration();
+
+  if (generation != m_repo_generation) {
+    DL_DEBUG(log_context, "Repo cache invalidated, dropping "
+                              << m_comms.size() << " repo connections");
+    clear();
+    m_repo_generation = generation;
+  }
+
+  unique_ptr<ICommunicator> &comm = m_comms[key(a_repo)];
+
+  if (!comm) {
+    DL_DEBUG(log_context, "Opening connection to repo " << a_repo.id() << " at "
+                                                        << a_repo.address());
+    comm = create(a_repo, log_context);
+  }
+
+  return *comm;
+}
+
+void RepoCommunicatorPool::discard(const RepoData &a_repo) {
+  m_comms.erase(key(a_repo));
+}
+
+void RepoCommunicatorPool::clear() { m_comms.clear(); }
+
+std::string RepoCommunicatorPool::key(const RepoData &a_repo) const {
+  return a_repo.id() + "|" + a_repo.address() + "|" + a_repo.pub_key();
+}
+
+std::unique_ptr<ICommunicator>
+RepoCommunicatorPool::create(const RepoData &a_repo,
+                             LogContext log_context) const {
+  Config &config = Config::getInstance();
+  AddressSplitter splitter(a_repo.address());
+
+  /// Creating input parameters for constructing Communication Instance
+  SocketOptions socket_options;
+  socket_options.scheme = URIScheme::TCP;
+  socket_options.class_type = SocketClassType::CLIENT;
+  socket_options.direction_type = SocketDirectionalityType::BIDIRECTIONAL;
+  socket_options.communication_type = SocketCommunicationType::ASYNCHRONOUS;
+  socket_options.connection_life = SocketConnectionLife::INTERMITTENT;
+  socket_options.connection_security = SocketConnectionSecurity::SECURE;
+  socket_options.protocol_type = ProtocolType::ZQTP;
+  socket_options.host = splitter.host();
+  socket_options.port = splitter.port();
+  socket_options.local_id = m_client_id;
+  socket_options.heartbeat_interval = 10000;
+
+  CredentialFactory cred_factory;
+
+  std::unordered_map<CredentialType, std::string> cred_options;
+  cred_options[CredentialType::PUBLIC_KEY] =
+      config.sec_ctx->get(CredentialType::PUBLIC_KEY);
+  cred_options[CredentialType::PRIVATE_KEY] =
+      config.sec_ctx->get(CredentialType::PRIVATE_KEY);
+  // Cannot grab the public key from sec_ctx because we have several repos to
+  // pick from
+  cred_options[CredentialType::SERVER_KEY] = a_repo.pub_key();
+
+  DL_TRACE(log_context, "Core server client to repo server public key "
+                            << cred_options[CredentialType::PUBLIC_KEY]);
+  DL_TRACE(log_context, "Core server client to repo server Repo public key "
+                            << cred_options[CredentialType::SERVER_KEY]);
+  auto credentials = cred_factory.create(ProtocolType::ZQTP, cred_options);
+
+  uint32_t timeout_on_receive = config.repo_timeout;
+  long timeout_on_poll = config.repo_timeout;
+
+  // When creating a communication channel with a server application we need
+  // to locally have a client socket. So though we have specified a client
+  // socket we will actually be communicating with the server.
+  CommunicatorFactory communicator_factory(log_context);
+  return communicator_factory.create(socket_options, *credentials,
+                                     timeout_on_receive, timeout_on_poll);
+}
+
+} // namespace Core
+} // namespace SDMS
@@ -0,0 +1,53 @@
+#ifndef REPOCOMMUNICATORPOOL_HPP
+#define REPOCOMMUNICATORPOOL_HPP
+#pragma once
+
+// Local public includes
+#include "common/DynaLog.hpp"
+#include "common/ICommunicator.hpp"
+#include "common/SDMS.pb.h"
+
+// Standard includes
+#include <map>
+#include <memory>
+#include <string>
+
+namespace SDMS {
+namespace Core {
+
+/**
+ * @brief Keeps one open, authenticated connection per repository server
+ *
+ * Connections are keyed by repo ID, address and public key, so a change to
+ * any of these results in a new connection. Sockets exchange heartbeats with
+ * the repo server and ZeroMQ transparently reconnects them if the peer
+ * restarts. A connection that times out or errors must be dropped with
+ * discard() so that late replies are never matched to a new request. All
+ * connections are dropped when the repo cache is invalidated via
+ * Config::triggerRepoCacheRefresh().
+ *
+ * A pool is owned by a single TaskWorker and is not thread safe; the worker
+ * ID is used as the socket identity seen by the repo server.
+ */
+class RepoCommunicatorPool {
+public:
+  explicit RepoCommunicatorPool(const std::string &a_client_id);
+
+  ICommunicator &get(const RepoData &a_repo, LogContext log_context);
+  void discard(const RepoData &a_repo);
+  void clear();
+
+private:
+  std::string key(const RepoData &a_repo) const;
+  std::unique_ptr<ICommunicator> create(const RepoData &a_repo,
+                                        LogContext log_context) const;
+
+  std::string m_client_id;
+  uint64_t m_repo_generation;
+  std::map<std::string, std::unique_ptr<ICommunicator>> m_comms;
+};
+
+} // namespace Core
+} // namespace SDMS
+
+#endif
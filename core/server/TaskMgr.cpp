@@ -7,6 +7,7 @@
 
 // Local public includes
 #include "common/DynaLog.hpp"
+#include "common/PoolScaler.hpp"
 #include "common/SDMS.pb.h"
 #include "common/TraceException.hpp"
 #include "common/libjson.hpp"
@@ -32,6 +33,10 @@ void TaskMgr::initialize(LogContext log_context) {
   m_maint_thread = new thread(&TaskMgr::maintenanceThread, this, m_log_context,
                               m_thread_count);
 
+  ++m_thread_count;
+  m_xfr_thread = new thread(&TaskMgr::transferMonitorThread, this,
+                            m_log_context, m_thread_count);
+
   unique_lock<mutex> lock(m_worker_mutex);
 
   /*
@@ -74,9 +79,16 @@ void TaskMgr::initialize(LogContext log_context) {
   }
 
   m_worker_next = m_workers.front();
+  m_next_worker_id = m_config.num_task_worker_threads;
 
   lock.unlock();
 
+  if (m_config.max_task_worker_threads > m_config.num_task_worker_threads) {
+    ++m_thread_count;
+    m_scale_thread = new thread(&TaskMgr::poolScalingThread, this,
+                                m_log_context, m_thread_count);
+  }
+
   // Load ready & running tasks and schedule workers
   // TODO This will break if there are too many tasks - must implement a paging
   // system to load chunks of tasks.
@@ -87,12 +99,28 @@ void TaskMgr::initialize(LogContext log_context) {
 }
 
 TaskMgr::TaskMgr(LogContext log_context)
-    : m_config(Config::getInstance()), m_worker_next(0), m_maint_thread(0) {
+    : m_config(Config::getInstance()), m_worker_next(0), m_maint_thread(0),
+      m_xfr_monitor(chrono::seconds(m_config.task_xfr_poll_period),
+                    [this](std::unique_ptr<Task> a_task,
+                           LogContext log_context) {
+                      lock_guard<mutex> lock(m_worker_mutex);
+                      resumeTaskAndScheduleWorker(std::move(a_task),
+                                                  log_context);
+                    }),
+      m_xfr_thread(0), m_scale_thread(0) {
   initialize(log_context);
 }
 
 TaskMgr::TaskMgr()
-    : m_config(Config::getInstance()), m_worker_next(0), m_maint_thread(0) {
+    : m_config(Config::getInstance()), m_worker_next(0), m_maint_thread(0),
+      m_xfr_monitor(chrono::seconds(m_config.task_xfr_poll_period),
+                    [this](std::unique_ptr<Task> a_task,
+                           LogContext log_context) {
+                      lock_guard<mutex> lock(m_worker_mutex);
+                      resumeTaskAndScheduleWorker(std::move(a_task),
+                                                  log_context);
+                    }),
+      m_xfr_thread(0), m_scale_thread(0) {
   LogContext log_context;
   initialize(log_context);
 }
@@ -216,6 +244,22 @@ void TaskMgr::maintenanceThread(LogContext log_context, int thread_id) {
   }
 }
 
+/**
+ * @brief Globus transfer monitor thread
+ *
+ * Polls the status of all Globus transfers submitted by task workers. Due
+ * transfers are polled as a batch - one task_list call per user access token,
+ * with individual status checks only for transfers that report faults. When a
+ * transfer finishes, its task is placed back on the ready queue to be resumed
+ * by the next available worker. The polling itself is done by TransferMonitor.
+ */
+void TaskMgr::transferMonitorThread(LogContext log_context, int thread_id) {
+  log_context.thread_name += "-transferMonitorThread";
+  log_context.thread_id = thread_id;
+
+  m_xfr_monitor.run(log_context);
+}
+
 void TaskMgr::purgeTaskHistory(LogContext log_context) const {
   try {
     DatabaseAPI db(m_config.db_url, m_config.db_user, m_config.db_pass);
@@ -289,6 +333,7 @@ void TaskMgr::addNewTaskAndScheduleWorker(const std::string &a_task_id,
 
   DL_DEBUG(log_context, "Adding task " << a_task_id);
   m_tasks_ready.push_back(std::make_unique<Task>(a_task_id));
+  m_tasks_ready.back()->ready_time = chrono::system_clock::now();
 
   if (m_worker_next) {
     DL_DEBUG(log_context, "Waking task worker " << m_worker_next->id());
@@ -302,6 +347,7 @@ void TaskMgr::retryTaskAndScheduleWorker(std::unique_ptr<Task> a_task,
                                          LogContext log_context) {
   DL_DEBUG(log_context, "Retrying task " << a_task->task_id);
   m_tasks_ready.push_back(std::move(a_task));
+  m_tasks_ready.back()->ready_time = chrono::system_clock::now();
 
   if (m_worker_next) {
     DL_DEBUG(log_context, "Waking task worker " << m_worker_next->id());
@@ -311,6 +357,34 @@ void TaskMgr::retryTaskAndScheduleWorker(std::unique_ptr<Task> a_task,
   }
 }
 
+/**
+ * @brief Place a task whose current step completed outside of a worker back
+ * on the ready queue
+ *
+ * NOTE: must be called with m_worker_mutex held by caller
+ */
+void TaskMgr::resumeTaskAndScheduleWorker(std::unique_ptr<Task> a_task,
+                                          LogContext log_context) {
+  DL_DEBUG(log_context, "Resuming task " << a_task->task_id);
+  m_tasks_ready.push_back(std::move(a_task));
+  m_tasks_ready.back()->ready_time = chrono::system_clock::now();
+
+  wakeNextWorker();
+}
+
+/**
+ * @brief Wake the next idle worker, if any
+ *
+ * NOTE: must be called with m_worker_mutex held by caller
+ */
+void TaskMgr::wakeNextWorker() {
+  if (m_worker_next) {
+    m_worker_next->m_run = true;
+    m_worker_next->m_cvar.notify_one();
+    m_worker_next = m_worker_next->m_next ? m_worker_next->m_next : 0;
+  }
+}
+
 void TaskMgr::cancelTask(const std::string &a_task_id, LogContext log_context) {
   DL_WARNING(log_context,
              "TaskMgr cancel task (NOT IMPLEMENTED) " << a_task_id);
@@ -372,10 +446,14 @@ std::unique_ptr<TaskMgr::Task> TaskMgr::getNextTask(ITaskWorker *a_worker) {
     m_worker_next = a_worker;
 
     // Sleep until work available, run flag suppresses spurious wakes
-    while (m_tasks_ready.empty() || !a_worker->m_run)
+    while (!a_worker->m_retire && (m_tasks_ready.empty() || !a_worker->m_run))
       a_worker->m_cvar.wait(lock);
   }
 
+  if (a_worker->m_retire) {
+    return nullptr;
+  }
+
   // Pop next task from ready queue and place in running map
   DL_DEBUG(log_context,
            "There are " << m_tasks_ready.size() << " grabbing one.");
@@ -386,6 +464,83 @@ std::unique_ptr<TaskMgr::Task> TaskMgr::getNextTask(ITaskWorker *a_worker) {
   return task;
 }
 
+/**
+ * @brief Task worker pool scaling thread
+ *
+ * Samples the pool every second, adding a worker while tasks wait for one
+ * and retiring an idle worker once the pool has been mostly idle for a while.
+ */
+void TaskMgr::poolScalingThread(LogContext log_context, int thread_id) {
+  log_context.thread_name += "-poolScalingThread";
+  log_context.thread_id = thread_id;
+
+  PoolScaler::Options options;
+  options.min_workers = m_config.num_task_worker_threads;
+  options.max_workers = m_config.max_task_worker_threads;
+  PoolScaler scaler(options);
+
+  while (1) {
+    this_thread::sleep_for(chrono::seconds(1));
+
+    unique_lock<mutex> lock(m_worker_mutex);
+
+    size_t idle = 0;
+    for (ITaskWorker *worker = m_worker_next; worker; worker = worker->m_next)
+      ++idle;
+    const size_t workers = m_workers.size();
+    const double busy_ratio = static_cast<double>(workers - idle) / workers;
+    chrono::steady_clock::duration queue_wait(0);
+    if (!m_tasks_ready.empty()) {
+      queue_wait = chrono::duration_cast<chrono::steady_clock::duration>(
+          chrono::system_clock::now() - m_tasks_ready.front()->ready_time);
+    }
+    const size_t target = scaler.sample(workers, busy_ratio, queue_wait);
+
+    ITaskWorker *retired = 0;
+    if (target > workers) {
+      m_workers.push_back(
+          new TaskWorker(*this, m_next_worker_id++, m_log_context));
+    } else if (target < workers && m_worker_next) {
+      retired = m_worker_next;
+      m_worker_next = retired->m_next;
+      retired->m_retire = true;
+      retired->m_cvar.notify_one();
+      m_workers.erase(find(m_workers.begin(), m_workers.end(), retired));
+    } else {
+      continue;
+    }
+
+    DL_INFO(log_context, "Task worker pool resized from "
+                             << workers << " to " << m_workers.size());
+    lock.unlock();
+
+    // The retired worker needs the lock to leave getNextTask
+    delete retired;
+  }
+}
+
+/**
+ * @brief Hand a task waiting on a Globus transfer to the transfer monitor
+ *
+ * @param a_task - task to monitor
+ * @param a_step - task step that submitted the transfer
+ * @param a_xfr_task_id - Globus transfer task ID
+ * @param a_acc_tok - Globus access token of the task owner
+ *
+ * Called by task workers after submitting a transfer so that the worker can
+ * move on to other tasks. The task is resumed at a_step once the transfer
+ * succeeds or fails.
+ */
+void TaskMgr::monitorTransfer(std::unique_ptr<Task> a_task, int a_step,
+                              const std::string &a_xfr_task_id,
+                              const std::string &a_acc_tok,
+                              LogContext log_context) {
+  DL_DEBUG(log_context, "Monitoring transfer " << a_xfr_task_id << " for task "
+                                               << a_task->task_id);
+
+  m_xfr_monitor.add(std::move(a_task), a_step, a_xfr_task_id, a_acc_tok);
+}
+
 /**
  * @brief Submit a task with a transient failure for later retry
  *
@@ -6,6 +6,7 @@
 #include "Config.hpp"
 #include "ITaskMgr.hpp"
 #include "ITaskWorker.hpp"
+#include "TransferMonitor.hpp"
 
 // Local public includes
 #include "common/SDMS.pb.h"
@@ -45,13 +46,20 @@ private:
   std::unique_ptr<Task> getNextTask(ITaskWorker *a_worker);
   bool retryTask(std::unique_ptr<Task> a_task, LogContext log_context);
   void newTasks(const libjson::Value &a_tasks, LogContext log_context);
+  void monitorTransfer(std::unique_ptr<Task> a_task, int a_step,
+                       const std::string &a_xfr_task_id,
+                       const std::string &a_acc_tok, LogContext log_context);
 
   // Private methods
   void maintenanceThread(LogContext, int);
+  void transferMonitorThread(LogContext, int);
+  void poolScalingThread(LogContext, int);
   void addNewTaskAndScheduleWorker(const std::string &a_task_id,
                                    LogContext log_context);
   void retryTaskAndScheduleWorker(std::unique_ptr<Task> a_task,
                                   LogContext log_context);
+  void resumeTaskAndScheduleWorker(std::unique_ptr<Task> a_task,
+                                   LogContext log_context);
   void wakeNextWorker();
   void purgeTaskHistory(LogContext log_context) const;
 
@@ -64,6 +72,11 @@ private:
   std::thread *m_maint_thread;
   std::mutex m_maint_mutex;
   std::condition_variable m_maint_cvar;
+  TransferMonitor m_xfr_monitor;
+  std::thread *m_xfr_thread;
+  std::thread *m_scale_thread;
+  /// IDs of workers added by the scaling thread, never reused
+  uint32_t m_next_worker_id = 0;
   LogContext m_log_context;
   int m_thread_count = 0;
 
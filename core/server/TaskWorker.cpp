@@ -3,18 +3,17 @@
 #include "TaskWorker.hpp"
 #include "Config.hpp"
 #include "ITaskMgr.hpp"
+#include "MetricsRegistry.hpp"
 
 // Common public includes
-#include "common/CommunicatorFactory.hpp"
-#include "common/CredentialFactory.hpp"
 #include "common/DynaLog.hpp"
 #include "common/ICommunicator.hpp"
 #include "common/IMessage.hpp"
 #include "common/MessageFactory.hpp"
-#include "common/SocketOptions.hpp"
 
 // Standard includes
 #include "unistd.h"
+#include <chrono>
 #include <memory>
 #include <sstream>
 
@@ -31,7 +30,8 @@ TaskWorker::TaskWorker(ITaskMgr &a_mgr, uint32_t a_worker_id,
                        LogContext log_context)
     : ITaskWorker(a_worker_id, log_context), m_mgr(a_mgr),
       m_db(Config::getInstance().db_url, Config::getInstance().db_user,
-           Config::getInstance().db_pass) {
+           Config::getInstance().db_pass),
+      m_repo_comms("task_worker-" + std::to_string(a_worker_id)) {
 
   log_context.thread_name += "-TaskWorker";
   log_context.thread_id = a_worker_id;
@@ -71,10 +71,22 @@ void TaskWorker::workerThread(LogContext log_context) {
   while (m_running) {
     DL_DEBUG(log_context, "Grabbing next task");
     std::unique_ptr<ITaskMgr::Task> m_task = m_mgr.getNextTask(this);
+    if (!m_task) {
+      // Retired by the TaskMgr
+      break;
+    }
 
     err_msg.clear();
     first = true;
 
+    if (m_task->resume) {
+      // Current step was completed by the transfer monitor, report outcome
+      first = false;
+      step = m_task->resume_step;
+      err_msg = m_task->resume_err;
+      m_task->resume = false;
+    }
+
     while (true) {
       try {
         if (first) {
@@ -104,6 +116,15 @@ void TaskWorker::workerThread(LogContext log_context) {
                    "TASK_ID: " << m_task->task_id << ", Step: " << step);
           response = m_execute[cmd](*this, params, log_context);
 
+          if (m_xfr_task_id.size()) {
+            // Transfer submitted - TaskMgr monitors it and resumes the task
+            // when done, so this worker is free to take another task
+            m_mgr.monitorTransfer(std::move(m_task), step, m_xfr_task_id,
+                                  m_xfr_acc_tok, log_context);
+            m_xfr_task_id.clear();
+            m_xfr_acc_tok.clear();
+            break;
+          }
         } else if (cmd == TC_STOP) {
           DL_DEBUG(log_context, "TASK_ID: " << m_task->task_id
                                             << ", STOP at step: " << step);
@@ -238,25 +259,10 @@ TaskWorker::cmdRawDataTransfer(TaskWorker &me, const Value &a_task_params,
     DL_TRACE(log_context, "Begin transfer of " << files_v.size() << " files");
     string glob_task_id =
         me.m_glob.transfer(src_ep, dst_ep, files_v, encrypted, acc_tok);
-    // Monitor Globus transfer
-
-    GlobusAPI::XfrStatus xfr_status;
-    string err_msg;
 
-    do {
-      sleep(5);
-
-      if (me.m_glob.checkTransferStatus(glob_task_id, acc_tok, xfr_status,
-                                        err_msg)) {
-        // Transfer task needs to be cancelled
-        DL_DEBUG(log_context, "Cancelling task: " << glob_task_id);
-        me.m_glob.cancelTask(glob_task_id, acc_tok);
-      }
-    } while (xfr_status < GlobusAPI::XS_SUCCEEDED);
-
-    if (xfr_status == GlobusAPI::XS_FAILED) {
-      EXCEPT(1, err_msg);
-    }
+    // Globus transfer is monitored by TaskMgr, see workerThread
+    me.m_xfr_task_id = glob_task_id;
+    me.m_xfr_acc_tok = acc_tok;
   } else {
     DL_DEBUG(log_context, "No files to transfer");
   }
@@ -507,92 +513,43 @@ TaskWorker::repoSendRecv(const string &a_repo_id,
                         << a_repo_id
                         << " Registered repos are: " << registered_repos);
   }
-  // Need to be able to split repos into host and scheme and port
-  const std::string client_id = [&]() {
-    std::stringstream ss;
-    ss << "task_worker-";
-    ss << id();
-    std::string str;
-    ss >> str;
-    return str;
-  }();
+  const RepoData &repo = repos.at(a_repo_id);
+  bool reply_received = false;
+
+  MetricsRegistry &metrics = MetricsRegistry::getInstance();
+  std::atomic<uint64_t> &errors =
+      metrics.counter(metrics::REPO_ERRORS, a_repo_id);
 
   try {
+    ICommunicator &client = m_repo_comms.get(repo, log_context);
 
-    auto client =
-        [&](const std::string &repo_address, const std::string &repo_pub_key,
-            const std::string &socket_id, LogContext log_context) {
-          AddressSplitter splitter(repo_address);
-
-          /// Creating input parameters for constructing Communication Instance
-          SocketOptions socket_options;
-          socket_options.scheme = splitter.scheme();
-          socket_options.scheme = URIScheme::TCP;
-          socket_options.class_type = SocketClassType::CLIENT;
-          socket_options.direction_type =
-              SocketDirectionalityType::BIDIRECTIONAL;
-          socket_options.communication_type =
-              SocketCommunicationType::ASYNCHRONOUS;
-          socket_options.connection_life = SocketConnectionLife::INTERMITTENT;
-          socket_options.connection_security = SocketConnectionSecurity::SECURE;
-          socket_options.protocol_type = ProtocolType::ZQTP;
-          socket_options.host = splitter.host();
-          socket_options.port = splitter.port();
-          socket_options.local_id = socket_id;
-
-          CredentialFactory cred_factory;
-
-          std::unordered_map<CredentialType, std::string> cred_options;
-          cred_options[CredentialType::PUBLIC_KEY] =
-              config.sec_ctx->get(CredentialType::PUBLIC_KEY);
-          cred_options[CredentialType::PRIVATE_KEY] =
-              config.sec_ctx->get(CredentialType::PRIVATE_KEY);
-          // Cannot grab the public key from sec_ctx because we have several
-          // repos to pick from
-          // cred_options[CredentialType::SERVER_KEY] =
-          // config.sec_ctx->get(CredentialType::SERVER_KEY);
-          cred_options[CredentialType::SERVER_KEY] = repo_pub_key;
-
-          DL_TRACE(log_context,
-                   "Core server client to repo server public key "
-                       << cred_options[CredentialType::PUBLIC_KEY]);
-          DL_TRACE(log_context,
-                   "Core server client to repo server private key "
-                       << cred_options[CredentialType::PRIVATE_KEY]);
-          DL_TRACE(log_context,
-                   "Core server client to repo server Repo public key "
-                       << cred_options[CredentialType::SERVER_KEY]);
-          auto credentials =
-              cred_factory.create(ProtocolType::ZQTP, cred_options);
-
-          uint32_t timeout_on_receive = Config::getInstance().repo_timeout;
-          long timeout_on_poll = Config::getInstance().repo_timeout;
-
-          // When creating a communication channel with a server application we
-          // need to locally have a client socket. So though we have specified a
-          // client socket we will actually be communicating with the server.
-          CommunicatorFactory communicator_factory(log_context);
-          return communicator_factory.create(socket_options, *credentials,
-                                             timeout_on_receive,
-                                             timeout_on_poll);
-        }(repos.at(a_repo_id).address(), repos.at(a_repo_id).pub_key(),
-          client_id, log_context); // Pass the address into the lambda
-
-    client->send(*a_msg);
+    const auto start = std::chrono::steady_clock::now();
+    client.send(*a_msg);
 
     ICommunicator::Response response =
-        client->receive(MessageType::GOOGLE_PROTOCOL_BUFFER);
+        client.receive(MessageType::GOOGLE_PROTOCOL_BUFFER);
+    metrics.histogram(metrics::REPO_DURATION, a_repo_id)
+        .record(std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start)
+                    .count());
     if (response.time_out) {
       DL_ERROR(log_context, "Timeout waiting for response from "
                                 << a_repo_id << " address "
-                                << client->address());
+                                << client.address());
+      // Drop connection so a late reply can't be taken for the next one
+      m_repo_comms.discard(repo);
+      errors.fetch_add(1, std::memory_order_relaxed);
       return response;
     } else if (response.error) {
       DL_ERROR(log_context, "Error while waiting for response from "
                                 << a_repo_id << " " << response.error_msg);
+      m_repo_comms.discard(repo);
+      errors.fetch_add(1, std::memory_order_relaxed);
       return response;
     }
 
+    reply_received = true;
+
     auto proto_msg =
         std::get<google::protobuf::Message *>(response.message->getPayload());
     auto nack = dynamic_cast<Anon::NackReply *>(proto_msg);
@@ -606,6 +563,9 @@ TaskWorker::repoSendRecv(const string &a_repo_id,
     return response;
 
   } catch (TraceException &e) {
+    if (!reply_received)
+      m_repo_comms.discard(repo);
+    errors.fetch_add(1, std::memory_order_relaxed);
 
     DL_ERROR(log_context,
              "Caught exception in repo communication logic: " << e.what());
@@ -7,6 +7,7 @@
 #include "GlobusAPI.hpp"
 #include "ITaskMgr.hpp"
 #include "ITaskWorker.hpp"
+#include "RepoCommunicatorPool.hpp"
 
 // Common public includes
 #include "common/ICommunicator.hpp"
@@ -68,6 +69,9 @@ private:
   ITaskMgr::Task *m_task;
   DatabaseAPI m_db;
   GlobusAPI m_glob;
+  std::string m_xfr_task_id; ///< Transfer submitted by current step, if any
+  std::string m_xfr_acc_tok;
+  RepoCommunicatorPool m_repo_comms; ///< Open connections to repo servers
   std::atomic<bool> m_running = true;
 };
 
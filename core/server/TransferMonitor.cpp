@@ -0,0 +1,182 @@
+// Local private includes
+#include "TransferMonitor.hpp"
+
+// Local public includes
+#include "common/TraceException.hpp"
+
+// Standard includes
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+namespace SDMS {
+namespace Core {
+
+TransferMonitor::TransferMonitor(duration_t a_poll_period, Resume a_resume)
+    : m_poll_period(a_poll_period), m_resume(std::move(a_resume)) {}
+
+void TransferMonitor::add(std::unique_ptr<Task> a_task, int a_step,
+                          const std::string &a_xfr_task_id,
+                          const std::string &a_acc_tok) {
+  auto xfr = std::make_unique<Transfer>();
+  xfr->task = std::move(a_task);
+  xfr->step = a_step;
+  xfr->xfr_task_id = a_xfr_task_id;
+  xfr->acc_tok = a_acc_tok;
+
+  lock_guard<mutex> lock(m_mutex);
+
+  m_active.insert(
+      make_pair(chrono::system_clock::now() + m_poll_period, std::move(xfr)));
+  m_cvar.notify_one();
+}
+
+void TransferMonitor::stop() {
+  lock_guard<mutex> lock(m_mutex);
+
+  m_stop = true;
+  m_cvar.notify_one();
+}
+
+size_t TransferMonitor::size() const {
+  lock_guard<mutex> lock(m_mutex);
+
+  return m_active.size();
+}
+
+void TransferMonitor::run(LogContext log_context) {
+  const size_t batch_size = 50;
+  GlobusAPI glob(log_context);
+  vector<std::unique_ptr<Transfer>> due;
+  vector<std::unique_ptr<Transfer>> active;
+  map<string, vector<Transfer *>> by_token;
+  StatusMap status;
+  timepoint_t now;
+  unique_lock<mutex> lock(m_mutex);
+
+  while (!m_stop) {
+    if (m_active.empty())
+      m_cvar.wait(lock);
+    else
+      m_cvar.wait_until(lock, m_active.begin()->first);
+
+    if (m_stop)
+      break;
+
+    now = chrono::system_clock::now();
+
+    for (auto x = m_active.begin(); x != m_active.end() && x->first <= now;) {
+      due.push_back(std::move(x->second));
+      x = m_active.erase(x);
+    }
+
+    if (due.empty())
+      continue;
+
+    DL_DEBUG(log_context, "XFR: polling " << due.size() << " of "
+                                          << (due.size() + m_active.size())
+                                          << " transfers");
+
+    lock.unlock();
+
+    for (auto &x : due)
+      by_token[x->acc_tok].push_back(x.get());
+
+    for (auto &tok : by_token) {
+      for (size_t i = 0; i < tok.second.size(); i += batch_size) {
+        vector<string> ids;
+
+        for (size_t j = i; j < min(i + batch_size, tok.second.size()); j++)
+          ids.push_back(tok.second[j]->xfr_task_id);
+
+        try {
+          glob.checkTransferStatus(ids, tok.first, status);
+        } catch (TraceException &e) {
+          // Fall back to checking transfers individually
+          DL_WARNING(log_context,
+                     "XFR: batch status check failed - " << e.toString());
+        }
+      }
+    }
+
+    for (auto &x : due) {
+      if (!poll(glob, *x, status, log_context))
+        active.push_back(std::move(x));
+    }
+
+    due.clear();
+    by_token.clear();
+    status.clear();
+
+    lock.lock();
+
+    now = chrono::system_clock::now();
+
+    for (auto &x : active)
+      m_active.insert(make_pair(now + m_poll_period, std::move(x)));
+
+    active.clear();
+  }
+}
+
+/**
+ * @brief Check one transfer and resume its task if finished
+ *
+ * @return True if the transfer is finished and the task was resumed, false
+ * if the transfer is still active.
+ */
+bool TransferMonitor::poll(GlobusAPI &a_glob, Transfer &a_xfr,
+                           const StatusMap &a_status, LogContext log_context) {
+  GlobusAPI::XfrStatus xfr_status;
+  string err_msg;
+
+  try {
+    auto s = a_status.find(a_xfr.xfr_task_id);
+
+    if (s != a_status.end()) {
+      xfr_status = s->second.first;
+      err_msg = s->second.second;
+
+      if (xfr_status == GlobusAPI::XS_FAILED) {
+        DL_DEBUG(log_context, "Cancelling task: " << a_xfr.xfr_task_id);
+        a_glob.cancelTask(a_xfr.xfr_task_id, a_xfr.acc_tok);
+      }
+    } else if (a_glob.checkTransferStatus(a_xfr.xfr_task_id, a_xfr.acc_tok,
+                                          xfr_status, err_msg)) {
+      // Transfer task needs to be cancelled
+      DL_DEBUG(log_context, "Cancelling task: " << a_xfr.xfr_task_id);
+      a_glob.cancelTask(a_xfr.xfr_task_id, a_xfr.acc_tok);
+    }
+  } catch (TraceException &e) {
+    xfr_status = GlobusAPI::XS_FAILED;
+    err_msg = e.toString();
+  } catch (exception &e) {
+    xfr_status = GlobusAPI::XS_FAILED;
+    err_msg = e.what();
+  }
+
+  if (xfr_status < GlobusAPI::XS_SUCCEEDED)
+    return false;
+
+  DL_DEBUG(log_context, "XFR: transfer " << a_xfr.xfr_task_id << " for task "
+                                         << a_xfr.task->task_id << " "
+                                         << (xfr_status == GlobusAPI::XS_FAILED
+                                                 ? "failed"
+                                                 : "succeeded"));
+
+  a_xfr.task->resume = true;
+  a_xfr.task->resume_step = a_xfr.step;
+  if (xfr_status == GlobusAPI::XS_FAILED)
+    a_xfr.task->resume_err =
+        err_msg.size() ? err_msg : "Globus transfer failed.";
+  else
+    a_xfr.task->resume_err.clear();
+
+  m_resume(std::move(a_xfr.task), log_context);
+
+  return true;
+}
+
+} // namespace Core
+} // namespace SDMS
@@ -0,0 +1,86 @@
+#ifndef TRANSFERMONITOR_HPP
+#define TRANSFERMONITOR_HPP
+#pragma once
+
+// Local private includes
+#include "GlobusAPI.hpp"
+#include "ITaskMgr.hpp"
+
+// Local public includes
+#include "common/DynaLog.hpp"
+
+// Standard includes
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace SDMS {
+namespace Core {
+
+/**
+ * @brief Polls the Globus transfers that tasks are blocked on
+ *
+ * Transfers are polled every poll period. Due transfers are polled as a batch,
+ * with one task_list call per user access token and individual status checks
+ * only for transfers that report faults. When a transfer finishes its task is
+ * flagged for resume and handed back through the resume callback.
+ *
+ * run() is the loop of the thread that polls, the other methods may be called
+ * from any thread.
+ */
+class TransferMonitor {
+public:
+  typedef ITaskMgr::Task Task;
+  typedef ITaskMgr::timepoint_t timepoint_t;
+  typedef ITaskMgr::duration_t duration_t;
+  /// Takes back the task of a finished transfer, called by the polling thread
+  typedef std::function<void(std::unique_ptr<Task>, LogContext)> Resume;
+
+  TransferMonitor(duration_t a_poll_period, Resume a_resume);
+
+  TransferMonitor(const TransferMonitor &) = delete;
+  TransferMonitor &operator=(const TransferMonitor &) = delete;
+
+  /// Monitors the transfer a task is blocked on, first polled after a period
+  void add(std::unique_ptr<Task> a_task, int a_step,
+           const std::string &a_xfr_task_id, const std::string &a_acc_tok);
+
+  /// Polls due transfers until stop() is called
+  void run(LogContext log_context);
+
+  /// Makes run() return once the poll in progress, if any, is done
+  void stop();
+
+  /// Number of transfers waiting for their next poll
+  size_t size() const;
+
+private:
+  typedef std::map<std::string, std::pair<GlobusAPI::XfrStatus, std::string>>
+      StatusMap;
+
+  struct Transfer {
+    std::unique_ptr<Task> task;
+    int step;
+    std::string xfr_task_id;
+    std::string acc_tok;
+  };
+
+  bool poll(GlobusAPI &a_glob, Transfer &a_xfr, const StatusMap &a_status,
+            LogContext log_context);
+
+  duration_t m_poll_period;
+  Resume m_resume;
+  std::multimap<timepoint_t, std::unique_ptr<Transfer>> m_active;
+  bool m_stop = false;
+  mutable std::mutex m_mutex;
+  std::condition_variable m_cvar;
+};
+
+} // namespace Core
+} // namespace SDMS
+
+#endif
@@ -45,6 +45,9 @@ int main(int a_argc, char **a_argv) {
     Core::Config &config = Core::Config::getInstance();
     string cfg_file;
     bool gen_keys = false;
+    bool log_async = false;
+    bool log_json = false;
+    string log_overflow = "count";
 
     po::options_description opts("Options");
 
@@ -67,20 +70,45 @@ int main(int a_argc, char **a_argv) {
                          "Task purge age (seconds)")(
         "task-purge-per", po::value<uint32_t>(&config.task_purge_period),
         "Task purge period (seconds)")(
+        "task-xfr-poll-per", po::value<uint32_t>(&config.task_xfr_poll_period),
+        "Globus transfer status poll period (seconds)")(
         "metrics-per", po::value<uint32_t>(&config.metrics_period),
         "Metrics update period (seconds)")(
         "metrics-purge-per", po::value<uint32_t>(&config.metrics_purge_period),
         "Metrics purge period (seconds)")(
         "metrics-purge-age", po::value<uint32_t>(&config.metrics_purge_age),
         "Metrics purge age (seconds)")(
+        "metrics-file", po::value<string>(&config.metrics_file),
+        "Write latency metrics to file in Prometheus text format")(
+        "metrics-file-per", po::value<uint32_t>(&config.metrics_file_period),
+        "Metrics file write period (seconds)")(
         "client-threads",
         po::value<uint32_t>(&config.num_client_worker_threads),
         "Number of client worker threads")(
+        "client-threads-max",
+        po::value<uint32_t>(&config.max_client_worker_threads),
+        "Maximum number of client worker threads under load")(
+        "client-requests",
+        po::value<uint32_t>(&config.num_client_worker_requests),
+        "Number of requests each client worker keeps in flight on the DB")(
         "task-threads", po::value<uint32_t>(&config.num_task_worker_threads),
-        "Number of task worker threads")("cfg", po::value<string>(&cfg_file),
-                                         "Use config file for options")(
+        "Number of task worker threads")(
+        "task-threads-max",
+        po::value<uint32_t>(&config.max_task_worker_threads),
+        "Maximum number of task worker threads under load")(
+        "db-max-connections", po::value<uint32_t>(&config.db_max_connections),
+        "Maximum number of DB connections held by worker threads")(
+        "db-stream-replies", po::bool_switch(&config.db_stream_replies),
+        "Translate large DB replies as they are parsed")(
+        "cfg", po::value<string>(&cfg_file), "Use config file for options")(
         "gen-keys", po::bool_switch(&gen_keys),
-        "Generate new server keys then exit");
+        "Generate new server keys then exit")(
+        "log-async", po::bool_switch(&log_async),
+        "Write log messages from a background thread")(
+        "log-overflow", po::value<string>(&log_overflow),
+        "Full async log queue policy: block, drop or count (default)")(
+        "log-json", po::bool_switch(&log_json),
+        "Write log messages as JSON objects");
 
     try {
       po::variables_map opt_map;
@@ -147,6 +175,23 @@ int main(int a_argc, char **a_argv) {
 
         return 0;
       }
+
+      if (log_json) {
+        global_logger.setFormat(LogFormat::JSON);
+      }
+
+      if (log_async) {
+        LogOverflowPolicy policy = LogOverflowPolicy::COUNT_DROPPED;
+        if (log_overflow == "block") {
+          policy = LogOverflowPolicy::BLOCK;
+        } else if (log_overflow == "drop") {
+          policy = LogOverflowPolicy::DROP;
+        } else if (log_overflow != "count") {
+          EXCEPT_PARAM(ID_CLIENT_ERROR,
+                       "Invalid log overflow policy: " << log_overflow);
+        }
+        global_logger.startAsync(8192, policy);
+      }
     } catch (po::unknown_option &e) {
       DL_ERROR(log_context, "Options error: " << e.what());
       return 1;
@@ -0,0 +1,147 @@
+// Local private includes
+#include "AuthMap.hpp"
+
+// Standard includes
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace SDMS::Core;
+
+/**
+ * Measures key to uid resolution while many threads authenticate messages at
+ * once. The baseline reproduces the previous AuthMap, a std::map behind a
+ * single mutex probed once by hasKey, once by incrementKeyAccessCounter and
+ * once by getUID. The sharded AuthMap resolves the key, type and access count
+ * with a single find under a shard read lock.
+ *
+ * Usage: benchmark_AuthMap [lookups per thread] [threads] [keys]
+ **/
+
+namespace {
+
+std::atomic<size_t> g_sink{0};
+
+/// Z85 keys are 40 characters, pad the index out to that length
+std::string makeKey(size_t i) {
+  std::string key = std::to_string(i);
+  key.insert(0, PublicKey::MAX_SIZE - key.size(), 'k');
+  return key;
+}
+
+class SingleMutexMap {
+public:
+  struct Element {
+    std::string uid;
+    size_t access_count = 0;
+  };
+
+  void addKey(const std::string &key, const std::string &uid) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_clients[key] = Element{uid, 0};
+  }
+
+  bool hasKey(const std::string &key) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_clients.count(key);
+  }
+
+  void incrementKeyAccessCounter(const std::string &key) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_clients.find(key);
+    if (it != m_clients.end()) {
+      ++it->second.access_count;
+    }
+  }
+
+  std::string getUID(const std::string &key) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_clients.at(key).uid;
+  }
+
+private:
+  mutable std::mutex m_mutex;
+  std::map<std::string, Element> m_clients;
+};
+
+void run(const std::string &name, size_t lookups, size_t threads,
+         const std::vector<std::string> &keys,
+         const std::function<size_t(const std::string &)> &lookup) {
+  std::vector<std::thread> workers;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t t = 0; t < threads; ++t) {
+    workers.emplace_back([&, t]() {
+      size_t found = 0;
+      for (size_t i = 0; i < lookups; ++i) {
+        found += lookup(keys[(i * 7919 + t * 104729) % keys.size()]);
+      }
+      g_sink += found;
+    });
+  }
+  for (std::thread &worker : workers) {
+    worker.join();
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::cout << name << ": "
+            << static_cast<size_t>(lookups * threads / elapsed.count())
+            << " lookups/s" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  size_t lookups = 1000000;
+  size_t threads = std::max(2u, std::thread::hardware_concurrency());
+  size_t number_of_keys = 1000;
+  if (argc > 1) {
+    lookups = std::strtoul(argv[1], nullptr, 10);
+  }
+  if (argc > 2) {
+    threads = std::strtoul(argv[2], nullptr, 10);
+  }
+  if (argc > 3) {
+    number_of_keys = std::strtoul(argv[3], nullptr, 10);
+  }
+  std::cout << threads << " threads, " << number_of_keys << " keys"
+            << std::endl;
+
+  std::vector<std::string> keys;
+  SingleMutexMap baseline;
+  AuthMap auth_map(30, 60, "", "", "");
+  for (size_t i = 0; i < number_of_keys; ++i) {
+    keys.push_back(makeKey(i));
+    const std::string uid = "u/user" + std::to_string(i);
+    baseline.addKey(keys.back(), uid);
+    auth_map.addKey(i % 2 ? PublicKeyType::SESSION : PublicKeyType::TRANSIENT,
+                    keys.back(), uid);
+  }
+
+  run("single mutex std::map, three probes (before)", lookups, threads, keys,
+      [&](const std::string &key) -> size_t {
+        if (baseline.hasKey(key)) {
+          baseline.incrementKeyAccessCounter(key);
+          return baseline.getUID(key).size();
+        }
+        return 0;
+      });
+
+  run("sharded AuthMap, single find", lookups, threads, keys,
+      [&](const std::string &key) -> size_t {
+        AuthMap::Lookup lookup;
+        if (auth_map.find(key, lookup, true)) {
+          return lookup.uid.size();
+        }
+        return 0;
+      });
+
+  return g_sink == 0;
+}
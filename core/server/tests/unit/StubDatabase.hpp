@@ -0,0 +1,153 @@
+#ifndef STUB_DATABASE_HPP
+#define STUB_DATABASE_HPP
+#pragma once
+
+// Third party includes
+#include <curl/curl.h>
+
+// Standard includes
+#include <arpa/inet.h>
+#include <cstdlib>
+#include <functional>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+namespace SDMS {
+namespace Core {
+namespace Test {
+
+/// Initializes curl for a test module, see BOOST_GLOBAL_FIXTURE
+struct CurlGlobalFixture {
+  CurlGlobalFixture() { curl_global_init(CURL_GLOBAL_DEFAULT); }
+};
+
+/**
+ * Stands in for the DB on a loopback port of its own.
+ *
+ * Each request is read whole, headers and body, and handed to the responder,
+ * which sets the status and body of the reply or returns false to close the
+ * connection without replying. Connections are closed after every reply.
+ **/
+class StubDatabase {
+public:
+  typedef std::function<bool(const std::string &a_request, int &a_status,
+                             std::string &a_body)>
+      Responder;
+
+  explicit StubDatabase(Responder a_responder)
+      : m_responder(std::move(a_responder)) {
+    m_socket = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(m_socket, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+    socklen_t length = sizeof(address);
+    getsockname(m_socket, reinterpret_cast<sockaddr *>(&address), &length);
+    m_port = ntohs(address.sin_port);
+    listen(m_socket, 16);
+    m_thread = std::thread(&StubDatabase::serve, this);
+  }
+
+  /// Answers every request with the same status and body
+  StubDatabase(const std::string &a_body, int a_status)
+      : StubDatabase([a_body, a_status](const std::string &, int &status,
+                                        std::string &body) {
+          status = a_status;
+          body = a_body;
+          return true;
+        }) {}
+
+  ~StubDatabase() {
+    shutdown(m_socket, SHUT_RDWR);
+    close(m_socket);
+    m_thread.join();
+  }
+
+  StubDatabase(const StubDatabase &) = delete;
+  StubDatabase &operator=(const StubDatabase &) = delete;
+
+  std::string url() const {
+    return "http://127.0.0.1:" + std::to_string(m_port) + "/";
+  }
+
+  /// The value of query parameter a_name in the request line, as sent
+  static std::string param(const std::string &a_request,
+                           const std::string &a_name) {
+    const std::string line = a_request.substr(0, a_request.find("\r\n"));
+    for (const char *separator : {"?", "&"}) {
+      size_t start = line.find(separator + a_name + "=");
+      if (start != std::string::npos) {
+        start += a_name.size() + 2;
+        return line.substr(start, line.find_first_of("& ", start) - start);
+      }
+    }
+    return "";
+  }
+
+  /// The body of a_request, empty for a GET
+  static std::string body(const std::string &a_request) {
+    return a_request.substr(a_request.find("\r\n\r\n") + 4);
+  }
+
+private:
+  void serve() {
+    int connection;
+    while ((connection = accept(m_socket, nullptr, nullptr)) >= 0) {
+      const std::string request = read(connection);
+      int status = 200;
+      std::string body;
+      if (!m_responder(request, status, body)) {
+        close(connection);
+        continue;
+      }
+
+      const std::string response =
+          "HTTP/1.1 " + std::to_string(status) +
+          " Reply\r\nContent-Length: " + std::to_string(body.size()) +
+          "\r\nConnection: close\r\n\r\n" + body;
+      if (write(connection, response.data(), response.size()) < 0) {
+        close(connection);
+        break;
+      }
+      close(connection);
+    }
+  }
+
+  /// Reads the headers, then as much body as they announce
+  static std::string read(int a_connection) {
+    std::string request;
+    char buffer[1024];
+    ssize_t size;
+    size_t end;
+    while ((end = request.find("\r\n\r\n")) == std::string::npos &&
+           (size = ::read(a_connection, buffer, sizeof(buffer))) > 0) {
+      request.append(buffer, size);
+    }
+    if (end == std::string::npos)
+      return request;
+
+    size_t length = 0;
+    const size_t header = request.find("Content-Length: ");
+    if (header != std::string::npos && header < end)
+      length = std::strtoul(request.c_str() + header + 16, nullptr, 10);
+    while (request.size() < end + 4 + length &&
+           (size = ::read(a_connection, buffer, sizeof(buffer))) > 0) {
+      request.append(buffer, size);
+    }
+    return request;
+  }
+
+  Responder m_responder;
+  int m_socket;
+  uint16_t m_port;
+  std::thread m_thread;
+};
+
+} // namespace Test
+} // namespace Core
+} // namespace SDMS
+
+#endif // STUB_DATABASE_HPP
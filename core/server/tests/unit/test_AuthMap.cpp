@@ -5,8 +5,15 @@
 #include <boost/test/unit_test.hpp>
 
 #include "AuthMap.hpp"
+#include "StubDatabase.hpp"
+#include "common/TraceException.hpp"
+
+#include <atomic>
 
 using namespace SDMS::Core;
+using namespace SDMS::Core::Test;
+
+BOOST_GLOBAL_FIXTURE(CurlGlobalFixture);
 
 BOOST_AUTO_TEST_SUITE(AuthMapTest)
 
@@ -33,4 +40,110 @@ BOOST_AUTO_TEST_CASE(testing_AuthMap) {
   BOOST_TEST(auth_map.getUID(PublicKeyType::TRANSIENT, new_pub_key) == user_id);
 }
 
+BOOST_AUTO_TEST_CASE(testing_AuthMapSingleLookup) {
+  AuthMap auth_map(30, 30, "https://db/sdms/blah", "greatestone", "1234");
+
+  const std::string pub_key(PublicKey::MAX_SIZE, 'k');
+  const std::string user_id = "u/bob";
+  auth_map.addKey(PublicKeyType::TRANSIENT, pub_key, user_id);
+
+  AuthMap::Lookup lookup;
+  BOOST_TEST(auth_map.find(pub_key, lookup, true));
+  BOOST_TEST((lookup.type == PublicKeyType::TRANSIENT));
+  BOOST_TEST(lookup.uid == user_id);
+  BOOST_TEST(lookup.access_count == 1);
+  BOOST_TEST(auth_map.getAccessCount(PublicKeyType::TRANSIENT, pub_key) == 1);
+
+  // Adding the key as a session key replaces the transient entry, which is
+  // how Promote moves keys between types
+  auth_map.addKey(PublicKeyType::SESSION, pub_key, user_id);
+  auth_map.removeKey(PublicKeyType::TRANSIENT, pub_key);
+  BOOST_TEST(auth_map.size(PublicKeyType::TRANSIENT) == 0);
+  BOOST_TEST(auth_map.size(PublicKeyType::SESSION) == 1);
+  BOOST_TEST(auth_map.hasKeyType(PublicKeyType::SESSION, pub_key));
+  BOOST_TEST(auth_map.hasKeyType(PublicKeyType::TRANSIENT, pub_key) == false);
+
+  auth_map.removeKey(PublicKeyType::SESSION, pub_key);
+  BOOST_TEST(auth_map.find(pub_key, lookup) == false);
+  BOOST_TEST(auth_map.size(PublicKeyType::SESSION) == 0);
+
+  const std::string long_key(PublicKey::MAX_SIZE + 1, 'k');
+  BOOST_CHECK_THROW(auth_map.addKey(PublicKeyType::TRANSIENT, long_key, user_id),
+                    TraceException);
+  BOOST_TEST(auth_map.find(long_key, lookup) == false);
+}
+
+BOOST_AUTO_TEST_CASE(testing_AuthMapExpiry) {
+  const time_t active_transient_key_time = 0;
+  const time_t active_session_key_time = 3600;
+  AuthMap auth_map(active_transient_key_time, active_session_key_time,
+                   "https://db/sdms/blah", "greatestone", "1234");
+
+  const std::string transient_key = "transient";
+  const std::string session_key = "session";
+  const std::string removed_key = "removed";
+  auth_map.addKey(PublicKeyType::TRANSIENT, transient_key, "u/bob");
+  auth_map.addKey(PublicKeyType::SESSION, session_key, "u/bob");
+  auth_map.addKey(PublicKeyType::TRANSIENT, removed_key, "u/bob");
+  auth_map.removeKey(PublicKeyType::TRANSIENT, removed_key);
+
+  const time_t now = time(0);
+  BOOST_TEST(auth_map.getExpiredKeys(PublicKeyType::SESSION, now).empty());
+  BOOST_TEST(auth_map.getExpiredKeys(PublicKeyType::TRANSIENT, now).size() ==
+             1);
+
+  // Only the transient key is due, the removed key is skipped
+  std::vector<std::string> expired =
+      auth_map.takeExpiredKeys(PublicKeyType::TRANSIENT, now);
+  BOOST_TEST(expired.size() == 1);
+  BOOST_TEST(expired.front() == transient_key);
+  BOOST_TEST(auth_map.takeExpiredKeys(PublicKeyType::TRANSIENT, now).empty());
+
+  BOOST_TEST(auth_map.takeExpiredKeys(PublicKeyType::SESSION, now).empty());
+  auth_map.resetKey(PublicKeyType::SESSION, session_key);
+  expired = auth_map.takeExpiredKeys(PublicKeyType::SESSION,
+                                     now + 2 * active_session_key_time);
+  BOOST_TEST(expired.size() == 1);
+  BOOST_TEST(expired.front() == session_key);
+}
+
+BOOST_AUTO_TEST_CASE(testing_AuthMapAssign) {
+  AuthMap auth_map(30, 30, "https://db/sdms/blah", "greatestone", "1234");
+  auth_map.addKey(PublicKeyType::TRANSIENT, "key1", "u/bob");
+
+  AuthMap other;
+  other.addKey(PublicKeyType::SESSION, "key2", "u/sally");
+  other = auth_map;
+  BOOST_TEST(other.size(PublicKeyType::TRANSIENT) == 1);
+  BOOST_TEST(other.getUID(PublicKeyType::TRANSIENT, "key1") == "u/bob");
+
+  // The assigned map is independent of the one it was copied from
+  other.removeKey(PublicKeyType::TRANSIENT, "key1");
+  BOOST_TEST(auth_map.hasKey(PublicKeyType::TRANSIENT, "key1"));
+}
+
+BOOST_AUTO_TEST_CASE(testing_AuthMapPersistentUserFailure) {
+  std::atomic<int> status(500);
+  StubDatabase server(
+      [&status](const std::string &, int &a_status, std::string &a_body) {
+        a_status = status;
+        a_body = a_status == 200 ? "u/bob" : "{\"errorMessage\":\"no\"}";
+        return true;
+      });
+  AuthMap auth_map(30, 30, server.url(), "greatestone", "1234");
+
+  // A failing DB is not taken for a miss, the next lookup asks again
+  std::string uid;
+  BOOST_TEST(auth_map.findPersistentUser("key1", uid) == false);
+  status = 200;
+  BOOST_TEST(auth_map.findPersistentUser("key1", uid));
+  BOOST_TEST(uid == "u/bob");
+
+  // A key the DB refuses is a miss and is answered from the cache
+  status = 400;
+  BOOST_TEST(auth_map.findPersistentUser("key2", uid) == false);
+  status = 200;
+  BOOST_TEST(auth_map.findPersistentUser("key2", uid) == false);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
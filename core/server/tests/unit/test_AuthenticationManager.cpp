@@ -173,4 +173,47 @@ BOOST_AUTO_TEST_CASE(testing_AuthenticationManagerSessionReset) {
   BOOST_TEST(auth_manager.hasKey(public_key) == false);
 }
 
+BOOST_AUTO_TEST_CASE(testing_AuthenticationManagerConnectionToken) {
+
+  std::map<PublicKeyType, time_t> purge_intervals;
+  purge_intervals[PublicKeyType::TRANSIENT] = 1; // Seconds
+  purge_intervals[PublicKeyType::SESSION] = 2;   // Seconds
+
+  std::map<PublicKeyType, std::vector<std::unique_ptr<Condition>>>
+      purge_conditions;
+
+  std::string db_url = "https://db/sdms/blah";
+  std::string db_user = "greatestone";
+  std::string db_pass = "1234";
+
+  AuthenticationManager auth_manager(
+      purge_intervals, std::move(purge_conditions), db_url, db_user, db_pass);
+
+  const std::string repo_key = "repo_key";
+  const std::string transient_key = "transient_key";
+  auth_manager.addKey(PublicKeyType::PERSISTENT, repo_key, "repo/fast");
+  auth_manager.addKey(PublicKeyType::TRANSIENT, transient_key, "u/slow");
+
+  // Persistent keys are given a token
+  std::string uid;
+  const uint32_t token = auth_manager.authenticateConnection(repo_key, uid);
+  BOOST_TEST(token != 0);
+  BOOST_TEST(uid == "repo/fast");
+  BOOST_TEST(auth_manager.isConnectionValid(token));
+
+  // Transient keys must still be counted per message so they have no token
+  BOOST_TEST(auth_manager.authenticateConnection(transient_key, uid) == 0);
+  BOOST_TEST(uid == "u/slow");
+  BOOST_TEST(auth_manager.isConnectionValid(0) == false);
+
+  const uint32_t second_token =
+      auth_manager.authenticateConnection(repo_key, uid);
+  BOOST_TEST(second_token != token);
+
+  // Revoking the key invalidates every connection that used it
+  auth_manager.revokeConnections(repo_key);
+  BOOST_TEST(auth_manager.isConnectionValid(token) == false);
+  BOOST_TEST(auth_manager.isConnectionValid(second_token) == false);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
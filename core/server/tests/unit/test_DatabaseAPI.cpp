@@ -0,0 +1,211 @@
+#define BOOST_TEST_MAIN
+
+#define BOOST_TEST_MODULE databaseapi
+#include <boost/test/unit_test.hpp>
+
+// Local private includes
+#include "DatabaseAPI.hpp"
+#include "MetricsRegistry.hpp"
+#include "StubDatabase.hpp"
+
+// Local public includes
+#include "common/TraceException.hpp"
+#include "common/libjson.hpp"
+
+// Third party includes
+#include <google/protobuf/text_format.h>
+#include <google/protobuf/util/message_differencer.h>
+
+// Standard includes
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+
+using namespace SDMS;
+using namespace SDMS::Core;
+using namespace SDMS::Core::Test;
+
+BOOST_GLOBAL_FIXTURE(CurlGlobalFixture);
+
+namespace {
+
+/**
+ * How a_reply differs from the golden reply given in protobuf text format,
+ * empty if they are the same.
+ **/
+std::string differences(const google::protobuf::Message &a_reply,
+                        const std::string &a_golden) {
+  std::unique_ptr<google::protobuf::Message> golden(a_reply.New());
+  if (!google::protobuf::TextFormat::ParseFromString(a_golden, golden.get()))
+    return "golden reply does not parse";
+
+  std::string report;
+  google::protobuf::util::MessageDifferencer differencer;
+  differencer.ReportDifferencesToString(&report);
+  differencer.Compare(*golden, a_reply);
+  return report;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(DatabaseAPITest)
+
+BOOST_AUTO_TEST_CASE(testing_DatabaseAPI_searchParams) {
+  std::mutex mutex;
+  std::string request_body;
+  StubDatabase server([&](const std::string &a_request, int &a_status,
+                          std::string &a_body) {
+    std::lock_guard<std::mutex> lock(mutex);
+    request_body = StubDatabase::body(a_request);
+    a_status = 200;
+    a_body = "[]";
+    return true;
+  });
+  DatabaseAPI db_client(server.url(), "user", "pass");
+  LogContext log_context;
+
+  // Values able to close the string they are written in and add a parameter
+  const std::string tag = "t\", \"owner\":\"u/eve";
+  const std::string tag2 = "back\\slash\\";
+  Auth::SearchRequest request;
+  request.set_mode(SM_DATA);
+  request.set_owner("u/bob");
+  request.add_tags(tag);
+  request.add_tags(tag2);
+  request.add_cat_tags("\"");
+  request.set_creator("u/\"c\"");
+  request.add_coll("c/\\1");
+  Auth::ListingReply reply;
+  db_client.generalSearch(request, reply, log_context);
+
+  libjson::Value body;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    body.fromString(request_body);
+  }
+  const libjson::Value::Object &params =
+      body.asObject().getObject("params");
+  BOOST_TEST(params.getString("owner") == "u/bob");
+  BOOST_REQUIRE(params.getArray("tags").size() == 2);
+  BOOST_TEST(params.getArray("tags")[0].asString() == tag);
+  BOOST_TEST(params.getArray("tags")[1].asString() == tag2);
+  BOOST_TEST(params.getArray("ctags")[0].asString() == "\"");
+  BOOST_TEST(params.getString("creator") == "u/\"c\"");
+  BOOST_TEST(params.getArray("cols")[0].asString() == "c/\\1");
+  BOOST_TEST(params.getNumber("off") == 0);
+  BOOST_TEST(params.getNumber("cnt") == 50);
+  BOOST_TEST(body.asObject().getNumber("limit") == 50);
+}
+
+BOOST_AUTO_TEST_CASE(testing_DatabaseAPI_routeMetrics) {
+  StubDatabase server("{}", 500);
+  DatabaseAPI db_client(server.url(), "user", "pass");
+  LogContext log_context;
+  MetricsRegistry &metrics = MetricsRegistry::getInstance();
+  Histogram &duration = metrics.histogram(metrics::DB_DURATION, "admin/ping");
+  std::atomic<uint64_t> &errors =
+      metrics.counter(metrics::DB_ERRORS, "admin/ping");
+  const uint64_t count = duration.count();
+  const uint64_t failed = errors.load();
+
+  // The second request records through the metrics kept by the first
+  for (int i = 0; i < 2; ++i) {
+    BOOST_CHECK_THROW(db_client.serverPing(log_context), TraceException);
+  }
+  BOOST_TEST(duration.count() == count + 2);
+  BOOST_TEST(errors.load() == failed + 2);
+}
+
+// The golden replies below are translations of DB replies as they are sent,
+// covering null values, keys named differently from their field and arrays
+// of nested messages.
+
+BOOST_AUTO_TEST_CASE(testing_DatabaseAPI_userReply) {
+  StubDatabase server(
+      R"([{"uid":"u/bob","name_last":"Smith","name_first":"Bob",)"
+      R"("email":"bob@x.org","is_admin":false,"is_repo_admin":true,)"
+      R"("idents":["u/bob.globus","orcid:0000"],"allocs":[{"repo":"repo/r1",)"
+      R"("data_limit":1000000,"data_size":2048,"rec_limit":100,)"
+      R"("rec_count":2,"path":"/mnt/r1/user/bob/","is_def":true,)"
+      R"("id":"repo/r1","stats":true,"file_count":3,"histogram":[10,20]}]},)"
+      R"({"paging":{"off":0,"cnt":1,"tot":1}}])",
+      200);
+  DatabaseAPI db_client(server.url(), "user", "pass");
+  LogContext log_context;
+
+  Auth::UserViewRequest request;
+  request.set_uid("u/bob");
+  Auth::UserDataReply reply;
+  db_client.userView(request, reply, log_context);
+
+  BOOST_TEST(differences(reply, R"(
+    user {
+      uid: "u/bob" name_last: "Smith" name_first: "Bob" email: "bob@x.org"
+      is_admin: false is_repo_admin: true
+      ident: "u/bob.globus" ident: "orcid:0000"
+      alloc {
+        repo: "repo/r1" data_limit: 1000000 data_size: 2048 rec_limit: 100
+        rec_count: 2 path: "/mnt/r1/user/bob/" id: "repo/r1" is_def: true
+        stats {
+          repo: "repo/r1" rec_count: 2 file_count: 3 data_size: 2048
+          histogram: 10 histogram: 20
+        }
+      }
+    }
+    offset: 0 count: 1 total: 1)") == "");
+}
+
+BOOST_AUTO_TEST_CASE(testing_DatabaseAPI_repoReply) {
+  StubDatabase server(
+      R"([{"id":"repo/r1","title":"Repo","desc":"Disk","capacity":5e9,)"
+      R"("pub_key":"key","address":"tcp://r1:9000","endpoint":"e-1",)"
+      R"("path":"/mnt/r1/","domain":null,"admins":["u/bob","u/ann"]}])",
+      200);
+  DatabaseAPI db_client(server.url(), "user", "pass");
+  LogContext log_context;
+
+  Auth::RepoViewRequest request;
+  request.set_id("repo/r1");
+  Auth::RepoDataReply reply;
+  db_client.repoView(request, reply, log_context);
+
+  BOOST_TEST(differences(reply, R"(
+    repo {
+      id: "repo/r1" title: "Repo" desc: "Disk" capacity: 5000000000
+      pub_key: "key" address: "tcp://r1:9000" endpoint: "e-1"
+      path: "/mnt/r1/" admin: "u/bob" admin: "u/ann"
+    })") == "");
+}
+
+BOOST_AUTO_TEST_CASE(testing_DatabaseAPI_noteReply) {
+  StubDatabase server(
+      R"({"results":[{"_id":"n/1","type":2,"state":1,"subject_id":"d/1",)"
+      R"("title":"Bad units","ct":100,"ut":200,"parent_id":null,)"
+      R"("has_child":false,"comments":[{"user":"u/bob","time":100,)"
+      R"("comment":"Check","new_type":2,"new_state":1},{"user":"u/ann",)"
+      R"("time":150,"comment":"Seen","new_type":null,"new_state":null}]}],)"
+      R"("updates":[{"_id":"d/1","title":"Data","owner":null}]})",
+      200);
+  DatabaseAPI db_client(server.url(), "user", "pass");
+  LogContext log_context;
+
+  Auth::NoteViewRequest request;
+  request.set_id("n/1");
+  Auth::NoteDataReply reply;
+  db_client.noteView(request, reply, log_context);
+
+  BOOST_TEST(differences(reply, R"(
+    note {
+      id: "n/1" type: NOTE_WARN state: NOTE_OPEN subject_id: "d/1"
+      title: "Bad units" ct: 100 ut: 200 has_child: false
+      comment {
+        user: "u/bob" time: 100 comment: "Check" type: NOTE_WARN
+        state: NOTE_OPEN
+      }
+      comment { user: "u/ann" time: 150 comment: "Seen" }
+    }
+    update { id: "d/1" title: "Data" })") == "");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,151 @@
+#define BOOST_TEST_MAIN
+
+#define BOOST_TEST_MODULE databaseconnectionpool
+#include <boost/test/unit_test.hpp>
+
+// Local private includes
+#include "DatabaseAPI.hpp"
+#include "DatabaseConnectionPool.hpp"
+#include "StubDatabase.hpp"
+
+// Local public includes
+#include "common/TraceException.hpp"
+
+// Standard includes
+#include <string>
+#include <vector>
+
+using namespace SDMS;
+using namespace SDMS::Core;
+using namespace SDMS::Core::Test;
+
+BOOST_GLOBAL_FIXTURE(CurlGlobalFixture);
+
+namespace {
+
+/**
+ * Answers records with a record titled after their id and schemas with a
+ * schema of their id. An id of "bad" is refused with an error naming the
+ * route and an id of "drop" gets no reply at all.
+ **/
+bool route(const std::string &a_request, int &a_status, std::string &a_body) {
+  const std::string id = StubDatabase::param(a_request, "id");
+  const bool schema = a_request.find("/schema/view") != std::string::npos;
+
+  if (id == "drop") {
+    return false;
+  } else if (id == "bad") {
+    a_status = 400;
+    a_body = std::string("{\"errorMessage\":\"") +
+             (schema ? "schema" : "record") + " refused\"}";
+  } else if (schema) {
+    a_body = "{\"id\":\"" + id + "\",\"ver\":1}";
+  } else {
+    a_body = "{\"results\":[{\"id\":\"" + id + "\",\"title\":\"Title " +
+             id + "\"}],\"updates\":[]}";
+  }
+  return true;
+}
+
+/// Views a record and a schema together, returning the error code and message
+/// of the exception thrown, or 0 and an empty message
+std::pair<int, std::string> viewWithSchema(DatabaseAPI &a_db_client,
+                                           const std::string &a_rec_id,
+                                           const std::string &a_sch_id) {
+  LogContext log_context;
+  Auth::RecordViewRequest request;
+  Auth::RecordDataReply reply;
+  libjson::Value schema;
+  request.set_id(a_rec_id);
+
+  try {
+    a_db_client.recordViewWithSchema(request, reply, a_sch_id, schema,
+                                     log_context);
+  } catch (TraceException &e) {
+    return {e.getErrorCode(), e.toString()};
+  }
+
+  BOOST_REQUIRE(reply.data_size() == 1);
+  BOOST_TEST(reply.data(0).id() == a_rec_id);
+  BOOST_TEST(reply.data(0).title() == "Title " + a_rec_id);
+  BOOST_TEST(schema.asObject().getString("id") == a_sch_id);
+  return {0, ""};
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(DatabaseConnectionPoolTest)
+
+BOOST_AUTO_TEST_CASE(testing_DatabaseConnectionPool_reuse) {
+  DatabaseConnectionPool &pool = DatabaseConnectionPool::getInstance();
+
+  CURL *curl = pool.acquire();
+  BOOST_TEST(curl != nullptr);
+
+  size_t idle = pool.idleCount();
+  pool.release(curl);
+  BOOST_TEST(pool.idleCount() == idle + 1);
+
+  // Released handles are handed out again instead of creating new ones
+  CURL *curl2 = pool.acquire();
+  BOOST_TEST(curl2 == curl);
+  BOOST_TEST(pool.idleCount() == idle);
+  pool.release(curl2);
+}
+
+BOOST_AUTO_TEST_CASE(testing_DatabaseConnectionPool_concurrent_empty) {
+  DatabaseConnectionPool &pool = DatabaseConnectionPool::getInstance();
+
+  std::vector<CURL *> handles;
+  std::vector<CURLcode> results;
+
+  pool.performConcurrent(handles, results);
+  BOOST_TEST(results.size() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(testing_DatabaseConnectionPool_concurrent_replies) {
+  StubDatabase server(route);
+  DatabaseAPI db_client(server.url(), "user", "pass");
+
+  // Each reply lands with the request that asked for it, on every reuse of
+  // the pooled handles
+  for (int i = 0; i < 3; i++) {
+    const std::string n = std::to_string(i);
+    BOOST_TEST(viewWithSchema(db_client, "d" + n, "s" + n).first == 0);
+  }
+
+  // Handles released by the batch serve plain requests of other clients
+  DatabaseAPI other_client(server.url(), "user", "pass");
+  LogContext log_context;
+  Auth::RecordViewRequest request;
+  Auth::RecordDataReply reply;
+  request.set_id("d9");
+  other_client.recordView(request, reply, log_context);
+  BOOST_REQUIRE(reply.data_size() == 1);
+  BOOST_TEST(reply.data(0).title() == "Title d9");
+}
+
+BOOST_AUTO_TEST_CASE(testing_DatabaseConnectionPool_concurrent_errors) {
+  StubDatabase server(route);
+  DatabaseAPI db_client(server.url(), "user", "pass");
+
+  // HTTP errors are reported with the reply of the request that failed
+  std::pair<int, std::string> error = viewWithSchema(db_client, "d1", "bad");
+  BOOST_TEST(error.first == ID_BAD_REQUEST);
+  BOOST_TEST(error.second == "schema refused");
+
+  error = viewWithSchema(db_client, "bad", "s1");
+  BOOST_TEST(error.first == ID_BAD_REQUEST);
+  BOOST_TEST(error.second == "record refused");
+
+  // Transport errors, whichever request runs into them
+  BOOST_TEST(viewWithSchema(db_client, "d1", "drop").first ==
+             ID_SERVICE_ERROR);
+  BOOST_TEST(viewWithSchema(db_client, "drop", "s1").first ==
+             ID_SERVICE_ERROR);
+
+  // The client recovers once the DB answers again
+  BOOST_TEST(viewWithSchema(db_client, "d2", "s2").first == 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,194 @@
+#define BOOST_TEST_MAIN
+
+#define BOOST_TEST_MODULE deferredrequests
+#include <boost/test/unit_test.hpp>
+
+// Local private includes
+#include "DatabaseAPI.hpp"
+#include "DeferredRequests.hpp"
+#include "StubDatabase.hpp"
+
+// Local public includes
+#include "common/TraceException.hpp"
+
+// Standard includes
+#include <chrono>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace SDMS;
+using namespace SDMS::Core;
+using namespace SDMS::Core::Test;
+
+BOOST_GLOBAL_FIXTURE(CurlGlobalFixture);
+
+namespace {
+
+/// Answers every request with the value of its pub_key parameter
+bool echo(const std::string &a_request, int &a_status, std::string &a_body) {
+  a_status = 200;
+  a_body = StubDatabase::param(a_request, "pub_key");
+  return true;
+}
+
+/// Polls until every request has completed or a few seconds have passed
+void waitFor(DeferredRequests &deferred) {
+  for (int i = 0; i < 500 && deferred.size(); ++i) {
+    deferred.poll(10);
+  }
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(DeferredRequestsTest)
+
+BOOST_AUTO_TEST_CASE(testing_DeferredRequests_inFlight) {
+  StubDatabase server(echo);
+  DatabaseAPI db_client(server.url(), "user", "pass");
+  LogContext log_context;
+  DeferredRequests deferred(db_client, 3, log_context);
+
+  const std::vector<std::string> keys = {"k1", "k2", "k3"};
+  std::vector<std::string> uids(keys.size());
+  std::vector<int> runs(keys.size(), 0);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    deferred.start([&, i]() {
+      ++runs[i];
+      std::string uid;
+      if (db_client.uidByPubKey(keys[i], uid)) {
+        uids[i] = uid;
+      }
+    });
+  }
+
+  // None can complete before the DB answers, so all three are in flight
+  BOOST_TEST(deferred.size() == 3);
+  BOOST_TEST(deferred.full());
+
+  waitFor(deferred);
+  BOOST_TEST(deferred.size() == 0);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    BOOST_TEST(uids[i] == keys[i]);
+    BOOST_TEST(runs[i] == 2);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(testing_DeferredRequests_replay) {
+  StubDatabase server(echo);
+  DatabaseAPI db_client(server.url(), "user", "pass");
+  LogContext log_context;
+  DeferredRequests deferred(db_client, 1, log_context);
+
+  // Only the first call is waited on, the second is made blocking when the
+  // request is run again, so it runs twice whatever its number of calls
+  std::vector<std::string> uids;
+  int runs = 0;
+  deferred.start([&]() {
+    ++runs;
+    std::string first;
+    std::string second;
+    db_client.uidByPubKey("first", first);
+    db_client.uidByPubKey("second", second);
+    uids = {first, second};
+  });
+
+  waitFor(deferred);
+  BOOST_TEST(deferred.size() == 0);
+  BOOST_TEST(runs == 2);
+  BOOST_REQUIRE(uids.size() == 2);
+  BOOST_TEST(uids[0] == "first");
+  BOOST_TEST(uids[1] == "second");
+
+  // Back in blocking mode once the request has completed
+  std::string uid;
+  BOOST_TEST(db_client.uidByPubKey("blocking", uid));
+  BOOST_TEST(uid == "blocking");
+}
+
+BOOST_AUTO_TEST_CASE(testing_DeferredRequests_replayMismatch) {
+  StubDatabase server("[]", 200);
+  DatabaseAPI db_client(server.url(), "user", "pass");
+  LogContext log_context;
+  DeferredRequests deferred(db_client, 1, log_context);
+
+  // A replayed POST to the same URL with another body is not the same call
+  int runs = 0;
+  int error_code = 0;
+  deferred.start([&]() {
+    Auth::SearchRequest request;
+    request.set_mode(SM_DATA);
+    request.add_tags("run" + std::to_string(++runs));
+    Auth::ListingReply reply;
+    try {
+      db_client.generalSearch(request, reply, log_context);
+    } catch (TraceException &e) {
+      error_code = e.getErrorCode();
+    }
+  });
+
+  waitFor(deferred);
+  BOOST_TEST(deferred.size() == 0);
+  BOOST_TEST(runs == 2);
+  BOOST_TEST(error_code == ID_INTERNAL_ERROR);
+}
+
+BOOST_AUTO_TEST_CASE(testing_DeferredRequests_pollFd) {
+  // The DB takes longer to answer than the test waits
+  StubDatabase server([](const std::string &a_request, int &a_status,
+                         std::string &a_body) {
+    std::this_thread::sleep_for(std::chrono::seconds(2));
+    return echo(a_request, a_status, a_body);
+  });
+  DatabaseAPI db_client(server.url(), "user", "pass");
+  LogContext log_context;
+  DeferredRequests deferred(db_client, 1, log_context);
+
+  std::string uid;
+  deferred.start([&]() { db_client.uidByPubKey("key", uid); });
+  BOOST_REQUIRE(deferred.size() == 1);
+
+  // A readable descriptor ends the wait before the DB has answered
+  int fds[2];
+  BOOST_REQUIRE(pipe(fds) == 0);
+  BOOST_REQUIRE(write(fds[1], "x", 1) == 1);
+  const auto start = std::chrono::steady_clock::now();
+  BOOST_TEST(deferred.poll(1500, fds[0]) == 0);
+  BOOST_TEST((std::chrono::steady_clock::now() - start <
+              std::chrono::milliseconds(1000)));
+  BOOST_TEST(deferred.size() == 1);
+
+  waitFor(deferred);
+  BOOST_TEST(deferred.size() == 0);
+  BOOST_TEST(uid == "key");
+  close(fds[0]);
+  close(fds[1]);
+}
+
+BOOST_AUTO_TEST_CASE(testing_DeferredRequests_failure) {
+  std::string url;
+  {
+    // Nothing listens on the port once the server is gone
+    StubDatabase server(echo);
+    url = server.url();
+  }
+  DatabaseAPI db_client(url, "user", "pass");
+  LogContext log_context;
+  DeferredRequests deferred(db_client, 2, log_context);
+
+  int error_code = 0;
+  deferred.start([&]() {
+    try {
+      db_client.serverPing(log_context);
+    } catch (TraceException &e) {
+      error_code = e.getErrorCode();
+    }
+  });
+
+  waitFor(deferred);
+  BOOST_TEST(deferred.size() == 0);
+  BOOST_TEST(error_code == ID_SERVICE_ERROR);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
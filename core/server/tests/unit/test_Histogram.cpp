@@ -0,0 +1,83 @@
+#define BOOST_TEST_MAIN
+
+#define BOOST_TEST_MODULE histogram
+#include <boost/test/unit_test.hpp>
+
+// Local includes
+#include "Histogram.hpp"
+
+// Standard includes
+#include <thread>
+#include <vector>
+
+using namespace SDMS::Core;
+
+BOOST_AUTO_TEST_SUITE(HistogramTest)
+
+BOOST_AUTO_TEST_CASE(testing_HistogramBuckets) {
+  // Small values are counted exactly
+  for (uint64_t value = 0; value < Histogram::SUB_BUCKETS; ++value) {
+    BOOST_TEST(Histogram::bucketUpperBound(Histogram::bucketIndex(value)) ==
+               value);
+  }
+
+  // Larger values land in a bucket no more than 12.5% wider than the value
+  for (uint64_t value = Histogram::SUB_BUCKETS; value < 1000000;
+       value = value * 3 / 2 + 1) {
+    const uint64_t upper =
+        Histogram::bucketUpperBound(Histogram::bucketIndex(value));
+    BOOST_TEST(upper >= value);
+    BOOST_TEST(upper - value <= value / Histogram::SUB_BUCKETS);
+  }
+
+  BOOST_TEST(Histogram::bucketIndex(uint64_t(1) << 50) ==
+             Histogram::NUMBER_OF_BUCKETS - 1);
+}
+
+BOOST_AUTO_TEST_CASE(testing_HistogramPercentiles) {
+  Histogram histogram;
+  BOOST_TEST(histogram.percentile(50) == 0);
+
+  for (uint64_t value = 1; value <= 1000; ++value) {
+    histogram.record(value);
+  }
+  BOOST_TEST(histogram.count() == 1000);
+  BOOST_TEST(histogram.sum() == 500500);
+  BOOST_TEST(histogram.max() == 1000);
+
+  const uint64_t p50 = histogram.percentile(50);
+  BOOST_TEST(p50 >= 500);
+  BOOST_TEST(p50 <= 500 + 500 / Histogram::SUB_BUCKETS);
+  BOOST_TEST(histogram.percentile(100) == 1000);
+
+  Histogram other;
+  other.record(5000);
+  histogram.merge(other);
+  BOOST_TEST(histogram.count() == 1001);
+  BOOST_TEST(histogram.max() == 5000);
+
+  histogram.reset();
+  BOOST_TEST(histogram.count() == 0);
+  BOOST_TEST(histogram.percentile(99) == 0);
+}
+
+BOOST_AUTO_TEST_CASE(testing_HistogramConcurrentRecord) {
+  Histogram histogram;
+  const size_t number_of_threads = 4;
+  const size_t records_per_thread = 100000;
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < number_of_threads; ++t) {
+    threads.emplace_back([&histogram, t]() {
+      for (size_t i = 0; i < records_per_thread; ++i) {
+        histogram.record(t * records_per_thread + i);
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  BOOST_TEST(histogram.count() == number_of_threads * records_per_thread);
+  BOOST_TEST(histogram.max() == number_of_threads * records_per_thread - 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,91 @@
+#define BOOST_TEST_MAIN
+
+#define BOOST_TEST_MODULE metrics_registry
+#include <boost/test/unit_test.hpp>
+
+// Local includes
+#include "MetricsRegistry.hpp"
+#include "common/TraceException.hpp"
+
+// Standard includes
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using namespace SDMS::Core;
+
+namespace {
+const MetricFamily TEST_DURATION = {"test_duration_seconds", "op",
+                                    "Duration of a test operation",
+                                    MetricFamily::Kind::SUMMARY, 1e-6};
+const MetricFamily TEST_ERRORS = {"test_errors_total", "op",
+                                  "Failed test operations",
+                                  MetricFamily::Kind::COUNTER, 1};
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(MetricsRegistryTest)
+
+BOOST_AUTO_TEST_CASE(testing_MetricsRegistrySameMetric) {
+  MetricsRegistry &metrics = MetricsRegistry::getInstance();
+
+  // The same label always resolves to the same metric
+  Histogram &read = metrics.histogram(TEST_DURATION, "read");
+  BOOST_TEST(&read == &metrics.histogram(TEST_DURATION, "read"));
+  BOOST_TEST(&read != &metrics.histogram(TEST_DURATION, "write"));
+
+  std::atomic<uint64_t> &errors = metrics.counter(TEST_ERRORS, "read");
+  BOOST_TEST(&errors == &metrics.counter(TEST_ERRORS, "read"));
+}
+
+BOOST_AUTO_TEST_CASE(testing_MetricsRegistryPrometheusFormat) {
+  MetricsRegistry &metrics = MetricsRegistry::getInstance();
+
+  Histogram &histogram = metrics.histogram(TEST_DURATION, "a\"b");
+  histogram.reset();
+  for (uint64_t value = 1; value <= 1000; ++value) {
+    histogram.record(2);
+  }
+  metrics.counter(TEST_ERRORS, "a\"b").store(3);
+
+  std::ostringstream out;
+  metrics.writePrometheus(out);
+  const std::string text = out.str();
+
+  BOOST_TEST(text.find("# TYPE test_duration_seconds summary\n") !=
+             std::string::npos);
+  BOOST_TEST(text.find("# TYPE test_errors_total counter\n") !=
+             std::string::npos);
+  // Values are scaled from microseconds to seconds and labels are escaped
+  BOOST_TEST(text.find("test_duration_seconds{op=\"a\\\"b\",quantile=\"0.5\"} "
+                       "2e-06\n") != std::string::npos);
+  BOOST_TEST(text.find("test_duration_seconds{op=\"a\\\"b\",quantile=\"0.999\"}"
+                       " 2e-06\n") != std::string::npos);
+  BOOST_TEST(text.find("test_duration_seconds_count{op=\"a\\\"b\"} 1000\n") !=
+             std::string::npos);
+  BOOST_TEST(text.find("test_errors_total{op=\"a\\\"b\"} 3\n") !=
+             std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(testing_MetricsRegistryFile) {
+  MetricsRegistry &metrics = MetricsRegistry::getInstance();
+  metrics.histogram(TEST_DURATION, "file").record(10);
+
+  const std::string path = "test_MetricsRegistry.prom";
+  metrics.writePrometheusFile(path);
+
+  std::ifstream in(path);
+  BOOST_REQUIRE(in.is_open());
+  std::stringstream text;
+  text << in.rdbuf();
+  BOOST_TEST(text.str().find("test_duration_seconds_count{op=\"file\"} 1\n") !=
+             std::string::npos);
+  // Nothing is left behind by the rename
+  BOOST_TEST(!std::ifstream(path + ".tmp").is_open());
+  std::remove(path.c_str());
+
+  BOOST_CHECK_THROW(metrics.writePrometheusFile("/nonexistent/metrics.prom"),
+                    TraceException);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
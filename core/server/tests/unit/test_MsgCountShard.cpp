@@ -0,0 +1,91 @@
+#define BOOST_TEST_MAIN
+
+#define BOOST_TEST_MODULE msg_count_shard
+#include <boost/test/unit_test.hpp>
+
+// Local includes
+#include "MsgCountShard.hpp"
+
+// Standard includes
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace SDMS::Core;
+
+BOOST_AUTO_TEST_SUITE(MsgCountShardTest)
+
+BOOST_AUTO_TEST_CASE(testing_MsgCountShardDrain) {
+  MsgCountShard shard;
+  shard.increment("u/alice", 0x201);
+  shard.increment("u/alice", 0x201);
+  shard.increment("u/alice", 0x305);
+  shard.increment("u/bob", 0x201);
+
+  std::map<std::string, MsgMetrics_t> metrics;
+  shard.drainInto(metrics);
+  BOOST_TEST(metrics.size() == 2);
+  BOOST_TEST(metrics["u/alice"][0x201] == 2);
+  BOOST_TEST(metrics["u/alice"][0x305] == 1);
+  BOOST_TEST(metrics["u/bob"][0x201] == 1);
+
+  // Draining starts a new period
+  metrics.clear();
+  shard.drainInto(metrics);
+  BOOST_TEST(metrics.empty());
+
+  // Counts of several shards are added together
+  MsgCountShard other;
+  shard.increment("u/bob", 0x201);
+  other.increment("u/bob", 0x201);
+  other.increment("u/carol", 0x201);
+  shard.drainInto(metrics);
+  other.drainInto(metrics);
+  BOOST_TEST(metrics.size() == 2);
+  BOOST_TEST(metrics["u/bob"][0x201] == 2);
+  BOOST_TEST(metrics["u/carol"][0x201] == 1);
+}
+
+BOOST_AUTO_TEST_CASE(testing_MsgCountShardInternLimit) {
+  MsgCountShard shard;
+  std::map<std::string, MsgMetrics_t> metrics;
+  for (size_t i = 0; i < MsgCountShard::MAX_INTERNED_UIDS + 10; ++i) {
+    shard.increment("u/" + std::to_string(i), 0x201);
+  }
+  shard.drainInto(metrics);
+  BOOST_TEST(metrics.size() == MsgCountShard::MAX_INTERNED_UIDS + 10);
+
+  // Forgetting the interned UIDs must not lose or misattribute counts
+  metrics.clear();
+  shard.increment("u/7", 0x201);
+  shard.drainInto(metrics);
+  BOOST_TEST(metrics.size() == 1);
+  BOOST_TEST(metrics["u/7"][0x201] == 1);
+}
+
+BOOST_AUTO_TEST_CASE(testing_MsgCountShardConcurrentDrain) {
+  MsgCountShard shard;
+  const uint32_t increments = 100000;
+  std::thread worker([&shard]() {
+    for (uint32_t i = 0; i < increments; ++i) {
+      shard.increment("u/alice", uint16_t(0x201 + i % 4));
+    }
+  });
+
+  // Drain while the worker counts, nothing may be lost
+  std::map<std::string, MsgMetrics_t> metrics;
+  for (int i = 0; i < 100; ++i) {
+    shard.drainInto(metrics);
+  }
+  worker.join();
+  shard.drainInto(metrics);
+
+  uint32_t total = 0;
+  for (const auto &count : metrics["u/alice"]) {
+    total += count.second;
+  }
+  BOOST_TEST(total == increments);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,65 @@
+#define BOOST_TEST_MAIN
+
+#define BOOST_TEST_MODULE publickeycache
+#include <boost/test/unit_test.hpp>
+
+// Local includes
+#include "PublicKeyCache.hpp"
+
+// Standard includes
+#include <string>
+
+using namespace SDMS::Core;
+
+BOOST_AUTO_TEST_SUITE(PublicKeyCacheTest)
+
+BOOST_AUTO_TEST_CASE(testing_PublicKeyCacheFoundAndMissing) {
+  const size_t capacity = 10;
+  const time_t found_ttl = 300;
+  const time_t missing_ttl = 300;
+  PublicKeyCache cache(capacity, found_ttl, missing_ttl);
+
+  bool found = false;
+  std::string uid = "anon";
+  BOOST_TEST(cache.lookup("user_key", found, uid) == false);
+
+  cache.insert("user_key", true, "u/bob");
+  cache.insert("unknown_key", false, "");
+  BOOST_TEST(cache.size() == 2);
+
+  BOOST_TEST(cache.lookup("user_key", found, uid));
+  BOOST_TEST(found);
+  BOOST_TEST(uid == "u/bob");
+
+  // Unknown keys are cached as well but leave the uid untouched
+  uid = "anon";
+  BOOST_TEST(cache.lookup("unknown_key", found, uid));
+  BOOST_TEST(found == false);
+  BOOST_TEST(uid == "anon");
+
+  cache.invalidate("user_key");
+  BOOST_TEST(cache.lookup("user_key", found, uid) == false);
+  BOOST_TEST(cache.size() == 1);
+}
+
+BOOST_AUTO_TEST_CASE(testing_PublicKeyCacheExpiryAndCapacity) {
+  const size_t capacity = 2;
+  const time_t found_ttl = 300;
+  const time_t missing_ttl = 0;
+  PublicKeyCache cache(capacity, found_ttl, missing_ttl);
+
+  bool found = false;
+  std::string uid;
+  cache.insert("unknown_key", false, "");
+  BOOST_TEST(cache.lookup("unknown_key", found, uid) == false);
+
+  // The oldest entry is evicted once the capacity is reached
+  cache.insert("first_key", true, "u/first");
+  cache.insert("second_key", true, "u/second");
+  BOOST_TEST(cache.size() == capacity);
+  BOOST_TEST(cache.lookup("unknown_key", found, uid) == false);
+  BOOST_TEST(cache.lookup("first_key", found, uid));
+  BOOST_TEST(cache.lookup("second_key", found, uid));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,139 @@
+#define BOOST_TEST_MAIN
+
+#define BOOST_TEST_MODULE streamedreplies
+#include <boost/test/unit_test.hpp>
+
+// Local private includes
+#include "DatabaseAPI.hpp"
+#include "StubDatabase.hpp"
+
+// Local public includes
+#include "common/TraceException.hpp"
+
+// Standard includes
+#include <string>
+
+using namespace SDMS;
+using namespace SDMS::Core;
+using namespace SDMS::Core::Test;
+
+BOOST_GLOBAL_FIXTURE(CurlGlobalFixture);
+
+namespace {
+
+const char *LISTING =
+    "[{\"id\":\"c/1\",\"title\":\"Collection\",\"alias\":null,\"owner\":"
+    "\"u/a\",\"size\":10,\"deps\":[{\"id\":\"d/2\",\"type\":1,\"dir\":0,"
+    "\"notes\":3,\"alias\":\"dep\"}]},{\"_id\":\"d/3\",\"title\":\"A \\\"quoted"
+    "\\\" title\\n\",\"locked\":true,\"extra\":{\"x\":[1,{\"y\":null}]}},"
+    "{\"paging\":{\"off\":20,\"cnt\":2,\"tot\":47}}]";
+
+const char *RECORD =
+    "{\"results\":[{\"id\":\"d/1\",\"title\":\"Record\",\"alias\":null,"
+    "\"tags\":[\"t1\",\"t2\"],\"md\":{\"z\":1,\"a\":{\"b\":[true,"
+    "\"\\u0041\"]}},"
+    "\"size\":1048576,\"ct\":1690000000,\"external\":false,\"notes\":0,"
+    "\"deps\":[{\"id\":\"d/2\",\"type\":0,\"dir\":1,\"alias\":null}],"
+    "\"unknown\":[1,2,3]}],\"updates\":[{\"id\":\"c/9\",\"title\":\"Parent\","
+    "\"paging\":{\"off\":0}}]}";
+
+/// Reads a listing through the tree and the stream, the replies must match
+void checkListing(const std::string &a_body) {
+  StubDatabase server(a_body, 200);
+  DatabaseAPI db_client(server.url(), "user", "pass");
+  LogContext log_context;
+  Auth::CollReadRequest request;
+  request.set_id("c/1");
+
+  Auth::ListingReply tree;
+  db_client.collRead(request, tree, log_context);
+
+  Auth::ListingReply streamed;
+  db_client.setStreamReplies(true);
+  db_client.collRead(request, streamed, log_context);
+
+  BOOST_TEST(streamed.SerializeAsString() == tree.SerializeAsString());
+}
+
+/// Expects a reply to fail the same way through the tree and the stream
+void checkFailure(const std::string &a_body, int a_status, int a_error_code) {
+  StubDatabase server(a_body, a_status);
+  DatabaseAPI db_client(server.url(), "user", "pass");
+  LogContext log_context;
+  Auth::RecordViewRequest request;
+  request.set_id("d/1");
+
+  for (bool stream : {false, true}) {
+    Auth::RecordDataReply reply;
+    int error_code = 0;
+    db_client.setStreamReplies(stream);
+    try {
+      db_client.recordView(request, reply, log_context);
+    } catch (TraceException &e) {
+      error_code = e.getErrorCode();
+    }
+    BOOST_TEST(error_code == a_error_code);
+  }
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(StreamedRepliesTest)
+
+BOOST_AUTO_TEST_CASE(testing_StreamedReplies_listing) {
+  checkListing(LISTING);
+  checkListing("[]");
+  // An escaped key is still known once its escaped value has been read
+  checkListing("[{\"\\u0069d\":\"d\\/4\",\"_id\":\"d/5\",\"title\":\"T\"}]");
+
+  StubDatabase server(LISTING, 200);
+  DatabaseAPI db_client(server.url(), "user", "pass");
+  LogContext log_context;
+  Auth::CollReadRequest request;
+  request.set_id("c/1");
+  Auth::ListingReply reply;
+  db_client.setStreamReplies(true);
+  db_client.collRead(request, reply, log_context);
+
+  BOOST_REQUIRE(reply.item_size() == 2);
+  BOOST_TEST(reply.item(0).id() == "c/1");
+  BOOST_TEST(!reply.item(0).has_alias());
+  BOOST_TEST(reply.item(0).dep(0).notes() == 3);
+  BOOST_TEST(reply.item(1).id() == "d/3");
+  BOOST_TEST(reply.item(1).title() == "A \"quoted\" title\n");
+  BOOST_TEST(reply.offset() == 20);
+  BOOST_TEST(reply.total() == 47);
+}
+
+BOOST_AUTO_TEST_CASE(testing_StreamedReplies_record) {
+  StubDatabase server(RECORD, 200);
+  DatabaseAPI db_client(server.url(), "user", "pass");
+  LogContext log_context;
+  Auth::RecordViewRequest request;
+  request.set_id("d/1");
+
+  Auth::RecordDataReply tree;
+  db_client.recordView(request, tree, log_context);
+
+  Auth::RecordDataReply streamed;
+  db_client.setStreamReplies(true);
+  db_client.recordView(request, streamed, log_context);
+
+  BOOST_TEST(streamed.SerializeAsString() == tree.SerializeAsString());
+  BOOST_REQUIRE(streamed.data_size() == 1);
+  // Metadata is written out as the tree writes it, keys sorted
+  BOOST_TEST(streamed.data(0).metadata() ==
+             "{\"a\":{\"b\":[true,\"A\"]},\"z\":1}");
+  BOOST_TEST(streamed.data(0).tags_size() == 2);
+  BOOST_TEST(streamed.update_size() == 1);
+}
+
+BOOST_AUTO_TEST_CASE(testing_StreamedReplies_failure) {
+  checkFailure("{\"results\":[{\"id\":\"d/1\"", 200, ID_SERVICE_ERROR);
+  // A record without a title
+  checkFailure("{\"results\":[{\"id\":\"d/1\"}]}", 200, 1);
+  checkFailure("{\"results\":[{\"id\":\"d/1\",\"title\":7}]}", 200, 1);
+  checkFailure("{\"errorMessage\":\"denied\"}", 400, ID_BAD_REQUEST);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
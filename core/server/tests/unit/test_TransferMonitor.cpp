@@ -0,0 +1,242 @@
+#define BOOST_TEST_MAIN
+
+#define BOOST_TEST_MODULE transfermonitor
+#include <boost/test/unit_test.hpp>
+
+// Local private includes
+#include "Config.hpp"
+#include "StubDatabase.hpp"
+#include "TransferMonitor.hpp"
+
+// Standard includes
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace SDMS;
+using namespace SDMS::Core;
+using namespace SDMS::Core::Test;
+
+BOOST_GLOBAL_FIXTURE(CurlGlobalFixture);
+
+namespace {
+
+typedef std::chrono::system_clock::time_point timepoint_t;
+
+/// A task_list call made to the stub, with the ids of its filter
+struct BatchCall {
+  std::string token;
+  std::vector<std::string> ids;
+  timepoint_t time;
+};
+
+/**
+ * Stands in for the Globus transfer API. Task lists are answered from the
+ * statuses set, which are given as Globus reports them, and cancels are
+ * always accepted. Both are recorded.
+ **/
+class StubGlobus {
+public:
+  StubGlobus()
+      : m_server([this](const std::string &a_request, int &a_status,
+                        std::string &a_body) {
+          return respond(a_request, a_status, a_body);
+        }) {
+    Config::getInstance().glob_xfr_url = m_server.url();
+  }
+
+  void set(const std::string &a_id, const std::string &a_status,
+           const std::string &a_nice_status = "") {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_status[a_id] = std::make_pair(a_status, a_nice_status);
+  }
+
+  std::vector<BatchCall> calls() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_calls;
+  }
+
+  std::vector<std::string> cancels() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_cancels;
+  }
+
+private:
+  bool respond(const std::string &a_request, int &a_status,
+               std::string &a_body) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const size_t auth = a_request.find("Bearer ") + 7;
+    const std::string token =
+        a_request.substr(auth, a_request.find("\r\n", auth) - auth);
+    a_status = 200;
+
+    // A cancel is a POST to task/<id>/cancel, all of it escaped as one path
+    if (a_request.compare(0, 5, "POST ") == 0) {
+      const size_t start = a_request.find("/task/") + 6;
+      m_cancels.push_back(
+          a_request.substr(start, a_request.find("%2Fcancel") - start));
+      a_body = "{\"code\":\"Canceled\"}";
+      return true;
+    }
+
+    // The filter is "task_id:<id>,<id>..." escaped
+    BatchCall call{token, {}, std::chrono::system_clock::now()};
+    std::string filter = StubDatabase::param(a_request, "filter");
+    filter = filter.substr(filter.find("%3A") + 3);
+    for (size_t start = 0; start <= filter.size();) {
+      size_t end = filter.find("%2C", start);
+      if (end == std::string::npos)
+        end = filter.size();
+      call.ids.push_back(filter.substr(start, end - start));
+      start = end + 3;
+    }
+
+    a_body = "{\"DATA\":[";
+    for (const std::string &id : call.ids) {
+      const auto &status = m_status[id];
+      if (a_body.back() == '}')
+        a_body += ",";
+      a_body += "{\"task_id\":\"" + id + "\",\"status\":\"" + status.first +
+                "\",\"nice_status\":\"" + status.second + "\",\"faults\":0}";
+    }
+    a_body += "]}";
+    m_calls.push_back(call);
+    return true;
+  }
+
+  mutable std::mutex m_mutex;
+  std::map<std::string, std::pair<std::string, std::string>> m_status;
+  std::vector<BatchCall> m_calls;
+  std::vector<std::string> m_cancels;
+  StubDatabase m_server;
+};
+
+/// Keeps the tasks handed back by a monitor
+struct Resumed {
+  TransferMonitor::Resume callback() {
+    return [this](std::unique_ptr<TransferMonitor::Task> a_task, LogContext) {
+      std::lock_guard<std::mutex> lock(mutex);
+      tasks[a_task->task_id] = std::move(a_task);
+    };
+  }
+
+  size_t size() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return tasks.size();
+  }
+
+  std::mutex mutex;
+  std::map<std::string, std::unique_ptr<TransferMonitor::Task>> tasks;
+};
+
+/// Whether a_done becomes true within a few seconds
+bool waitFor(const std::function<bool()> &a_done) {
+  const auto end = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (!a_done()) {
+    if (std::chrono::steady_clock::now() > end)
+      return false;
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  return true;
+}
+
+void add(TransferMonitor &a_monitor, const std::string &a_task_id, int a_step,
+         const std::string &a_xfr_task_id, const std::string &a_acc_tok) {
+  a_monitor.add(std::make_unique<TransferMonitor::Task>(a_task_id), a_step,
+                a_xfr_task_id, a_acc_tok);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(TransferMonitorTest)
+
+BOOST_AUTO_TEST_CASE(testing_TransferMonitor_poll) {
+  const auto period = std::chrono::milliseconds(200);
+  StubGlobus globus;
+  globus.set("x1", "SUCCEEDED");
+  globus.set("x2", "FAILED", "Permission denied");
+  globus.set("x3", "ACTIVE");
+  Resumed resumed;
+  TransferMonitor monitor(period, resumed.callback());
+  LogContext log_context;
+
+  const timepoint_t added = std::chrono::system_clock::now();
+  add(monitor, "task/1", 2, "x1", "tok_a");
+  add(monitor, "task/2", 3, "x2", "tok_a");
+  add(monitor, "task/3", 4, "x3", "tok_b");
+  std::thread thread(&TransferMonitor::run, &monitor, log_context);
+
+  // One batch per token, made a poll period after the transfers were added
+  BOOST_REQUIRE(waitFor([&]() { return resumed.size() == 2; }));
+  std::vector<BatchCall> calls = globus.calls();
+  BOOST_REQUIRE(calls.size() == 2);
+  BOOST_TEST(calls[0].token == "tok_a");
+  BOOST_TEST(calls[0].ids == std::vector<std::string>({"x1", "x2"}));
+  BOOST_TEST(calls[1].token == "tok_b");
+  BOOST_TEST(calls[1].ids == std::vector<std::string>({"x3"}));
+  BOOST_TEST((calls[0].time - added >= period));
+
+  {
+    std::lock_guard<std::mutex> lock(resumed.mutex);
+    const TransferMonitor::Task &succeeded = *resumed.tasks["task/1"];
+    BOOST_TEST(succeeded.resume);
+    BOOST_TEST(succeeded.resume_step == 2);
+    BOOST_TEST(succeeded.resume_err == "");
+    const TransferMonitor::Task &failed = *resumed.tasks["task/2"];
+    BOOST_TEST(failed.resume);
+    BOOST_TEST(failed.resume_step == 3);
+    BOOST_TEST(failed.resume_err == "Permission denied");
+  }
+  BOOST_TEST(globus.cancels() == std::vector<std::string>({"x2"}));
+
+  // The active transfer is polled again a period later
+  BOOST_TEST(waitFor([&]() { return monitor.size() == 1; }));
+  globus.set("x3", "SUCCEEDED");
+  BOOST_REQUIRE(waitFor([&]() { return resumed.size() == 3; }));
+  calls = globus.calls();
+  BOOST_REQUIRE(calls.size() == 3);
+  BOOST_TEST(calls[2].ids == std::vector<std::string>({"x3"}));
+  BOOST_TEST((calls[2].time - calls[1].time >= period));
+  BOOST_TEST(monitor.size() == 0);
+
+  monitor.stop();
+  thread.join();
+}
+
+BOOST_AUTO_TEST_CASE(testing_TransferMonitor_stop) {
+  StubGlobus globus;
+  Resumed resumed;
+  LogContext log_context;
+
+  // Stopping while no transfer is monitored
+  {
+    TransferMonitor monitor(std::chrono::milliseconds(10), resumed.callback());
+    std::thread thread(&TransferMonitor::run, &monitor, log_context);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    monitor.stop();
+    thread.join();
+  }
+
+  // Stopping while waiting for the next poll, long before it is due
+  TransferMonitor monitor(std::chrono::hours(1), resumed.callback());
+  add(monitor, "task/1", 1, "x1", "tok_a");
+  std::thread thread(&TransferMonitor::run, &monitor, log_context);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  const auto start = std::chrono::steady_clock::now();
+  monitor.stop();
+  thread.join();
+  BOOST_TEST((std::chrono::steady_clock::now() - start <
+              std::chrono::seconds(1)));
+
+  // Nothing was polled and the transfer is left as it was
+  BOOST_TEST(globus.calls().empty());
+  BOOST_TEST(resumed.size() == 0);
+  BOOST_TEST(monitor.size() == 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <iostream>
+#include <vector>
 
 #if defined(_WIN32) || defined(_WIN64)
 #include <profileapi.h>
@@ -7,6 +9,9 @@
 #include <time.h>
 #endif
 
+#include "JsonScanner.hpp"
+#include "JsonWriter.hpp"
+#include "Util.hpp"
 #include "libjson.hpp"
 
 using namespace std;
@@ -271,8 +276,8 @@ void parse1(const Value &v, Schema1 &result) {
   subParse1(obj, "obj9", result.sub9);
 }
 
-void perfTest() {
-  string json = "{\
+string schemaDocument() {
+  return "{\
             \"req1s\":\"long text long text long text long text long text long text long text long\
             text long text long text long text long text long text long text long text long text\
             text long text long text long text long text long text long text long text long text\
@@ -321,59 +326,298 @@ void perfTest() {
             \"obj8\":{\"n\":null,\"a\":\"value\",\"b\":true,\"c\":9.999,\"d\":[0,1.5,2,3.5,4,5.5],\"e\":{\"n\":null,\"p\":\"value\",\"q\":false,\"r\":-9.999,\"s\":[0.5,1,2.5,3,4.5,5]}},\
             \"obj9\":{\"n\":null,\"a\":\"value\",\"b\":true,\"c\":9.999,\"d\":[0,1.5,2,3.5,4,5.5],\"e\":{\"n\":null,\"p\":\"value\",\"q\":false,\"r\":-9.999,\"s\":[0.5,1,2.5,3,4.5,5]}}\
         }";
+}
 
-  Value v;
-  Schema1 result;
+// A listing reply, as returned for a large collection or query
+string listingDocument(size_t a_items) {
+  string json = "{\"item\":[";
+  for (size_t i = 0; i < a_items; i++) {
+    string id = to_string(1000000 + i);
+    json += (i ? "," : "");
+    json += "{\"id\":\"d/" + id + "\",\"title\":\"Scan " + id +
+            " of sample \\\"A\\\" at 300K\",\"alias\":\"scan-" + id +
+            "\",\"owner\":\"p/beamline_2024\",\"creator\":\"u/user" +
+            to_string(i % 17) + "\",\"size\":" + to_string(i * 4099 % 900001) +
+            ",\"ct\":" + to_string(1690000000 + i * 37) +
+            ",\"ut\":" + to_string(1690000000 + i * 41) +
+            ",\"locked\":false,\"notes\":0,\"deps\":[]}";
+  }
+  json += "],\"offset\":0,\"count\":" + to_string(a_items) +
+          ",\"total\":" + to_string(a_items) + "}";
+  return json;
+}
 
-  v.fromString(json);
-  // cout << "Parsed: " << v.toString() << "\n";
-  size_t i, ntest = 10000;
-  double elapsed;
-  string res;
+// A record whose metadata holds long strings with the odd escape
+string metadataDocument(size_t a_bytes) {
+  string line = "detector frame 0042 exposure ok, gain nominal, "
+                "temperature stable; ";
+  string json = "{\"id\":\"d/1000001\",\"md\":{";
+  for (size_t field = 0; json.size() < a_bytes; field++) {
+    json += (field ? ",\"" : "\"") + string("field") + to_string(field) +
+            "\":\"";
+    for (size_t i = 0; i < 200; i++) {
+      json += line;
+      if (i % 50 == 49)
+        json += "\\n\\t\\\"quoted\\\"\\u00b0C ";
+    }
+    json += "\"";
+  }
+  json += "}}";
+  return json;
+}
+
+// The listing as written by a pretty printer, mostly indentation
+string prettyDocument(size_t a_items) {
+  string compact = listingDocument(a_items);
+  string json;
+  size_t depth = 0;
+  bool in_string = false;
+
+  for (size_t i = 0; i < compact.size(); i++) {
+    char c = compact[i];
+    if (in_string) {
+      json += c;
+      if (c == '\\')
+        json += compact[++i];
+      else if (c == '"')
+        in_string = false;
+    } else if (c == '{' || c == '[') {
+      json += c;
+      json += "\n" + string(2 * ++depth, ' ');
+    } else if (c == '}' || c == ']') {
+      json += "\n" + string(2 * --depth, ' ') + c;
+    } else if (c == ',') {
+      json += ",\n" + string(2 * depth, ' ');
+    } else if (c == ':') {
+      json += ": ";
+    } else {
+      json += c;
+      in_string = (c == '"');
+    }
+  }
+  return json;
+}
+
+// Sizes, times and measurements
+string numbersDocument(size_t a_count) {
+  string json = "[";
+  for (size_t i = 0; i < a_count; i++) {
+    json += (i ? "," : "");
+    switch (i % 4) {
+    case 0:
+      json += to_string(i * 7919);
+      break;
+    case 1:
+      json += "-" + to_string(i % 1000) + "." + to_string(i % 97);
+      break;
+    case 2:
+      json += to_string(i % 10) + ".5e-" + to_string(i % 12);
+      break;
+    default:
+      json += to_string(1690000000 + i);
+      break;
+    }
+  }
+  json += "]";
+  return json;
+}
+
+struct Timing {
+  double best;
+  double median;
+};
+
+// Times a_reps parses of a_json after one untimed parse to warm up
+Timing timeParse(const string &a_json, bool a_arena, size_t a_reps) {
+  Value v;
+  vector<double> times;
 
   timerDef();
 
-  try {
+  v.fromString(a_json, a_arena);
+  for (size_t i = 0; i < a_reps; i++) {
     timerStart();
+    v.fromString(a_json, a_arena);
+    timerStop();
+    times.push_back(timerElapsed());
+  }
+
+  sort(times.begin(), times.end());
+  return Timing{times.front(), times[times.size() / 2]};
+}
 
-    for (i = 0; i < ntest; i++) {
-      v.fromString(json);
-      res = v.toString();
+void parseBenchmark() {
+  struct Document {
+    const char *name;
+    string json;
+  };
+  vector<Document> documents = {{"schema", schemaDocument()},
+                                {"listing", listingDocument(5000)},
+                                {"metadata", metadataDocument(1 << 20)},
+                                {"pretty", prettyDocument(2000)},
+                                {"numbers", numbersDocument(50000)}};
+  vector<string> kernels = scan::kernels();
+  const double bytes_per_config = 32.0 * (1 << 20);
+
+  cout << "\nParse, best and median of repeated runs\n";
+  cout << "document  bytes     kernel  alloc  best us     median us   MB/s\n";
+
+  for (const Document &doc : documents) {
+    size_t reps = max((size_t)10, (size_t)(bytes_per_config / doc.json.size()));
+    for (const string &kernel : kernels) {
+      scan::useKernel(kernel);
+      for (bool arena : {false, true}) {
+        Timing t = timeParse(doc.json, arena, reps);
+        printf("%-9s %-9zu %-7s %-6s %-11.1f %-11.1f %.0f\n", doc.name,
+               doc.json.size(), kernel.c_str(), arena ? "arena" : "heap",
+               t.best * 1.0e6, t.median * 1.0e6,
+               doc.json.size() / t.best / (1 << 20));
+      }
     }
+  }
+  scan::useKernel(kernels.front());
+}
 
-    timerStop();
-    elapsed = timerElapsed();
+// Fields of a record create request
+struct RecordBody {
+  string title;
+  string desc;
+  vector<string> tags;
+  string metadata;
+  vector<string> deps;
+};
+
+// The body built by concatenation, as DatabaseAPI did before the writer
+void concatBody(const RecordBody &a_rec, string &a_body) {
+  a_body = "{\"title\":\"" + escapeJSON(a_rec.title) + "\"";
+  a_body += ",\"desc\":\"" + escapeJSON(a_rec.desc) + "\"";
+  a_body += ",\"tags\":[";
+  for (size_t i = 0; i < a_rec.tags.size(); i++) {
+    if (i)
+      a_body += ",";
+    a_body += "\"" + a_rec.tags[i] + "\"";
+  }
+  a_body += "]";
+  a_body += ",\"md\":" + a_rec.metadata;
+  a_body += ",\"deps\":[";
+  for (size_t i = 0; i < a_rec.deps.size(); i++) {
+    a_body += string(i > 0 ? "," : "") + "{\"id\":\"" + a_rec.deps[i] +
+              "\",\"type\":" + to_string(i % 3) + "}";
+  }
+  a_body += "]}";
+}
 
-    cout << "Completed " << ntest << " parses in " << elapsed << " sec, "
-         << 1000.0 * elapsed / ntest << " msec per parse\n";
+// The same body through the writer
+void writerBody(const RecordBody &a_rec, string &a_body) {
+  Writer body;
+  body.beginObject().key("title").string(a_rec.title);
+  body.key("desc").string(a_rec.desc);
+  body.key("tags").beginArray();
+  for (const string &tag : a_rec.tags)
+    body.string(tag);
+  body.endArray().key("md").raw(a_rec.metadata);
+  body.key("deps").beginArray();
+  for (size_t i = 0; i < a_rec.deps.size(); i++) {
+    body.beginObject().key("id").string(a_rec.deps[i]);
+    body.key("type").number(i % 3).endObject();
+  }
+  body.endArray().endObject();
 
+  // Stands in for the request, which reads the body in place
+  a_body.assign(body.str(), 0, 16);
+}
+
+// Times a_reps bodies after one untimed build to warm up
+template <typename Build>
+Timing timeBody(Build a_build, const RecordBody &a_rec, size_t a_reps) {
+  string out;
+  vector<double> times;
+
+  timerDef();
+
+  a_build(a_rec, out);
+  for (size_t i = 0; i < a_reps; i++) {
     timerStart();
+    a_build(a_rec, out);
+    timerStop();
+    times.push_back(timerElapsed());
+  }
+
+  sort(times.begin(), times.end());
+  return Timing{times.front(), times[times.size() / 2]};
+}
 
-    for (i = 0; i < ntest; i++) {
-      parse1(v, result);
+void writeBenchmark() {
+  RecordBody rec;
+  rec.title = "Scan 1000042 of sample \"A\" at 300K";
+  for (size_t i = 0; i < 20; i++)
+    rec.desc += "Detector frame exposure ok,\tgain nominal.\n";
+  for (size_t i = 0; i < 8; i++)
+    rec.tags.push_back("tag" + to_string(i));
+  for (size_t i = 0; i < 4; i++)
+    rec.deps.push_back("d/" + to_string(2000000 + i));
+
+  cout << "\nRecord create body, best and median of repeated runs\n";
+  cout << "md bytes  builder  best us     median us   MB/s\n";
+
+  for (size_t md_size : {(size_t)1 << 10, (size_t)64 << 10, (size_t)1 << 20}) {
+    rec.metadata = metadataDocument(md_size);
+    size_t reps = max((size_t)10, (size_t)(32.0 * (1 << 20) / md_size));
+    size_t bytes = 0;
+    string body;
+
+    writerBody(rec, body);
+    concatBody(rec, body);
+    bytes = body.size();
+
+    for (bool writer : {false, true}) {
+      Timing t = writer ? timeBody(writerBody, rec, reps)
+                        : timeBody(concatBody, rec, reps);
+      printf("%-9zu %-8s %-11.1f %-11.1f %.0f\n", rec.metadata.size(),
+             writer ? "writer" : "concat", t.best * 1.0e6, t.median * 1.0e6,
+             bytes / t.best / (1 << 20));
     }
+  }
+}
 
-    timerStop();
-    elapsed = timerElapsed();
+void translateBenchmark() {
+  Value v;
+  Schema1 result;
+  size_t i, ntest = 10000;
+  double elapsed;
 
-    cout << "Completed " << ntest << " translations in " << elapsed << " sec, "
-         << 1000.0 * elapsed / ntest << " msec per translation\n";
-  } catch (TraceException &e) {
-    cout << e.toString(true) << "\n";
+  timerDef();
+
+  v.fromString(schemaDocument());
+  timerStart();
+
+  for (i = 0; i < ntest; i++) {
+    parse1(v, result);
   }
+
+  timerStop();
+  elapsed = timerElapsed();
+
+  cout << "\nCompleted " << ntest << " translations in " << elapsed
+       << " sec, " << 1000.0 * elapsed / ntest << " msec per translation\n";
 }
 
 int main(int argc, char **argv) {
   (void)argc;
   (void)argv;
 
-  cout << "LibJSON Test\n";
+  cout << "LibJSON Benchmark, scanning with " << scan::kernel() << "\n";
 
   try {
-    perfTest();
+    parseBenchmark();
+    writeBenchmark();
+    translateBenchmark();
     return 0;
   } catch (TraceException &e) {
     cout << "Error: " << e.toString(true) << "\n";
     return 1;
+  } catch (ParseError &e) {
+    cout << "Error: " << e.toString() << "\n";
+    return 1;
   }
 }